@@ -0,0 +1,749 @@
+// DTU swarm load generator.
+//
+//   iot-dtu-swarm [--key=value ...]
+//
+// Opens thousands of TCP connections to a running server and behaves like the
+// DTUs behind them, so ingest capacity can be measured on a local box (server
+// plus local PostgreSQL) without real hardware:
+//
+//   modbus - each DTU sends its registration code, a heartbeat every
+//            --heartbeat-s, and answers the server's Modbus TCP/RTU polls with
+//            "<registration><response>" like tools/dtu-simulator.mjs
+//   sl651  - each station pushes timed reports (7E7E up frames, FC 32) every
+//            --report-ms with water level, rainfall and voltage elements
+//
+// Registration codes are --reg-prefix followed by the zero-padded DTU index
+// (--reg-width digits in total), starting at --first; SL651 station addresses
+// are --station-base + index. The matching devices must already exist on the
+// target link, otherwise the server just drops the traffic.
+//
+// Options (defaults in brackets):
+//   --host [127.0.0.1] --port [9003] --protocol modbus|sl651 [modbus]
+//   --frame tcp|rtu [tcp]           Modbus framing used by the link
+//   --dtus [1000] --first [1] --threads [hardware concurrency]
+//   --connect-rate [2000]           new connections per second during ramp-up
+//   --reg-prefix [8604100670] --reg-width [15] --heartbeat-s [30]
+//   --map random|sine|counter|const:N [sine]
+//                                   register values served for FC01-04
+//   --latency fixed:MS|uniform:MIN:MAX|exp:MEAN|lognormal:MEDIAN:SIGMA [fixed:0]
+//                                   delay before each Modbus response
+//   --drop [0]                      probability a poll gets no response
+//   --corrupt [0]                   probability a response/report has one byte flipped
+//   --noise [0]                     probability random bytes precede a response/report
+//   --station-base [1000000000] --report-ms [60000] --center [1]
+//   --storm-every-s [0] --storm-fraction [0.5]
+//                                   periodically drop a fraction of all DTUs at once
+//   --reconnect-ms [5000]           delay before reconnecting after a close
+//   --duration-s [0 = until Ctrl-C] --report-s [5]
+//
+// Every report interval prints connected DTUs, achieved rx/tx rates and the
+// server turnaround: time from a Modbus response to that DTU's next poll (the
+// server's per-device poll cycle under load) and from registration to the
+// first poll.
+
+#include <json/json.h>
+#include <trantor/net/EventLoopThreadPool.h>
+#include <trantor/net/TcpClient.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The server headers lean on pch.hpp for the includes above
+#include "common/protocol/modbus/Modbus.Utils.hpp"
+#include "common/protocol/sl651/SL651.Utils.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum class Protocol { Modbus, Sl651 };
+enum class ValueMap { Random, Sine, Counter, Const };
+enum class LatencyKind { Fixed, Uniform, Exponential, LogNormal };
+
+struct Options {
+    std::string host = "127.0.0.1";
+    uint16_t port = 9003;
+    Protocol protocol = Protocol::Modbus;
+    bool rtu = false;
+    int dtus = 1000;
+    int first = 1;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    double connectRate = 2000;
+    std::string regPrefix = "8604100670";
+    int regWidth = 15;
+    double heartbeatS = 30;
+    ValueMap map = ValueMap::Sine;
+    uint16_t constValue = 0;
+    LatencyKind latency = LatencyKind::Fixed;
+    double latencyA = 0;
+    double latencyB = 0;
+    double drop = 0;
+    double corrupt = 0;
+    double noise = 0;
+    int64_t stationBase = 1000000000;
+    double reportMs = 60000;
+    int center = 1;
+    double stormEveryS = 0;
+    double stormFraction = 0.5;
+    double reconnectMs = 5000;
+    double durationS = 0;
+    double reportS = 5;
+};
+
+// Log2 buckets in microseconds; enough for percentiles in a console report.
+class LatencyHistogram {
+public:
+    void observe(Clock::duration elapsed) {
+        const auto us = std::max<int64_t>(1, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+        size_t bucket = 0;
+        while (bucket + 1 < kBuckets && (int64_t{1} << bucket) < us) ++bucket;
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Snapshot and reset; returns {count, p50, p90, p99, max} in milliseconds
+    std::array<double, 5> take() {
+        std::array<uint64_t, kBuckets> counts{};
+        uint64_t total = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            counts[i] = buckets_[i].exchange(0, std::memory_order_relaxed);
+            total += counts[i];
+        }
+        std::array<double, 5> result{static_cast<double>(total), 0, 0, 0, 0};
+        if (total == 0) return result;
+
+        const std::array<double, 3> quantiles{0.5, 0.9, 0.99};
+        uint64_t seen = 0;
+        size_t q = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            if (counts[i] == 0) continue;
+            seen += counts[i];
+            const double upperMs = static_cast<double>(int64_t{1} << i) / 1000.0;
+            while (q < quantiles.size() && static_cast<double>(seen) >= quantiles[q] * static_cast<double>(total)) {
+                result[1 + q++] = upperMs;
+            }
+            result[4] = upperMs;
+        }
+        return result;
+    }
+
+private:
+    static constexpr size_t kBuckets = 32;
+    std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+};
+
+struct Stats {
+    std::atomic<int64_t> connected{0};
+    std::atomic<uint64_t> connects{0};
+    std::atomic<uint64_t> disconnects{0};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> responses{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> corrupted{0};
+    std::atomic<uint64_t> reports{0};
+    std::atomic<uint64_t> heartbeats{0};
+    std::atomic<uint64_t> unparsed{0};
+    std::atomic<uint64_t> bytesRx{0};
+    std::atomic<uint64_t> bytesTx{0};
+    LatencyHistogram turnaround;
+    LatencyHistogram firstPoll;
+};
+
+Options gOptions;
+Stats gStats;
+std::atomic<bool> gStop{false};
+
+std::mt19937_64& rng() {
+    thread_local std::mt19937_64 engine{std::random_device{}()};
+    return engine;
+}
+
+bool chance(double probability) {
+    return probability > 0 && std::uniform_real_distribution<double>(0, 1)(rng()) < probability;
+}
+
+double sampleLatencyMs() {
+    const auto& o = gOptions;
+    switch (o.latency) {
+        case LatencyKind::Fixed:
+            return o.latencyA;
+        case LatencyKind::Uniform:
+            return std::uniform_real_distribution<double>(o.latencyA, std::max(o.latencyA, o.latencyB))(rng());
+        case LatencyKind::Exponential:
+            return o.latencyA > 0 ? std::exponential_distribution<double>(1.0 / o.latencyA)(rng()) : 0;
+        case LatencyKind::LogNormal:
+            return o.latencyA > 0 ? std::lognormal_distribution<double>(std::log(o.latencyA), o.latencyB)(rng()) : 0;
+    }
+    return 0;
+}
+
+uint16_t registerValue(int dtuIndex, uint16_t address) {
+    switch (gOptions.map) {
+        case ValueMap::Random:
+            return static_cast<uint16_t>(rng()());
+        case ValueMap::Sine: {
+            const double t = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+            return static_cast<uint16_t>(1000 + 1000 * std::sin(t / 60.0 + address * 0.7 + dtuIndex * 0.013));
+        }
+        case ValueMap::Counter: {
+            thread_local uint16_t counter = 0;
+            return static_cast<uint16_t>(++counter + address);
+        }
+        case ValueMap::Const:
+            return gOptions.constValue;
+    }
+    return 0;
+}
+
+// A Modbus poll cut from the receive buffer; pdu excludes the unit id and CRC
+struct ModbusPoll {
+    uint16_t transactionId = 0;
+    uint8_t unitId = 0;
+    std::vector<uint8_t> pdu;
+};
+
+// Returns bytes consumed, 0 when more data is needed
+size_t takeModbusPoll(const uint8_t* data, size_t len, ModbusPoll& poll, bool& valid) {
+    valid = false;
+    if (!gOptions.rtu) {
+        if (len < 8) return 0;
+        const size_t length = (static_cast<size_t>(data[4]) << 8) | data[5];
+        if (data[2] != 0 || data[3] != 0 || length < 2 || length > 254) return 1;
+        if (len < 6 + length) return 0;
+        poll.transactionId = static_cast<uint16_t>((data[0] << 8) | data[1]);
+        poll.unitId = data[6];
+        poll.pdu.assign(data + 7, data + 6 + length);
+        valid = true;
+        return 6 + length;
+    }
+
+    if (len < 8) return 0;
+    size_t frameLen = 8;
+    if (data[1] == 0x0F || data[1] == 0x10) {
+        frameLen = 9 + static_cast<size_t>(data[6]);
+    }
+    if (len < frameLen) return 0;
+    const uint16_t crc = modbus::ModbusUtils::crc16(data, frameLen - 2);
+    if (data[frameLen - 2] != (crc & 0xFF) || data[frameLen - 1] != (crc >> 8)) return 1;
+    poll.unitId = data[0];
+    poll.pdu.assign(data + 1, data + frameLen - 2);
+    valid = true;
+    return frameLen;
+}
+
+std::vector<uint8_t> buildModbusResponse(int dtuIndex, const ModbusPoll& poll) {
+    const auto& req = poll.pdu;
+    if (req.size() < 5) return {};
+    const uint8_t fc = req[0];
+    const uint16_t address = static_cast<uint16_t>((req[1] << 8) | req[2]);
+    const uint16_t quantity = static_cast<uint16_t>((req[3] << 8) | req[4]);
+
+    std::vector<uint8_t> pdu{fc};
+    switch (fc) {
+        case 0x01:
+        case 0x02: {
+            const size_t bytes = (quantity + 7u) / 8u;
+            pdu.push_back(static_cast<uint8_t>(bytes));
+            for (size_t i = 0; i < bytes; ++i) {
+                uint8_t bits = 0;
+                for (size_t b = 0; b < 8 && i * 8 + b < quantity; ++b) {
+                    if (registerValue(dtuIndex, static_cast<uint16_t>(address + i * 8 + b)) & 1) bits |= 1u << b;
+                }
+                pdu.push_back(bits);
+            }
+            break;
+        }
+        case 0x03:
+        case 0x04:
+            pdu.push_back(static_cast<uint8_t>(quantity * 2));
+            for (uint16_t i = 0; i < quantity; ++i) {
+                const uint16_t value = registerValue(dtuIndex, static_cast<uint16_t>(address + i));
+                pdu.push_back(static_cast<uint8_t>(value >> 8));
+                pdu.push_back(static_cast<uint8_t>(value & 0xFF));
+            }
+            break;
+        case 0x05:
+        case 0x06:
+        case 0x0F:
+        case 0x10:
+            // Writes echo address and value/quantity
+            pdu.insert(pdu.end(), req.begin() + 1, req.begin() + 5);
+            break;
+        default:
+            pdu = {static_cast<uint8_t>(fc | 0x80), 0x01};
+            break;
+    }
+
+    std::vector<uint8_t> frame;
+    if (!gOptions.rtu) {
+        const size_t length = pdu.size() + 1;
+        frame = {
+            static_cast<uint8_t>(poll.transactionId >> 8), static_cast<uint8_t>(poll.transactionId & 0xFF),
+            0x00, 0x00,
+            static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length & 0xFF),
+            poll.unitId
+        };
+        frame.insert(frame.end(), pdu.begin(), pdu.end());
+    } else {
+        frame.push_back(poll.unitId);
+        frame.insert(frame.end(), pdu.begin(), pdu.end());
+        const uint16_t crc = modbus::ModbusUtils::crc16(frame);
+        frame.push_back(static_cast<uint8_t>(crc & 0xFF));
+        frame.push_back(static_cast<uint8_t>(crc >> 8));
+    }
+    return frame;
+}
+
+void append(std::vector<uint8_t>& out, const std::vector<uint8_t>& bytes) {
+    out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+// Up frame: 7E7E | center | station(5) | password(2) | FC | len | STX | body | ETX | CRC
+std::vector<uint8_t> buildSl651Report(int64_t station, uint16_t serial, int dtuIndex) {
+    using sl651::SL651Utils;
+    const auto now = std::chrono::system_clock::now();
+    const auto stationBcd = SL651Utils::encodeBCDAddress(std::to_string(station), 5);
+    const auto reportTime = SL651Utils::encodeReportTime(now);
+    const double phase = std::chrono::duration<double>(now.time_since_epoch()).count() / 600.0 + dtuIndex * 0.1;
+
+    std::vector<uint8_t> body{static_cast<uint8_t>(serial >> 8), static_cast<uint8_t>(serial & 0xFF)};
+    append(body, reportTime);
+    body.insert(body.end(), {0xF1, 0xF1});
+    append(body, stationBcd);
+    body.push_back(0x48);                                      // station type: river
+    body.insert(body.end(), {0xF0, 0xF0});
+    body.insert(body.end(), reportTime.begin(), reportTime.begin() + 5);  // observed YYMMDDHHmm
+    body.insert(body.end(), {0x39, 0x23});                     // water level, 4 bytes, 3 decimals
+    append(body, SL651Utils::encodeBCDValue(12.5 + 2.0 * std::sin(phase), 4, 3));
+    body.insert(body.end(), {0x20, 0x19});                     // rainfall, 3 bytes, 1 decimal
+    append(body, SL651Utils::encodeBCDValue(static_cast<double>(rng()() % 500) / 10.0, 3, 1));
+    body.insert(body.end(), {0x38, 0x12});                     // supply voltage, 2 bytes, 2 decimals
+    append(body, SL651Utils::encodeBCDValue(12.0 + 0.5 * std::cos(phase), 2, 2));
+
+    std::vector<uint8_t> frame{0x7E, 0x7E, static_cast<uint8_t>(gOptions.center)};
+    append(frame, stationBcd);
+    frame.insert(frame.end(), {0x00, 0x00, 0x32});
+    frame.push_back(static_cast<uint8_t>((body.size() >> 8) & 0x0F));
+    frame.push_back(static_cast<uint8_t>(body.size() & 0xFF));
+    frame.push_back(0x02);
+    append(frame, body);
+    frame.push_back(0x03);
+    const uint16_t crc = SL651Utils::crc16Modbus(frame);
+    frame.push_back(static_cast<uint8_t>(crc >> 8));
+    frame.push_back(static_cast<uint8_t>(crc & 0xFF));
+    return frame;
+}
+
+// Applies --noise / --corrupt to an outgoing frame
+std::string impair(std::string payload) {
+    if (chance(gOptions.corrupt) && !payload.empty()) {
+        const size_t at = rng()() % payload.size();
+        payload[at] = static_cast<char>(payload[at] ^ (1 + rng()() % 255));
+        gStats.corrupted.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (chance(gOptions.noise)) {
+        std::string garbage(1 + rng()() % 16, '\0');
+        for (auto& c : garbage) c = static_cast<char>(rng()());
+        payload.insert(0, garbage);
+    }
+    return payload;
+}
+
+// One simulated DTU. Lives on a single loop; every member is touched only there.
+class Dtu : public std::enable_shared_from_this<Dtu> {
+public:
+    Dtu(trantor::EventLoop* loop, int index)
+        : loop_(loop), index_(index) {
+        const auto number = std::to_string(index);
+        const size_t width = static_cast<size_t>(std::max<int>(gOptions.regWidth, static_cast<int>(gOptions.regPrefix.size())));
+        registration_ = gOptions.regPrefix +
+            std::string(width - std::min(width, gOptions.regPrefix.size() + number.size()), '0') + number;
+        station_ = gOptions.stationBase + index;
+    }
+
+    void start() {
+        auto self = shared_from_this();
+        auto client = std::make_shared<trantor::TcpClient>(
+            loop_, trantor::InetAddress(gOptions.host, gOptions.port), "dtu-" + std::to_string(index_));
+        std::weak_ptr<Dtu> weak = self;
+        client->setConnectionCallback([weak](const trantor::TcpConnectionPtr& conn) {
+            if (auto dtu = weak.lock()) dtu->onConnection(conn);
+        });
+        client->setConnectionErrorCallback([weak]() {
+            if (auto dtu = weak.lock()) dtu->scheduleReconnect();
+        });
+        client->setMessageCallback([weak](const trantor::TcpConnectionPtr&, trantor::MsgBuffer* buffer) {
+            if (auto dtu = weak.lock()) {
+                dtu->onMessage(buffer);
+            } else {
+                buffer->retrieveAll();
+            }
+        });
+        client_ = std::move(client);
+        client_->connect();
+    }
+
+    // Reconnect storm: close now, come back after --reconnect-ms like a real DTU would.
+    // Callable from any thread.
+    void drop() {
+        auto self = shared_from_this();
+        loop_->queueInLoop([self]() {
+            if (self->conn_) self->conn_->forceClose();
+        });
+    }
+
+    // Shutdown: close and release the client on its own loop
+    void stop() {
+        auto self = shared_from_this();
+        loop_->queueInLoop([self]() {
+            if (self->conn_) self->conn_->forceClose();
+            self->client_.reset();
+        });
+    }
+
+private:
+    void onConnection(const trantor::TcpConnectionPtr& conn) {
+        if (conn->connected()) {
+            conn_ = conn;
+            gStats.connected.fetch_add(1, std::memory_order_relaxed);
+            gStats.connects.fetch_add(1, std::memory_order_relaxed);
+            awaitingFirstPoll_ = true;
+            registeredAt_ = Clock::now();
+            lastResponseAt_.reset();
+            if (gOptions.protocol == Protocol::Modbus) {
+                send(registration_);
+                scheduleHeartbeat();
+            } else {
+                scheduleReport(std::uniform_real_distribution<double>(0, gOptions.reportMs)(rng()));
+            }
+            return;
+        }
+
+        if (conn_) {
+            gStats.connected.fetch_sub(1, std::memory_order_relaxed);
+            gStats.disconnects.fetch_add(1, std::memory_order_relaxed);
+        }
+        conn_.reset();
+        ++generation_;
+        scheduleReconnect();
+    }
+
+    void scheduleReconnect() {
+        if (gStop.load(std::memory_order_relaxed)) return;
+        // The old client must not be destroyed inside its own callback
+        auto self = shared_from_this();
+        loop_->runAfter(gOptions.reconnectMs / 1000.0, [self, old = client_]() {
+            if (!gStop.load(std::memory_order_relaxed)) self->start();
+        });
+    }
+
+    void onMessage(trantor::MsgBuffer* buffer) {
+        gStats.bytesRx.fetch_add(buffer->readableBytes(), std::memory_order_relaxed);
+        if (gOptions.protocol == Protocol::Sl651) {
+            // The center does not acknowledge timed reports; downlink commands are ignored
+            buffer->retrieveAll();
+            return;
+        }
+
+        while (buffer->readableBytes() > 0) {
+            ModbusPoll poll;
+            bool valid = false;
+            const auto* data = reinterpret_cast<const uint8_t*>(buffer->peek());
+            const size_t consumed = takeModbusPoll(data, buffer->readableBytes(), poll, valid);
+            if (consumed == 0) break;
+            buffer->retrieve(consumed);
+            if (!valid) {
+                gStats.unparsed.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            onPoll(poll);
+        }
+    }
+
+    void onPoll(const ModbusPoll& poll) {
+        const auto now = Clock::now();
+        gStats.requests.fetch_add(1, std::memory_order_relaxed);
+        if (awaitingFirstPoll_) {
+            awaitingFirstPoll_ = false;
+            gStats.firstPoll.observe(now - registeredAt_);
+        }
+        if (lastResponseAt_) {
+            gStats.turnaround.observe(now - *lastResponseAt_);
+            lastResponseAt_.reset();
+        }
+
+        if (chance(gOptions.drop)) {
+            gStats.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        const auto frame = buildModbusResponse(index_, poll);
+        if (frame.empty()) return;
+
+        std::string payload = registration_;
+        payload.append(reinterpret_cast<const char*>(frame.data()), frame.size());
+        payload = impair(std::move(payload));
+
+        const double delayMs = sampleLatencyMs();
+        if (delayMs <= 0) {
+            respond(payload);
+            return;
+        }
+        std::weak_ptr<Dtu> weak = shared_from_this();
+        loop_->runAfter(delayMs / 1000.0, [weak, payload = std::move(payload), generation = generation_]() {
+            auto dtu = weak.lock();
+            if (dtu && dtu->generation_ == generation) dtu->respond(payload);
+        });
+    }
+
+    void respond(const std::string& payload) {
+        if (!conn_) return;
+        send(payload);
+        lastResponseAt_ = Clock::now();
+        gStats.responses.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void scheduleHeartbeat() {
+        std::weak_ptr<Dtu> weak = shared_from_this();
+        loop_->runAfter(gOptions.heartbeatS, [weak, generation = generation_]() {
+            auto dtu = weak.lock();
+            if (!dtu || dtu->generation_ != generation || !dtu->conn_) return;
+            dtu->send("HELLO");
+            gStats.heartbeats.fetch_add(1, std::memory_order_relaxed);
+            dtu->scheduleHeartbeat();
+        });
+    }
+
+    void scheduleReport(double delayMs) {
+        std::weak_ptr<Dtu> weak = shared_from_this();
+        loop_->runAfter(delayMs / 1000.0, [weak, generation = generation_]() {
+            auto dtu = weak.lock();
+            if (!dtu || dtu->generation_ != generation || !dtu->conn_) return;
+            const auto frame = buildSl651Report(dtu->station_, dtu->serial_++, dtu->index_);
+            dtu->send(impair(std::string(reinterpret_cast<const char*>(frame.data()), frame.size())));
+            gStats.reports.fetch_add(1, std::memory_order_relaxed);
+            dtu->scheduleReport(gOptions.reportMs);
+        });
+    }
+
+    void send(const std::string& payload) {
+        if (!conn_) return;
+        conn_->send(payload);
+        gStats.bytesTx.fetch_add(payload.size(), std::memory_order_relaxed);
+    }
+
+    trantor::EventLoop* loop_;
+    int index_;
+    std::string registration_;
+    int64_t station_ = 0;
+    uint16_t serial_ = 1;
+    uint64_t generation_ = 0;     // bumped on every close; stale timers check it
+    std::shared_ptr<trantor::TcpClient> client_;
+    trantor::TcpConnectionPtr conn_;
+    bool awaitingFirstPoll_ = false;
+    Clock::time_point registeredAt_;
+    std::optional<Clock::time_point> lastResponseAt_;
+};
+
+bool parseLatency(const std::string& spec) {
+    auto& o = gOptions;
+    const auto colon = spec.find(':');
+    const std::string kind = spec.substr(0, colon);
+    const std::string rest = colon == std::string::npos ? "" : spec.substr(colon + 1);
+    const auto second = rest.find(':');
+    o.latencyA = std::atof(rest.substr(0, second).c_str());
+    o.latencyB = second == std::string::npos ? 0 : std::atof(rest.substr(second + 1).c_str());
+    if (kind == "fixed") o.latency = LatencyKind::Fixed;
+    else if (kind == "uniform") o.latency = LatencyKind::Uniform;
+    else if (kind == "exp") o.latency = LatencyKind::Exponential;
+    else if (kind == "lognormal") o.latency = LatencyKind::LogNormal;
+    else return false;
+    return true;
+}
+
+bool parseMap(const std::string& spec) {
+    auto& o = gOptions;
+    if (spec == "random") o.map = ValueMap::Random;
+    else if (spec == "sine") o.map = ValueMap::Sine;
+    else if (spec == "counter") o.map = ValueMap::Counter;
+    else if (spec.rfind("const:", 0) == 0) {
+        o.map = ValueMap::Const;
+        o.constValue = static_cast<uint16_t>(std::atoi(spec.c_str() + 6));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseArgs(int argc, char** argv) {
+    auto& o = gOptions;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos) {
+            std::cerr << "bad argument: " << arg << " (expected --key=value)" << std::endl;
+            return false;
+        }
+        const std::string key = arg.substr(2, eq - 2);
+        const std::string value = arg.substr(eq + 1);
+        const double number = std::atof(value.c_str());
+
+        if (key == "host") o.host = value;
+        else if (key == "port") o.port = static_cast<uint16_t>(number);
+        else if (key == "protocol" && (value == "modbus" || value == "sl651"))
+            o.protocol = value == "modbus" ? Protocol::Modbus : Protocol::Sl651;
+        else if (key == "frame" && (value == "tcp" || value == "rtu")) o.rtu = value == "rtu";
+        else if (key == "dtus") o.dtus = std::max(1, static_cast<int>(number));
+        else if (key == "first") o.first = static_cast<int>(number);
+        else if (key == "threads") o.threads = std::max(1, static_cast<int>(number));
+        else if (key == "connect-rate") o.connectRate = std::max(1.0, number);
+        else if (key == "reg-prefix") o.regPrefix = value;
+        else if (key == "reg-width") o.regWidth = static_cast<int>(number);
+        else if (key == "heartbeat-s") o.heartbeatS = std::max(1.0, number);
+        else if (key == "map") { if (!parseMap(value)) return false; }
+        else if (key == "latency") { if (!parseLatency(value)) return false; }
+        else if (key == "drop") o.drop = number;
+        else if (key == "corrupt") o.corrupt = number;
+        else if (key == "noise") o.noise = number;
+        else if (key == "station-base") o.stationBase = std::atoll(value.c_str());
+        else if (key == "report-ms") o.reportMs = std::max(10.0, number);
+        else if (key == "center") o.center = static_cast<int>(number);
+        else if (key == "storm-every-s") o.stormEveryS = number;
+        else if (key == "storm-fraction") o.stormFraction = std::clamp(number, 0.0, 1.0);
+        else if (key == "reconnect-ms") o.reconnectMs = std::max(0.0, number);
+        else if (key == "duration-s") o.durationS = number;
+        else if (key == "report-s") o.reportS = std::max(1.0, number);
+        else {
+            std::cerr << "unknown or invalid option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void printReport(double elapsedS, double intervalS, std::map<std::string, uint64_t>& last) {
+    auto rate = [&](const char* name, const std::atomic<uint64_t>& counter) {
+        const uint64_t value = counter.load(std::memory_order_relaxed);
+        const double perSecond = static_cast<double>(value - last[name]) / intervalS;
+        last[name] = value;
+        return perSecond;
+    };
+
+    std::cout << std::fixed << std::setprecision(0)
+              << "[" << std::setw(5) << elapsedS << "s] connected=" << gStats.connected.load()
+              << " connects/s=" << rate("connects", gStats.connects)
+              << " closes/s=" << rate("disconnects", gStats.disconnects)
+              << " rx=" << std::setprecision(1) << rate("bytesRx", gStats.bytesRx) / 1024.0 << "KiB/s"
+              << " tx=" << rate("bytesTx", gStats.bytesTx) / 1024.0 << "KiB/s" << std::setprecision(0);
+    if (gOptions.protocol == Protocol::Modbus) {
+        std::cout << " polls/s=" << rate("requests", gStats.requests)
+                  << " responses/s=" << rate("responses", gStats.responses)
+                  << " dropped/s=" << rate("dropped", gStats.dropped)
+                  << " unparsed/s=" << rate("unparsed", gStats.unparsed);
+    } else {
+        std::cout << " reports/s=" << rate("reports", gStats.reports);
+    }
+    std::cout << " corrupted/s=" << rate("corrupted", gStats.corrupted) << "\n";
+
+    if (gOptions.protocol == Protocol::Modbus) {
+        auto line = [](const char* label, LatencyHistogram& histogram) {
+            const auto [count, p50, p90, p99, max] = histogram.take();
+            std::cout << "         " << label << " n=" << std::setprecision(0) << count
+                      << std::setprecision(1) << " p50<=" << p50 << "ms p90<=" << p90
+                      << "ms p99<=" << p99 << "ms max<=" << max << "ms\n";
+        };
+        line("turnaround ", gStats.turnaround);
+        line("first-poll ", gStats.firstPoll);
+    }
+    std::cout << std::flush;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (!parseArgs(argc, argv)) {
+        std::cerr << "usage: iot-dtu-swarm [--key=value ...]  (see bench/DtuSwarm.cpp for options)" << std::endl;
+        return 2;
+    }
+    const auto& o = gOptions;
+    trantor::Logger::setLogLevel(trantor::Logger::kError);
+    std::signal(SIGINT, [](int) { gStop.store(true); });
+    std::signal(SIGTERM, [](int) { gStop.store(true); });
+
+    trantor::EventLoopThreadPool pool(static_cast<size_t>(o.threads), "DtuSwarm");
+    pool.start();
+
+    std::cout << "dtus=" << o.dtus << " protocol=" << (o.protocol == Protocol::Modbus ? "modbus" : "sl651")
+              << (o.protocol == Protocol::Modbus ? (o.rtu ? "/rtu" : "/tcp") : "")
+              << " target=" << o.host << ":" << o.port << " threads=" << o.threads << std::endl;
+
+    std::vector<std::shared_ptr<Dtu>> dtus;
+    dtus.reserve(static_cast<size_t>(o.dtus));
+    const auto begin = Clock::now();
+    auto lastReport = begin;
+    auto lastStorm = begin;
+    std::map<std::string, uint64_t> last;
+    std::mt19937_64 stormRng{std::random_device{}()};
+
+    // Ramp-up, storms and reporting run on the main thread in 10ms steps
+    while (!gStop.load()) {
+        const auto now = Clock::now();
+        const double elapsedS = std::chrono::duration<double>(now - begin).count();
+        if (o.durationS > 0 && elapsedS >= o.durationS) break;
+
+        const auto target = std::min<size_t>(static_cast<size_t>(o.dtus), static_cast<size_t>(elapsedS * o.connectRate) + 1);
+        while (dtus.size() < target) {
+            auto* loop = pool.getNextLoop();
+            auto dtu = std::make_shared<Dtu>(loop, o.first + static_cast<int>(dtus.size()));
+            loop->queueInLoop([dtu]() { dtu->start(); });
+            dtus.push_back(std::move(dtu));
+        }
+
+        if (o.stormEveryS > 0 && std::chrono::duration<double>(now - lastStorm).count() >= o.stormEveryS) {
+            lastStorm = now;
+            size_t dropped = 0;
+            for (const auto& dtu : dtus) {
+                if (std::uniform_real_distribution<double>(0, 1)(stormRng) >= o.stormFraction) continue;
+                ++dropped;
+                dtu->drop();
+            }
+            std::cout << "storm: dropping " << dropped << " connections" << std::endl;
+        }
+
+        const double sinceReport = std::chrono::duration<double>(now - lastReport).count();
+        if (sinceReport >= o.reportS) {
+            printReport(elapsedS, sinceReport, last);
+            lastReport = now;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    gStop.store(true);
+    for (const auto& dtu : dtus) {
+        dtu->stop();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    printReport(std::chrono::duration<double>(Clock::now() - begin).count(),
+                std::max(0.001, std::chrono::duration<double>(Clock::now() - lastReport).count()), last);
+    for (size_t i = 0; i < pool.size(); ++i) {
+        pool.getLoop(i)->quit();
+    }
+    pool.wait();
+    return 0;
+}
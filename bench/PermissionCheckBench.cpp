@@ -0,0 +1,232 @@
+// Authorised-request permission check throughput, before and after snapshots.
+//
+//   iot-permission-bench <conninfo> <user-id> <device-id> [requests] [invalidate-every]
+//
+// Each simulated request checks one menu permission and device control access
+// for <user-id> against a live PostgreSQL with the iot-manager schema:
+//   sql      - the per-request path: permission join + device creator lookup +
+//              device share lookup, three prepared round trips per request
+//   snapshot - PermissionChecker::loadSnapshot's two queries run once, then
+//              every request is a hash lookup; the snapshot is rebuilt every
+//              [invalidate-every] requests to account for event invalidation
+//
+// Only SELECTs are issued.
+
+#include <libpq-fe.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+const char* kPermission = "iot:device:control";
+
+const char* kHasAny =
+    "SELECT "
+    "  COALESCE(MAX(CASE WHEN r.code = 'superadmin' THEN 1 ELSE 0 END), 0) as is_superadmin, "
+    "  COUNT(DISTINCT m.permission_code) as permission_count "
+    "FROM sys_user_role ur "
+    "INNER JOIN sys_role r ON ur.role_id = r.id "
+    "LEFT JOIN sys_role_menu rm ON r.id = rm.role_id "
+    "LEFT JOIN sys_menu m ON rm.menu_id = m.id "
+    "  AND m.permission_code = ANY($1::text[]) "
+    "  AND m.deleted_at IS NULL "
+    "WHERE ur.user_id = $2 "
+    "  AND r.status = 'enabled' "
+    "  AND r.deleted_at IS NULL";
+
+const char* kCreatedBy = "SELECT created_by FROM device WHERE id = $1 AND deleted_at IS NULL";
+
+const char* kShareScope =
+    "WITH share_scope AS ("
+    "  SELECT ds.device_id, "
+    "         COALESCE((ds.permission->>'control')::boolean, false) AS can_control, "
+    "         NULLIF(ds.permission->>'target_type', '') AS target_type, "
+    "         CASE WHEN (ds.permission->>'target_id') ~ '^[0-9]+$' "
+    "              THEN (ds.permission->>'target_id')::INT END AS target_id "
+    "  FROM device_share ds) ";
+
+const std::string kShareSingle = std::string(kShareScope) +
+    "SELECT ss.can_control FROM share_scope ss "
+    "LEFT JOIN sys_user su ON su.id = $1 AND su.deleted_at IS NULL "
+    "WHERE ss.device_id = $2 "
+    "  AND ((ss.target_type = 'user' AND ss.target_id = $1::int) "
+    "    OR (ss.target_type = 'department' AND su.department_id IS NOT NULL "
+    "        AND ss.target_id = su.department_id))";
+
+const char* kGrants =
+    "SELECT r.code AS role_code, m.permission_code "
+    "FROM sys_user_role ur "
+    "INNER JOIN sys_role r ON ur.role_id = r.id "
+    "LEFT JOIN sys_role_menu rm ON r.id = rm.role_id "
+    "LEFT JOIN sys_menu m ON rm.menu_id = m.id "
+    "  AND m.permission_code IS NOT NULL AND m.permission_code <> '' AND m.deleted_at IS NULL "
+    "WHERE ur.user_id = $1 AND r.status = 'enabled' AND r.deleted_at IS NULL";
+
+const std::string kShares = std::string(kShareScope) +
+    "SELECT ss.device_id, bool_or(ss.can_control) AS can_control FROM share_scope ss "
+    "LEFT JOIN sys_user su ON su.id = $1 AND su.deleted_at IS NULL "
+    "WHERE (ss.target_type = 'user' AND ss.target_id = $1::int) "
+    "   OR (ss.target_type = 'department' AND su.department_id IS NOT NULL "
+    "       AND ss.target_id = su.department_id) "
+    "GROUP BY ss.device_id";
+
+struct Snapshot {
+    bool isSuperAdmin = false;
+    std::unordered_set<std::string> permissionCodes;
+    std::unordered_map<int, bool> deviceShares;
+};
+
+PGresult* run(PGconn* conn, const char* name, const std::vector<std::string>& params) {
+    std::vector<const char*> values;
+    values.reserve(params.size());
+    for (const auto& p : params) {
+        values.push_back(p.c_str());
+    }
+    PGresult* result = PQexecPrepared(conn, name, static_cast<int>(values.size()), values.data(), nullptr, nullptr, 0);
+    if (PQresultStatus(result) != PGRES_TUPLES_OK) {
+        std::cerr << name << ": " << PQresultErrorMessage(result);
+        PQclear(result);
+        std::exit(1);
+    }
+    return result;
+}
+
+bool prepare(PGconn* conn, const char* name, const char* sql) {
+    PGresult* result = PQprepare(conn, name, sql, 0, nullptr);
+    const bool ok = PQresultStatus(result) == PGRES_COMMAND_OK;
+    if (!ok) {
+        std::cerr << "prepare " << name << ": " << PQresultErrorMessage(result);
+    }
+    PQclear(result);
+    return ok;
+}
+
+bool authoriseSql(PGconn* conn, const std::string& userId, const std::string& deviceId) {
+    PGresult* grants = run(conn, "has_any", {std::string("{") + kPermission + "}", userId});
+    const bool superAdmin = std::atoi(PQgetvalue(grants, 0, 0)) > 0;
+    const bool permitted = superAdmin || std::atoi(PQgetvalue(grants, 0, 1)) > 0;
+    PQclear(grants);
+    if (!permitted) {
+        return false;
+    }
+
+    PGresult* creator = run(conn, "created_by", {deviceId});
+    const bool owner = PQntuples(creator) > 0 && !PQgetisnull(creator, 0, 0) && userId == PQgetvalue(creator, 0, 0);
+    PQclear(creator);
+    if (superAdmin || owner) {
+        return true;
+    }
+
+    PGresult* share = run(conn, "share_single", {userId, deviceId});
+    bool control = false;
+    for (int i = 0; i < PQntuples(share); ++i) {
+        control = control || PQgetvalue(share, i, 0)[0] == 't';
+    }
+    PQclear(share);
+    return control;
+}
+
+Snapshot loadSnapshot(PGconn* conn, const std::string& userId) {
+    Snapshot snapshot;
+    PGresult* grants = run(conn, "grants", {userId});
+    for (int i = 0; i < PQntuples(grants); ++i) {
+        if (std::string(PQgetvalue(grants, i, 0)) == "superadmin") {
+            snapshot.isSuperAdmin = true;
+        }
+        if (!PQgetisnull(grants, i, 1)) {
+            snapshot.permissionCodes.insert(PQgetvalue(grants, i, 1));
+        }
+    }
+    PQclear(grants);
+
+    PGresult* shares = run(conn, "shares", {userId});
+    for (int i = 0; i < PQntuples(shares); ++i) {
+        snapshot.deviceShares[std::atoi(PQgetvalue(shares, i, 0))] = PQgetvalue(shares, i, 1)[0] == 't';
+    }
+    PQclear(shares);
+    return snapshot;
+}
+
+bool authoriseSnapshot(const Snapshot& snapshot, int userId, int deviceId, int creatorId) {
+    if (!snapshot.isSuperAdmin && snapshot.permissionCodes.count(kPermission) == 0) {
+        return false;
+    }
+    if (snapshot.isSuperAdmin || creatorId == userId) {
+        return true;
+    }
+    auto it = snapshot.deviceShares.find(deviceId);
+    return it != snapshot.deviceShares.end() && it->second;
+}
+
+void report(const char* label, std::size_t requests, std::size_t granted, double seconds) {
+    std::cout << std::left << std::setw(10) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << static_cast<double>(requests) / seconds << " req/s"
+              << std::setw(10) << seconds * 1e6 / static_cast<double>(requests) << " us/req"
+              << "  granted " << granted << "/" << requests << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "usage: iot-permission-bench <conninfo> <user-id> <device-id> [requests] [invalidate-every]"
+                  << std::endl;
+        return 2;
+    }
+    const std::string userId = argv[2];
+    const std::string deviceId = argv[3];
+    const auto requests = argc > 4 ? static_cast<std::size_t>(std::strtoull(argv[4], nullptr, 10)) : 5000;
+    const auto invalidateEvery = argc > 5 ? static_cast<std::size_t>(std::strtoull(argv[5], nullptr, 10)) : 1000;
+
+    PGconn* conn = PQconnectdb(argv[1]);
+    if (PQstatus(conn) != CONNECTION_OK) {
+        std::cerr << "connect failed: " << PQerrorMessage(conn);
+        PQfinish(conn);
+        return 1;
+    }
+    if (!prepare(conn, "has_any", kHasAny) || !prepare(conn, "created_by", kCreatedBy) ||
+        !prepare(conn, "share_single", kShareSingle.c_str()) || !prepare(conn, "grants", kGrants) ||
+        !prepare(conn, "shares", kShares.c_str())) {
+        PQfinish(conn);
+        return 1;
+    }
+
+    // The server reads the device creator from DeviceCache; resolve it once here
+    PGresult* creator = run(conn, "created_by", {deviceId});
+    const int creatorId = PQntuples(creator) > 0 && !PQgetisnull(creator, 0, 0) ? std::atoi(PQgetvalue(creator, 0, 0)) : 0;
+    PQclear(creator);
+
+    std::cout << "requests=" << requests << " invalidate-every=" << invalidateEvery << "\n";
+
+    std::size_t granted = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < requests; ++i) {
+        granted += authoriseSql(conn, userId, deviceId) ? 1 : 0;
+    }
+    report("sql", requests, granted,
+           std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+
+    granted = 0;
+    const int uid = std::atoi(userId.c_str());
+    const int did = std::atoi(deviceId.c_str());
+    begin = std::chrono::steady_clock::now();
+    Snapshot snapshot;
+    for (std::size_t i = 0; i < requests; ++i) {
+        if (invalidateEvery == 0 ? i == 0 : i % invalidateEvery == 0) {
+            snapshot = loadSnapshot(conn, userId);
+        }
+        granted += authoriseSnapshot(snapshot, uid, did, creatorId) ? 1 : 0;
+    }
+    report("snapshot", requests, granted,
+           std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+
+    PQfinish(conn);
+    return 0;
+}
@@ -0,0 +1,255 @@
+// Prepared statement microbenchmark for the hot SQL paths.
+//
+//   iot-prepared-stmt-bench <conninfo> [iterations]
+//
+// Runs each hot query two ways against a live PostgreSQL with the iot-manager
+// schema applied:
+//   text     - SQL rebuilt per call (IN lists / multi-row VALUES expanded to
+//              the input size) and sent with PQexecParams, so the server
+//              parses and plans every execution
+//   prepared - the fixed-text shape from PreparedStatementRegistry (arrays +
+//              ANY / unnest), prepared once and run with PQexecPrepared
+//
+// Ingest rows go to a TEMP table, so nothing is written to device_data.
+
+#include <libpq-fe.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* kPermissionTextPrefix =
+    "SELECT "
+    "  COALESCE(MAX(CASE WHEN r.code = $1 THEN 1 ELSE 0 END), 0) as is_superadmin, "
+    "  COUNT(DISTINCT m.permission_code) as permission_count "
+    "FROM sys_user_role ur "
+    "INNER JOIN sys_role r ON ur.role_id = r.id "
+    "LEFT JOIN sys_role_menu rm ON r.id = rm.role_id "
+    "LEFT JOIN sys_menu m ON rm.menu_id = m.id "
+    "  AND m.permission_code IN (";
+
+const char* kPermissionPrepared =
+    "SELECT "
+    "  COALESCE(MAX(CASE WHEN r.code = $1 THEN 1 ELSE 0 END), 0) as is_superadmin, "
+    "  COUNT(DISTINCT m.permission_code) as permission_count "
+    "FROM sys_user_role ur "
+    "INNER JOIN sys_role r ON ur.role_id = r.id "
+    "LEFT JOIN sys_role_menu rm ON r.id = rm.role_id "
+    "LEFT JOIN sys_menu m ON rm.menu_id = m.id "
+    "  AND m.permission_code = ANY($2::text[]) "
+    "  AND m.deleted_at IS NULL "
+    "WHERE ur.user_id = $3 "
+    "  AND r.status = 'enabled' "
+    "  AND r.deleted_at IS NULL";
+
+const char* kIngestPrepared =
+    "INSERT INTO bench_device_data (device_id, link_id, protocol, data, report_time) "
+    "SELECT t.device_id, t.link_id, t.protocol, t.data, t.report_time "
+    "FROM unnest($1::int[], $2::int[], $3::text[], $4::jsonb[], $5::timestamptz[]) "
+    "     WITH ORDINALITY AS t(device_id, link_id, protocol, data, report_time, ord) "
+    "ORDER BY t.ord "
+    "RETURNING id";
+
+const std::vector<std::string> kPermissions = {"iot:device:query", "iot:device:edit", "iot:device:control"};
+const std::vector<std::size_t> kBatchSizes = {1, 7, 32, 100, 3, 64};
+const char* kPayload = R"({"funcCode":"32","direction":"UP","data":{"39":{"name":"water level","value":"1.23","unit":"m"}}})";
+
+bool ok(PGresult* result, const char* what) {
+    const auto status = PQresultStatus(result);
+    if (status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK) {
+        PQclear(result);
+        return true;
+    }
+    std::cerr << what << ": " << PQresultErrorMessage(result);
+    PQclear(result);
+    return false;
+}
+
+std::string quoteArray(const std::vector<std::string>& values) {
+    std::string out = "{";
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (i > 0) {
+            out += ',';
+        }
+        out += '"';
+        for (char c : values[i]) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+            }
+            out += c;
+        }
+        out += '"';
+    }
+    return out + "}";
+}
+
+PGresult* execParams(PGconn* conn, const std::string& sql, const std::vector<std::string>& params) {
+    std::vector<const char*> values;
+    values.reserve(params.size());
+    for (const auto& p : params) {
+        values.push_back(p.c_str());
+    }
+    return PQexecParams(conn, sql.c_str(), static_cast<int>(values.size()), nullptr, values.data(), nullptr, nullptr, 0);
+}
+
+PGresult* execPrepared(PGconn* conn, const char* name, const std::vector<std::string>& params) {
+    std::vector<const char*> values;
+    values.reserve(params.size());
+    for (const auto& p : params) {
+        values.push_back(p.c_str());
+    }
+    return PQexecPrepared(conn, name, static_cast<int>(values.size()), values.data(), nullptr, nullptr, 0);
+}
+
+bool permissionText(PGconn* conn) {
+    std::string sql = kPermissionTextPrefix;
+    std::vector<std::string> params = {"superadmin"};
+    for (std::size_t i = 0; i < kPermissions.size(); ++i) {
+        sql += (i > 0 ? ", $" : "$") + std::to_string(i + 2);
+        params.push_back(kPermissions[i]);
+    }
+    sql += ")   AND m.deleted_at IS NULL WHERE ur.user_id = $" + std::to_string(params.size() + 1) +
+           "   AND r.status = 'enabled'   AND r.deleted_at IS NULL";
+    params.emplace_back("1");
+    return ok(execParams(conn, sql, params), "permission text");
+}
+
+bool permissionPrepared(PGconn* conn) {
+    return ok(execPrepared(conn, "permission_has_any", {"superadmin", quoteArray(kPermissions), "1"}),
+              "permission prepared");
+}
+
+struct Batch {
+    std::vector<std::string> deviceIds, linkIds, protocols, payloads, reportTimes;
+};
+
+Batch makeBatch(std::size_t rows) {
+    Batch batch;
+    for (std::size_t i = 0; i < rows; ++i) {
+        batch.deviceIds.push_back(std::to_string(1 + i % 50));
+        batch.linkIds.emplace_back("1");
+        batch.protocols.emplace_back("SL651");
+        batch.payloads.emplace_back(kPayload);
+        batch.reportTimes.emplace_back("2026-01-01 08:00:00+08");
+    }
+    return batch;
+}
+
+bool ingestText(PGconn* conn, const Batch& batch) {
+    std::string sql = "INSERT INTO bench_device_data (device_id, link_id, protocol, data, report_time) VALUES ";
+    std::vector<std::string> params;
+    for (std::size_t i = 0; i < batch.deviceIds.size(); ++i) {
+        const auto base = i * 5;
+        sql += (i > 0 ? ", ($" : "($") + std::to_string(base + 1) + ", $" + std::to_string(base + 2) + ", $" +
+               std::to_string(base + 3) + ", $" + std::to_string(base + 4) + "::jsonb, $" +
+               std::to_string(base + 5) + "::timestamptz)";
+        params.push_back(batch.deviceIds[i]);
+        params.push_back(batch.linkIds[i]);
+        params.push_back(batch.protocols[i]);
+        params.push_back(batch.payloads[i]);
+        params.push_back(batch.reportTimes[i]);
+    }
+    sql += " RETURNING id";
+    return ok(execParams(conn, sql, params), "ingest text");
+}
+
+bool ingestPrepared(PGconn* conn, const Batch& batch) {
+    std::string ids = "{", links = "{";
+    for (std::size_t i = 0; i < batch.deviceIds.size(); ++i) {
+        ids += (i > 0 ? "," : "") + batch.deviceIds[i];
+        links += (i > 0 ? "," : "") + batch.linkIds[i];
+    }
+    ids += "}";
+    links += "}";
+    return ok(execPrepared(conn, "device_data_insert_batch",
+                           {ids, links, quoteArray(batch.protocols), quoteArray(batch.payloads),
+                            quoteArray(batch.reportTimes)}),
+              "ingest prepared");
+}
+
+struct Stats {
+    double meanUs{0};
+    double p50Us{0};
+    double p99Us{0};
+};
+
+Stats measure(std::size_t iterations, const std::function<bool(std::size_t)>& fn) {
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (std::size_t i = 0; i < iterations; ++i) {
+        const auto begin = std::chrono::steady_clock::now();
+        if (!fn(i)) {
+            std::exit(1);
+        }
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    Stats stats;
+    for (double s : samples) {
+        stats.meanUs += s;
+    }
+    stats.meanUs /= static_cast<double>(samples.size());
+    stats.p50Us = samples[samples.size() / 2];
+    stats.p99Us = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    return stats;
+}
+
+void report(const char* label, const Stats& stats) {
+    std::cout << std::left << std::setw(22) << label << std::right << std::fixed << std::setprecision(1)
+              << " mean " << std::setw(8) << stats.meanUs << " us"
+              << "  p50 " << std::setw(8) << stats.p50Us << " us"
+              << "  p99 " << std::setw(8) << stats.p99Us << " us\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: iot-prepared-stmt-bench <conninfo> [iterations]" << std::endl;
+        return 2;
+    }
+    const auto iterations = argc > 2 ? static_cast<std::size_t>(std::strtoull(argv[2], nullptr, 10)) : 2000;
+
+    PGconn* conn = PQconnectdb(argv[1]);
+    if (PQstatus(conn) != CONNECTION_OK) {
+        std::cerr << "connect failed: " << PQerrorMessage(conn);
+        PQfinish(conn);
+        return 1;
+    }
+
+    const bool ready =
+        ok(PQexec(conn, "CREATE TEMP TABLE bench_device_data (id BIGSERIAL, device_id INT, link_id INT, "
+                        "protocol TEXT, data JSONB, report_time TIMESTAMPTZ)"),
+           "create temp table") &&
+        ok(PQprepare(conn, "permission_has_any", kPermissionPrepared, 0, nullptr), "prepare permission") &&
+        ok(PQprepare(conn, "device_data_insert_batch", kIngestPrepared, 0, nullptr), "prepare ingest");
+    if (!ready) {
+        PQfinish(conn);
+        return 1;
+    }
+
+    std::vector<Batch> batches;
+    for (auto rows : kBatchSizes) {
+        batches.push_back(makeBatch(rows));
+    }
+
+    std::cout << "iterations=" << iterations << "\n";
+    report("permission text", measure(iterations, [&](std::size_t) { return permissionText(conn); }));
+    report("permission prepared", measure(iterations, [&](std::size_t) { return permissionPrepared(conn); }));
+    report("ingest text", measure(iterations, [&](std::size_t i) {
+        return ingestText(conn, batches[i % batches.size()]);
+    }));
+    report("ingest prepared", measure(iterations, [&](std::size_t i) {
+        return ingestPrepared(conn, batches[i % batches.size()]);
+    }));
+
+    PQfinish(conn);
+    return 0;
+}
@@ -0,0 +1,243 @@
+// GB28181 SIP parse microbenchmark.
+//
+//   iot-sip-parse-bench [capture-dir] [iterations]
+//
+// capture-dir holds one raw SIP packet per *.sip file (e.g. Wireshark
+// "Export Packet Bytes" of UDP payloads). Without it a small built-in set of
+// device packets is used, weighted like real traffic (mostly keepalives).
+
+#include "sip/ManscdpScanner.h"
+#include "sip/SipMessage.h"
+
+#include <pugixml.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const char* kKeepalive =
+    "MESSAGE sip:34020000002000000001@3402000000 SIP/2.0\r\n"
+    "Via: SIP/2.0/UDP 192.168.1.64:5060;rport;branch=z9hG4bK1433263451\r\n"
+    "From: <sip:34020000001320000001@3402000000>;tag=1918452213\r\n"
+    "To: <sip:34020000002000000001@3402000000>\r\n"
+    "Call-ID: 1209421925\r\n"
+    "CSeq: 20 MESSAGE\r\n"
+    "Content-Type: Application/MANSCDP+xml\r\n"
+    "Max-Forwards: 70\r\n"
+    "User-Agent: IP Camera\r\n"
+    "Content-Length: 178\r\n"
+    "\r\n"
+    "<?xml version=\"1.0\" encoding=\"GB2312\"?>\r\n"
+    "<Notify>\r\n"
+    "<CmdType>Keepalive</CmdType>\r\n"
+    "<SN>43</SN>\r\n"
+    "<DeviceID>34020000001320000001</DeviceID>\r\n"
+    "<Status>OK</Status>\r\n"
+    "</Notify>\r\n";
+
+const char* kRegister =
+    "REGISTER sip:34020000002000000001@3402000000 SIP/2.0\r\n"
+    "Via: SIP/2.0/UDP 192.168.1.64:5060;rport;branch=z9hG4bK1926137593\r\n"
+    "From: <sip:34020000001320000001@3402000000>;tag=1136249424\r\n"
+    "To: <sip:34020000001320000001@3402000000>\r\n"
+    "Call-ID: 1540428612\r\n"
+    "CSeq: 2 REGISTER\r\n"
+    "Contact: <sip:34020000001320000001@192.168.1.64:5060>\r\n"
+    "Authorization: Digest username=\"34020000001320000001\", realm=\"3402000000\", "
+    "nonce=\"9bd055\", uri=\"sip:34020000002000000001@3402000000\", "
+    "response=\"0b5e9c9e8f2a1f9d4c1f0e4d5b9a8c7d\", algorithm=MD5\r\n"
+    "Max-Forwards: 70\r\n"
+    "User-Agent: IP Camera\r\n"
+    "Expires: 3600\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+const char* kCatalog =
+    "MESSAGE sip:34020000002000000001@3402000000 SIP/2.0\r\n"
+    "Via: SIP/2.0/UDP 192.168.1.64:5060;rport;branch=z9hG4bK803366924\r\n"
+    "From: <sip:34020000001320000001@3402000000>;tag=1581520392\r\n"
+    "To: <sip:34020000002000000001@3402000000>\r\n"
+    "Call-ID: 1011476396\r\n"
+    "CSeq: 21 MESSAGE\r\n"
+    "Content-Type: Application/MANSCDP+xml\r\n"
+    "Content-Length: 520\r\n"
+    "\r\n"
+    "<?xml version=\"1.0\" encoding=\"GB2312\"?>\r\n"
+    "<Response>\r\n"
+    "<CmdType>Catalog</CmdType>\r\n"
+    "<SN>2</SN>\r\n"
+    "<DeviceID>34020000001320000001</DeviceID>\r\n"
+    "<SumNum>1</SumNum>\r\n"
+    "<DeviceList Num=\"1\">\r\n"
+    "<Item>\r\n"
+    "<DeviceID>34020000001310000001</DeviceID>\r\n"
+    "<Name>Camera 01</Name>\r\n"
+    "<Manufacturer>Vendor</Manufacturer>\r\n"
+    "<Status>ON</Status>\r\n"
+    "<Info><PTZType>1</PTZType></Info>\r\n"
+    "</Item>\r\n"
+    "</DeviceList>\r\n"
+    "</Response>\r\n";
+
+// The parser this module used before the string_view rewrite, kept here so
+// both paths run over the same input.
+struct LegacySipMessage {
+    std::string startLine;
+    std::string method;
+    std::string requestUri;
+    int statusCode{0};
+    std::string reasonPhrase;
+    std::unordered_map<std::string, std::string> headers;
+    std::string body;
+};
+
+std::string legacyTrim(std::string value) {
+    const auto notSpace = [](unsigned char c) { return !std::isspace(c); };
+    value.erase(value.begin(), std::find_if(value.begin(), value.end(), notSpace));
+    value.erase(std::find_if(value.rbegin(), value.rend(), notSpace).base(), value.end());
+    return value;
+}
+
+std::string legacyLower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return value;
+}
+
+std::optional<LegacySipMessage> legacyParse(const std::string& raw) {
+    const auto headerEnd = raw.find("\r\n\r\n");
+    if (headerEnd == std::string::npos) {
+        return std::nullopt;
+    }
+    LegacySipMessage message;
+    message.body = raw.substr(headerEnd + 4);
+    std::istringstream lines(raw.substr(0, headerEnd));
+    if (!std::getline(lines, message.startLine)) {
+        return std::nullopt;
+    }
+    if (!message.startLine.empty() && message.startLine.back() == '\r') {
+        message.startLine.pop_back();
+    }
+    std::istringstream start(message.startLine);
+    if (message.startLine.rfind("SIP/2.0", 0) == 0) {
+        std::string version;
+        start >> version >> message.statusCode;
+        std::getline(start, message.reasonPhrase);
+        message.reasonPhrase = legacyTrim(message.reasonPhrase);
+    } else {
+        start >> message.method >> message.requestUri;
+    }
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        const auto colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        message.headers[legacyLower(legacyTrim(line.substr(0, colon)))] = legacyTrim(line.substr(colon + 1));
+    }
+    return message;
+}
+
+std::size_t runLegacy(const std::string& packet) {
+    auto message = legacyParse(packet);
+    if (!message) {
+        return 0;
+    }
+    std::size_t sink = message->headers["call-id"].size() + message->headers["cseq"].size();
+    if (message->method == "MESSAGE") {
+        pugi::xml_document document;
+        document.load_string(message->body.c_str());
+        const auto root = document.first_child();
+        sink += std::string(root.child("CmdType").text().as_string()).size();
+        sink += std::string(root.child("DeviceID").text().as_string()).size();
+    }
+    return sink;
+}
+
+std::size_t runCurrent(const std::string& packet) {
+    const auto message = SipMessage::parse(packet);
+    if (!message) {
+        return 0;
+    }
+    std::size_t sink = message->headerView("Call-ID").size() + message->headerView("CSeq").size();
+    if (message->method == "MESSAGE") {
+        if (const auto keepalive = ManscdpScanner::scanKeepalive(message->body)) {
+            return sink + keepalive->deviceId.size() + keepalive->status.size();
+        }
+        pugi::xml_document document;
+        document.load_buffer(message->body.data(), message->body.size());
+        const auto root = document.first_child();
+        sink += std::string(root.child("CmdType").text().as_string()).size();
+        sink += std::string(root.child("DeviceID").text().as_string()).size();
+    }
+    return sink;
+}
+
+std::vector<std::string> loadCapture(const std::filesystem::path& directory) {
+    std::vector<std::string> packets;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".sip") {
+            continue;
+        }
+        std::ifstream input(entry.path(), std::ios::binary);
+        packets.emplace_back(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+    return packets;
+}
+
+template <typename Fn>
+double measure(const std::vector<std::string>& packets, std::size_t iterations, Fn&& fn, std::size_t& sink) {
+    const auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        for (const auto& packet : packets) {
+            sink += fn(packet);
+        }
+    }
+    const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    return elapsed / static_cast<double>(iterations * packets.size());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> packets;
+    if (argc > 1) {
+        packets = loadCapture(argv[1]);
+    } else {
+        for (int i = 0; i < 18; ++i) {
+            packets.emplace_back(kKeepalive);
+        }
+        packets.emplace_back(kRegister);
+        packets.emplace_back(kCatalog);
+    }
+    if (packets.empty()) {
+        std::cerr << "no *.sip packets found" << std::endl;
+        return 1;
+    }
+    const auto iterations = argc > 2 ? static_cast<std::size_t>(std::strtoull(argv[2], nullptr, 10)) : 50000;
+
+    std::size_t sink = 0;
+    const auto legacyNs = measure(packets, iterations, runLegacy, sink);
+    const auto currentNs = measure(packets, iterations, runCurrent, sink);
+
+    std::cout << "packets=" << packets.size() << " iterations=" << iterations << "\n"
+              << "legacy  (owned strings + DOM): " << legacyNs << " ns/packet\n"
+              << "current (string_view + scan):  " << currentNs << " ns/packet\n"
+              << "speedup: " << legacyNs / currentNs << "x (sink=" << sink << ")\n";
+    return 0;
+}
@@ -13,6 +13,7 @@
 #include "common/utils/Constants.hpp"
 #include "modules/alert/AlertEngine.hpp"
 #include "modules/gb28181/Gb28181Module.hpp"
+#include "modules/home/DashboardEventHandlers.hpp"
 #include "modules/link/Link.Service.hpp"
 #include "modules/link/domain/LinkEventHandlers.hpp"
 #include "modules/open/OpenWebhookEventHandlers.hpp"
@@ -95,6 +96,7 @@ public:
         LinkEventHandlers::registerAll();
         WsEventHandlers::registerAll();
         OpenWebhookEventHandlers::registerAll();
+        DashboardEventHandlers::registerAll();
     }
 };
 
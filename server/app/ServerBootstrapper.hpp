@@ -3,12 +3,20 @@
 #include "ApplicationModule.hpp"
 #include "RuntimeModules.hpp"
 
+#include "common/cache/AuthCache.hpp"
 #include "common/cache/DeviceCache.hpp"
+#include "common/cache/RealtimeDataCache.hpp"
 #include "common/cache/ResourceVersion.hpp"
 #include "common/database/DatabaseInitializer.hpp"
 #include "common/database/DatabaseService.hpp"
 #include "common/domain/EventBus.hpp"
 #include "common/edgenode/AgentBridgeManager.hpp"
+#include "common/network/FrameTrace.hpp"
+#include "common/network/TcpLinkManager.hpp"
+#include "common/utils/LoopWatchdog.hpp"
+#include "common/utils/MemoryMonitor.hpp"
+#include "modules/home/DashboardStats.hpp"
+#include "modules/home/MonitorSampler.hpp"
 
 #include <drogon/drogon.h>
 
@@ -61,6 +69,11 @@ public:
             co_await dbHealthCheck.ping();
         });
 
+        co_await runStage("database:replica-router", []() -> drogon::Task<> {
+            ReplicaRouter::instance().start();
+            co_return;
+        });
+
         co_await runStage("database:initialize", []() -> drogon::Task<> {
             co_await DatabaseInitializer::initialize();
         });
@@ -74,14 +87,19 @@ public:
             co_await DeviceCache::instance().getDevices();
         });
 
+        co_await runStage("network:frame-trace", []() -> drogon::Task<> {
+            FrameTrace::instance().configure();
+            co_return;
+        });
+
         co_await runStage("protocol:initialize", [this]() -> drogon::Task<> {
             co_await module("protocol").start();
         });
 
         co_await runStage("resource-version:reset", []() -> drogon::Task<> {
             ResourceVersion::instance().resetAll({
-                "device", "user", "role", "menu", "department", "link",
-                "protocol", "alert", "deviceGroup", "agent"
+                "device", "device:data", "user", "role", "menu", "department", "link",
+                "link:status", "protocol", "alert", "deviceGroup", "agent"
             });
             co_return;
         });
@@ -90,6 +108,27 @@ public:
             co_await module("alert").start();
         });
 
+        co_await runStage("dashboard:seed", []() -> drogon::Task<> {
+            co_await DashboardStats::instance().start();
+        });
+
+        co_await runStage("monitor:loop-watchdog", []() -> drogon::Task<> {
+            registerWatchedLoops();
+            LoopWatchdog::instance().start();
+            co_return;
+        });
+
+        co_await runStage("monitor:sampler", []() -> drogon::Task<> {
+            MonitorSampler::instance().start();
+            co_return;
+        });
+
+        co_await runStage("monitor:memory", []() -> drogon::Task<> {
+            registerMemorySubsystems();
+            MemoryMonitor::instance().start();
+            co_return;
+        });
+
         co_await runStage("agent:reset-online-status", []() -> drogon::Task<> {
             co_await AgentBridgeManager::instance().resetOnStartup();
         });
@@ -101,15 +140,70 @@ public:
     }
 
     drogon::Task<> stop() {
+        LoopWatchdog::instance().stop();
+        MemoryMonitor::instance().stop();
         co_await module("gb28181").stop();
         co_await module("alert").stop();
         co_await module("link").stop();
+        co_await AgentBridgeManager::instance().flushPendingWrites();
+        DashboardStats::instance().stop();
+        MonitorSampler::instance().stop();
+        ReplicaRouter::instance().stop();
         EventBus::instance().unsubscribeAll();
         DeviceCache::instance().invalidate();
         co_return;
     }
 
 private:
+    /**
+     * @brief 登记卡顿监测的循环：Drogon 主循环与 IO 线程（含攒批写入 fixed(0)）、
+     * TcpIoPool（链路收发、协议维护、轮询调度、GB28181 SIP 均运行于此）
+     */
+    static void registerWatchedLoops() {
+        auto& watchdog = LoopWatchdog::instance();
+        watchdog.registerLoop("drogon-main", drogon::app().getLoop());
+        const size_t ioThreads = drogon::app().getThreadNum();
+        for (size_t i = 0; i < ioThreads; ++i) {
+            watchdog.registerLoop("drogon-io-" + std::to_string(i), drogon::app().getIOLoop(i));
+        }
+        const auto tcpLoops = TcpLinkManager::instance().getIoLoops();
+        for (size_t i = 0; i < tcpLoops.size(); ++i) {
+            watchdog.registerLoop("tcp-io-" + std::to_string(i), tcpLoops[i]);
+        }
+    }
+
+    /**
+     * @brief 登记内存统计的子系统；只有能从数据库回源重建的缓存提供裁剪
+     */
+    static void registerMemorySubsystems() {
+        auto& monitor = MemoryMonitor::instance();
+        monitor.registerSubsystem("device_cache", [] {
+            return DeviceCache::instance().approximateBytes();
+        });
+        monitor.registerSubsystem("realtime_cache", [] {
+            return RealtimeDataCache::instance().approximateBytes();
+        }, [] {
+            RealtimeDataCache::instance().invalidateAll();
+        });
+        monitor.registerSubsystem("auth_cache", [] {
+            return AuthCache::approximateBytes();
+        }, [] {
+            AuthCache::trim();
+        });
+        monitor.registerSubsystem("result_batches", [] {
+            return ProtocolDispatcher::instance().pendingResultBytes();
+        });
+        monitor.registerSubsystem("session_buffers", [] {
+            return ProtocolDispatcher::instance().sessionBufferBytes();
+        });
+        monitor.registerSubsystem("agent_sessions", [] {
+            return AgentBridgeManager::instance().approximateBytes();
+        });
+        monitor.registerSubsystem("gb28181_registries", [] {
+            return Gb28181Module::instance().approximateBytes();
+        });
+    }
+
     ServerBootstrapper() {
         modules_.push_back(std::make_unique<Gb28181RuntimeModule>());
         modules_.push_back(std::make_unique<ProtocolRuntimeModule>());
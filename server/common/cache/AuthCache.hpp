@@ -4,16 +4,48 @@
 #include <openssl/sha.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <iomanip>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <shared_mutex>
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "common/utils/Constants.hpp"
+#include "common/utils/MemoryFootprint.hpp"
+
+/**
+ * @brief 用户权限快照
+ *
+ * 一次加载用户的超管标记、权限码集合和设备分享授权，之后权限检查只做哈希查找。
+ * 由 PermissionChecker 构建，存放在 AuthCache 中，用户/角色/菜单/部门/分享变更时
+ * 经 EventBus 内置副作用失效。
+ */
+struct PermissionSnapshot {
+    bool isSuperAdmin = false;
+    std::unordered_set<std::string> permissionCodes;
+    std::unordered_map<int, bool> deviceShares;  // deviceId -> 是否可控制
+
+    bool hasAny(const std::vector<std::string>& required) const {
+        if (isSuperAdmin || required.empty()) return true;
+        return std::any_of(required.begin(), required.end(), [this](const std::string& code) {
+            return permissionCodes.count(code) > 0;
+        });
+    }
+
+    /** @return "control" / "view" / ""（未分享） */
+    std::string sharePermission(int deviceId) const {
+        auto it = deviceShares.find(deviceId);
+        if (it == deviceShares.end()) return "";
+        return it->second ? "control" : "view";
+    }
+};
 
 class AuthCache {
 public:
@@ -56,18 +88,6 @@ public:
         co_return eraseJson("user:roles:" + std::to_string(userId));
     }
 
-    Task<bool> cacheUserMenus(int userId, const Json::Value& menus) {
-        co_return setJson("user:menus:" + std::to_string(userId), menus, userMenusTtl_);
-    }
-
-    Task<std::optional<Json::Value>> getUserMenus(int userId) {
-        co_return getJson("user:menus:" + std::to_string(userId));
-    }
-
-    Task<bool> deleteUserMenus(int userId) {
-        co_return eraseJson("user:menus:" + std::to_string(userId));
-    }
-
     Task<bool> cacheAllMenus(const Json::Value& menus) {
         co_return setJson("menu:all", menus, userMenusTtl_);
     }
@@ -133,20 +153,58 @@ public:
         co_return getCounter("login:failed:ip:" + ip);
     }
 
+    std::shared_ptr<const PermissionSnapshot> getPermissionSnapshot(int userId) const {
+        std::shared_lock lock(permissionMutex_);
+        auto it = permissionSnapshots_.find(userId);
+        if (it == permissionSnapshots_.end() || isExpired(it->second.expiresAt)) {
+            return nullptr;
+        }
+        return it->second.snapshot;
+    }
+
+    /**
+     * @brief 当前失效代数（构建快照前读取，写入时比对）
+     */
+    static uint64_t permissionGeneration() {
+        return permissionGeneration_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 写入权限快照
+     *
+     * 构建期间发生过失效（代数变化）时丢弃，避免把失效前读到的旧权限写回缓存。
+     */
+    bool cachePermissionSnapshot(int userId, std::shared_ptr<const PermissionSnapshot> snapshot,
+                                 uint64_t generation) {
+        std::unique_lock lock(permissionMutex_);
+        if (permissionGeneration_.load(std::memory_order_acquire) != generation) {
+            return false;
+        }
+        permissionSnapshots_[userId] = {std::move(snapshot), makeExpiry(userRolesTtl_)};
+        return true;
+    }
+
+    void deletePermissionSnapshot(int userId) {
+        std::unique_lock lock(permissionMutex_);
+        permissionGeneration_.fetch_add(1, std::memory_order_acq_rel);
+        permissionSnapshots_.erase(userId);
+    }
+
+    int clearAllPermissionSnapshots() {
+        std::unique_lock lock(permissionMutex_);
+        permissionGeneration_.fetch_add(1, std::memory_order_acq_rel);
+        auto count = static_cast<int>(permissionSnapshots_.size());
+        permissionSnapshots_.clear();
+        return count;
+    }
+
     Task<void> clearUserCache(int userId) {
         co_await deleteUserSession(userId);
         co_await deleteUserRoles(userId);
-        co_await deleteUserMenus(userId);
+        deletePermissionSnapshot(userId);
         LOG_INFO << "Cleared all auth cache for user: " << userId;
     }
 
-    Task<int> clearAllUserMenusCache() {
-        co_await deleteAllMenus();
-        auto count = eraseJsonByPrefix("user:menus:");
-        LOG_INFO << "Cleared menu cache for " << count << " users";
-        co_return count;
-    }
-
     Task<int> clearAllUserRolesCache() {
         auto count = eraseJsonByPrefix("user:roles:");
         LOG_INFO << "Cleared role cache for " << count << " users";
@@ -159,6 +217,63 @@ public:
         co_return count;
     }
 
+    /**
+     * @brief 内存紧张时裁剪：丢弃会话/角色/菜单 JSON 与权限快照
+     *
+     * 这些都会在下次访问时回源重建；令牌黑名单与登录失败计数无法重建，只清过期项
+     * （过期项平时只在再次访问时惰性删除，不再访问的键会一直占用）。
+     */
+    static void trim() {
+        purgeExpired();
+        {
+            std::unique_lock lock(jsonCacheMutex_);
+            jsonCache_.clear();
+        }
+        std::unique_lock lock(permissionMutex_);
+        permissionGeneration_.fetch_add(1, std::memory_order_acq_rel);
+        permissionSnapshots_.clear();
+    }
+
+    /**
+     * @brief 近似占用字节数（见 MemoryFootprint.hpp）
+     */
+    static size_t approximateBytes() {
+        size_t bytes = 0;
+        {
+            std::shared_lock lock(jsonCacheMutex_);
+            bytes += memory::hashBytes(jsonCache_);
+            for (const auto& [key, entry] : jsonCache_) {
+                bytes += memory::heapBytes(key) + memory::jsonBytes(entry.value) - sizeof(Json::Value);
+            }
+        }
+        {
+            std::shared_lock lock(tokenBlacklistMutex_);
+            bytes += memory::hashBytes(tokenBlacklist_);
+            for (const auto& [key, _] : tokenBlacklist_) {
+                bytes += memory::heapBytes(key);
+            }
+        }
+        {
+            std::shared_lock lock(countersMutex_);
+            bytes += memory::hashBytes(counters_);
+            for (const auto& [key, _] : counters_) {
+                bytes += memory::heapBytes(key);
+            }
+        }
+        std::shared_lock lock(permissionMutex_);
+        bytes += memory::hashBytes(permissionSnapshots_);
+        for (const auto& [_, entry] : permissionSnapshots_) {
+            if (!entry.snapshot) continue;
+            bytes += sizeof(PermissionSnapshot)
+                   + memory::hashBytes(entry.snapshot->permissionCodes)
+                   + memory::hashBytes(entry.snapshot->deviceShares);
+            for (const auto& code : entry.snapshot->permissionCodes) {
+                bytes += memory::heapBytes(code);
+            }
+        }
+        return bytes;
+    }
+
 private:
     using Clock = std::chrono::steady_clock;
     using TimePoint = Clock::time_point;
@@ -177,6 +292,11 @@ private:
         TimePoint expiresAt;
     };
 
+    struct PermissionEntry {
+        std::shared_ptr<const PermissionSnapshot> snapshot;
+        TimePoint expiresAt;
+    };
+
     int userSessionTtl_;
     int userMenusTtl_;
     int userRolesTtl_;
@@ -187,6 +307,9 @@ private:
     inline static std::shared_mutex jsonCacheMutex_;
     inline static std::shared_mutex tokenBlacklistMutex_;
     inline static std::shared_mutex countersMutex_;
+    inline static std::unordered_map<int, PermissionEntry> permissionSnapshots_;
+    inline static std::shared_mutex permissionMutex_;
+    inline static std::atomic<uint64_t> permissionGeneration_{0};
 
     static TimePoint makeExpiry(int ttlSeconds) {
         return Clock::now() + std::chrono::seconds(std::max(1, ttlSeconds));
@@ -196,6 +319,20 @@ private:
         return Clock::now() >= expiresAt;
     }
 
+    static size_t purgeExpired() {
+        const auto now = Clock::now();
+        size_t count = 0;
+        auto purge = [&](auto& map, auto& mutex) {
+            std::unique_lock lock(mutex);
+            count += std::erase_if(map, [&](const auto& item) { return now >= item.second.expiresAt; });
+        };
+        purge(jsonCache_, jsonCacheMutex_);
+        purge(tokenBlacklist_, tokenBlacklistMutex_);
+        purge(counters_, countersMutex_);
+        purge(permissionSnapshots_, permissionMutex_);
+        return count;
+    }
+
     static std::string hashToken(const std::string& token) {
         unsigned char hash[SHA256_DIGEST_LENGTH];
         SHA256(reinterpret_cast<const unsigned char*>(token.data()), token.size(), hash);
@@ -5,10 +5,14 @@
 #include "common/utils/FieldHelper.hpp"
 #include "common/utils/DeviceConnectionStateHelper.hpp"
 #include "common/utils/DrogonLoopSelector.hpp"
+#include "common/utils/MemoryFootprint.hpp"
 
 #include <algorithm>
+#include <deque>
 #include <initializer_list>
 #include <optional>
+#include <type_traits>
+#include <unordered_set>
 
 /**
  * @brief 设备缓存服务
@@ -23,6 +27,7 @@ public:
     // 缓存的设备信息
     struct CachedDevice {
         int id;
+        uint32_t slot = 0;  // 稠密下标：设备在缓存中存续期间不变，供可见性位图使用
         std::string name;
         std::string deviceCode;
         int createdBy = 0;
@@ -65,21 +70,36 @@ public:
         return instance;
     }
 
+    // 稠密下标表项：deviceId 为 0 表示空闲槽位
+    struct SlotEntry {
+        int deviceId = 0;
+        int createdBy = 0;
+    };
+
     /**
      * @brief 获取缓存的设备列表
+     */
+    Task<std::vector<CachedDevice>> getDevices() {
+        co_await ensureFresh();
+        std::shared_lock lock(mutex_);
+        co_return devices_;
+    }
+
+    /**
+     * @brief 确保缓存已加载且未过期
      *
      * 并发安全：多个协程同时请求时，只有一个执行刷新，
      * 其他协程通过 RefreshNotifier 零轮询等待刷新完成。
      */
-    Task<std::vector<CachedDevice>> getDevices() {
+    Task<void> ensureFresh() {
         {
             std::unique_lock lock(mutex_);
             auto now = std::chrono::steady_clock::now();
             // 缓存有效，直接返回
-            if (loaded_ &&
-                std::chrono::duration_cast<std::chrono::seconds>(now - lastRefresh_).count() < CACHE_TTL_SECONDS) {
-                co_return devices_;
-            }
+            if (loaded_ &&
+                std::chrono::duration_cast<std::chrono::seconds>(now - lastRefresh_).count() < CACHE_TTL_SECONDS) {
+                co_return;
+            }
 
             if (!refreshing_) {
                 // 本协程负责刷新
@@ -89,8 +109,7 @@ public:
                 // 已有协程在刷新，零轮询等待通知
                 lock.unlock();
                 co_await refreshNotifier_;
-                std::shared_lock readLock(mutex_);
-                co_return devices_;
+                co_return;
             }
         }
 
@@ -107,7 +126,6 @@ public:
         std::unique_lock lock(mutex_);
         refreshing_ = false;
         refreshNotifier_.notify();
-        co_return devices_;
     }
 
     /**
@@ -276,6 +294,9 @@ public:
         }
 
         devices_.pop_back();
+        if (auto slotIt = slotById_.find(deviceId); slotIt != slotById_.end()) {
+            releaseSlotLocked(slotIt->second);
+        }
         LOG_DEBUG << "[DeviceCache] Device " << deviceId << " invalidated";
     }
 
@@ -365,6 +386,143 @@ public:
         return devices_;
     }
 
+    /**
+     * @brief 近似占用字节数（见 MemoryFootprint.hpp）
+     *
+     * 接入链路同步查询依赖本缓存，内存紧张时不裁剪，只统计。
+     */
+    size_t approximateBytes() const {
+        std::shared_lock lock(mutex_);
+        size_t bytes = memory::vectorBytes(devices_)
+                     + memory::hashBytes(deviceIndex_)
+                     + memory::hashBytes(deviceCodeIndex_)
+                     + memory::hashBytes(linkDeviceIndex_)
+                     + memory::vectorBytes(slots_)
+                     + memory::hashBytes(slotById_)
+                     + memory::vectorBytes(freeSlots_)
+                     + slotJournal_.size() * sizeof(std::pair<uint64_t, uint32_t>);
+        for (const auto& device : devices_) {
+            for (const auto* s : {&device.name, &device.deviceCode, &device.status, &device.timezone,
+                                  &device.modbusMode, &device.heartbeatMode, &device.heartbeatContent,
+                                  &device.registrationMode, &device.registrationContent, &device.remark,
+                                  &device.createdAt, &device.linkName, &device.linkMode, &device.targetId,
+                                  &device.linkIp, &device.protocolName, &device.protocolType}) {
+                bytes += memory::heapBytes(*s);
+            }
+            bytes += memory::vectorBytes(device.heartbeatBytes)
+                   + memory::vectorBytes(device.registrationBytes)
+                   + memory::jsonBytes(device.protocolConfig) - sizeof(Json::Value);
+        }
+        for (const auto& [code, _] : deviceCodeIndex_) {
+            bytes += memory::heapBytes(code);
+        }
+        for (const auto& [_, indices] : linkDeviceIndex_) {
+            bytes += memory::vectorBytes(indices);
+        }
+        return bytes;
+    }
+
+    // 挑选结果的投影：整条设备拷贝 / 只取 ID
+    struct CopyDevice {
+        const CachedDevice& operator()(const CachedDevice& device) const { return device; }
+    };
+    struct DeviceIdOf {
+        int operator()(const CachedDevice& device) const { return device.id; }
+    };
+
+    template<typename Projection>
+    using Projected = std::decay_t<std::invoke_result_t<const Projection&, const CachedDevice&>>;
+
+    /**
+     * @brief 在共享锁下按条件挑选设备，只拷贝命中的设备（或其投影）
+     */
+    template<typename Predicate, typename Projection = CopyDevice>
+    std::vector<Projected<Projection>> selectDevicesSync(Predicate predicate, Projection project = {}) const {
+        std::shared_lock lock(mutex_);
+        std::vector<Projected<Projection>> result;
+        for (const auto& device : devices_) {
+            if (predicate(device)) {
+                result.push_back(project(device));
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief 按稠密下标挑选设备（可见性位图过滤用）
+     * @param version 位图构建时的下标版本
+     * @return 下标版本已变化（槽位可能被复用）时返回 std::nullopt，调用方应重取位图
+     */
+    template<typename SlotPredicate, typename Projection = CopyDevice>
+    std::optional<std::vector<Projected<Projection>>> selectBySlotsSync(
+        uint64_t version,
+        SlotPredicate test,
+        Projection project = {}
+    ) const {
+        std::shared_lock lock(mutex_);
+        if (version != slotVersion_) {
+            return std::nullopt;
+        }
+        std::vector<Projected<Projection>> result;
+        for (const auto& device : devices_) {
+            if (test(device.slot)) {
+                result.push_back(project(device));
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief 下标版本：任一槽位的设备或创建人变化时递增
+     */
+    uint64_t slotVersion() const {
+        std::shared_lock lock(mutex_);
+        return slotVersion_;
+    }
+
+    std::optional<uint32_t> slotOfSync(int deviceId) const {
+        std::shared_lock lock(mutex_);
+        auto it = slotById_.find(deviceId);
+        if (it == slotById_.end()) return std::nullopt;
+        return it->second;
+    }
+
+    /**
+     * @brief 完整下标表（可见性位图全量构建用）
+     */
+    std::vector<SlotEntry> getSlotTableSync(uint64_t& version) const {
+        std::shared_lock lock(mutex_);
+        version = slotVersion_;
+        return slots_;
+    }
+
+    /**
+     * @brief 取 since 之后变化过的槽位及其当前内容（可见性位图增量修补用）
+     * @return false 表示变更日志已截断，调用方需全量构建
+     */
+    bool getSlotChangesSinceSync(
+        uint64_t since,
+        std::vector<std::pair<uint32_t, SlotEntry>>& changes,
+        uint64_t& version
+    ) const {
+        std::shared_lock lock(mutex_);
+        version = slotVersion_;
+        if (since == slotVersion_) {
+            return true;
+        }
+        if (since > slotVersion_ || slotJournal_.empty() || slotJournal_.front().first > since + 1) {
+            return false;
+        }
+
+        std::unordered_set<uint32_t> seen;
+        for (const auto& [changeVersion, slot] : slotJournal_) {
+            if (changeVersion > since && seen.insert(slot).second) {
+                changes.emplace_back(slot, slots_[slot]);
+            }
+        }
+        return true;
+    }
+
     /**
      * @brief 解析心跳/注册包内容为字节序列
      * @param mode "HEX" 或 "ASCII"
@@ -659,6 +817,62 @@ private:
                 linkDeviceIndex_[devices_[i].linkId].push_back(i);
             }
         }
+        syncSlotsLocked();
+    }
+
+    /**
+     * @brief 为缓存中的设备分配稠密下标，回收已移除设备的下标（调用方必须持有 unique_lock）
+     *
+     * 已有设备保持原下标；槽位内容（设备/创建人）变化时记入变更日志。
+     * invalidate() 清空缓存时不回收，重新加载后设备沿用原下标。
+     */
+    void syncSlotsLocked() {
+        std::vector<bool> live(slots_.size(), false);
+        for (auto& device : devices_) {
+            uint32_t slot;
+            auto it = slotById_.find(device.id);
+            if (it != slotById_.end()) {
+                slot = it->second;
+            } else if (!freeSlots_.empty()) {
+                slot = freeSlots_.back();
+                freeSlots_.pop_back();
+                slotById_.emplace(device.id, slot);
+            } else {
+                slot = static_cast<uint32_t>(slots_.size());
+                slots_.emplace_back();
+                live.push_back(false);
+                slotById_.emplace(device.id, slot);
+            }
+
+            device.slot = slot;
+            live[slot] = true;
+            auto& entry = slots_[slot];
+            if (entry.deviceId != device.id || entry.createdBy != device.createdBy) {
+                entry = SlotEntry{device.id, device.createdBy};
+                recordSlotChangeLocked(slot);
+            }
+        }
+
+        for (uint32_t slot = 0; slot < slots_.size(); ++slot) {
+            if (!live[slot] && slots_[slot].deviceId != 0) {
+                releaseSlotLocked(slot);
+            }
+        }
+    }
+
+    void releaseSlotLocked(uint32_t slot) {
+        slotById_.erase(slots_[slot].deviceId);
+        slots_[slot] = SlotEntry{};
+        freeSlots_.push_back(slot);
+        recordSlotChangeLocked(slot);
+    }
+
+    void recordSlotChangeLocked(uint32_t slot) {
+        ++slotVersion_;
+        slotJournal_.emplace_back(slotVersion_, slot);
+        if (slotJournal_.size() > SLOT_JOURNAL_LIMIT) {
+            slotJournal_.pop_front();
+        }
     }
 
     /**
@@ -736,10 +950,18 @@ private:
     // 设备/协议配置变更时事件总线立即清缓存，无需频繁轮询 DB
     static constexpr int CACHE_TTL_SECONDS = 600;
 
+    // 下标变更日志上限，超出后可见性位图退化为全量重建
+    static constexpr size_t SLOT_JOURNAL_LIMIT = 4096;
+
     std::vector<CachedDevice> devices_;
     std::unordered_map<int, size_t> deviceIndex_;  // deviceId -> index in devices_
     std::unordered_map<std::string, size_t> deviceCodeIndex_;  // deviceCode -> index in devices_
     std::unordered_map<int, std::vector<size_t>> linkDeviceIndex_;  // linkId -> indices in devices_
+    std::vector<SlotEntry> slots_;  // slot -> 设备/创建人
+    std::unordered_map<int, uint32_t> slotById_;  // deviceId -> slot
+    std::vector<uint32_t> freeSlots_;
+    uint64_t slotVersion_ = 0;
+    std::deque<std::pair<uint64_t, uint32_t>> slotJournal_;  // (版本, 变化的槽位)
     std::chrono::steady_clock::time_point lastRefresh_;
     mutable std::shared_mutex mutex_;
     bool loaded_ = false;
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "common/cache/AuthCache.hpp"
+#include "common/cache/DeviceCache.hpp"
+
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 按设备稠密下标（DeviceCache::CachedDevice::slot）组织的位图
+ */
+class DeviceBitmap {
+public:
+    void set(uint32_t slot) {
+        if (slot / 64 >= words_.size()) {
+            words_.resize(slot / 64 + 1, 0);
+        }
+        words_[slot / 64] |= (uint64_t{1} << (slot % 64));
+    }
+
+    void reset(uint32_t slot) {
+        if (slot / 64 < words_.size()) {
+            words_[slot / 64] &= ~(uint64_t{1} << (slot % 64));
+        }
+    }
+
+    bool test(uint32_t slot) const {
+        return slot / 64 < words_.size() && (words_[slot / 64] >> (slot % 64)) & 1;
+    }
+
+    size_t count() const {
+        size_t total = 0;
+        for (auto word : words_) {
+            total += static_cast<size_t>(std::popcount(word));
+        }
+        return total;
+    }
+
+private:
+    std::vector<uint64_t> words_;
+};
+
+/**
+ * @brief 用户设备可见性索引
+ *
+ * 为每个用户维护一张可见设备位图（自己创建的设备 ∪ 分享给本人/本部门的设备），
+ * 设备列表过滤从逐设备判定归属/分享变为按位测试。
+ *
+ * 位图与两样东西绑定：
+ * - 构建时使用的权限快照（指针相等即未变）：分享/部门/用户/角色变更会使快照失效，
+ *   下次访问按新快照全量重建
+ * - DeviceCache 的下标版本：设备增删或创建人变化时只按变更日志修补受影响的槽位，
+ *   日志被截断时才全量重建
+ *
+ * 超级管理员不走位图（全部可见），由调用方判断。
+ */
+class DeviceVisibilityIndex {
+public:
+    template<typename T = void> using Task = drogon::Task<T>;
+    using CachedDevice = DeviceCache::CachedDevice;
+
+    static DeviceVisibilityIndex& instance() {
+        static DeviceVisibilityIndex inst;
+        return inst;
+    }
+
+    /**
+     * @brief 获取用户可见的设备（缓存顺序，未排序）
+     */
+    Task<std::vector<CachedDevice>> visibleDevices(
+        int userId,
+        std::shared_ptr<const PermissionSnapshot> permissions
+    ) {
+        co_await DeviceCache::instance().ensureFresh();
+        co_return select(userId, permissions, DeviceCache::CopyDevice{});
+    }
+
+    /**
+     * @brief 获取用户可见的设备 ID（列表 ETag 计算用，不拷贝设备）
+     */
+    Task<std::vector<int>> visibleDeviceIds(
+        int userId,
+        std::shared_ptr<const PermissionSnapshot> permissions
+    ) {
+        co_await DeviceCache::instance().ensureFresh();
+        co_return select(userId, permissions, DeviceCache::DeviceIdOf{});
+    }
+
+    /**
+     * @brief 同步判断单个设备是否对用户可见（实时推送按用户过滤时使用）
+     *
+     * 只读取已构建的位图，不触发构建；位图不存在或已过期时返回 std::nullopt，
+     * 调用方自行回落到逐设备判定。
+     */
+    std::optional<bool> isVisibleSync(int userId, int deviceId) const {
+        auto snapshot = authCache().getPermissionSnapshot(userId);
+        if (!snapshot) return std::nullopt;
+        if (snapshot->isSuperAdmin) return true;
+
+        auto slot = DeviceCache::instance().slotOfSync(deviceId);
+        if (!slot) return false;
+
+        std::lock_guard lock(mutex_);
+        auto it = entries_.find(userId);
+        if (it == entries_.end() || it->second.permissions != snapshot
+            || it->second.version != DeviceCache::instance().slotVersion()) {
+            return std::nullopt;
+        }
+        return it->second.bits->test(*slot);
+    }
+
+    /**
+     * @brief 丢弃全部位图（手动清缓存时调用）
+     */
+    void clear() {
+        std::lock_guard lock(mutex_);
+        entries_.clear();
+    }
+
+private:
+    DeviceVisibilityIndex() = default;
+
+    struct Entry {
+        std::shared_ptr<const PermissionSnapshot> permissions;
+        uint64_t version = 0;
+        std::shared_ptr<const DeviceBitmap> bits;
+    };
+
+    template<typename Projection>
+    std::vector<DeviceCache::Projected<Projection>> select(
+        int userId,
+        const std::shared_ptr<const PermissionSnapshot>& permissions,
+        Projection project
+    ) {
+        auto& cache = DeviceCache::instance();
+
+        // 位图与设备表之间设备可能又发生变化，下标版本不一致时重取位图
+        for (int attempt = 0; attempt < 3; ++attempt) {
+            auto [bits, version] = visibleFor(userId, permissions);
+            auto selected = cache.selectBySlotsSync(version, [&bits](uint32_t slot) {
+                return bits->test(slot);
+            }, project);
+            if (selected) {
+                return std::move(*selected);
+            }
+        }
+
+        // 设备持续变更时退化为逐设备判定
+        return cache.selectDevicesSync([userId, &permissions](const CachedDevice& device) {
+            return isVisible(device.id, device.createdBy, userId, *permissions);
+        }, project);
+    }
+
+    static bool isVisible(int deviceId, int createdBy, int userId, const PermissionSnapshot& permissions) {
+        return createdBy == userId || permissions.deviceShares.count(deviceId) > 0;
+    }
+
+    static AuthCache& authCache() {
+        static AuthCache cache;
+        return cache;
+    }
+
+    /**
+     * @brief 取用户位图及其对应的下标版本（必要时增量修补或全量构建）
+     */
+    std::pair<std::shared_ptr<const DeviceBitmap>, uint64_t> visibleFor(
+        int userId,
+        const std::shared_ptr<const PermissionSnapshot>& permissions
+    ) {
+        auto& cache = DeviceCache::instance();
+        const uint64_t current = cache.slotVersion();
+
+        Entry previous;
+        {
+            std::lock_guard lock(mutex_);
+            auto it = entries_.find(userId);
+            if (it != entries_.end()) {
+                if (it->second.permissions == permissions && it->second.version == current) {
+                    return {it->second.bits, current};
+                }
+                previous = it->second;
+            }
+        }
+
+        std::shared_ptr<DeviceBitmap> bits;
+        uint64_t version = 0;
+
+        if (previous.bits && previous.permissions == permissions) {
+            std::vector<std::pair<uint32_t, DeviceCache::SlotEntry>> changes;
+            if (cache.getSlotChangesSinceSync(previous.version, changes, version)) {
+                bits = std::make_shared<DeviceBitmap>(*previous.bits);
+                for (const auto& [slot, entry] : changes) {
+                    if (entry.deviceId != 0 && isVisible(entry.deviceId, entry.createdBy, userId, *permissions)) {
+                        bits->set(slot);
+                    } else {
+                        bits->reset(slot);
+                    }
+                }
+            }
+        }
+
+        if (!bits) {
+            auto table = cache.getSlotTableSync(version);
+            bits = std::make_shared<DeviceBitmap>();
+            for (uint32_t slot = 0; slot < table.size(); ++slot) {
+                const auto& entry = table[slot];
+                if (entry.deviceId != 0 && isVisible(entry.deviceId, entry.createdBy, userId, *permissions)) {
+                    bits->set(slot);
+                }
+            }
+        }
+
+        std::lock_guard lock(mutex_);
+        auto& entry = entries_[userId];
+        if (entry.permissions != permissions || entry.version <= version) {
+            entry = Entry{permissions, version, bits};
+        }
+        return {bits, version};
+    }
+
+    mutable std::mutex mutex_;
+    std::unordered_map<int, Entry> entries_;
+};
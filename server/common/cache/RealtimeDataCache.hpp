@@ -15,6 +15,7 @@
 #include "common/database/DatabaseService.hpp"
 #include "common/utils/Constants.hpp"
 #include "common/utils/FieldHelper.hpp"
+#include "common/utils/MemoryFootprint.hpp"
 #include "common/utils/SqlHelper.hpp"
 
 class RealtimeDataCache {
@@ -205,6 +206,25 @@ public:
         initializing_.store(false, std::memory_order_release);
     }
 
+    /**
+     * @brief 近似占用字节数（见 MemoryFootprint.hpp），遍历全部 JSON，只在监控线程调用
+     */
+    size_t approximateBytes() const {
+        std::shared_lock lock(mutex_);
+        size_t bytes = memory::treeBytes(cache_) + memory::treeBytes(latestReportTimes_);
+        for (const auto& [_, deviceData] : cache_) {
+            bytes += memory::treeBytes(deviceData);
+            for (const auto& [funcCode, funcData] : deviceData) {
+                bytes += memory::heapBytes(funcCode) + memory::heapBytes(funcData.reportTime)
+                       + memory::jsonBytes(funcData.data) - sizeof(Json::Value);
+            }
+        }
+        for (const auto& [_, latestTime] : latestReportTimes_) {
+            bytes += memory::heapBytes(latestTime);
+        }
+        return bytes;
+    }
+
 private:
     RealtimeDataCache() = default;
 
@@ -2,19 +2,30 @@
 
 #include <drogon/drogon.h>
 
+#include <algorithm>
+#include <chrono>
 #include <format>
 #include <functional>
 #include <initializer_list>
 #include <map>
 #include <shared_mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 /**
  * @brief 资源版本管理器
  *
  * 提供版本号的存取功能，具体的缓存 key 和清理由各 Controller/Service 自行管理。
- * 使用 UUID 作为版本标识，避免哈希冲突。
+ *
+ * 版本号为单调递增的 64 位计数（全局时钟，以进程启动时刻的微秒数为起点，
+ * 重启后不会与客户端手中的旧 ETag 重复），按两级维护：
+ * - 资源类型级：incrementVersion(key)，影响该类型下所有实体
+ * - 实体级：incrementVersion(key, id)，只影响单个设备/链路/分组等
+ *
+ * getVersion(key) 取该类型下任意变更的最新版本；列表接口可用 maxVersion(key, ids)
+ * 只取可见集合内实体的最大版本，无关实体变化时 ETag 保持不变。
+ * 配置类与实时类变更使用不同的 key（如 "device" / "device:data"），互不影响。
  */
 class ResourceVersion {
 public:
@@ -35,26 +46,93 @@ public:
         std::shared_lock<std::shared_mutex> lock(sharedMutex_);
         auto it = versions_.find(key);
         if (it != versions_.end()) [[likely]] {
-            return it->second;
+            return toString(it->second.latest);
         }
         return "";
     }
 
     /**
-     * @brief 更新版本号（数据变更时调用）
+     * @brief 获取单个实体的版本号（实体未单独变更过时取资源类型的基线版本）
+     */
+    std::string getVersion(const std::string& key, int id) {
+        std::shared_lock<std::shared_mutex> lock(sharedMutex_);
+        auto it = versions_.find(key);
+        if (it == versions_.end()) {
+            return "";
+        }
+        auto entityIt = it->second.entities.find(id);
+        uint64_t version = it->second.base;
+        if (entityIt != it->second.entities.end()) {
+            version = std::max(version, entityIt->second);
+        }
+        return toString(version);
+    }
+
+    /**
+     * @brief 获取一组实体中的最大版本号
+     *
+     * 集合成员的增减（如取消分享）不一定体现为版本变化，
+     * 调用方应把集合大小一并纳入 ETag。
+     */
+    std::string maxVersion(const std::string& key, const std::vector<int>& ids) {
+        std::shared_lock<std::shared_mutex> lock(sharedMutex_);
+        auto it = versions_.find(key);
+        if (it == versions_.end()) {
+            return "";
+        }
+        uint64_t version = it->second.base;
+        for (int id : ids) {
+            auto entityIt = it->second.entities.find(id);
+            if (entityIt != it->second.entities.end()) {
+                version = std::max(version, entityIt->second);
+            }
+        }
+        return toString(version);
+    }
+
+    /**
+     * @brief 更新资源类型版本号（影响该类型下全部实体）
      * @param key 资源 key
      *
      * 设计取舍：优先保证低延迟（TcpIoPool 线程调用不阻塞），
      * 代价是服务崩溃时可能丢失最近一次版本号。
      */
     void incrementVersion(const std::string& key) {
-        std::string uuid;
+        uint64_t version;
         {
             std::lock_guard<std::shared_mutex> lock(sharedMutex_);
-            uuid = drogon::utils::getUuid();
-            versions_[key] = uuid;
+            version = ++clock_;
+            auto& entry = versions_[key];
+            entry.base = version;
+            entry.latest = version;
         }
-        LOG_TRACE << "[ResourceVersion] " << key << " -> " << uuid;
+        LOG_TRACE << "[ResourceVersion] " << key << " -> " << version;
+    }
+
+    /**
+     * @brief 更新单个实体的版本号
+     */
+    void incrementVersion(const std::string& key, int id) {
+        incrementVersions(key, std::vector<int>{id});
+    }
+
+    /**
+     * @brief 批量更新实体版本号（同一批次共用一个版本，只加一次锁）
+     */
+    void incrementVersions(const std::string& key, const std::vector<int>& ids) {
+        if (ids.empty()) return;
+
+        uint64_t version;
+        {
+            std::lock_guard<std::shared_mutex> lock(sharedMutex_);
+            version = ++clock_;
+            auto& entry = versions_[key];
+            for (int id : ids) {
+                entry.entities[id] = version;
+            }
+            entry.latest = version;
+        }
+        LOG_TRACE << "[ResourceVersion] " << key << " x" << ids.size() << " -> " << version;
     }
 
     /**
@@ -80,8 +158,9 @@ public:
      */
     void resetAll() {
         std::lock_guard<std::shared_mutex> lock(sharedMutex_);
-        for (auto& [key, version] : versions_) {
-            version = drogon::utils::getUuid();
+        for (auto& [key, entry] : versions_) {
+            auto version = ++clock_;
+            entry = Versions{version, version, {}};
             LOG_DEBUG << "[ResourceVersion] " << key << " version reset to " << version;
         }
         LOG_INFO << "[ResourceVersion] All " << versions_.size() << " versions reset";
@@ -91,19 +170,32 @@ public:
         std::lock_guard<std::shared_mutex> lock(sharedMutex_);
         versions_.clear();
         for (const auto& key : keys) {
-            auto version = drogon::utils::getUuid();
-            versions_[key] = version;
+            auto version = ++clock_;
+            versions_[key] = Versions{version, version, {}};
             LOG_DEBUG << "[ResourceVersion] " << key << " version reset to " << version;
         }
         LOG_INFO << "[ResourceVersion] All " << versions_.size() << " versions reset";
     }
 
 private:
-    ResourceVersion() = default;
+    ResourceVersion()
+        : clock_(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::system_clock::now().time_since_epoch()).count())) {}
     ResourceVersion(const ResourceVersion&) = delete;
     ResourceVersion& operator=(const ResourceVersion&) = delete;
 
-    std::map<std::string, std::string> versions_;  // key -> UUID
+    struct Versions {
+        uint64_t base = 0;    // 资源类型级版本
+        uint64_t latest = 0;  // 类型级或任一实体的最新版本
+        std::unordered_map<int, uint64_t> entities;  // id -> 实体版本
+    };
+
+    static std::string toString(uint64_t version) {
+        return std::format("{:x}", version);
+    }
+
+    std::map<std::string, Versions> versions_;
+    uint64_t clock_;
     mutable std::shared_mutex sharedMutex_;
 };
 
@@ -133,6 +225,16 @@ namespace ETagUtils {
         resp->addHeader("Cache-Control", "private, no-cache");
     }
 
+    /**
+     * @brief 由查询参数与调用方给出的版本串生成 ETag
+     *
+     * 用于版本不只取决于单个资源 key 的接口（如按可见设备集合计算的版本）。
+     */
+    inline std::string makeVersionedETag(const std::string& params, const std::string& version) {
+        size_t paramHash = std::hash<std::string>{}(params);
+        return "\"" + std::format("{:x}", paramHash) + "-" + version + "\"";
+    }
+
     /**
      * @brief 生成参数化 ETag
      * @param resourceKey 资源 key
@@ -140,9 +242,7 @@ namespace ETagUtils {
      * @return ETag 字符串（带引号）
      */
     inline std::string makeParamETag(const std::string& resourceKey, const std::string& params) {
-        size_t paramHash = std::hash<std::string>{}(params);
-        std::string version = ResourceVersion::instance().getVersion(resourceKey);
-        return "\"" + std::format("{:x}", paramHash) + "-" + version + "\"";
+        return makeVersionedETag(params, ResourceVersion::instance().getVersion(resourceKey));
     }
 
     /**
@@ -194,21 +294,17 @@ namespace ETagUtils {
     }
 
     /**
-     * @brief 检查并处理参数化 ETag（在 Controller 方法开头调用）
-     * @param req HTTP 请求
-     * @param resourceKey 资源 key
-     * @param params 查询参数字符串
-     * @return 如果返回非空响应，直接返回该响应（304）；否则继续执行业务逻辑
+     * @brief 检查并处理参数化 ETag（版本串由调用方计算）
      */
-    inline HttpResponsePtr checkParamETag(const HttpRequestPtr& req,
-                                          const std::string& resourceKey,
-                                          const std::string& params) {
+    inline HttpResponsePtr checkVersionedETag(const HttpRequestPtr& req,
+                                              const std::string& params,
+                                              const std::string& version) {
         if (req->method() != Get) return nullptr;
 
         std::string ifNoneMatch = req->getHeader("If-None-Match");
         if (ifNoneMatch.empty()) return nullptr;
 
-        std::string etag = makeParamETag(resourceKey, params);
+        std::string etag = makeVersionedETag(params, version);
         if (ifNoneMatch == etag) {
             LOG_DEBUG << "[ETag] 304 for " << req->path() << " (parameterized)";
             auto resp = HttpResponse::newHttpResponse();
@@ -220,6 +316,19 @@ namespace ETagUtils {
         return nullptr;
     }
 
+    /**
+     * @brief 检查并处理参数化 ETag（在 Controller 方法开头调用）
+     * @param req HTTP 请求
+     * @param resourceKey 资源 key
+     * @param params 查询参数字符串
+     * @return 如果返回非空响应，直接返回该响应（304）；否则继续执行业务逻辑
+     */
+    inline HttpResponsePtr checkParamETag(const HttpRequestPtr& req,
+                                          const std::string& resourceKey,
+                                          const std::string& params) {
+        return checkVersionedETag(req, params, ResourceVersion::instance().getVersion(resourceKey));
+    }
+
     /**
      * @brief 为响应添加 ETag header（简单模式）
      */
@@ -251,4 +360,14 @@ namespace ETagUtils {
         resp->addHeader("ETag", makeParamETag(resourceKey, params));
         addAuthAwareCacheHeaders(resp);
     }
+
+    /**
+     * @brief 为响应添加参数化 ETag header（版本串由调用方计算）
+     */
+    inline void addVersionedETag(const HttpResponsePtr& resp,
+                                 const std::string& params,
+                                 const std::string& version) {
+        resp->addHeader("ETag", makeVersionedETag(params, version));
+        addAuthAwareCacheHeaders(resp);
+    }
 }
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "common/utils/TreeBuilder.hpp"
+
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief 树快照缓存
+ *
+ * 菜单、部门、设备分组的树只在首次使用时从数据库构建，之后以不可变快照共享；
+ * 同一资源族下按视图区分（状态过滤、按角色集合过滤的菜单等）。
+ * 资源族由 EventBus 内置副作用整体失效：菜单/角色变更失效 "menu"，
+ * 部门变更失效 "department"，分组变更失效 "deviceGroup"。
+ */
+class TreeCache {
+public:
+    template<typename T = void> using Task = drogon::Task<T>;
+
+    static TreeCache& instance() {
+        static TreeCache inst;
+        return inst;
+    }
+
+    /**
+     * @brief 获取树快照，未命中时调用 loadItems 加载平铺数据并构建
+     * @param family 资源族（"menu" / "department" / "deviceGroup"）
+     * @param view 族内视图 key
+     * @param loadItems 返回 Task<Json::Value> 的加载函数
+     */
+    template<typename Loader>
+    Task<std::shared_ptr<const TreeSnapshot>> get(std::string family, std::string view, Loader loadItems) {
+        uint64_t generation = 0;
+        {
+            std::shared_lock lock(mutex_);
+            auto it = families_.find(family);
+            if (it != families_.end()) {
+                auto viewIt = it->second.views.find(view);
+                if (viewIt != it->second.views.end()) {
+                    co_return viewIt->second;
+                }
+                generation = it->second.generation;
+            }
+        }
+
+        auto items = co_await loadItems();
+        auto snapshot = std::make_shared<const TreeSnapshot>(TreeBuilder::snapshot(items));
+
+        // 加载期间若已失效，结果只用于本次请求，不写入缓存
+        std::unique_lock lock(mutex_);
+        auto& entry = families_[family];
+        if (entry.generation == generation) {
+            entry.views[view] = snapshot;
+        }
+        co_return snapshot;
+    }
+
+    /**
+     * @brief 失效某个资源族下的全部视图
+     */
+    void invalidate(const std::string& family) {
+        std::unique_lock lock(mutex_);
+        auto& entry = families_[family];
+        entry.views.clear();
+        ++entry.generation;
+    }
+
+    void clear() {
+        std::unique_lock lock(mutex_);
+        for (auto& [family, entry] : families_) {
+            entry.views.clear();
+            ++entry.generation;
+        }
+    }
+
+private:
+    TreeCache() = default;
+
+    struct Family {
+        uint64_t generation = 0;
+        std::unordered_map<std::string, std::shared_ptr<const TreeSnapshot>> views;
+    };
+
+    std::unordered_map<std::string, Family> families_;
+    mutable std::shared_mutex mutex_;
+};
@@ -40,9 +40,7 @@ public:
 
 private:
     static DbClientPtr getDbClient() {
-        return AppDbConfig::useFast()
-            ? drogon::app().getFastDbClient("default")
-            : drogon::app().getDbClient("default");
+        return DatabaseService(DbWorkload::Maintenance).getClient();
     }
 
     /// 注册所有迁移（新增迁移在此处添加）
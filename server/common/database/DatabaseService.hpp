@@ -1,5 +1,7 @@
 #pragma once
 
+#include "ReplicaRouter.hpp"
+
 #include <stdexcept>
 
 /**
@@ -25,18 +27,189 @@ inline std::string toParameterized(const std::string& sql, size_t paramCount) {
     return result;
 }
 
+/**
+ * @brief 命名参数化语句（由 PreparedStatementRegistry 注册，SQL 文本固定）
+ */
+struct PreparedStatement {
+    std::string name;
+    std::string sql;    // 已转换为 $1, $2, ...
+    size_t arity = 0;
+
+    mutable std::atomic<uint64_t> calls{0};
+    mutable std::atomic<uint64_t> totalMicros{0};
+
+    PreparedStatement(std::string n, std::string s, size_t a)
+        : name(std::move(n)), sql(std::move(s)), arity(a) {}
+};
+
+/**
+ * @brief 数据库负载类别
+ *
+ * 每类负载可在 db_clients 中配置同名连接池（"ingest"、"reporting" 等），
+ * 各自拥有独立的连接数（connection_number）和语句超时（timeout），
+ * 避免历史导出、统计聚合等重查询耗尽连接而阻塞数据入库。
+ * 未配置同名连接池时回落到 "default"。
+ */
+enum class DbWorkload : uint8_t {
+    Interactive = 0,  // 交互式 API（CRUD、权限校验）
+    Ingest,           // 数据入库（批量写入、告警记录、状态落盘）
+    Reporting,        // 报表/导出（首页统计、历史查询、开放接口导出）
+    Maintenance,      // 后台维护（迁移、种子数据、定期清理）
+};
+
+inline constexpr size_t kDbWorkloadCount = 4;
+
+inline const char* dbWorkloadName(DbWorkload workload) {
+    switch (workload) {
+        case DbWorkload::Ingest: return "ingest";
+        case DbWorkload::Reporting: return "reporting";
+        case DbWorkload::Maintenance: return "maintenance";
+        case DbWorkload::Interactive:
+        default: return "interactive";
+    }
+}
+
 /**
  * @brief 数据库配置（由 main.cpp 初始化）
  */
 struct AppDbConfig {
+    /** "default" 连接池是否为 FastDbClient */
     static bool& useFast() {
         static bool value = false;
         return value;
     }
+
+    /** 各负载类别实际使用的连接池配置 */
+    struct Pool {
+        std::string clientName{"default"};
+        bool isFast{false};
+        bool dedicated{false};
+    };
+
+    static std::array<Pool, kDbWorkloadCount>& pools() {
+        static std::array<Pool, kDbWorkloadCount> value{};
+        return value;
+    }
+
+    static const Pool& poolFor(DbWorkload workload) {
+        return pools()[static_cast<size_t>(workload)];
+    }
+
+    /**
+     * @brief 按 db_clients 的 name 绑定负载类别，未配置的类别回落到 "default"
+     */
+    static void bindPools(const std::vector<std::pair<std::string, bool>>& clients) {
+        auto& all = pools();
+        for (auto& pool : all) {
+            pool = Pool{"default", useFast(), false};
+        }
+        for (const auto& [name, isFast] : clients) {
+            for (size_t i = 0; i < kDbWorkloadCount; ++i) {
+                if (name == dbWorkloadName(static_cast<DbWorkload>(i))) {
+                    all[i] = Pool{name, isFast, true};
+                }
+            }
+        }
+    }
+};
+
+/**
+ * @brief 连接池负载指标（按负载类别统计，无锁计数）
+ *
+ * inFlight 为已发出但尚未返回的语句数，包含在 Drogon 连接池内排队等待连接的部分，
+ * 即该池的队列深度。
+ */
+class DbPoolMetrics {
+public:
+    static DbPoolMetrics& instance() {
+        static DbPoolMetrics inst;
+        return inst;
+    }
+
+    void onStart(DbWorkload workload) {
+        auto& c = counters_[static_cast<size_t>(workload)];
+        auto depth = c.inFlight.fetch_add(1, std::memory_order_relaxed) + 1;
+        auto peak = c.peakInFlight.load(std::memory_order_relaxed);
+        while (depth > peak &&
+               !c.peakInFlight.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {
+        }
+    }
+
+    void onFinish(DbWorkload workload, std::chrono::steady_clock::duration elapsed,
+                  bool failed, bool timedOut) {
+        auto& c = counters_[static_cast<size_t>(workload)];
+        c.inFlight.fetch_sub(1, std::memory_order_relaxed);
+        c.total.fetch_add(1, std::memory_order_relaxed);
+        if (failed) c.errors.fetch_add(1, std::memory_order_relaxed);
+        if (timedOut) c.timeouts.fetch_add(1, std::memory_order_relaxed);
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        c.totalMicros.fetch_add(static_cast<uint64_t>(us), std::memory_order_relaxed);
+        auto slowest = c.maxMicros.load(std::memory_order_relaxed);
+        while (static_cast<uint64_t>(us) > slowest &&
+               !c.maxMicros.compare_exchange_weak(slowest, static_cast<uint64_t>(us),
+                                                  std::memory_order_relaxed)) {
+        }
+    }
+
+    int64_t inFlight(DbWorkload workload) const {
+        return counters_[static_cast<size_t>(workload)].inFlight.load(std::memory_order_relaxed);
+    }
+
+    uint64_t total(DbWorkload workload) const {
+        return counters_[static_cast<size_t>(workload)].total.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 导出各负载类别的连接池指标
+     */
+    Json::Value toJson() const {
+        Json::Value arr(Json::arrayValue);
+        for (size_t i = 0; i < kDbWorkloadCount; ++i) {
+            auto workload = static_cast<DbWorkload>(i);
+            const auto& pool = AppDbConfig::poolFor(workload);
+            const auto& c = counters_[i];
+            auto total = c.total.load(std::memory_order_relaxed);
+
+            Json::Value item;
+            item["workload"] = dbWorkloadName(workload);
+            item["client"] = pool.clientName;
+            item["dedicated"] = pool.dedicated;
+            item["inFlight"] = static_cast<Json::Int64>(c.inFlight.load(std::memory_order_relaxed));
+            item["peakInFlight"] = static_cast<Json::Int64>(c.peakInFlight.load(std::memory_order_relaxed));
+            item["total"] = static_cast<Json::UInt64>(total);
+            item["errors"] = static_cast<Json::UInt64>(c.errors.load(std::memory_order_relaxed));
+            item["timeouts"] = static_cast<Json::UInt64>(c.timeouts.load(std::memory_order_relaxed));
+            item["avgMs"] = total > 0
+                ? static_cast<double>(c.totalMicros.load(std::memory_order_relaxed)) / total / 1000.0
+                : 0.0;
+            item["maxMs"] = static_cast<double>(c.maxMicros.load(std::memory_order_relaxed)) / 1000.0;
+            arr.append(item);
+        }
+        return arr;
+    }
+
+private:
+    struct Counters {
+        std::atomic<int64_t> inFlight{0};
+        std::atomic<int64_t> peakInFlight{0};
+        std::atomic<uint64_t> total{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> timeouts{0};
+        std::atomic<uint64_t> totalMicros{0};
+        std::atomic<uint64_t> maxMicros{0};
+    };
+
+    DbPoolMetrics() = default;
+    std::array<Counters, kDbWorkloadCount> counters_;
 };
 
 /**
  * @brief 数据库服务类
+ *
+ * 构造时指定负载类别，语句路由到该类别的连接池并计入对应指标：
+ * @code
+ * DatabaseService db(DbWorkload::Ingest);
+ * @endcode
  */
 class DatabaseService {
 public:
@@ -45,18 +218,23 @@ public:
     using Transaction = drogon::orm::Transaction;
     template<typename T = void> using Task = drogon::Task<T>;
 
-    DatabaseService() = default;
+    explicit DatabaseService(DbWorkload workload = DbWorkload::Interactive)
+        : workload_(workload) {}
+
+    DbWorkload workload() const { return workload_; }
 
     DbClientPtr getClient() const {
-        return AppDbConfig::useFast()
-            ? drogon::app().getFastDbClient("default")
-            : drogon::app().getDbClient("default");
+        const auto& pool = AppDbConfig::poolFor(workload_);
+        return pool.isFast
+            ? drogon::app().getFastDbClient(pool.clientName)
+            : drogon::app().getDbClient(pool.clientName);
     }
 
     DbClientPtr requireClient() const {
         auto client = getClient();
         if (!client) {
-            throw std::runtime_error("Drogon DB client 'default' is not available; database work must run on a Drogon EventLoop");
+            throw std::runtime_error("Drogon DB client '" + AppDbConfig::poolFor(workload_).clientName
+                + "' is not available; database work must run on a Drogon EventLoop");
         }
         return client;
     }
@@ -67,19 +245,108 @@ public:
 
     Task<Result> execSqlCoro(const std::string& sql,
                               const std::vector<std::string>& params = {}) {
-        auto client = requireClient();
-        if (params.empty()) {
-            co_return co_await client->execSqlCoro(sql);
-        }
         // 使用 PostgreSQL 原生参数绑定（$1, $2, ...），由 libpq 服务端处理
-        auto binder = *client << toParameterized(sql, params.size());
-        for (const auto& p : params) {
-            binder << p;
+        co_return co_await execRouted(params.empty() ? sql : toParameterized(sql, params.size()), params);
+    }
+
+    /**
+     * @brief 执行已注册的命名语句（连接上首次执行时 prepare，之后直接复用执行计划）
+     */
+    Task<Result> execPreparedCoro(const PreparedStatement& stmt,
+                                  const std::vector<std::string>& params = {}) {
+        if (params.size() != stmt.arity) {
+            throw std::invalid_argument("Prepared statement '" + stmt.name + "' expects "
+                + std::to_string(stmt.arity) + " params, got " + std::to_string(params.size()));
         }
-        co_return co_await drogon::orm::internal::SqlAwaiter(std::move(binder));
+        auto startedAt = std::chrono::steady_clock::now();
+        auto result = co_await execRouted(stmt.sql, params);
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - startedAt).count();
+        stmt.calls.fetch_add(1, std::memory_order_relaxed);
+        stmt.totalMicros.fetch_add(static_cast<uint64_t>(us), std::memory_order_relaxed);
+        co_return result;
     }
 
+    /**
+     * @brief 事务始终在主库上执行（即使是 Reporting 负载）
+     */
     Task<std::shared_ptr<Transaction>> newTransactionCoro() {
-        co_return co_await requireClient()->newTransactionCoro();
+        auto client = requireClient();
+        PoolScope scope(workload_);
+        try {
+            co_return co_await client->newTransactionCoro();
+        } catch (...) {
+            scope.failed = true;
+            throw;
+        }
+    }
+
+private:
+    /**
+     * @brief 按负载路由：Reporting 在副本可用时走副本，副本断连/超时立即回落主库重试
+     */
+    Task<Result> execRouted(const std::string& pgSql, const std::vector<std::string>& params) {
+        if (workload_ == DbWorkload::Reporting) {
+            auto& router = ReplicaRouter::instance();
+            if (router.usable()) {
+                if (auto replica = router.client()) {
+                    std::string failure;
+                    try {
+                        router.onRoutedRead();
+                        co_return co_await execOn(replica, pgSql, params);
+                    } catch (const drogon::orm::TimeoutError& e) {
+                        failure = std::string("timeout: ") + e.what();
+                    } catch (const drogon::orm::BrokenConnection& e) {
+                        failure = std::string("broken connection: ") + e.what();
+                    }
+                    router.markUnavailable(failure);
+                }
+            }
+            if (router.enabled()) {
+                router.onPrimaryFallbackRead();
+            }
+        }
+        co_return co_await execOn(requireClient(), pgSql, params);
     }
+
+    Task<Result> execOn(DbClientPtr client, const std::string& pgSql,
+                        const std::vector<std::string>& params) {
+        PoolScope scope(workload_);
+        try {
+            if (params.empty()) {
+                co_return co_await client->execSqlCoro(pgSql);
+            }
+            auto binder = *client << pgSql;
+            for (const auto& p : params) {
+                binder << p;
+            }
+            co_return co_await drogon::orm::internal::SqlAwaiter(std::move(binder));
+        } catch (const drogon::orm::TimeoutError&) {
+            scope.failed = scope.timedOut = true;
+            throw;
+        } catch (...) {
+            scope.failed = true;
+            throw;
+        }
+    }
+
+    /** 语句生命周期内计入连接池队列深度与耗时 */
+    struct PoolScope {
+        DbWorkload workload;
+        std::chrono::steady_clock::time_point startedAt{std::chrono::steady_clock::now()};
+        bool failed{false};
+        bool timedOut{false};
+
+        explicit PoolScope(DbWorkload w) : workload(w) {
+            DbPoolMetrics::instance().onStart(workload);
+        }
+        ~PoolScope() {
+            DbPoolMetrics::instance().onFinish(
+                workload, std::chrono::steady_clock::now() - startedAt, failed, timedOut);
+        }
+        PoolScope(const PoolScope&) = delete;
+        PoolScope& operator=(const PoolScope&) = delete;
+    };
+
+    DbWorkload workload_{DbWorkload::Interactive};
 };
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "DatabaseService.hpp"
+
+/**
+ * @brief 命名预编译语句注册表
+ *
+ * Drogon 的 PostgreSQL 连接对带参数的 SQL 按文本在每条连接上首次执行时 PQprepare，
+ * 之后复用 PQexecPrepared，只要 SQL 文本固定，规划只发生一次。
+ * 热点查询若拼接 IN 列表、LIMIT 数字或多值 VALUES，每种长度都会变成一条新语句，
+ * 既反复规划又撑大每条连接的语句缓存。
+ *
+ * 注册表为热点 SQL 提供固定文本：
+ * - 集合参数用 ANY(?::int[]) / unnest(?::type[]) 代替展开的占位符
+ * - ? 占位符在注册时一次性转换为 $n，执行时不再重写 SQL
+ * - 按语句统计调用次数和累计耗时
+ *
+ * 使用示例：
+ * @code
+ * static const auto& stmt = PreparedStatementRegistry::instance().define(
+ *     "auth.isSuperAdmin", "SELECT 1 FROM ... WHERE ur.user_id = ? LIMIT 1");
+ * auto rows = co_await db.execPreparedCoro(stmt, {std::to_string(userId)});
+ * @endcode
+ */
+class PreparedStatementRegistry {
+public:
+    static PreparedStatementRegistry& instance() {
+        static PreparedStatementRegistry inst;
+        return inst;
+    }
+
+    /**
+     * @brief 注册（或取回已注册的）命名语句
+     *
+     * 同名语句只能对应同一段 SQL，文本不一致说明两个调用点共用了名字，直接抛出。
+     * 返回的引用在进程生命周期内有效，调用点通常以函数内 static 保存。
+     */
+    const PreparedStatement& define(const std::string& name, std::string_view sql) {
+        std::lock_guard lock(mutex_);
+        size_t arity = static_cast<size_t>(std::count(sql.begin(), sql.end(), '?'));
+        auto parameterized = toParameterized(std::string(sql), arity);
+
+        auto it = byName_.find(name);
+        if (it != byName_.end()) {
+            if (it->second->sql != parameterized) {
+                throw std::logic_error("Prepared statement '" + name + "' redefined with different SQL");
+            }
+            return *it->second;
+        }
+        auto& stmt = statements_.emplace_back(name, std::move(parameterized), arity);
+        byName_.emplace(name, &stmt);
+        return stmt;
+    }
+
+    size_t size() const {
+        std::lock_guard lock(mutex_);
+        return statements_.size();
+    }
+
+    /**
+     * @brief 导出各语句的调用统计
+     */
+    Json::Value toJson() const {
+        std::lock_guard lock(mutex_);
+        Json::Value arr(Json::arrayValue);
+        for (const auto& stmt : statements_) {
+            auto calls = stmt.calls.load(std::memory_order_relaxed);
+            Json::Value item;
+            item["name"] = stmt.name;
+            item["arity"] = static_cast<Json::UInt64>(stmt.arity);
+            item["calls"] = static_cast<Json::UInt64>(calls);
+            item["avgMs"] = calls > 0
+                ? static_cast<double>(stmt.totalMicros.load(std::memory_order_relaxed)) / calls / 1000.0
+                : 0.0;
+            arr.append(item);
+        }
+        return arr;
+    }
+
+private:
+    PreparedStatementRegistry() = default;
+
+    mutable std::mutex mutex_;
+    std::deque<PreparedStatement> statements_;  // deque 保证引用稳定
+    std::unordered_map<std::string, PreparedStatement*> byName_;
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "common/utils/DrogonLoopSelector.hpp"
+
+/**
+ * @brief 只读副本路由
+ *
+ * db_clients 中配置名为 "replica" 的连接（流复制备库）后，报表类只读查询
+ * （DbWorkload::Reporting）优先路由到副本，减轻同时承担入库写入的主库负载。
+ *
+ * 有界陈旧度：后台定期在副本上探测 WAL 接收状态与复制延迟。
+ * 接收进程停止或断连时两个 LSN 会一起停住，单看“已全部回放”会把任意陈旧的数据当作零延迟，
+ * 因此要求 pg_stat_wal_receiver.status = 'streaming' 且最近 receiver_timeout_sec 内收到过主库消息；
+ * 满足时已收到的 WAL 全部回放视为 0，否则取 now() - pg_last_xact_replay_timestamp()。
+ * 接收进程不在、非 streaming、消息超时、延迟超过 max_lag_sec 或探测失败时副本判定为不可用，
+ * 报表查询回落到主库，直到下一次探测恢复。查询过程中副本连接中断/超时同样立即判定不可用并回落重试。
+ * 副本连接所用角色需能读取 pg_stat_wal_receiver 明细（授予 pg_monitor 或 pg_read_all_stats）。
+ *
+ * 写入、事务以及写后立即读的路径不使用 Reporting 负载，始终走主库。
+ *
+ * 配置（custom_config.db_replica，可选）：
+ * - max_lag_sec: 允许的最大复制延迟，默认 10 秒
+ * - check_interval_sec: 探测周期，默认 5 秒
+ * - receiver_timeout_sec: 接收进程多久未收到主库消息视为断连，默认 60 秒
+ *   （与 wal_receiver_timeout 默认值一致；主库空闲时心跳间隔可达 wal_sender_timeout 的一半）
+ */
+class ReplicaRouter {
+public:
+    template<typename T = void> using Task = drogon::Task<T>;
+    using DbClientPtr = drogon::orm::DbClientPtr;
+
+    static ReplicaRouter& instance() {
+        static ReplicaRouter inst;
+        return inst;
+    }
+
+    /**
+     * @brief 由 ConfigManager 在加载配置时调用
+     */
+    void configure(bool enabled, bool isFast) {
+        enabled_.store(enabled, std::memory_order_relaxed);
+        isFast_.store(isFast, std::memory_order_relaxed);
+        available_.store(false, std::memory_order_relaxed);
+    }
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    /** 副本已配置且最近一次探测延迟在阈值内 */
+    bool usable() const {
+        return enabled() && available_.load(std::memory_order_acquire);
+    }
+
+    DbClientPtr client() const {
+        return isFast_.load(std::memory_order_relaxed)
+            ? drogon::app().getFastDbClient(kClientName)
+            : drogon::app().getDbClient(kClientName);
+    }
+
+    /**
+     * @brief 启动后台探测（未配置副本时为空操作）
+     */
+    void start() {
+        if (!enabled() || loop_) return;
+
+        auto config = drogon::app().getCustomConfig();
+        if (config.isMember("db_replica") && config["db_replica"].isObject()) {
+            maxLagSec_ = config["db_replica"].get("max_lag_sec", maxLagSec_).asDouble();
+            checkIntervalSec_ = config["db_replica"].get("check_interval_sec", checkIntervalSec_).asDouble();
+            receiverTimeoutSec_ = config["db_replica"].get("receiver_timeout_sec", receiverTimeoutSec_).asDouble();
+        }
+        checkIntervalSec_ = std::max(1.0, checkIntervalSec_);
+        receiverTimeoutSec_ = std::max(1.0, receiverTimeoutSec_);
+
+        // FastDbClient 只能在 IO 线程上取用
+        loop_ = DrogonLoopSelector::fixed(0);
+        loop_->queueInLoop([this]() {
+            drogon::async_run([this]() -> Task<> { co_await probe(); });
+        });
+        timerId_ = loop_->runEvery(checkIntervalSec_, [this]() {
+            drogon::async_run([this]() -> Task<> { co_await probe(); });
+        });
+
+        LOG_INFO << "[ReplicaRouter] Reporting reads routed to replica, maxLag="
+                 << maxLagSec_ << "s, interval=" << checkIntervalSec_ << "s";
+    }
+
+    void stop() {
+        if (loop_) {
+            loop_->invalidateTimer(timerId_);
+            loop_ = nullptr;
+        }
+        available_.store(false, std::memory_order_release);
+    }
+
+    /**
+     * @brief 查询期间副本失败（断连/超时），立即回落主库直到下一次探测
+     */
+    void markUnavailable(const std::string& reason) {
+        fallbacks_.fetch_add(1, std::memory_order_relaxed);
+        if (available_.exchange(false, std::memory_order_acq_rel)) {
+            LOG_WARN << "[ReplicaRouter] Replica marked unavailable: " << reason;
+        }
+    }
+
+    void onRoutedRead() { routedReads_.fetch_add(1, std::memory_order_relaxed); }
+
+    void onPrimaryFallbackRead() { primaryReads_.fetch_add(1, std::memory_order_relaxed); }
+
+    Json::Value toJson() const {
+        Json::Value data;
+        data["enabled"] = enabled();
+        data["available"] = usable();
+        data["lagMs"] = static_cast<Json::Int64>(lagMs_.load(std::memory_order_relaxed));
+        data["maxLagSec"] = maxLagSec_;
+        data["receiverTimeoutSec"] = receiverTimeoutSec_;
+        data["routedReads"] = static_cast<Json::UInt64>(routedReads_.load(std::memory_order_relaxed));
+        data["primaryReads"] = static_cast<Json::UInt64>(primaryReads_.load(std::memory_order_relaxed));
+        data["fallbacks"] = static_cast<Json::UInt64>(fallbacks_.load(std::memory_order_relaxed));
+        return data;
+    }
+
+private:
+    ReplicaRouter() = default;
+
+    Task<> probe() {
+        bool ok = false;
+        std::string reason;
+        try {
+            auto db = client();
+            if (!db) {
+                reason = "client not available";
+            } else {
+                auto result = co_await db->execSqlCoro(R"(
+                    SELECT pg_is_in_recovery() AS in_recovery,
+                           r.pid IS NOT NULL AS has_receiver,
+                           r.status AS receiver_status,
+                           EXTRACT(EPOCH FROM now() - r.last_msg_receipt_time)::float8 AS receipt_age_sec,
+                           CASE
+                               WHEN pg_last_wal_receive_lsn() = pg_last_wal_replay_lsn() THEN 0
+                               ELSE COALESCE(EXTRACT(EPOCH FROM now() - pg_last_xact_replay_timestamp()), 0)
+                           END::float8 AS replay_lag_sec
+                    FROM (SELECT 1) AS probe
+                    LEFT JOIN pg_stat_wal_receiver r ON true
+                )");
+                if (result.empty()) {
+                    reason = "empty probe result";
+                } else if (!result[0]["in_recovery"].as<bool>()) {
+                    lagMs_.store(0, std::memory_order_relaxed);
+                    ok = true;
+                } else if (!result[0]["has_receiver"].as<bool>()) {
+                    reason = "WAL receiver not running";
+                } else if (result[0]["receiver_status"].isNull()) {
+                    reason = "WAL receiver status not visible, grant pg_monitor to the replica role";
+                } else if (auto status = result[0]["receiver_status"].as<std::string>(); status != "streaming") {
+                    reason = "WAL receiver " + status;
+                } else if (result[0]["receipt_age_sec"].isNull()
+                           || result[0]["receipt_age_sec"].as<double>() > receiverTimeoutSec_) {
+                    reason = "no message from primary within " + std::to_string(receiverTimeoutSec_) + "s";
+                } else {
+                    double lagSec = result[0]["replay_lag_sec"].as<double>();
+                    lagMs_.store(static_cast<int64_t>(lagSec * 1000.0), std::memory_order_relaxed);
+                    ok = lagSec <= maxLagSec_;
+                    if (!ok) {
+                        reason = "replication lag " + std::to_string(lagSec) + "s";
+                    }
+                }
+            }
+        } catch (const std::exception& e) {
+            reason = e.what();
+        }
+
+        bool was = available_.exchange(ok, std::memory_order_acq_rel);
+        if (was != ok) {
+            if (ok) {
+                LOG_INFO << "[ReplicaRouter] Replica available, lag=" << lagMs_.load() << "ms";
+            } else {
+                LOG_WARN << "[ReplicaRouter] Replica unavailable, reporting reads fall back to primary: " << reason;
+            }
+        }
+    }
+
+    static constexpr const char* kClientName = "replica";
+
+    std::atomic<bool> enabled_{false};
+    std::atomic<bool> isFast_{false};
+    std::atomic<bool> available_{false};
+    std::atomic<int64_t> lagMs_{0};
+    std::atomic<uint64_t> routedReads_{0};
+    std::atomic<uint64_t> primaryReads_{0};
+    std::atomic<uint64_t> fallbacks_{0};
+
+    double maxLagSec_{10.0};
+    double checkIntervalSec_{5.0};
+    double receiverTimeoutSec_{60.0};
+    trantor::EventLoop* loop_{nullptr};
+    trantor::TimerId timerId_{0};
+};
@@ -9,6 +9,7 @@
 #include "common/cache/DeviceCache.hpp"
 #include "common/cache/RealtimeDataCache.hpp"
 #include "common/cache/ResourceVersion.hpp"
+#include "common/cache/TreeCache.hpp"
 
 /**
  * @brief 事件处理器类型
@@ -142,8 +143,9 @@ private:
             int aggId = event.aggregateId;
 
             co_await authCache_.clearAllUserRolesCache();
-            co_await authCache_.clearAllUserMenusCache();
             co_await authCache_.clearAllUserSessionsCache();
+            authCache_.clearAllPermissionSnapshots();
+            TreeCache::instance().invalidate("menu");  // 按角色集合缓存的菜单视图
             ResourceVersion::instance().incrementVersion("role");
 
             LOG_DEBUG << "EventBus: Invalidated all user caches for Role#" << aggId;
@@ -153,15 +155,20 @@ private:
         registerBuiltinEffect("Menu", [this](const DomainEvent& event) -> Task<void> {
             int aggId = event.aggregateId;
 
-            co_await authCache_.clearAllUserMenusCache();
+            co_await authCache_.deleteAllMenus();
             co_await authCache_.clearAllUserSessionsCache();
+            authCache_.clearAllPermissionSnapshots();
+            TreeCache::instance().invalidate("menu");
             ResourceVersion::instance().incrementVersion("menu");
 
             LOG_DEBUG << "EventBus: Invalidated menu and session caches for Menu#" << aggId;
             co_return;
         });
 
-        registerBuiltinEffect("Department", [](const DomainEvent& event) -> Task<void> {
+        registerBuiltinEffect("Department", [this](const DomainEvent& event) -> Task<void> {
+            // 部门级设备分享按部门成员展开在权限快照中
+            authCache_.clearAllPermissionSnapshots();
+            TreeCache::instance().invalidate("department");
             ResourceVersion::instance().incrementVersion("department");
 
             LOG_DEBUG << "EventBus: Updated version for Department#" << event.aggregateId;
@@ -181,13 +188,23 @@ private:
                     DeviceCache::instance().markStale();
                 }
                 RealtimeDataCache::instance().invalidate(event.aggregateId);
-                ResourceVersion::instance().incrementVersion("device");
+                ResourceVersion::instance().incrementVersion("device", event.aggregateId);
 
                 LOG_DEBUG << "EventBus: Refreshed device cache for Device#" << event.aggregateId;
             }
             co_return;
         });
 
+        registerBuiltinEffect("DeviceShare", [this](const DomainEvent& event) -> Task<void> {
+            // 分享目标可能是部门，无法只定位到单个用户，整体失效
+            auto count = authCache_.clearAllPermissionSnapshots();
+            ResourceVersion::instance().incrementVersion("device", event.aggregateId);
+
+            LOG_DEBUG << "EventBus: Invalidated " << count << " permission snapshots for DeviceShare#"
+                      << event.aggregateId;
+            co_return;
+        });
+
         registerBuiltinEffect("Link", [](const DomainEvent& event) -> Task<void> {
             try {
                 co_await DeviceCache::instance().refreshDevicesByLinkId(event.aggregateId);
@@ -197,7 +214,7 @@ private:
                          << ", falling back to stale refresh";
                 DeviceCache::instance().markStale();
             }
-            ResourceVersion::instance().incrementVersion("link");
+            ResourceVersion::instance().incrementVersion("link", event.aggregateId);
 
             LOG_DEBUG << "EventBus: Refreshed device cache for Link#" << event.aggregateId;
             co_return;
@@ -231,7 +248,8 @@ private:
         });
 
         registerBuiltinEffect("DeviceGroup", [](const DomainEvent& event) -> Task<void> {
-            ResourceVersion::instance().incrementVersion("deviceGroup");
+            TreeCache::instance().invalidate("deviceGroup");
+            ResourceVersion::instance().incrementVersion("deviceGroup", event.aggregateId);
 
             LOG_DEBUG << "EventBus: Updated version for DeviceGroup#" << event.aggregateId;
             co_return;
@@ -1,14 +1,17 @@
 #pragma once
 
 #include "AgentProtocol.hpp"
+#include "AgentStateWriter.hpp"
 #include "common/cache/DeviceConnectionCache.hpp"
 #include "common/network/WebSocketManager.hpp"
 #include "common/cache/ResourceVersion.hpp"
 #include "common/database/DatabaseService.hpp"
 #include "common/protocol/FrameResult.hpp"
 #include "common/protocol/ProtocolLog.hpp"
+#include "common/utils/LogLimiter.hpp"
 #include "common/utils/FieldHelper.hpp"
 #include "common/utils/JsonHelper.hpp"
+#include "common/utils/MemoryFootprint.hpp"
 #include "common/utils/TimestampHelper.hpp"
 
 #include <deque>
@@ -67,7 +70,7 @@ public:
      * @brief 服务器启动时调用：重置所有 agent_node 为离线，清理残留事件数据
      */
     Task<void> resetOnStartup(int eventRetentionDays = 30) {
-        DatabaseService db;
+        DatabaseService db(DbWorkload::Maintenance);
 
         auto resetResult = co_await db.execSqlCoro(R"(
             UPDATE agent_node
@@ -95,6 +98,17 @@ public:
                  << eventRetentionDays << " days";
     }
 
+    /**
+     * @brief 关停时写出尚未落库的 Agent 状态与事件
+     */
+    Task<void> flushPendingWrites() {
+        co_await stateWriter_.drain();
+    }
+
+    AgentStateWriter::Stats getStateWriterStats() const {
+        return stateWriter_.getStats();
+    }
+
     bool authorize(const std::string& agentSn, const std::string& model) const {
         const auto normalizedSn = normalizeSn(agentSn);
         if (normalizedSn.empty()) return false;
@@ -142,7 +156,7 @@ public:
         loop->runEvery(6 * 3600.0, [eventRetentionDays]() {
             drogon::async_run([eventRetentionDays]() -> Task<> {
                 try {
-                    DatabaseService db;
+                    DatabaseService db(DbWorkload::Maintenance);
                     co_await db.execSqlCoro(R"(
                         DELETE FROM agent_event
                         WHERE created_at < CURRENT_TIMESTAMP - (? || ' days')::INTERVAL
@@ -153,6 +167,8 @@ public:
             });
         });
 
+        stateWriter_.initialize(loop);
+
         LOG_INFO << "[AgentBridge] Health check started (timeout=" << heartbeatTimeoutSec
                  << "s, retention=" << eventRetentionDays << "d)";
     }
@@ -168,6 +184,10 @@ public:
         result.model = agentModel;
         result.code = result.sn;
 
+        // 断线重连：撤销尚未写出的离线标记，避免批量 flush 覆盖本次在线 upsert
+        stateWriter_.cancelPendingOffline(result.code);
+        co_await stateWriter_.waitOfflineWritten(result.code);
+
         const auto upsertResult = co_await upsertAgentNode(
             result.sn,
             result.model,
@@ -291,25 +311,12 @@ public:
             configVersions_[session->agentId] = std::max(configVersions_[session->agentId], configVersion);
         }
 
-        DatabaseService db;
-        co_await db.execSqlCoro(R"(
-            UPDATE agent_node
-            SET runtime = ?::jsonb,
-                expected_config_version = GREATEST(expected_config_version, ?),
-                applied_config_version = GREATEST(applied_config_version, ?),
-                config_status = ?,
-                config_error = NULL,
-                last_seen = CURRENT_TIMESTAMP,
-                last_config_applied_at = CURRENT_TIMESTAMP,
-                updated_at = CURRENT_TIMESTAMP
-            WHERE code = ? AND deleted_at IS NULL
-        )", {
-            JsonHelper::serialize(runtime.isObject() ? runtime : Json::Value(Json::objectValue)),
-            std::to_string(configVersion),
-            std::to_string(configVersion),
-            CONFIG_STATUS_APPLIED,
-            agentCode
-        });
+        AgentStateWriter::StatusUpdate update;
+        update.kind = AgentStateWriter::UpdateKind::ConfigApplied;
+        update.agentCode = agentCode;
+        update.configVersion = configVersion;
+        update.runtime = JsonHelper::serialize(runtime.isObject() ? runtime : Json::Value(Json::objectValue));
+        stateWriter_.enqueueStatus(std::move(update));
 
         Json::Value eventDetail(Json::objectValue);
         eventDetail["configVersion"] = static_cast<Json::Int64>(configVersion);
@@ -339,23 +346,13 @@ public:
             configVersions_[session->agentId] = std::max(configVersions_[session->agentId], configVersion);
         }
 
-        DatabaseService db;
-        co_await db.execSqlCoro(R"(
-            UPDATE agent_node
-            SET runtime = ?::jsonb,
-                expected_config_version = GREATEST(expected_config_version, ?),
-                config_status = ?,
-                config_error = ?,
-                last_seen = CURRENT_TIMESTAMP,
-                updated_at = CURRENT_TIMESTAMP
-            WHERE code = ? AND deleted_at IS NULL
-        )", {
-            JsonHelper::serialize(runtime.isObject() ? runtime : Json::Value(Json::objectValue)),
-            std::to_string(configVersion),
-            CONFIG_STATUS_FAILED,
-            finalError,
-            agentCode
-        });
+        AgentStateWriter::StatusUpdate update;
+        update.kind = AgentStateWriter::UpdateKind::ConfigFailed;
+        update.agentCode = agentCode;
+        update.configVersion = configVersion;
+        update.configError = finalError;
+        update.runtime = JsonHelper::serialize(runtime.isObject() ? runtime : Json::Value(Json::objectValue));
+        stateWriter_.enqueueStatus(std::move(update));
 
         Json::Value eventDetail(Json::objectValue);
         eventDetail["configVersion"] = static_cast<Json::Int64>(configVersion);
@@ -385,12 +382,11 @@ public:
             }
         }
 
-        DatabaseService db;
-        co_await db.execSqlCoro(R"(
-            UPDATE agent_node
-            SET is_online = FALSE, updated_at = CURRENT_TIMESTAMP
-            WHERE code = ? AND deleted_at IS NULL
-        )", {agentCode});
+        AgentStateWriter::StatusUpdate update;
+        update.kind = AgentStateWriter::UpdateKind::Offline;
+        update.agentCode = agentCode;
+        update.agentId = session->agentId;
+        stateWriter_.enqueueStatus(std::move(update));
 
         // 清理该 Agent 注册的设备连接状态（避免 Agent 离线后设备仍显示在线）
         DeviceConnectionCache::instance().removeByClient(0, "agent:" + std::to_string(session->agentId));
@@ -433,8 +429,8 @@ public:
                           const std::string& clientAddr,
                           const std::string& payloadBase64) {
         if (agentId <= 0 || deviceId <= 0) {
-            LOG_WARN << "[AgentBridge] Drop device:data with invalid ids, agentId="
-                     << agentId << ", deviceId=" << deviceId;
+            LOG_LIMITED(kWarn, 1, 5) << "[AgentBridge] Drop device:data with invalid ids, agentId="
+                                     << agentId << ", deviceId=" << deviceId;
             return;
         }
 
@@ -454,8 +450,9 @@ public:
                 handler(deviceId, clientAddr, payload);
             }
         } catch (const std::exception& e) {
-            LOG_WARN << "[AgentBridge] Failed to decode device:data, deviceId=" << deviceId
-                     << ", client=" << clientAddr << ", error=" << e.what();
+            LOG_DEVICE_LIMITED(kWarn, deviceId)
+                << "[AgentBridge] Failed to decode device:data, deviceId=" << deviceId
+                << ", client=" << clientAddr << ", error=" << e.what();
         }
     }
 
@@ -719,19 +716,7 @@ public:
 
         // 更新数据库中的 capabilities / runtime
         if (agentId > 0) {
-            DatabaseService db;
-            co_await db.execSqlCoro(R"(
-                UPDATE agent_node
-                SET capabilities = ?::jsonb,
-                    runtime = ?::jsonb,
-                    last_seen = CURRENT_TIMESTAMP,
-                    updated_at = CURRENT_TIMESTAMP
-                WHERE id = ? AND deleted_at IS NULL
-            )", {
-                JsonHelper::serialize(capabilities.isObject() ? capabilities : Json::Value(Json::objectValue)),
-                JsonHelper::serialize(runtime.isObject() ? runtime : Json::Value(Json::objectValue)),
-                std::to_string(agentId)
-            });
+            enqueueNetworkReport(agentCode, agentId, capabilities, runtime);
         }
 
         Json::Value detail(Json::objectValue);
@@ -740,6 +725,7 @@ public:
         detail["reportedInterfaceCount"] = data.get("reportedInterfaceCount", 0).asInt();
         appendRecentEvent(agentId, "network_config_applied", "success", "网络配置应用成功", detail);
         ResourceVersion::instance().incrementVersion("agent");
+        co_return;
     }
 
     /**
@@ -753,21 +739,7 @@ public:
         const auto runtime = data.get("runtime", Json::Value(Json::objectValue));
 
         if (agentId > 0) {
-            drogon::async_run([agentId, capabilities, runtime]() -> Task<> {
-                DatabaseService db;
-                co_await db.execSqlCoro(R"(
-                    UPDATE agent_node
-                    SET capabilities = ?::jsonb,
-                        runtime = ?::jsonb,
-                        last_seen = CURRENT_TIMESTAMP,
-                        updated_at = CURRENT_TIMESTAMP
-                    WHERE id = ? AND deleted_at IS NULL
-                )", {
-                    JsonHelper::serialize(capabilities.isObject() ? capabilities : Json::Value(Json::objectValue)),
-                    JsonHelper::serialize(runtime.isObject() ? runtime : Json::Value(Json::objectValue)),
-                    std::to_string(agentId)
-                });
-            });
+            enqueueNetworkReport(agentCode, agentId, capabilities, runtime);
         }
 
         Json::Value detail(Json::objectValue);
@@ -790,6 +762,35 @@ public:
         return hasOnlineSessionLocked(agentId);
     }
 
+    /**
+     * @brief 会话、端点状态与最近事件的近似占用（见 MemoryFootprint.hpp）
+     */
+    size_t approximateBytes() const {
+        std::shared_lock lock(mutex_);
+        size_t bytes = memory::hashBytes(sessionsByCode_) + memory::hashBytes(endpointStatuses_)
+                     + memory::hashBytes(configVersions_) + memory::hashBytes(recentEventsByAgent_)
+                     + memory::hashBytes(recentEventsTouched_) + memory::hashBytes(shellClients_);
+        for (const auto& [code, session] : sessionsByCode_) {
+            bytes += memory::heapBytes(code);
+            if (!session) continue;
+            bytes += sizeof(Session);
+            for (const auto* s : {&session->code, &session->sn, &session->model, &session->name,
+                                  &session->version, &session->configStatus, &session->configError}) {
+                bytes += memory::heapBytes(*s);
+            }
+            bytes += memory::jsonBytes(session->capabilities) - sizeof(Json::Value);
+        }
+        for (const auto& [endpointId, status] : endpointStatuses_) {
+            bytes += memory::heapBytes(endpointId) + memory::jsonBytes(status) - sizeof(Json::Value);
+        }
+        for (const auto& [_, events] : recentEventsByAgent_) {
+            for (const auto& event : events) {
+                bytes += memory::jsonBytes(event);
+            }
+        }
+        return bytes;
+    }
+
     // ==================== Shell 转发 ====================
 
     /**
@@ -1294,24 +1295,32 @@ private:
         }
         trimRecentEventsLocked();
 
-        const auto serializedDetail = JsonHelper::serialize(
+        lock.unlock();
+
+        AgentStateWriter::EventRecord record;
+        record.agentId = agentId;
+        record.type = type;
+        record.level = level;
+        record.message = message;
+        record.detail = JsonHelper::serialize(
             detail.isObject() ? detail : Json::Value(Json::objectValue)
         );
-        drogon::async_run([agentId, type, level, message, serializedDetail]() -> Task<> {
-            try {
-                DatabaseService db;
-                co_await db.execSqlCoro(R"(
-                    INSERT INTO agent_event (agent_id, event_type, level, message, detail, created_at)
-                    VALUES (?, ?, ?, ?, ?::jsonb, CURRENT_TIMESTAMP)
-                )", {
-                    std::to_string(agentId), type, level, message, serializedDetail
-                });
-            } catch (const std::exception& e) {
-                LOG_WARN << "[EdgeNodeBridge] Persist agent event failed, agentId=" << agentId
-                         << ", event=" << type << ", error=" << e.what();
-            }
-            co_return;
-        });
+        stateWriter_.enqueueEvent(std::move(record));
+    }
+
+    void enqueueNetworkReport(const std::string& agentCode,
+                              int agentId,
+                              const Json::Value& capabilities,
+                              const Json::Value& runtime) {
+        AgentStateWriter::StatusUpdate update;
+        update.kind = AgentStateWriter::UpdateKind::NetworkReport;
+        update.agentCode = agentCode;
+        update.agentId = agentId;
+        update.capabilities = JsonHelper::serialize(
+            capabilities.isObject() ? capabilities : Json::Value(Json::objectValue));
+        update.runtime = JsonHelper::serialize(
+            runtime.isObject() ? runtime : Json::Value(Json::objectValue));
+        stateWriter_.enqueueStatus(std::move(update));
     }
 
     void trimRecentEventsLocked() {
@@ -1355,6 +1364,7 @@ private:
     EndpointConnectionHandler connectionHandler_;
     CommandResultCallback commandResultCallback_;
     std::unordered_map<int, WebSocketConnectionPtr> shellClients_;   // agentId → 前端 shell ws 连接
+    AgentStateWriter stateWriter_;
 };
 
 using AgentBridgeManager = EdgeNodeBridgeManager;
@@ -0,0 +1,511 @@
+#pragma once
+
+#include "common/cache/ResourceVersion.hpp"
+#include "common/database/DatabaseService.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Agent 状态与事件写入队列
+ *
+ * Agent 生命周期事件（离线、配置应用成功/失败、网络配置回报、事件日志）
+ * 不再各自发起一次 execSqlCoro，而是进入有界的进程内队列，由固定的
+ * EventLoop 按短间隔攒批，合并为多值 INSERT / UPDATE ... FROM (VALUES ...) 写库。
+ *
+ * 顺序保证：
+ * - 同一 Agent 的状态更新按入队顺序执行：一次 flush 会按"波次"切分，
+ *   每个波次内同一 Agent 最多一条状态更新，波次之间串行执行
+ * - 事件日志携带入队时刻的毫秒时间戳写入 created_at，与 flush 时机无关
+ *
+ * 重连：
+ * - Agent 重新上线前调用 cancelPendingOffline()，撤销尚未写出的离线标记；
+ *   若离线更新正在写库，调用方 co_await waitOfflineWritten() 挂起到该批写完再写在线状态
+ *
+ * 关停：
+ * - drain() 先等待进行中的 flush 结束并占用同一 flushing_ 标记，不会与定时 flush 并发写库
+ *
+ * 容量：
+ * - 队列达到 MAX_PENDING 后丢弃新的事件日志（计入 droppedEvents）
+ * - 状态更新始终入队，丢失会导致 agent_node 与内存会话长期不一致
+ */
+class AgentStateWriter {
+public:
+    template<typename T = void> using Task = drogon::Task<T>;
+
+    static constexpr size_t MAX_PENDING = 10000;
+    static constexpr size_t MAX_ROWS_PER_STATEMENT = 500;
+    static constexpr double FLUSH_INTERVAL_SEC = 0.2;
+
+    enum class UpdateKind {
+        Offline,
+        ConfigApplied,
+        ConfigFailed,
+        NetworkReport
+    };
+
+    /** agent_node 状态更新（字段按 kind 取用） */
+    struct StatusUpdate {
+        UpdateKind kind = UpdateKind::Offline;
+        std::string agentCode;
+        int agentId = 0;
+        int64_t configVersion = 0;
+        std::string configError;
+        std::string capabilities;
+        std::string runtime;
+    };
+
+    /** agent_event 事件日志 */
+    struct EventRecord {
+        int agentId = 0;
+        std::string type;
+        std::string level;
+        std::string message;
+        std::string detail;
+        int64_t createdAtMs = 0;
+    };
+
+    struct Stats {
+        size_t backlog = 0;
+        int64_t flushes = 0;
+        int64_t rowsWritten = 0;
+        int64_t droppedEvents = 0;
+        int64_t failedStatements = 0;
+    };
+
+    /**
+     * @brief 绑定执行 flush 的 EventLoop（未绑定前入队的数据会在绑定后写出）
+     */
+    void initialize(trantor::EventLoop* loop) {
+        if (!loop) return;
+        {
+            std::lock_guard lock(mutex_);
+            loop_ = loop;
+        }
+        scheduleFlush();
+    }
+
+    void enqueueStatus(StatusUpdate update) {
+        if (update.agentCode.empty() && update.agentId <= 0) return;
+        {
+            std::lock_guard lock(mutex_);
+            pending_.push_back(Item{std::move(update), std::nullopt});
+        }
+        scheduleFlush();
+    }
+
+    void enqueueEvent(EventRecord event) {
+        if (event.agentId <= 0) return;
+        if (event.createdAtMs <= 0) {
+            event.createdAtMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+        {
+            std::lock_guard lock(mutex_);
+            if (pending_.size() >= MAX_PENDING) {
+                const auto dropped = droppedEvents_.fetch_add(1, std::memory_order_relaxed) + 1;
+                if (dropped == 1 || dropped % 1000 == 0) {
+                    LOG_WARN << "[AgentStateWriter] Queue full (" << MAX_PENDING
+                             << "), dropped agent events: " << dropped;
+                }
+                return;
+            }
+            pending_.push_back(Item{std::nullopt, std::move(event)});
+        }
+        scheduleFlush();
+    }
+
+    /**
+     * @brief 撤销某 Agent 尚未写出的离线更新（重连时，在线 upsert 之前调用）
+     */
+    void cancelPendingOffline(const std::string& agentCode) {
+        if (agentCode.empty()) return;
+        std::lock_guard lock(mutex_);
+        for (auto it = pending_.begin(); it != pending_.end();) {
+            if (it->status && it->status->kind == UpdateKind::Offline
+                && it->status->agentCode == agentCode) {
+                it = pending_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    /**
+     * @brief 挂起到该 Agent 正在写库的离线更新完成；没有时立即返回
+     */
+    auto waitOfflineWritten(const std::string& agentCode) {
+        return WaitAwaiter{*this, agentCode};
+    }
+
+    /**
+     * @brief 立即写出队列中剩余的全部数据（关停时调用）
+     *
+     * 与定时 flush 共用 flushing_：先等进行中的 flush 写完，再以同一标记独占写库，
+     * 保证同一 Agent 的波次顺序。
+     */
+    Task<void> drain() {
+        for (;;) {
+            co_await WaitAwaiter{*this, {}};
+            std::vector<Item> batch;
+            {
+                std::lock_guard lock(mutex_);
+                if (flushing_) continue;  // 被定时 flush 抢先，继续等
+                if (pending_.empty()) break;
+                flushing_ = true;
+                batch.assign(std::make_move_iterator(pending_.begin()),
+                             std::make_move_iterator(pending_.end()));
+                pending_.clear();
+            }
+            try {
+                co_await writeBatch(std::move(batch));
+            } catch (const std::exception& e) {
+                LOG_ERROR << "[AgentStateWriter] drain failed: " << e.what();
+            }
+            finishFlush();
+        }
+    }
+
+    Stats getStats() const {
+        Stats stats;
+        {
+            std::lock_guard lock(mutex_);
+            stats.backlog = pending_.size();
+        }
+        stats.flushes = flushes_.load(std::memory_order_relaxed);
+        stats.rowsWritten = rowsWritten_.load(std::memory_order_relaxed);
+        stats.droppedEvents = droppedEvents_.load(std::memory_order_relaxed);
+        stats.failedStatements = failedStatements_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct Item {
+        std::optional<StatusUpdate> status;
+        std::optional<EventRecord> event;
+    };
+
+    struct Waiter {
+        trantor::EventLoop* loop;
+        std::coroutine_handle<> handle;
+    };
+
+    /**
+     * @brief 条件成立前挂起：agentCode 为空时等 flush 结束，否则等该 Agent 的离线写库结束
+     *
+     * 条件检查与登记在同一把锁内完成，完成方在清除条件时恢复全部等待者。
+     */
+    struct WaitAwaiter {
+        AgentStateWriter& writer;
+        std::string agentCode;
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            auto* loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+            std::lock_guard lock(writer.mutex_);
+            if (agentCode.empty()) {
+                if (!writer.flushing_) return false;
+                writer.flushWaiters_.push_back({loop, handle});
+            } else {
+                if (writer.inflightOffline_.count(agentCode) == 0) return false;
+                writer.offlineWaiters_[agentCode].push_back({loop, handle});
+            }
+            return true;
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    static void resumeAll(std::vector<Waiter>& waiters) {
+        for (auto& [loop, handle] : waiters) {
+            if (loop) {
+                loop->queueInLoop([h = handle]() { h.resume(); });
+            } else {
+                handle.resume();
+            }
+        }
+    }
+
+    void finishFlush() {
+        std::vector<Waiter> waiters;
+        {
+            std::lock_guard lock(mutex_);
+            flushing_ = false;
+            waiters.swap(flushWaiters_);
+        }
+        resumeAll(waiters);
+    }
+
+    void scheduleFlush() {
+        trantor::EventLoop* loop = nullptr;
+        {
+            std::lock_guard lock(mutex_);
+            if (!loop_ || timerArmed_ || flushing_ || pending_.empty()) return;
+            timerArmed_ = true;
+            loop = loop_;
+        }
+        loop->runAfter(FLUSH_INTERVAL_SEC, [this]() {
+            flush();
+        });
+    }
+
+    void flush() {
+        std::vector<Item> batch;
+        {
+            std::lock_guard lock(mutex_);
+            timerArmed_ = false;
+            if (flushing_ || pending_.empty()) return;
+            flushing_ = true;
+            const size_t count = std::min(pending_.size(), MAX_ROWS_PER_STATEMENT * 4);
+            batch.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                batch.push_back(std::move(pending_.front()));
+                pending_.pop_front();
+            }
+        }
+
+        drogon::async_run([this, batch = std::move(batch)]() mutable -> Task<> {
+            try {
+                co_await writeBatch(std::move(batch));
+            } catch (const std::exception& e) {
+                LOG_ERROR << "[AgentStateWriter] flush failed: " << e.what();
+            }
+            finishFlush();
+            scheduleFlush();
+        });
+    }
+
+    Task<void> writeBatch(std::vector<Item> batch) {
+        if (batch.empty()) co_return;
+        flushes_.fetch_add(1, std::memory_order_relaxed);
+
+        std::vector<std::string> offlineCodes;
+        for (const auto& item : batch) {
+            if (item.status && item.status->kind == UpdateKind::Offline) {
+                offlineCodes.push_back(item.status->agentCode);
+            }
+        }
+        if (!offlineCodes.empty()) {
+            std::lock_guard lock(mutex_);
+            for (const auto& code : offlineCodes) {
+                inflightOffline_.insert(code);
+            }
+        }
+
+        std::vector<EventRecord> events;
+        std::vector<std::vector<StatusUpdate>> waves;
+        std::unordered_map<std::string, size_t> nextWaveByAgent;
+
+        for (auto& item : batch) {
+            if (item.event) {
+                events.push_back(std::move(*item.event));
+                continue;
+            }
+            if (!item.status) continue;
+
+            auto& update = *item.status;
+            const auto key = update.agentCode.empty()
+                ? "#" + std::to_string(update.agentId)
+                : update.agentCode;
+            auto& waveIndex = nextWaveByAgent[key];
+            if (waveIndex >= waves.size()) {
+                waves.resize(waveIndex + 1);
+            }
+            waves[waveIndex].push_back(std::move(update));
+            ++waveIndex;
+        }
+
+        for (auto& wave : waves) {
+            co_await writeStatusWave(wave);
+        }
+        if (!offlineCodes.empty()) {
+            std::vector<Waiter> waiters;
+            {
+                std::lock_guard lock(mutex_);
+                for (const auto& code : offlineCodes) {
+                    if (auto it = inflightOffline_.find(code); it != inflightOffline_.end()) {
+                        inflightOffline_.erase(it);
+                    }
+                    if (inflightOffline_.count(code) > 0) continue;
+                    if (auto it = offlineWaiters_.find(code); it != offlineWaiters_.end()) {
+                        waiters.insert(waiters.end(), it->second.begin(), it->second.end());
+                        offlineWaiters_.erase(it);
+                    }
+                }
+            }
+            resumeAll(waiters);
+        }
+        if (!waves.empty()) {
+            // 状态真正落库后再推进版本，避免客户端在 flush 前拿到旧数据 + 新 ETag
+            ResourceVersion::instance().incrementVersion("agent");
+        }
+        for (size_t offset = 0; offset < events.size(); offset += MAX_ROWS_PER_STATEMENT) {
+            const size_t end = std::min(events.size(), offset + MAX_ROWS_PER_STATEMENT);
+            co_await writeEvents(events, offset, end);
+        }
+    }
+
+    Task<void> writeStatusWave(const std::vector<StatusUpdate>& wave) {
+        std::vector<const StatusUpdate*> offline;
+        std::vector<const StatusUpdate*> applied;
+        std::vector<const StatusUpdate*> failed;
+        std::vector<const StatusUpdate*> network;
+        for (const auto& update : wave) {
+            switch (update.kind) {
+                case UpdateKind::Offline: offline.push_back(&update); break;
+                case UpdateKind::ConfigApplied: applied.push_back(&update); break;
+                case UpdateKind::ConfigFailed: failed.push_back(&update); break;
+                case UpdateKind::NetworkReport: network.push_back(&update); break;
+            }
+        }
+
+        if (!offline.empty()) {
+            std::vector<std::string> params;
+            std::string values;
+            for (const auto* u : offline) {
+                appendRow(values, "(?)");
+                params.push_back(u->agentCode);
+            }
+            co_await execStatement(R"(
+                UPDATE agent_node AS a
+                SET is_online = FALSE, updated_at = CURRENT_TIMESTAMP
+                FROM (VALUES )" + values + R"() AS v(code)
+                WHERE a.code = v.code AND a.deleted_at IS NULL
+            )", params, offline.size());
+        }
+
+        if (!applied.empty()) {
+            std::vector<std::string> params;
+            std::string values;
+            for (const auto* u : applied) {
+                appendRow(values, "(?, ?::jsonb, ?::bigint)");
+                params.push_back(u->agentCode);
+                params.push_back(u->runtime);
+                params.push_back(std::to_string(u->configVersion));
+            }
+            co_await execStatement(R"(
+                UPDATE agent_node AS a
+                SET runtime = v.runtime,
+                    expected_config_version = GREATEST(a.expected_config_version, v.version),
+                    applied_config_version = GREATEST(a.applied_config_version, v.version),
+                    config_status = 'applied',
+                    config_error = NULL,
+                    last_seen = CURRENT_TIMESTAMP,
+                    last_config_applied_at = CURRENT_TIMESTAMP,
+                    updated_at = CURRENT_TIMESTAMP
+                FROM (VALUES )" + values + R"() AS v(code, runtime, version)
+                WHERE a.code = v.code AND a.deleted_at IS NULL
+            )", params, applied.size());
+        }
+
+        if (!failed.empty()) {
+            std::vector<std::string> params;
+            std::string values;
+            for (const auto* u : failed) {
+                appendRow(values, "(?, ?::jsonb, ?::bigint, ?)");
+                params.push_back(u->agentCode);
+                params.push_back(u->runtime);
+                params.push_back(std::to_string(u->configVersion));
+                params.push_back(u->configError);
+            }
+            co_await execStatement(R"(
+                UPDATE agent_node AS a
+                SET runtime = v.runtime,
+                    expected_config_version = GREATEST(a.expected_config_version, v.version),
+                    config_status = 'failed',
+                    config_error = v.error,
+                    last_seen = CURRENT_TIMESTAMP,
+                    updated_at = CURRENT_TIMESTAMP
+                FROM (VALUES )" + values + R"() AS v(code, runtime, version, error)
+                WHERE a.code = v.code AND a.deleted_at IS NULL
+            )", params, failed.size());
+        }
+
+        if (!network.empty()) {
+            std::vector<std::string> params;
+            std::string values;
+            for (const auto* u : network) {
+                if (u->agentId <= 0) continue;
+                appendRow(values, "(?::int, ?::jsonb, ?::jsonb)");
+                params.push_back(std::to_string(u->agentId));
+                params.push_back(u->capabilities);
+                params.push_back(u->runtime);
+            }
+            if (!params.empty()) {
+                co_await execStatement(R"(
+                    UPDATE agent_node AS a
+                    SET capabilities = v.capabilities,
+                        runtime = v.runtime,
+                        last_seen = CURRENT_TIMESTAMP,
+                        updated_at = CURRENT_TIMESTAMP
+                    FROM (VALUES )" + values + R"() AS v(id, capabilities, runtime)
+                    WHERE a.id = v.id AND a.deleted_at IS NULL
+                )", params, params.size() / 3);
+            }
+        }
+    }
+
+    Task<void> writeEvents(const std::vector<EventRecord>& events, size_t begin, size_t end) {
+        std::vector<std::string> params;
+        params.reserve((end - begin) * 6);
+        std::string values;
+        for (size_t i = begin; i < end; ++i) {
+            const auto& e = events[i];
+            appendRow(values, "(?::int, ?, ?, ?, ?::jsonb, to_timestamp(?::bigint / 1000.0))");
+            params.push_back(std::to_string(e.agentId));
+            params.push_back(e.type);
+            params.push_back(e.level);
+            params.push_back(e.message);
+            params.push_back(e.detail);
+            params.push_back(std::to_string(e.createdAtMs));
+        }
+        co_await execStatement(
+            "INSERT INTO agent_event (agent_id, event_type, level, message, detail, created_at) VALUES "
+                + values,
+            params, end - begin);
+    }
+
+    Task<void> execStatement(const std::string& sql,
+                             const std::vector<std::string>& params,
+                             size_t rows) {
+        try {
+            DatabaseService db(DbWorkload::Ingest);
+            co_await db.execSqlCoro(sql, params);
+            rowsWritten_.fetch_add(static_cast<int64_t>(rows), std::memory_order_relaxed);
+        } catch (const std::exception& e) {
+            failedStatements_.fetch_add(1, std::memory_order_relaxed);
+            LOG_WARN << "[AgentStateWriter] Batched write failed (" << rows << " rows): " << e.what();
+        } catch (...) {
+            failedStatements_.fetch_add(1, std::memory_order_relaxed);
+            LOG_WARN << "[AgentStateWriter] Batched write failed (" << rows << " rows): unknown exception";
+        }
+    }
+
+    static void appendRow(std::string& values, const char* row) {
+        if (!values.empty()) values += ", ";
+        values += row;
+    }
+
+    mutable std::mutex mutex_;
+    std::deque<Item> pending_;
+    std::unordered_multiset<std::string> inflightOffline_;
+    std::unordered_map<std::string, std::vector<Waiter>> offlineWaiters_;
+    std::vector<Waiter> flushWaiters_;
+    trantor::EventLoop* loop_ = nullptr;
+    bool timerArmed_ = false;
+    bool flushing_ = false;
+    std::atomic<int64_t> flushes_{0};
+    std::atomic<int64_t> rowsWritten_{0};
+    std::atomic<int64_t> droppedEvents_{0};
+    std::atomic<int64_t> failedStatements_{0};
+};
@@ -3,12 +3,16 @@
 #include "common/utils/AppException.hpp"
 #include "common/utils/FieldHelper.hpp"
 #include "common/utils/Constants.hpp"
-#include "common/database/DatabaseService.hpp"
+#include "common/database/PreparedStatements.hpp"
+#include "common/utils/SqlHelper.hpp"
+#include "common/cache/AuthCache.hpp"
 
 /**
  * @brief 权限检查工具类
  *
- * 使用单次查询同时检查超级管理员和具体权限，优化数据库查询性能
+ * 权限判定读取用户权限快照（超管标记 + 权限码集合 + 设备分享），
+ * 快照首次使用时加载并缓存在 AuthCache，之后每次检查只做哈希查找；
+ * 用户/角色/菜单/部门/分享变更时由 EventBus 内置副作用失效。
  */
 class PermissionChecker {
 public:
@@ -18,82 +22,105 @@ public:
      * @brief 检查用户是否为超级管理员
      */
     static Task<bool> isSuperAdmin(int userId) {
-        DatabaseService dbService;
-        auto result = co_await dbService.execSqlCoro(
-            R"(
-                SELECT 1
-                FROM sys_user_role ur
-                INNER JOIN sys_role r ON ur.role_id = r.id
-                WHERE ur.user_id = ?
-                  AND r.code = ?
-                  AND r.status = 'enabled'
-                  AND r.deleted_at IS NULL
-                LIMIT 1
-            )",
-            {std::to_string(userId), Constants::ROLE_SUPERADMIN}
-        );
-        co_return !result.empty();
+        auto snapshot = co_await loadSnapshot(userId);
+        co_return snapshot->isSuperAdmin;
     }
 
     /**
      * @brief 检查用户是否有指定权限
      *
-     * 优化：使用单次查询同时检查：
-     * 1. 用户是否是超级管理员
-     * 2. 用户是否拥有所需的权限码
+     * 超级管理员或拥有任意一个所需权限码即通过
      */
     static Task<bool> hasPermission(int userId, const std::vector<std::string>& requiredPermissions) {
         if (requiredPermissions.empty()) {
             co_return true;
         }
 
-        DatabaseService dbService;
+        auto snapshot = co_await loadSnapshot(userId);
+        co_return snapshot->hasAny(requiredPermissions);
+    }
 
-        // 构建权限码的 IN 子句占位符
-        std::string permissionsPlaceholder;
-        for (size_t i = 0; i < requiredPermissions.size(); ++i) {
-            if (i > 0) permissionsPlaceholder += ", ";
-            permissionsPlaceholder += "?";
+    /**
+     * @brief 获取用户权限快照（缓存未命中时从数据库构建）
+     */
+    static Task<std::shared_ptr<const PermissionSnapshot>> loadSnapshot(int userId) {
+        if (auto cached = authCache().getPermissionSnapshot(userId)) {
+            co_return cached;
         }
 
-        // 单次查询：使用 CASE WHEN 同时检查超级管理员和权限码
-        // 返回两个计数：is_superadmin 和 has_permission
-        std::string sql =
-            "SELECT "
-            "  COALESCE(MAX(CASE WHEN r.code = ? THEN 1 ELSE 0 END), 0) as is_superadmin, "
-            "  COUNT(DISTINCT m.permission_code) as permission_count "
-            "FROM sys_user_role ur "
-            "INNER JOIN sys_role r ON ur.role_id = r.id "
-            "LEFT JOIN sys_role_menu rm ON r.id = rm.role_id "
-            "LEFT JOIN sys_menu m ON rm.menu_id = m.id "
-            "  AND m.permission_code IN (" + permissionsPlaceholder + ") "
-            "  AND m.deleted_at IS NULL "
-            "WHERE ur.user_id = ? "
-            "  AND r.status = 'enabled' "
-            "  AND r.deleted_at IS NULL";
+        // 先取代数再查询：查询期间若有失效，写入会被丢弃，本次结果只用于当前请求
+        auto generation = AuthCache::permissionGeneration();
 
-        // 构建参数：角色码 → 权限码 → 用户ID
-        std::vector<std::string> params;
-        params.reserve(requiredPermissions.size() + 2);
-        params.emplace_back(Constants::ROLE_SUPERADMIN);
-        for (const auto& perm : requiredPermissions) {
-            params.push_back(perm);
-        }
-        params.push_back(std::to_string(userId));
+        static const auto& grantsStmt = PreparedStatementRegistry::instance().define("permission.snapshot.grants", R"(
+            SELECT r.code AS role_code, m.permission_code
+            FROM sys_user_role ur
+            INNER JOIN sys_role r ON ur.role_id = r.id
+            LEFT JOIN sys_role_menu rm ON r.id = rm.role_id
+            LEFT JOIN sys_menu m ON rm.menu_id = m.id
+              AND m.permission_code IS NOT NULL
+              AND m.permission_code <> ''
+              AND m.deleted_at IS NULL
+            WHERE ur.user_id = ?
+              AND r.status = 'enabled'
+              AND r.deleted_at IS NULL
+        )");
 
-        auto result = co_await dbService.execSqlCoro(sql, params);
+        // 用户级分享 + 所在部门的部门级分享；同一设备命中多条时取更高权限 control
+        static const auto& sharesStmt = PreparedStatementRegistry::instance().define("permission.snapshot.shares", R"(
+            WITH share_scope AS (
+                SELECT
+                    ds.device_id,
+                    COALESCE((ds.permission->>'control')::boolean, false) AS can_control,
+                    NULLIF(ds.permission->>'target_type', '') AS target_type,
+                    CASE
+                        WHEN jsonb_exists(ds.permission, 'target_id')
+                             AND jsonb_typeof(ds.permission->'target_id') = 'number'
+                            THEN (ds.permission->>'target_id')::INT
+                        WHEN jsonb_exists(ds.permission, 'target_id')
+                             AND jsonb_typeof(ds.permission->'target_id') = 'string'
+                             AND (ds.permission->>'target_id') ~ '^[0-9]+$'
+                            THEN (ds.permission->>'target_id')::INT
+                        ELSE NULL
+                    END AS target_id
+                FROM device_share ds
+            )
+            SELECT ss.device_id, bool_or(ss.can_control) AS can_control
+            FROM share_scope ss
+            LEFT JOIN sys_user su ON su.id = ? AND su.deleted_at IS NULL
+            WHERE (
+                ss.target_type = 'user'
+                AND ss.target_id = ?
+              )
+              OR (
+                ss.target_type = 'department'
+                AND su.department_id IS NOT NULL
+                AND ss.target_id = su.department_id
+              )
+            GROUP BY ss.device_id
+        )");
 
-        if (result.empty()) {
-            co_return false;
-        }
+        DatabaseService dbService;
+        const auto uid = std::to_string(userId);
+        auto grants = co_await dbService.execPreparedCoro(grantsStmt, {uid});
+        auto shares = co_await dbService.execPreparedCoro(sharesStmt, {uid, uid});
 
-        // 检查是否是超级管理员
-        if (FieldHelper::getInt(result[0]["is_superadmin"]) > 0) {
-            co_return true;
+        auto snapshot = std::make_shared<PermissionSnapshot>();
+        for (const auto& row : grants) {
+            if (FieldHelper::getString(row["role_code"]) == Constants::ROLE_SUPERADMIN) {
+                snapshot->isSuperAdmin = true;
+            }
+            if (!row["permission_code"].isNull()) {
+                snapshot->permissionCodes.insert(row["permission_code"].as<std::string>());
+            }
+        }
+        for (const auto& row : shares) {
+            snapshot->deviceShares[FieldHelper::getInt(row["device_id"])] =
+                FieldHelper::getBool(row["can_control"], false);
         }
 
-        // 检查是否有任意一个所需权限
-        co_return FieldHelper::getInt(result[0]["permission_count"]) > 0;
+        std::shared_ptr<const PermissionSnapshot> result = std::move(snapshot);
+        authCache().cachePermissionSnapshot(userId, result, generation);
+        co_return result;
     }
 
     /**
@@ -105,4 +132,10 @@ public:
             throw AuthException::NoPermission("无权限访问此资源");
         }
     }
+
+private:
+    static AuthCache& authCache() {
+        static AuthCache cache;
+        return cache;
+    }
 };
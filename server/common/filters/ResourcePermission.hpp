@@ -1,7 +1,8 @@
 #pragma once
 
 #include "PermissionFilter.hpp"
-#include "common/database/DatabaseService.hpp"
+#include "common/cache/DeviceCache.hpp"
+#include "common/database/PreparedStatements.hpp"
 #include "common/utils/AppException.hpp"
 #include "common/utils/FieldHelper.hpp"
 #include "common/utils/SqlHelper.hpp"
@@ -101,125 +102,19 @@ public:
             co_return permissions;
         }
 
-        auto [placeholders, idParams] = SqlHelper::buildParameterizedIn(deviceIds);
-        std::vector<std::string> params;
-        params.reserve(2 + idParams.size());
-        params.push_back(std::to_string(userId));
-        params.insert(params.end(), idParams.begin(), idParams.end());
-        params.push_back(std::to_string(userId));
-
-        DatabaseService db;
-        std::string sql = R"(
-            WITH share_scope AS (
-                SELECT
-                    ds.device_id,
-                    COALESCE((ds.permission->>'control')::boolean, false) AS can_control,
-                    NULLIF(ds.permission->>'target_type', '') AS target_type,
-                    CASE
-                        WHEN jsonb_exists(ds.permission, 'target_id')
-                             AND jsonb_typeof(ds.permission->'target_id') = 'number'
-                            THEN (ds.permission->>'target_id')::INT
-                        WHEN jsonb_exists(ds.permission, 'target_id')
-                             AND jsonb_typeof(ds.permission->'target_id') = 'string'
-                             AND (ds.permission->>'target_id') ~ '^[0-9]+$'
-                            THEN (ds.permission->>'target_id')::INT
-                        ELSE NULL
-                    END AS target_id
-                FROM device_share ds
-            )
-            SELECT ss.device_id,
-                   ss.can_control
-            FROM share_scope ss
-            LEFT JOIN sys_user su ON su.id = ? AND su.deleted_at IS NULL
-            WHERE ss.device_id IN (
-        )";
-        sql += placeholders;
-        sql += R"(
-            )
-              AND (
-                (
-                    ss.target_type = 'user'
-                    AND ss.target_id = ?
-                )
-                OR (
-                    ss.target_type = 'department'
-                    AND su.department_id IS NOT NULL
-                    AND ss.target_id = su.department_id
-                )
-              )
-        )";
-
-        auto rows = co_await db.execSqlCoro(sql, params);
-
-        for (const auto& row : rows) {
-            int deviceId = FieldHelper::getInt(row["device_id"]);
-            std::string permission = FieldHelper::getBool(row["can_control"], false) ? "control" : "view";
-            auto it = permissions.find(deviceId);
-            if (it == permissions.end()) {
-                permissions[deviceId] = permission;
-                continue;
-            }
-            // 同时命中用户级和部门级时，取更高权限 control
-            if (it->second != "control" && permission == "control") {
-                it->second = "control";
+        auto snapshot = co_await PermissionChecker::loadSnapshot(userId);
+        for (int deviceId : deviceIds) {
+            auto permission = snapshot->sharePermission(deviceId);
+            if (!permission.empty()) {
+                permissions[deviceId] = std::move(permission);
             }
         }
         co_return permissions;
     }
 
     static Task<std::string> getSingleDeviceSharePermission(int deviceId, int userId) {
-        DatabaseService db;
-        auto rows = co_await db.execSqlCoro(
-            R"(
-                WITH share_scope AS (
-                    SELECT
-                        ds.device_id,
-                        COALESCE((ds.permission->>'control')::boolean, false) AS can_control,
-                        NULLIF(ds.permission->>'target_type', '') AS target_type,
-                        CASE
-                            WHEN jsonb_exists(ds.permission, 'target_id')
-                                 AND jsonb_typeof(ds.permission->'target_id') = 'number'
-                                THEN (ds.permission->>'target_id')::INT
-                            WHEN jsonb_exists(ds.permission, 'target_id')
-                                 AND jsonb_typeof(ds.permission->'target_id') = 'string'
-                                 AND (ds.permission->>'target_id') ~ '^[0-9]+$'
-                                THEN (ds.permission->>'target_id')::INT
-                            ELSE NULL
-                        END AS target_id
-                    FROM device_share ds
-                )
-                SELECT ss.can_control
-                FROM share_scope ss
-                LEFT JOIN sys_user su ON su.id = ? AND su.deleted_at IS NULL
-                WHERE ss.device_id = ?
-                  AND (
-                    (
-                        ss.target_type = 'user'
-                        AND ss.target_id = ?
-                    )
-                    OR (
-                        ss.target_type = 'department'
-                        AND su.department_id IS NOT NULL
-                        AND ss.target_id = su.department_id
-                    )
-                  )
-            )",
-            {std::to_string(userId), std::to_string(deviceId), std::to_string(userId)}
-        );
-        if (rows.empty()) {
-            co_return "";
-        }
-        std::string effective;
-        for (const auto& row : rows) {
-            const bool canControl = FieldHelper::getBool(row["can_control"], false);
-            if (canControl) {
-                co_return "control";
-            }
-            if (effective.empty()) {
-                effective = "view";
-            }
-        }
-        co_return effective;
+        auto snapshot = co_await PermissionChecker::loadSnapshot(userId);
+        co_return snapshot->sharePermission(deviceId);
     }
 
 private:
@@ -252,21 +147,26 @@ private:
     ) {
         DeviceAccessInfo info;
 
-        DatabaseService db;
-        auto rows = co_await db.execSqlCoro(
-            "SELECT created_by FROM device WHERE id = ? AND deleted_at IS NULL",
-            {std::to_string(deviceId)}
-        );
-        if (rows.empty()) {
-            throw NotFoundException(resourceName + "不存在");
-        }
-        if (!rows[0]["created_by"].isNull()) {
-            info.creatorId = FieldHelper::getInt(rows[0]["created_by"]);
+        // 创建者优先取设备缓存，未命中（缓存未加载或刚创建）时回查数据库
+        if (auto cached = DeviceCache::instance().findByIdSync(deviceId)) {
+            info.creatorId = cached->createdBy;
+        } else {
+            static const auto& stmt = PreparedStatementRegistry::instance().define(
+                "device.createdBy", "SELECT created_by FROM device WHERE id = ? AND deleted_at IS NULL");
+            DatabaseService db;
+            auto rows = co_await db.execPreparedCoro(stmt, {std::to_string(deviceId)});
+            if (rows.empty()) {
+                throw NotFoundException(resourceName + "不存在");
+            }
+            if (!rows[0]["created_by"].isNull()) {
+                info.creatorId = FieldHelper::getInt(rows[0]["created_by"]);
+            }
         }
 
-        info.isSuperAdmin = co_await PermissionChecker::isSuperAdmin(userId);
+        auto snapshot = co_await PermissionChecker::loadSnapshot(userId);
+        info.isSuperAdmin = snapshot->isSuperAdmin;
         if (!info.isSuperAdmin && info.creatorId != userId) {
-            info.sharePermission = co_await getSingleDeviceSharePermission(deviceId, userId);
+            info.sharePermission = snapshot->sharePermission(deviceId);
         }
 
         co_return info;
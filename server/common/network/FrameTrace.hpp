@@ -0,0 +1,445 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief 链路原始报文追踪环（常开）
+ *
+ * 每个收发线程持有一个私有环形缓冲区，按固定大小的块轮转：写满当前块即切到下一块并
+ * 覆盖其中最旧的记录。记录为 定长头 + 连接地址 + 报文字节，写入只做一次 memcpy，
+ * 不做十六进制格式化；锁只在导出快照时才会出现竞争。
+ *
+ * 记录在 TcpLinkManager 收发处写入（linkId、对端地址），设备 ID 由协议层发送时通过
+ * DeviceScope 注入；接收侧在链路层尚不知道设备，导出时按“同一连接上该设备的发送记录”
+ * 关联（见 snapshot 的 deviceId 过滤）。
+ *
+ * 配置（custom_config.frame_trace，可选，仅启动时生效）：
+ * - enabled: 默认 true
+ * - bytes_per_thread: 每线程缓冲字节数，默认 1 MiB
+ * - max_frame_bytes: 单条报文最多保留的字节数，默认 1024（超出截断，记录原长度）
+ */
+class FrameTrace {
+public:
+    enum class Direction : uint8_t {
+        Rx = 0,
+        Tx = 1
+    };
+
+    struct Record {
+        int64_t timeUs = 0;        // system_clock 微秒
+        Direction direction = Direction::Rx;
+        int linkId = 0;
+        int deviceId = 0;
+        std::string connection;    // 对端地址 ip:port
+        uint32_t originalSize = 0;
+        std::string payload;       // 可能被截断
+    };
+
+    struct Filter {
+        std::optional<int> linkId;
+        std::optional<int> deviceId;
+        size_t limit = 500;
+    };
+
+    static FrameTrace& instance() {
+        static FrameTrace inst;
+        return inst;
+    }
+
+    /**
+     * @brief 读取配置（须在链路启动前调用；已创建的线程缓冲不受影响）
+     */
+    void configure() {
+        auto config = drogon::app().getCustomConfig();
+        if (!config.isMember("frame_trace") || !config["frame_trace"].isObject()) {
+            return;
+        }
+        const auto& section = config["frame_trace"];
+        enabled_ = section.get("enabled", enabled_).asBool();
+        bytesPerThread_ = std::clamp<size_t>(
+            section.get("bytes_per_thread", static_cast<Json::UInt64>(bytesPerThread_)).asUInt64(),
+            MIN_BUFFER_BYTES, size_t{256} << 20);
+        // 单条记录不能超过一个块
+        const size_t chunkPayloadLimit = bytesPerThread_ / CHUNK_COUNT - sizeof(RecordHeader) - MAX_CONNECTION_BYTES;
+        maxFrameBytes_ = std::clamp<size_t>(
+            section.get("max_frame_bytes", static_cast<Json::UInt64>(maxFrameBytes_)).asUInt64(),
+            16, std::min<size_t>(65535, chunkPayloadLimit));
+    }
+
+    bool enabled() const {
+        return enabled_;
+    }
+
+    void record(Direction direction, int linkId, std::string_view connection, std::string_view data) {
+        if (!enabled_) return;
+        ThreadRing* ring = threadRing();
+        if (!ring) return;
+
+        RecordHeader header;
+        header.timeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        header.linkId = linkId;
+        header.deviceId = currentDeviceId_;
+        header.originalSize = static_cast<uint32_t>(data.size());
+        header.payloadSize = static_cast<uint16_t>(std::min(data.size(), maxFrameBytes_));
+        header.direction = static_cast<uint8_t>(direction);
+        header.connectionSize = static_cast<uint8_t>(std::min<size_t>(connection.size(), MAX_CONNECTION_BYTES));
+        ring->append(header, connection.data(), data.data());
+    }
+
+    /**
+     * @brief 标注当前线程后续发送的报文所属设备（协议层发送时使用）
+     */
+    class DeviceScope {
+    public:
+        explicit DeviceScope(int deviceId)
+            : previous_(currentDeviceId_) {
+            currentDeviceId_ = deviceId;
+        }
+        ~DeviceScope() {
+            currentDeviceId_ = previous_;
+        }
+        DeviceScope(const DeviceScope&) = delete;
+        DeviceScope& operator=(const DeviceScope&) = delete;
+
+    private:
+        int previous_;
+    };
+
+    /**
+     * @brief 汇总各线程缓冲，按时间升序返回最近 limit 条匹配记录
+     *
+     * deviceId 过滤：记录自带该设备 ID，或与该设备的发送记录处于同一连接（linkId + 对端地址）。
+     *
+     * 过滤和 limit 在遍历缓冲时完成：每个线程缓冲在锁内只由新到旧复制最多 limit 条匹配
+     * 记录的原始字节，解码为 Record 放到锁外。deviceId 过滤需先扫一遍头部收集连接。
+     */
+    std::vector<Record> snapshot(const Filter& filter) const {
+        std::vector<std::shared_ptr<ThreadRing>> rings;
+        {
+            std::lock_guard lock(ringsMutex_);
+            rings = rings_;
+        }
+
+        const auto linkMatches = [&filter](const RecordHeader& header) {
+            return !filter.linkId || header.linkId == *filter.linkId;
+        };
+        const auto connectionLess = [](const auto& a, const auto& b) {
+            return a.first != b.first ? a.first < b.first
+                                      : std::string_view(a.second) < std::string_view(b.second);
+        };
+
+        std::vector<std::pair<int, std::string>> connections;
+        if (filter.deviceId) {
+            for (const auto& ring : rings) {
+                ring->scan([&](const RecordHeader& header, std::string_view connection) {
+                    if (header.deviceId == *filter.deviceId && linkMatches(header)) {
+                        connections.emplace_back(header.linkId, std::string(connection));
+                    }
+                });
+            }
+            std::sort(connections.begin(), connections.end(), connectionLess);
+            connections.erase(std::unique(connections.begin(), connections.end()), connections.end());
+        }
+
+        const auto accept = [&](const RecordHeader& header, std::string_view connection) {
+            if (!linkMatches(header)) return false;
+            if (!filter.deviceId || header.deviceId == *filter.deviceId) return true;
+            if (header.deviceId != 0) return false;
+            return std::binary_search(connections.begin(), connections.end(),
+                                      std::make_pair(static_cast<int>(header.linkId), connection),
+                                      connectionLess);
+        };
+
+        const size_t limit = filter.limit > 0 ? filter.limit : SIZE_MAX;
+        std::vector<Record> records;
+        std::string raw;
+        for (const auto& ring : rings) {
+            raw.clear();
+            if (ring->copyNewest(raw, limit, accept) == 0) continue;
+            // 缓冲按由新到旧复制，解码后翻转回时间顺序
+            const auto begin = records.size();
+            decodeRecords(raw, records);
+            std::reverse(records.begin() + static_cast<std::ptrdiff_t>(begin), records.end());
+        }
+
+        std::stable_sort(records.begin(), records.end(), [](const Record& a, const Record& b) {
+            return a.timeUs < b.timeUs;
+        });
+        if (filter.limit > 0 && records.size() > filter.limit) {
+            records.erase(records.begin(), records.end() - static_cast<std::ptrdiff_t>(filter.limit));
+        }
+        return records;
+    }
+
+    /**
+     * @brief 导出为 pcap（LINKTYPE_USER0）
+     *
+     * 每个包的数据 = 16 字节元数据（方向 u8、保留 3 字节、linkId / deviceId / 原始长度
+     * 各 u32 大端）+ 报文字节，可在 Wireshark 中以自定义 DLT 查看或用脚本解析。
+     */
+    static std::string toPcap(const std::vector<Record>& records) {
+        std::string out;
+        appendLe32(out, 0xA1B2C3D4);  // 微秒精度
+        appendLe16(out, 2);
+        appendLe16(out, 4);
+        appendLe32(out, 0);
+        appendLe32(out, 0);
+        appendLe32(out, 65535 + PCAP_META_BYTES);
+        appendLe32(out, 147);         // LINKTYPE_USER0
+
+        for (const auto& r : records) {
+            const auto captured = static_cast<uint32_t>(PCAP_META_BYTES + r.payload.size());
+            appendLe32(out, static_cast<uint32_t>(r.timeUs / 1000000));
+            appendLe32(out, static_cast<uint32_t>(r.timeUs % 1000000));
+            appendLe32(out, captured);
+            appendLe32(out, static_cast<uint32_t>(PCAP_META_BYTES + r.originalSize));
+
+            out.push_back(static_cast<char>(r.direction));
+            out.append(3, '\0');
+            appendBe32(out, static_cast<uint32_t>(r.linkId));
+            appendBe32(out, static_cast<uint32_t>(r.deviceId));
+            appendBe32(out, r.originalSize);
+            out += r.payload;
+        }
+        return out;
+    }
+
+    /**
+     * @brief 导出为文本十六进制（每条一行头 + 每 16 字节一行）
+     */
+    static std::string toHexDump(const std::vector<Record>& records) {
+        static constexpr char HEX[] = "0123456789ABCDEF";
+        std::string out;
+        for (const auto& r : records) {
+            const auto seconds = static_cast<std::time_t>(r.timeUs / 1000000);
+            std::tm tm{};
+#ifdef _WIN32
+            localtime_s(&tm, &seconds);
+#else
+            localtime_r(&seconds, &tm);
+#endif
+            char time[32];
+            std::strftime(time, sizeof(time), "%Y-%m-%d %H:%M:%S", &tm);
+            char micros[8];
+            std::snprintf(micros, sizeof(micros), ".%06d", static_cast<int>(r.timeUs % 1000000));
+
+            out += time;
+            out += micros;
+            out += r.direction == Direction::Rx ? " RX" : " TX";
+            out += " link=" + std::to_string(r.linkId);
+            out += " device=" + std::to_string(r.deviceId);
+            out += " conn=" + r.connection;
+            out += " bytes=" + std::to_string(r.originalSize);
+            if (r.payload.size() < r.originalSize) {
+                out += " (truncated)";
+            }
+            out += '\n';
+
+            for (size_t offset = 0; offset < r.payload.size(); offset += 16) {
+                char prefix[12];
+                std::snprintf(prefix, sizeof(prefix), "  %04zx  ", offset);
+                out += prefix;
+                const size_t end = std::min(offset + 16, r.payload.size());
+                for (size_t i = offset; i < offset + 16; ++i) {
+                    if (i < end) {
+                        const auto byte = static_cast<unsigned char>(r.payload[i]);
+                        out += HEX[byte >> 4];
+                        out += HEX[byte & 0x0F];
+                        out += ' ';
+                    } else {
+                        out += "   ";
+                    }
+                }
+                out += ' ';
+                for (size_t i = offset; i < end; ++i) {
+                    const auto byte = static_cast<unsigned char>(r.payload[i]);
+                    out += (byte >= 0x20 && byte < 0x7F) ? static_cast<char>(byte) : '.';
+                }
+                out += '\n';
+            }
+        }
+        return out;
+    }
+
+private:
+    FrameTrace() = default;
+
+    static constexpr size_t MIN_BUFFER_BYTES = 128 * 1024;
+    static constexpr size_t CHUNK_COUNT = 16;
+    static constexpr size_t MAX_CONNECTION_BYTES = 64;
+    static constexpr size_t PCAP_META_BYTES = 16;
+
+    struct RecordHeader {
+        int64_t timeUs = 0;
+        int32_t linkId = 0;
+        int32_t deviceId = 0;
+        uint32_t originalSize = 0;
+        uint16_t payloadSize = 0;
+        uint8_t direction = 0;
+        uint8_t connectionSize = 0;
+    };
+
+    /**
+     * @brief 单线程缓冲：CHUNK_COUNT 个块轮转，块内记录紧密排列
+     */
+    class ThreadRing {
+    public:
+        explicit ThreadRing(size_t bytes)
+            : chunkBytes_(std::max(bytes, MIN_BUFFER_BYTES) / CHUNK_COUNT),
+              chunks_(CHUNK_COUNT) {
+            for (auto& chunk : chunks_) {
+                chunk.data = std::make_unique<uint8_t[]>(chunkBytes_);
+            }
+        }
+
+        void append(const RecordHeader& header, const char* connection, const char* payload) {
+            const size_t size = sizeof(RecordHeader) + header.connectionSize + header.payloadSize;
+            if (size > chunkBytes_) return;
+
+            std::lock_guard lock(mutex_);
+            if (chunks_[current_].used + size > chunkBytes_) {
+                current_ = (current_ + 1) % chunks_.size();
+                chunks_[current_].used = 0;
+            }
+            auto& chunk = chunks_[current_];
+            uint8_t* out = chunk.data.get() + chunk.used;
+            std::memcpy(out, &header, sizeof(RecordHeader));
+            std::memcpy(out + sizeof(RecordHeader), connection, header.connectionSize);
+            std::memcpy(out + sizeof(RecordHeader) + header.connectionSize, payload, header.payloadSize);
+            chunk.used += size;
+        }
+
+        /**
+         * @brief 遍历全部记录的头部与连接地址（不复制报文）
+         */
+        template<typename Visitor>
+        void scan(Visitor&& visit) const {
+            std::lock_guard lock(mutex_);
+            for (const auto& chunk : chunks_) {
+                forEachRecord(chunk, [&](const RecordHeader& header, std::string_view connection, size_t, size_t) {
+                    visit(header, connection);
+                });
+            }
+        }
+
+        /**
+         * @brief 由新到旧把最多 limit 条匹配记录的原始字节追加到 raw，返回条数
+         */
+        template<typename Predicate>
+        size_t copyNewest(std::string& raw, size_t limit, Predicate&& accept) const {
+            std::vector<std::pair<size_t, size_t>> matches;  // 块内偏移、记录长度
+            size_t copied = 0;
+            std::lock_guard lock(mutex_);
+            for (size_t i = 0; i < chunks_.size() && copied < limit; ++i) {
+                const auto& chunk = chunks_[(current_ + chunks_.size() - i) % chunks_.size()];
+                matches.clear();
+                forEachRecord(chunk, [&](const RecordHeader& header, std::string_view connection,
+                                         size_t offset, size_t size) {
+                    if (accept(header, connection)) {
+                        matches.emplace_back(offset, size);
+                    }
+                });
+                for (auto it = matches.rbegin(); it != matches.rend() && copied < limit; ++it, ++copied) {
+                    raw.append(reinterpret_cast<const char*>(chunk.data.get()) + it->first, it->second);
+                }
+            }
+            return copied;
+        }
+
+    private:
+        struct Chunk {
+            std::unique_ptr<uint8_t[]> data;
+            size_t used = 0;
+        };
+
+        template<typename Visitor>
+        static void forEachRecord(const Chunk& chunk, Visitor&& visit) {
+            const auto* base = reinterpret_cast<const char*>(chunk.data.get());
+            size_t offset = 0;
+            while (offset + sizeof(RecordHeader) <= chunk.used) {
+                RecordHeader header;
+                std::memcpy(&header, base + offset, sizeof(RecordHeader));
+                const size_t size = sizeof(RecordHeader) + header.connectionSize + header.payloadSize;
+                visit(header, std::string_view(base + offset + sizeof(RecordHeader), header.connectionSize),
+                      offset, size);
+                offset += size;
+            }
+        }
+
+        size_t chunkBytes_;
+        std::vector<Chunk> chunks_;
+        size_t current_ = 0;
+        mutable std::mutex mutex_;
+    };
+
+    /**
+     * @brief 把 copyNewest 复制出的原始字节解码为 Record（在锁外调用）
+     */
+    static void decodeRecords(std::string_view raw, std::vector<Record>& out) {
+        size_t offset = 0;
+        while (offset + sizeof(RecordHeader) <= raw.size()) {
+            RecordHeader header;
+            std::memcpy(&header, raw.data() + offset, sizeof(RecordHeader));
+            const char* body = raw.data() + offset + sizeof(RecordHeader);
+            offset += sizeof(RecordHeader) + header.connectionSize + header.payloadSize;
+
+            Record r;
+            r.timeUs = header.timeUs;
+            r.direction = static_cast<Direction>(header.direction);
+            r.linkId = header.linkId;
+            r.deviceId = header.deviceId;
+            r.originalSize = header.originalSize;
+            r.connection.assign(body, header.connectionSize);
+            r.payload.assign(body + header.connectionSize, header.payloadSize);
+            out.push_back(std::move(r));
+        }
+    }
+
+    ThreadRing* threadRing() {
+        thread_local ThreadRing* ring = nullptr;
+        if (!ring) {
+            auto created = std::make_shared<ThreadRing>(bytesPerThread_);
+            ring = created.get();
+            std::lock_guard lock(ringsMutex_);
+            rings_.push_back(std::move(created));
+        }
+        return ring;
+    }
+
+    static void appendLe16(std::string& out, uint16_t v) {
+        out.push_back(static_cast<char>(v & 0xFF));
+        out.push_back(static_cast<char>(v >> 8));
+    }
+
+    static void appendLe32(std::string& out, uint32_t v) {
+        for (int i = 0; i < 4; ++i) {
+            out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+        }
+    }
+
+    static void appendBe32(std::string& out, uint32_t v) {
+        for (int i = 3; i >= 0; --i) {
+            out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+        }
+    }
+
+    static inline thread_local int currentDeviceId_ = 0;
+
+    bool enabled_ = true;
+    size_t bytesPerThread_ = size_t{1} << 20;
+    size_t maxFrameBytes_ = 1024;
+    mutable std::mutex ringsMutex_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+};
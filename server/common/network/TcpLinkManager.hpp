@@ -1,5 +1,6 @@
 #pragma once
 
+#include "FrameTrace.hpp"
 #include "LinkState.hpp"
 
 #include <cstddef>
@@ -137,6 +138,16 @@ public:
         return drogon::app().getLoop();
     }
 
+    /**
+     * @brief 获取 TCP IO 线程池的全部 EventLoop（卡顿监测登记用）
+     */
+    std::vector<EventLoop*> getIoLoops() const {
+        if (initialized_ && ioLoopPool_) {
+            return ioLoopPool_->getLoops();
+        }
+        return {};
+    }
+
     /**
      * @brief 启动 TCP Server
      */
@@ -208,6 +219,7 @@ public:
 
             totalBytesRx_.fetch_add(static_cast<int64_t>(data.size()), std::memory_order_relaxed);
             totalPacketsRx_.fetch_add(1, std::memory_order_relaxed);
+            FrameTrace::instance().record(FrameTrace::Direction::Rx, linkId, clientAddr, data);
 
             // 无锁更新活动时间（高频消息路径避免锁竞争）
             rt->recordActivity();
@@ -311,6 +323,7 @@ public:
 
                 totalBytesRx_.fetch_add(static_cast<int64_t>(data.size()), std::memory_order_relaxed);
                 totalPacketsRx_.fetch_add(1, std::memory_order_relaxed);
+                FrameTrace::instance().record(FrameTrace::Direction::Rx, linkId, serverAddr, data);
 
                 // 无锁更新活动时间（高频消息路径避免锁竞争）
                 rt->recordActivity();
@@ -611,6 +624,7 @@ public:
 
         if (runtime->clientConn && runtime->clientConn->connected()) {
             runtime->clientConn->send(data);
+            traceTx(linkId, runtime->clientConn, data);
             totalBytesTx_.fetch_add(static_cast<int64_t>(data.size()), std::memory_order_relaxed);
             totalPacketsTx_.fetch_add(1, std::memory_order_relaxed);
             return true;
@@ -621,6 +635,7 @@ public:
             for (const auto& conn : runtime->serverConns) {
                 if (conn->connected()) {
                     conn->send(data);
+                    traceTx(linkId, conn, data);
                     ++sentCount;
                 }
             }
@@ -643,6 +658,7 @@ public:
         std::lock_guard<std::mutex> connLock(runtime->connMutex);
         if (!runtime->clientConn || !runtime->clientConn->connected()) return false;
         runtime->clientConn->send(data);
+        traceTx(linkId, runtime->clientConn, data);
         totalBytesTx_.fetch_add(static_cast<int64_t>(data.size()), std::memory_order_relaxed);
         totalPacketsTx_.fetch_add(1, std::memory_order_relaxed);
         return true;
@@ -670,6 +686,7 @@ public:
             for (const auto& conn : runtime->serverConns) {
                 if (conn->connected() && excludeAddrs.find(conn->peerAddr().toIpPort()) == excludeAddrs.end()) {
                     conn->send(data);
+                    traceTx(linkId, conn, data);
                     ++sentCount;
                 }
             }
@@ -696,6 +713,7 @@ public:
         for (const auto& conn : runtime->serverConns) {
             if (conn->connected() && conn->peerAddr().toIpPort() == clientAddr) {
                 conn->send(data);
+                FrameTrace::instance().record(FrameTrace::Direction::Tx, linkId, clientAddr, data);
                 totalBytesTx_.fetch_add(static_cast<int64_t>(data.size()), std::memory_order_relaxed);
                 totalPacketsTx_.fetch_add(1, std::memory_order_relaxed);
                 return true;
@@ -857,6 +875,13 @@ private:
         return std::to_string(linkId) + ":" + targetId;
     }
 
+    /** 发送追踪（关闭时不取对端地址） */
+    static void traceTx(int linkId, const TcpConnectionPtr& conn, const std::string& data) {
+        auto& trace = FrameTrace::instance();
+        if (!trace.enabled()) return;
+        trace.record(FrameTrace::Direction::Tx, linkId, conn->peerAddr().toIpPort(), data);
+    }
+
     void stopRuntime(const std::shared_ptr<LinkRuntime>& runtime) {
         if (!runtime) return;
         {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "common/utils/LoopWatchdog.hpp"
+
 /**
  * @brief WebSocket 连接会话（存储在连接 context 中）
  */
@@ -73,6 +75,7 @@ public:
 
     /** 广播给所有连接（先快照再发送，避免持锁期间调用 send） */
     void broadcast(const std::string& type, const Json::Value& data) {
+        LoopWatchdog::TaskScope task("ws.broadcast");
         std::vector<WebSocketConnectionPtr> snapshot;
         {
             std::shared_lock lock(mutex_);
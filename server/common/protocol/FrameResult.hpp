@@ -2,6 +2,7 @@
 
 #include <json/json.h>
 
+#include <chrono>
 #include <optional>
 #include <string>
 
@@ -28,4 +29,8 @@ struct ParsedFrameResult {
         bool success = false;
     };
     std::optional<CommandCompletion> commandCompletion;
+
+    // 阶段耗时统计：收到报文的时刻与提交攒批写入的时刻（未设置时由分发器补齐）
+    std::chrono::steady_clock::time_point receivedAt{};
+    std::chrono::steady_clock::time_point submittedAt{};
 };
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "common/utils/Metrics.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 接入链路各阶段耗时指标
+ *
+ * 统一直方图 iot_ingest_stage_seconds{stage, protocol, link}：
+ * - ingress:      链路回调到交给协议适配器（缓存查表、协议路由）
+ * - framing:      从接收缓冲切出完整报文
+ * - parse:        报文解析为设备数据（含应答匹配）
+ * - queue_wait:   解析结果提交到攒批写入开始
+ * - batch_flush:  一个批次从开始写入到推送完成
+ * - db_insert:    批量写 device_data
+ * - cache_merge:  合并实时缓存
+ * - alert_eval:   告警规则评估
+ * - ws_broadcast: WebSocket 实时推送
+ * - webhook:      单次 Webhook 投递（含 HTTP 往返）
+ * - end_to_end:   收到报文到入库、推送完成
+ *
+ * 批次级阶段（batch_flush / db_insert / ws_broadcast / webhook）跨协议、跨链路，
+ * protocol 与 link 固定为 "all"。链路标签序列数超过上限后折叠为 "other"。
+ */
+namespace ingest_metrics {
+
+using Clock = std::chrono::steady_clock;
+
+enum class Stage : uint8_t {
+    Ingress,
+    Framing,
+    Parse,
+    QueueWait,
+    BatchFlush,
+    DbInsert,
+    CacheMerge,
+    AlertEval,
+    WsBroadcast,
+    Webhook,
+    EndToEnd,
+    Count_
+};
+
+inline constexpr std::array<std::string_view, static_cast<size_t>(Stage::Count_)> STAGE_NAMES{
+    "ingress", "framing", "parse", "queue_wait", "batch_flush", "db_insert",
+    "cache_merge", "alert_eval", "ws_broadcast", "webhook", "end_to_end"
+};
+
+inline constexpr std::string_view ALL_LABEL = "all";
+
+/** 100us ~ 10s，覆盖解析（微秒级）到入库推送（秒级） */
+inline const std::vector<double>& stageBuckets() {
+    static const std::vector<double> buckets{
+        0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+        0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+    };
+    return buckets;
+}
+
+/** 链路标签：Agent 上报（linkId=0）与批次级阶段分别归类 */
+inline std::string linkLabel(int linkId) {
+    if (linkId < 0) return std::string(ALL_LABEL);
+    return linkId == 0 ? std::string("agent") : std::to_string(linkId);
+}
+
+inline metrics::Family<metrics::Histogram>& stageFamily() {
+    static auto& family = metrics::MetricsRegistry::instance().histogram(
+        "iot_ingest_stage_seconds",
+        "Latency of each ingest pipeline stage in seconds",
+        {"stage", "protocol", "link"},
+        stageBuckets(),
+        1024);
+    return family;
+}
+
+/**
+ * @brief 取阶段直方图序列（线程本地缓存，热路径不构造标签字符串、不取注册表锁）
+ */
+inline metrics::Histogram& stageHistogram(Stage stage, std::string_view protocol, int linkId) {
+    struct CacheEntry {
+        std::string protocol;
+        metrics::Histogram* histogram;
+    };
+    thread_local std::unordered_map<uint64_t, std::vector<CacheEntry>> cache;
+
+    const uint64_t key = (static_cast<uint64_t>(stage) << 32) | static_cast<uint32_t>(linkId);
+    auto& entries = cache[key];
+    for (const auto& entry : entries) {
+        if (entry.protocol == protocol) {
+            return *entry.histogram;
+        }
+    }
+
+    const auto link = linkLabel(linkId);
+    auto& histogram = stageFamily().with({
+        STAGE_NAMES[static_cast<size_t>(stage)],
+        protocol.empty() ? std::string_view("unknown") : protocol,
+        link
+    });
+    entries.push_back({std::string(protocol), &histogram});
+    return histogram;
+}
+
+inline void observe(Stage stage, std::string_view protocol, int linkId, Clock::duration elapsed) {
+    stageHistogram(stage, protocol, linkId).observeDuration(elapsed);
+}
+
+/** 批次级阶段（protocol / link 均为 "all"） */
+inline void observeBatch(Stage stage, Clock::duration elapsed) {
+    observe(stage, ALL_LABEL, -1, elapsed);
+}
+
+/**
+ * @brief 作用域计时：析构时记录从构造到析构的耗时
+ */
+class StageTimer {
+public:
+    StageTimer(Stage stage, std::string_view protocol, int linkId)
+        : histogram_(&stageHistogram(stage, protocol, linkId)), start_(Clock::now()) {}
+
+    ~StageTimer() {
+        histogram_->observeDuration(Clock::now() - start_);
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    metrics::Histogram* histogram_;
+    Clock::time_point start_;
+};
+
+/** 接入字节/报文计数（按协议、链路） */
+inline void countIngress(std::string_view protocol, int linkId, size_t bytes) {
+    static auto& bytesFamily = metrics::MetricsRegistry::instance().counter(
+        "iot_ingress_bytes_total", "Bytes routed to protocol adapters", {"protocol", "link"}, 1024);
+    static auto& packetsFamily = metrics::MetricsRegistry::instance().counter(
+        "iot_ingress_packets_total", "Packets routed to protocol adapters", {"protocol", "link"}, 1024);
+
+    struct CacheEntry {
+        std::string protocol;
+        metrics::Counter* bytes;
+        metrics::Counter* packets;
+    };
+    thread_local std::unordered_map<int, std::vector<CacheEntry>> cache;
+
+    auto& entries = cache[linkId];
+    for (const auto& entry : entries) {
+        if (entry.protocol == protocol) {
+            entry.bytes->inc(bytes);
+            entry.packets->inc();
+            return;
+        }
+    }
+
+    const auto link = linkLabel(linkId);
+    CacheEntry entry{
+        std::string(protocol),
+        &bytesFamily.with({protocol, link}),
+        &packetsFamily.with({protocol, link})
+    };
+    entry.bytes->inc(bytes);
+    entry.packets->inc();
+    entries.push_back(std::move(entry));
+}
+
+}  // namespace ingest_metrics
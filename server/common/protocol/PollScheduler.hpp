@@ -2,13 +2,20 @@
 
 #include "common/network/TcpLinkManager.hpp"
 #include "common/protocol/ProtocolLog.hpp"
+#include "common/utils/LoopWatchdog.hpp"
+
+#include <drogon/drogon.h>
+#include <json/json.h>
 
 #include <algorithm>
 #include <chrono>
 #include <functional>
 #include <map>
 #include <mutex>
+#include <queue>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -16,17 +23,28 @@
  * @brief 协议无关的设备轮询调度器
  *
  * 统一 Modbus / S7 等协议共有的轮询语义：
- * - 周期 tick 与到期投递
+ * - 按到期时间排序的最小堆 + 单次定时器，只处理已到期的设备，周期精确到毫秒
  * - 单设备轮询周期 in-progress 保护
  * - 多 step 轮询推进（Modbus 读组）；单 step 协议使用 stepCount=1
  * - 失败重试、连续失败降频
  * - 指令后快读窗口
- * - 按 groupKey 错峰和按组启停
+ * - 按组启停；同一限速键下相同周期的设备按设备 ID 均匀分布相位，增删设备时重新分布
+ * - 按限速键（默认链路，Modbus 为 DTU）令牌桶整形：每秒请求数 / 每秒字节数
+ * - 单轮投递有上限时按限速键轮转，键内按到期先后，避免固定偏向小 ID 设备
+ * - 每设备投递迟到（实际投递 - 应到期）统计
  *
  * 实际报文构建、session 队列和 in-flight 处理仍由协议引擎负责。
  */
 class ProtocolPollScheduler {
 public:
+    using Clock = std::chrono::steady_clock;
+
+    /** 限速参数，0 表示不限 */
+    struct RateLimit {
+        double requestsPerSec = 0.0;
+        double bytesPerSec = 0.0;
+    };
+
     struct TaskConfig {
         int deviceId = 0;
         std::string deviceName;
@@ -34,19 +52,36 @@ public:
         int linkId = 0;
         size_t stepCount = 1;
         int intervalSec = 1;
+        int intervalMs = 0;  // >0 时优先于 intervalSec（亚秒级轮询）
         int fastReadDurationSec = 60;
         int fastReadIntervalSec = 1;
         bool enabled = true;
+        std::string rateKey;       // 整形/分道键，为空时按链路（无链路按设备）
+        size_t bytesPerCycle = 0;  // 单周期请求 + 应答字节估算，0 表示不按字节整形
+        RateLimit rateLimit;       // 设备配置的限速，同键取最严，未配置时用全局默认
+    };
+
+    /** 单设备投递迟到统计 */
+    struct LatenessStats {
+        int deviceId = 0;
+        std::string deviceName;
+        int linkId = 0;
+        int64_t intervalMs = 0;
+        int64_t lastMs = 0;
+        int64_t maxMs = 0;
+        double avgMs = 0.0;  // 指数滑动平均
+        uint64_t dispatches = 0;
     };
 
     using EnqueueCallback = std::function<bool(int deviceId, size_t stepIndex)>;
 
     explicit ProtocolPollScheduler(std::string logPrefix)
-        : logPrefix_(std::move(logPrefix)) {}
+        : logPrefix_(std::move(logPrefix))
+        , defaultLimit_(loadDefaultRateLimit()) {}
 
     ~ProtocolPollScheduler() {
         std::lock_guard<std::mutex> lock(mutex_);
-        stopTickLocked();
+        stopTimerLocked();
     }
 
     void setEnqueueCallback(EnqueueCallback cb) {
@@ -58,67 +93,103 @@ public:
     }
 
     void reload(const std::vector<TaskConfig>& configs, bool preserveInProgress) {
-        std::vector<std::pair<int, size_t>> immediateSteps;
-        const auto now = std::chrono::steady_clock::now();
+        const auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
 
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
+        std::map<int, PollEntry> rebuilt;
+        std::unordered_map<std::string, RateLimit> limits;
+        std::unordered_map<int, Clock::duration> previousPhases;
+        std::unordered_set<int> spreadFromNow;
 
-            std::map<int, PollEntry> rebuilt;
-            std::map<std::string, int> groupStagger;
+        for (const auto& config : configs) {
+            if (config.deviceId <= 0 || config.stepCount == 0) {
+                continue;
+            }
 
-            for (const auto& config : configs) {
-                if (config.deviceId <= 0 || config.stepCount == 0) {
-                    continue;
-                }
+            PollEntry entry;
+            entry.deviceId = config.deviceId;
+            entry.deviceName = config.deviceName;
+            entry.groupKey = config.groupKey;
+            entry.linkId = config.linkId;
+            entry.rateKey = !config.rateKey.empty() ? config.rateKey
+                : config.linkId > 0 ? "link:" + std::to_string(config.linkId)
+                : "device:" + std::to_string(config.deviceId);
+            entry.stepCount = config.stepCount;
+            entry.bytesPerCycle = config.bytesPerCycle;
+            entry.interval = config.intervalMs > 0
+                ? std::chrono::milliseconds(std::clamp(config.intervalMs, MIN_INTERVAL_MS, MAX_INTERVAL_MS))
+                : std::chrono::seconds(std::max(1, config.intervalSec));
+            entry.fastReadDurationSec = std::clamp(config.fastReadDurationSec, 0, 3600);
+            entry.fastReadIntervalSec = std::clamp(config.fastReadIntervalSec, 1, 60);
+            entry.enabled = config.enabled;
+            entry.nextDueTime = now;
 
-                PollEntry entry;
-                entry.deviceId = config.deviceId;
-                entry.deviceName = config.deviceName;
-                entry.groupKey = config.groupKey;
-                entry.linkId = config.linkId;
-                entry.stepCount = config.stepCount;
-                entry.intervalSec = std::max(1, config.intervalSec);
-                entry.fastReadDurationSec = std::clamp(config.fastReadDurationSec, 0, 3600);
-                entry.fastReadIntervalSec = std::clamp(config.fastReadIntervalSec, 1, 60);
-                entry.enabled = config.enabled;
-                entry.nextDueTime = now;
-
-                auto oldIt = pollEntries_.find(config.deviceId);
-                if (oldIt != pollEntries_.end()) {
-                    entry.enabled = config.enabled;
-                    entry.cycleInProgress = preserveInProgress && oldIt->second.cycleInProgress;
-                    entry.consecutiveFailures = oldIt->second.consecutiveFailures;
-                    entry.fastReadUntil = oldIt->second.fastReadUntil;
-                    entry.nextDueTime = oldIt->second.nextDueTime;
-                    entry.nextStepIndex = std::min(oldIt->second.nextStepIndex, entry.stepCount - 1);
-                    if (!preserveInProgress && entry.enabled) {
-                        entry.nextStepIndex = 0;
-                        entry.nextDueTime = now;
-                    }
-                } else if (entry.enabled) {
-                    const int idx = groupStagger[entry.groupKey]++;
-                    if (idx == 0) {
-                        entry.cycleInProgress = true;
-                        entry.nextStepIndex = 0;
-                        immediateSteps.emplace_back(entry.deviceId, 0);
-                    } else {
-                        entry.nextDueTime = now + std::chrono::seconds(idx);
-                    }
+            auto [limitIt, inserted] = limits.try_emplace(entry.rateKey, config.rateLimit);
+            if (!inserted) {
+                limitIt->second = stricter(limitIt->second, config.rateLimit);
+            }
+
+            auto oldIt = pollEntries_.find(config.deviceId);
+            if (oldIt != pollEntries_.end()) {
+                entry.cycleInProgress = preserveInProgress && oldIt->second.cycleInProgress;
+                entry.consecutiveFailures = oldIt->second.consecutiveFailures;
+                entry.fastReadUntil = oldIt->second.fastReadUntil;
+                entry.nextDueTime = oldIt->second.nextDueTime;
+                entry.nextStepIndex = std::min(oldIt->second.nextStepIndex, entry.stepCount - 1);
+                entry.lateness = oldIt->second.lateness;
+                if (oldIt->second.interval == entry.interval && oldIt->second.rateKey == entry.rateKey) {
+                    previousPhases.emplace(entry.deviceId, oldIt->second.phase);
+                }
+                if (!preserveInProgress && entry.enabled) {
+                    entry.nextStepIndex = 0;
+                    spreadFromNow.insert(entry.deviceId);
                 }
+            } else if (entry.enabled) {
+                spreadFromNow.insert(entry.deviceId);
+            }
+
+            rebuilt.emplace(entry.deviceId, std::move(entry));
+        }
+
+        pollEntries_ = std::move(rebuilt);
+        assignPhasesLocked();
 
-                rebuilt.emplace(entry.deviceId, std::move(entry));
+        // 新增/重置的设备在首轮窗口内按相位错开；相位变化的设备改到新相位的下一个时隙
+        for (int deviceId : spreadFromNow) {
+            auto& entry = pollEntries_.at(deviceId);
+            entry.nextDueTime = spreadStart(entry, now);
+        }
+        for (auto& [deviceId, entry] : pollEntries_) {
+            auto phaseIt = previousPhases.find(deviceId);
+            if (entry.cycleInProgress || entry.nextDueTime <= now || spreadFromNow.count(deviceId) > 0
+                || (phaseIt != previousPhases.end() && phaseIt->second == entry.phase)) {
+                continue;
             }
+            entry.nextDueTime = nextPhaseSlot(entry, now);
+        }
 
-            pollEntries_ = std::move(rebuilt);
-            if (pollEntries_.empty()) {
-                stopTickLocked();
-            } else {
-                ensureTickLocked();
+        std::unordered_map<std::string, Shaper> shapers;
+        for (const auto& [key, limit] : limits) {
+            auto& shaper = shapers[key];
+            auto oldIt = shapers_.find(key);
+            if (oldIt != shapers_.end()) {
+                shaper = oldIt->second;
             }
+            const RateLimit effective{
+                limit.requestsPerSec > 0 ? limit.requestsPerSec : defaultLimit_.requestsPerSec,
+                limit.bytesPerSec > 0 ? limit.bytesPerSec : defaultLimit_.bytesPerSec
+            };
+            shaper.requests.configure(effective.requestsPerSec, now);
+            shaper.bytes.configure(effective.bytesPerSec, now);
         }
+        shapers_ = std::move(shapers);
 
-        dispatchSteps(immediateSteps);
+        rebuildDueHeapLocked();
+        if (pollEntries_.empty()) {
+            stopTimerLocked();
+        } else {
+            armNextLocked();
+        }
     }
 
     void setGroupEnabled(const std::string& groupKey, bool enabled) {
@@ -126,26 +197,23 @@ public:
             return;
         }
 
-        const auto now = std::chrono::steady_clock::now();
+        const auto now = Clock::now();
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            bool matched = false;
             for (auto& [deviceId, entry] : pollEntries_) {
                 (void)deviceId;
                 if (entry.groupKey != groupKey) {
                     continue;
                 }
-                matched = true;
                 entry.enabled = enabled;
                 entry.cycleInProgress = false;
                 entry.nextStepIndex = 0;
                 if (enabled) {
-                    entry.nextDueTime = now;
+                    scheduleLocked(entry, spreadStart(entry, now));
+                } else {
+                    entry.dueSeq = 0;
                 }
             }
-            if (matched && enabled) {
-                ensureTickLocked();
-            }
         }
     }
 
@@ -158,13 +226,11 @@ public:
                 return;
             }
 
+            // 周期进行中时由周期结束重新入堆
             if (!it->second.cycleInProgress) {
-                it->second.cycleInProgress = true;
-                it->second.nextStepIndex = 0;
-                it->second.nextDueTime = std::chrono::steady_clock::now();
+                startCycleLocked(it->second);
+                chargeLocked(it->second, Clock::now());
                 immediateSteps.emplace_back(deviceId, 0);
-            } else {
-                it->second.nextDueTime = std::chrono::steady_clock::now();
             }
         }
 
@@ -180,7 +246,9 @@ public:
 
         it->second.cycleInProgress = false;
         it->second.nextStepIndex = 0;
-        it->second.nextDueTime = std::chrono::steady_clock::now();
+        if (it->second.enabled) {
+            scheduleLocked(it->second, Clock::now());
+        }
     }
 
     void defer(int deviceId, int delaySec = 1) {
@@ -192,8 +260,9 @@ public:
 
         it->second.cycleInProgress = false;
         it->second.nextStepIndex = 0;
-        it->second.nextDueTime = std::chrono::steady_clock::now()
-            + std::chrono::seconds(std::max(1, delaySec));
+        if (it->second.enabled) {
+            scheduleLocked(it->second, Clock::now() + std::chrono::seconds(std::max(1, delaySec)));
+        }
     }
 
     void activateFastRead(int deviceId, int durationSec, int intervalSec) {
@@ -202,7 +271,7 @@ public:
         }
 
         std::vector<std::pair<int, size_t>> immediateSteps;
-        const auto now = std::chrono::steady_clock::now();
+        const auto now = Clock::now();
         {
             std::lock_guard<std::mutex> lock(mutex_);
             auto it = pollEntries_.find(deviceId);
@@ -213,11 +282,10 @@ public:
             auto& entry = it->second;
             entry.fastReadIntervalSec = std::clamp(intervalSec, 1, 60);
             entry.fastReadUntil = now + std::chrono::seconds(durationSec);
-            entry.nextDueTime = now;
 
             if (!entry.cycleInProgress) {
-                entry.cycleInProgress = true;
-                entry.nextStepIndex = 0;
+                startCycleLocked(entry);
+                chargeLocked(entry, now);
                 immediateSteps.emplace_back(deviceId, 0);
             }
         }
@@ -227,7 +295,7 @@ public:
 
     void onStepCompleted(int deviceId, size_t stepIndex, bool success) {
         std::vector<std::pair<int, size_t>> immediateSteps;
-        const auto now = std::chrono::steady_clock::now();
+        const auto now = Clock::now();
 
         {
             std::lock_guard<std::mutex> lock(mutex_);
@@ -240,6 +308,7 @@ public:
             if (!entry.enabled) {
                 entry.cycleInProgress = false;
                 entry.nextStepIndex = 0;
+                entry.dueSeq = 0;
                 return;
             }
 
@@ -248,18 +317,18 @@ public:
                 entry.cycleInProgress = false;
                 entry.nextStepIndex = 0;
 
-                int intervalSec = effectiveIntervalSec(entry, now);
+                auto interval = effectiveInterval(entry, now);
                 if (entry.consecutiveFailures >= DEGRADE_THRESHOLD
-                    && entry.intervalSec < DEGRADE_INTERVAL_SEC) {
-                    intervalSec = DEGRADE_INTERVAL_SEC;
+                    && entry.interval < std::chrono::seconds(DEGRADE_INTERVAL_SEC)) {
+                    interval = std::chrono::seconds(DEGRADE_INTERVAL_SEC);
                     if (entry.consecutiveFailures == DEGRADE_THRESHOLD) {
                         LOG_WARN << protocol_log::prefix(logPrefix_, "PollScheduler", "degraded")
                                  << ' ' << protocol_log::device(deviceId, deviceLabel(entry))
                                  << " degraded after " << DEGRADE_THRESHOLD
-                                 << " consecutive failures, interval=" << intervalSec << "s";
+                                 << " consecutive failures, interval=" << DEGRADE_INTERVAL_SEC << "s";
                     }
                 }
-                entry.nextDueTime = now + std::chrono::seconds(intervalSec);
+                scheduleLocked(entry, now + interval);
                 return;
             }
 
@@ -277,74 +346,417 @@ public:
             } else {
                 entry.cycleInProgress = false;
                 entry.nextStepIndex = 0;
-                entry.nextDueTime = now + std::chrono::seconds(effectiveIntervalSec(entry, now));
+                scheduleLocked(entry, nextCycleDue(entry, now));
             }
         }
 
         dispatchSteps(immediateSteps);
     }
 
+    /**
+     * @brief 各设备投递迟到统计（未发生过定时投递的设备不返回）
+     */
+    std::vector<LatenessStats> latenessSnapshot() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<LatenessStats> result;
+        result.reserve(pollEntries_.size());
+        for (const auto& [deviceId, entry] : pollEntries_) {
+            if (entry.lateness.dispatches == 0) {
+                continue;
+            }
+            auto stats = entry.lateness;
+            stats.deviceId = deviceId;
+            stats.deviceName = entry.deviceName;
+            stats.linkId = entry.linkId;
+            stats.intervalMs = std::chrono::duration_cast<std::chrono::milliseconds>(entry.interval).count();
+            result.push_back(std::move(stats));
+        }
+        return result;
+    }
+
+    /**
+     * @brief 写入适配器指标：调度规模、积压、迟到汇总及迟到最严重的 topN 设备
+     */
+    void appendMetrics(Json::Value& stats, size_t topN = 20) const {
+        auto lateness = latenessSnapshot();
+        size_t scheduled = 0;
+        size_t overdue = 0;
+        size_t shapedKeys = 0;
+        uint64_t shapedDeferrals = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto now = Clock::now();
+            for (const auto& [key, shaper] : shapers_) {
+                (void)key;
+                if (shaper.requests.limited() || shaper.bytes.limited()) {
+                    ++shapedKeys;
+                }
+                shapedDeferrals += shaper.deferrals;
+            }
+            for (const auto& [deviceId, entry] : pollEntries_) {
+                (void)deviceId;
+                if (entry.dueSeq == 0) {
+                    continue;
+                }
+                ++scheduled;
+                if (entry.nextDueTime <= now) {
+                    ++overdue;
+                }
+            }
+        }
+
+        uint64_t dispatches = 0;
+        double weighted = 0.0;
+        int64_t maxMs = 0;
+        for (const auto& item : lateness) {
+            dispatches += item.dispatches;
+            weighted += item.avgMs * static_cast<double>(item.dispatches);
+            maxMs = std::max(maxMs, item.maxMs);
+        }
+
+        stats["pollScheduledCount"] = static_cast<Json::Int64>(scheduled);
+        stats["pollOverdueCount"] = static_cast<Json::Int64>(overdue);
+        stats["pollDispatchTotal"] = static_cast<Json::UInt64>(dispatches);
+        stats["pollLatenessAvgMs"] = dispatches > 0 ? weighted / static_cast<double>(dispatches) : 0.0;
+        stats["pollLatenessMaxMs"] = static_cast<Json::Int64>(maxMs);
+        stats["pollShapedKeyCount"] = static_cast<Json::Int64>(shapedKeys);
+        stats["pollShapedDeferrals"] = static_cast<Json::UInt64>(shapedDeferrals);
+
+        std::sort(lateness.begin(), lateness.end(), [](const LatenessStats& a, const LatenessStats& b) {
+            return a.avgMs > b.avgMs;
+        });
+        Json::Value devices(Json::arrayValue);
+        for (size_t i = 0; i < lateness.size() && i < topN; ++i) {
+            const auto& item = lateness[i];
+            Json::Value row;
+            row["deviceId"] = item.deviceId;
+            row["deviceName"] = item.deviceName;
+            row["linkId"] = item.linkId;
+            row["intervalMs"] = static_cast<Json::Int64>(item.intervalMs);
+            row["lastMs"] = static_cast<Json::Int64>(item.lastMs);
+            row["maxMs"] = static_cast<Json::Int64>(item.maxMs);
+            row["avgMs"] = item.avgMs;
+            row["dispatches"] = static_cast<Json::UInt64>(item.dispatches);
+            devices.append(std::move(row));
+        }
+        stats["pollLateness"] = std::move(devices);
+    }
+
 private:
-    static constexpr double TICK_INTERVAL_SEC = 1.0;
     static constexpr int RETRY_INTERVAL_SEC = 1;
     static constexpr int DEGRADE_THRESHOLD = 3;
     static constexpr int DEGRADE_INTERVAL_SEC = 10;
-    static constexpr std::size_t MAX_DISPATCH_PER_TICK = 64;
+    static constexpr int MIN_INTERVAL_MS = 100;
+    static constexpr int MAX_INTERVAL_MS = 3600 * 1000;
+    // 单轮投递上限与积压时的轮间隔，整体上限与原 1s tick 的 64 个/秒一致
+    static constexpr std::size_t MAX_DISPATCH_PER_PASS = 16;
+    static constexpr std::chrono::milliseconds BACKLOG_PASS_INTERVAL{250};
+    static constexpr std::chrono::milliseconds MIN_TIMER_DELAY{5};
+    static constexpr double LATENESS_EWMA_ALPHA = 0.2;
+    // 新增/重连设备的首轮错峰窗口（不超过设备周期）
+    static constexpr std::chrono::seconds FIRST_POLL_WINDOW{10};
+    // 令牌桶容量：按速率折算的秒数
+    static constexpr double BURST_SEC = 1.0;
+
+    /**
+     * @brief 令牌桶；速率为 0 时不限
+     *
+     * 令牌不足 min(cost, 容量) 时拒绝；放行后按实际 cost 扣减，可透支，
+     * 单周期成本超过容量的设备也能在桶满时通过，透支部分由后续补充偿还。
+     */
+    class TokenBucket {
+    public:
+        void configure(double rate, Clock::time_point now) {
+            refill(now);
+            const bool fresh = rate_ <= 0.0;
+            rate_ = std::max(0.0, rate);
+            capacity_ = std::max(rate_ * BURST_SEC, 1.0);
+            tokens_ = fresh ? capacity_ : std::min(tokens_, capacity_);
+            updated_ = now;
+        }
+
+        bool limited() const { return rate_ > 0.0; }
+
+        bool admits(double cost, Clock::time_point now) {
+            if (!limited()) return true;
+            refill(now);
+            return tokens_ >= std::min(cost, capacity_);
+        }
+
+        void charge(double cost, Clock::time_point now) {
+            if (!limited()) return;
+            refill(now);
+            tokens_ -= cost;
+        }
+
+        Clock::time_point readyAt(double cost, Clock::time_point now) const {
+            const double missing = std::min(cost, capacity_) - tokens_;
+            if (!limited() || missing <= 0.0) return now;
+            return now + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(missing / rate_));
+        }
+
+    private:
+        void refill(Clock::time_point now) {
+            if (limited() && now > updated_) {
+                tokens_ = std::min(capacity_, tokens_ + rate_ * std::chrono::duration<double>(now - updated_).count());
+            }
+            updated_ = now;
+        }
+
+        double rate_ = 0.0;
+        double capacity_ = 1.0;
+        double tokens_ = 0.0;
+        Clock::time_point updated_{};
+    };
+
+    /** 单个限速键的请求数/字节数双桶 */
+    struct Shaper {
+        TokenBucket requests;
+        TokenBucket bytes;
+        uint64_t deferrals = 0;
+    };
 
     struct PollEntry {
         int deviceId = 0;
         std::string deviceName;
         std::string groupKey;
         int linkId = 0;
+        std::string rateKey;
         size_t nextStepIndex = 0;
         size_t stepCount = 1;
-        int intervalSec = 1;
+        size_t bytesPerCycle = 0;
+        Clock::duration interval = std::chrono::seconds(1);
+        Clock::duration phase{0};   // 相位：周期时隙 = epoch_ + phase + k * interval
+        double phaseFraction = 0.0;  // phase / interval
         bool enabled = true;
         bool cycleInProgress = false;
         int consecutiveFailures = 0;
-        std::chrono::steady_clock::time_point nextDueTime = std::chrono::steady_clock::now();
-        std::chrono::steady_clock::time_point fastReadUntil{};
+        Clock::time_point nextDueTime = Clock::now();
+        Clock::time_point fastReadUntil{};
         int fastReadDurationSec = 60;
         int fastReadIntervalSec = 1;
+        uint64_t dueSeq = 0;  // 当前有效的堆节点序号，0 表示不在堆中
+        LatenessStats lateness;
     };
 
-    void ensureTickLocked() {
-        if (tickActive_ || pollEntries_.empty()) {
-            return;
+    /** 堆节点：dueSeq 与条目不一致即为过期节点，出堆时丢弃 */
+    struct DueItem {
+        Clock::time_point due;
+        uint64_t seq = 0;
+        int deviceId = 0;
+
+        bool operator>(const DueItem& other) const {
+            return due != other.due ? due > other.due : seq > other.seq;
         }
+    };
 
-        loop_ = TcpLinkManager::instance().getNextIoLoop();
-        if (!loop_) {
-            return;
+    using DueHeap = std::priority_queue<DueItem, std::vector<DueItem>, std::greater<>>;
+
+    static RateLimit loadDefaultRateLimit() {
+        RateLimit limit;
+        auto config = drogon::app().getCustomConfig();
+        if (config.isMember("polling")) {
+            const auto& polling = config["polling"];
+            limit.requestsPerSec = std::max(0.0, polling.get("link_max_requests_per_sec", 0.0).asDouble());
+            limit.bytesPerSec = std::max(0.0, polling.get("link_max_bytes_per_sec", 0.0).asDouble());
         }
+        return limit;
+    }
+
+    static RateLimit stricter(const RateLimit& a, const RateLimit& b) {
+        auto pick = [](double x, double y) {
+            return x > 0.0 && y > 0.0 ? std::min(x, y) : std::max(x, y);
+        };
+        return {pick(a.requestsPerSec, b.requestsPerSec), pick(a.bytesPerSec, b.bytesPerSec)};
+    }
 
-        tickTimerId_ = loop_->runEvery(TICK_INTERVAL_SEC, [this]() {
-            try {
-                onTick();
-            } catch (const std::exception& e) {
-                LOG_ERROR << protocol_log::prefix(logPrefix_, "PollScheduler", "tick_error")
-                          << " error=" << e.what();
-            } catch (...) {
-                LOG_ERROR << protocol_log::prefix(logPrefix_, "PollScheduler", "tick_error")
-                          << " error=<unknown>";
+    /**
+     * @brief 同一限速键、同一周期的设备按设备 ID 顺序均分周期作为相位
+     */
+    void assignPhasesLocked() {
+        std::map<std::pair<std::string, Clock::rep>, std::vector<PollEntry*>> classes;
+        for (auto& [deviceId, entry] : pollEntries_) {
+            (void)deviceId;
+            classes[{entry.rateKey, entry.interval.count()}].push_back(&entry);
+        }
+        for (auto& [key, members] : classes) {
+            (void)key;
+            const auto count = static_cast<Clock::rep>(members.size());
+            for (Clock::rep i = 0; i < count; ++i) {
+                auto* entry = members[static_cast<size_t>(i)];
+                entry->phase = Clock::duration(entry->interval.count() * i / count);
+                entry->phaseFraction = static_cast<double>(i) / static_cast<double>(count);
             }
-        });
-        tickActive_ = true;
+        }
+    }
+
+    /** 首轮投递时间：在 min(周期, 首轮窗口) 内按相位比例错开 */
+    static Clock::time_point spreadStart(const PollEntry& entry, Clock::time_point now) {
+        const auto window = std::min<Clock::duration>(entry.interval, FIRST_POLL_WINDOW);
+        return now + std::chrono::duration_cast<Clock::duration>(window * entry.phaseFraction);
+    }
+
+    /** after 之后的第一个相位时隙 */
+    Clock::time_point nextPhaseSlot(const PollEntry& entry, Clock::time_point after) const {
+        const auto interval = entry.interval.count();
+        const auto offset = (after - epoch_ - entry.phase).count();
+        if (interval <= 0 || offset < 0) {
+            return epoch_ + entry.phase;
+        }
+        return epoch_ + entry.phase + Clock::duration((offset / interval + 1) * interval);
+    }
+
+    /** 周期完成后的下次到期：快读窗口内按快读周期，否则对齐相位时隙 */
+    Clock::time_point nextCycleDue(const PollEntry& entry, Clock::time_point now) const {
+        const auto interval = effectiveInterval(entry, now);
+        if (interval < entry.interval) {
+            return now + interval;
+        }
+        return nextPhaseSlot(entry, now);
+    }
+
+    bool admitsLocked(const PollEntry& entry, Clock::time_point now) {
+        auto it = shapers_.find(entry.rateKey);
+        return it == shapers_.end()
+            || (it->second.requests.admits(static_cast<double>(entry.stepCount), now)
+                && it->second.bytes.admits(static_cast<double>(entry.bytesPerCycle), now));
+    }
+
+    Clock::time_point shaperReadyAt(const PollEntry& entry, Clock::time_point now) const {
+        auto it = shapers_.find(entry.rateKey);
+        if (it == shapers_.end()) {
+            return now;
+        }
+        return std::max(it->second.requests.readyAt(static_cast<double>(entry.stepCount), now),
+                        it->second.bytes.readyAt(static_cast<double>(entry.bytesPerCycle), now));
+    }
+
+    /** 按整个周期（stepCount 个请求、bytesPerCycle 字节）扣减令牌；立即投递也计入，使定时轮询让路 */
+    void chargeLocked(const PollEntry& entry, Clock::time_point now) {
+        auto it = shapers_.find(entry.rateKey);
+        if (it != shapers_.end()) {
+            it->second.requests.charge(static_cast<double>(entry.stepCount), now);
+            it->second.bytes.charge(static_cast<double>(entry.bytesPerCycle), now);
+        }
+    }
+
+    void startCycleLocked(PollEntry& entry) {
+        entry.cycleInProgress = true;
+        entry.nextStepIndex = 0;
+        entry.dueSeq = 0;
+    }
+
+    void scheduleLocked(PollEntry& entry, Clock::time_point due) {
+        entry.nextDueTime = due;
+        entry.dueSeq = ++dueSeq_;
+        dueHeap_.push(DueItem{due, entry.dueSeq, entry.deviceId});
+
+        // 频繁改期会留下过期节点，超过有效条目数的两倍时整体重建
+        if (dueHeap_.size() > pollEntries_.size() * 2 + 64) {
+            rebuildDueHeapLocked();
+        }
+        armLocked(due);
     }
 
-    void stopTickLocked() {
-        if (!tickActive_ || !loop_) {
+    void rebuildDueHeapLocked() {
+        DueHeap heap;
+        for (auto& [deviceId, entry] : pollEntries_) {
+            if (!entry.enabled || entry.stepCount == 0 || entry.cycleInProgress) {
+                entry.dueSeq = 0;
+                continue;
+            }
+            entry.dueSeq = ++dueSeq_;
+            heap.push(DueItem{entry.nextDueTime, entry.dueSeq, deviceId});
+        }
+        dueHeap_ = std::move(heap);
+    }
+
+    PollEntry* validTopLocked() {
+        while (!dueHeap_.empty()) {
+            const auto& top = dueHeap_.top();
+            auto it = pollEntries_.find(top.deviceId);
+            if (it != pollEntries_.end() && it->second.dueSeq == top.seq) {
+                return &it->second;
+            }
+            dueHeap_.pop();
+        }
+        return nullptr;
+    }
+
+    void armNextLocked() {
+        if (auto* entry = validTopLocked()) {
+            armLocked(entry->nextDueTime);
+        }
+    }
+
+    /**
+     * @brief 定时器对准指定时刻；已有更早的定时器时保持不变
+     *
+     * 积压期间不早于下一轮积压时刻，避免改期把定时器提前而绕过轮间隔限速。
+     */
+    void armLocked(Clock::time_point at) {
+        at = std::max(at, backlogPassAt_);
+        if (timerArmed_ && timerAt_ <= at) {
             return;
         }
-        loop_->invalidateTimer(tickTimerId_);
-        tickTimerId_ = trantor::TimerId{0};
-        tickActive_ = false;
+        if (!loop_) {
+            loop_ = TcpLinkManager::instance().getNextIoLoop();
+            if (!loop_) {
+                return;
+            }
+        }
+        if (timerArmed_) {
+            loop_->invalidateTimer(timerId_);
+        }
+
+        const auto delay = std::max<Clock::duration>(at - Clock::now(), MIN_TIMER_DELAY);
+        const uint64_t token = ++timerToken_;
+        timerId_ = loop_->runAfter(std::chrono::duration<double>(delay).count(), [this, token]() {
+            onTimer(token);
+        });
+        timerArmed_ = true;
+        timerAt_ = at;
+    }
+
+    void stopTimerLocked() {
+        if (timerArmed_ && loop_) {
+            loop_->invalidateTimer(timerId_);
+        }
+        timerId_ = trantor::TimerId{0};
+        timerArmed_ = false;
+        ++timerToken_;
+        backlogPassAt_ = Clock::time_point{};
+        dueHeap_ = DueHeap{};
+    }
+
+    void onTimer(uint64_t token) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (token != timerToken_) {
+                return;
+            }
+            timerArmed_ = false;
+        }
+
+        LoopWatchdog::TaskScope task("poll.dispatch");
+        try {
+            onTick();
+        } catch (const std::exception& e) {
+            LOG_ERROR << protocol_log::prefix(logPrefix_, "PollScheduler", "tick_error")
+                      << " error=" << e.what();
+        } catch (...) {
+            LOG_ERROR << protocol_log::prefix(logPrefix_, "PollScheduler", "tick_error")
+                      << " error=<unknown>";
+        }
     }
 
-    void resetEntryForRetry(PollEntry& entry, std::chrono::steady_clock::time_point now) {
+    void resetEntryForRetry(PollEntry& entry, Clock::time_point now) {
         entry.cycleInProgress = false;
         entry.nextStepIndex = 0;
-        entry.nextDueTime = now + std::chrono::seconds(RETRY_INTERVAL_SEC);
+        if (entry.enabled) {
+            scheduleLocked(entry, now + std::chrono::seconds(RETRY_INTERVAL_SEC));
+        }
     }
 
     void dispatchSteps(const std::vector<std::pair<int, size_t>>& steps) {
@@ -352,7 +764,7 @@ private:
             return;
         }
 
-        const auto now = std::chrono::steady_clock::now();
+        const auto now = Clock::now();
         for (const auto& [deviceId, stepIndex] : steps) {
             if (enqueueCallback_(deviceId, stepIndex)) {
                 continue;
@@ -368,35 +780,94 @@ private:
 
     void onTick() {
         std::vector<std::pair<int, size_t>> dueSteps;
-        const auto now = std::chrono::steady_clock::now();
+        const auto now = Clock::now();
 
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            for (auto& [deviceId, entry] : pollEntries_) {
-                if (!entry.enabled || entry.stepCount == 0 || entry.cycleInProgress) {
-                    continue;
+
+            // 取出全部到期节点，按限速键分道，道内保持到期先后
+            std::vector<std::vector<DueItem>> lanes;
+            std::unordered_map<std::string, size_t> laneIndex;
+            while (auto* entry = validTopLocked()) {
+                if (entry->nextDueTime > now) {
+                    break;
                 }
-                if (now < entry.nextDueTime) {
-                    continue;
+                const auto item = dueHeap_.top();
+                dueHeap_.pop();
+
+                auto [laneIt, inserted] = laneIndex.try_emplace(entry->rateKey, lanes.size());
+                if (inserted) {
+                    lanes.emplace_back();
+                }
+                lanes[laneIt->second].push_back(item);
+            }
+            auto* nextPending = validTopLocked();
+            auto nextPass = nextPending ? nextPending->nextDueTime : Clock::time_point::max();
+
+            // 按道轮转投递；最早到期的道排在最前，上轮没轮到的下轮自然优先。
+            // 道首设备超出令牌桶时整道本轮停投，按令牌补足时间重排
+            std::vector<size_t> cursor(lanes.size(), 0);
+            std::vector<bool> blocked(lanes.size(), false);
+            bool progressed = true;
+            while (progressed && dueSteps.size() < MAX_DISPATCH_PER_PASS) {
+                progressed = false;
+                for (size_t lane = 0; lane < lanes.size() && dueSteps.size() < MAX_DISPATCH_PER_PASS; ++lane) {
+                    if (blocked[lane] || cursor[lane] >= lanes[lane].size()) {
+                        continue;
+                    }
+                    auto& entry = pollEntries_.at(lanes[lane][cursor[lane]].deviceId);
+                    if (!admitsLocked(entry, now)) {
+                        blocked[lane] = true;
+                        ++shapers_[entry.rateKey].deferrals;
+                        nextPass = std::min(nextPass, shaperReadyAt(entry, now));
+                        continue;
+                    }
+                    ++cursor[lane];
+                    chargeLocked(entry, now);
+                    recordLateness(entry, now);
+                    startCycleLocked(entry);
+                    dueSteps.emplace_back(entry.deviceId, 0);
+                    progressed = true;
                 }
+            }
 
-                entry.cycleInProgress = true;
-                entry.nextStepIndex = 0;
-                dueSteps.emplace_back(deviceId, 0);
-                if (dueSteps.size() >= MAX_DISPATCH_PER_TICK) {
-                    break;
+            // 未投递的节点原样放回；受上限截断的下一轮在积压间隔后继续
+            bool capped = false;
+            for (size_t lane = 0; lane < lanes.size(); ++lane) {
+                for (size_t i = cursor[lane]; i < lanes[lane].size(); ++i) {
+                    dueHeap_.push(lanes[lane][i]);
+                    capped = capped || !blocked[lane];
                 }
             }
+
+            backlogPassAt_ = capped ? now + BACKLOG_PASS_INTERVAL : Clock::time_point{};
+            if (capped) {
+                nextPass = std::min(nextPass, backlogPassAt_);
+            }
+            if (nextPass != Clock::time_point::max()) {
+                armLocked(nextPass);
+            }
         }
 
         dispatchSteps(dueSteps);
     }
 
-    static int effectiveIntervalSec(const PollEntry& entry, std::chrono::steady_clock::time_point now) {
-        if (entry.fastReadUntil != std::chrono::steady_clock::time_point{} && now < entry.fastReadUntil) {
-            return std::max(1, entry.fastReadIntervalSec);
+    static void recordLateness(PollEntry& entry, Clock::time_point now) {
+        const auto lateMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - entry.nextDueTime).count();
+        auto& stats = entry.lateness;
+        stats.lastMs = lateMs;
+        stats.maxMs = std::max(stats.maxMs, lateMs);
+        stats.avgMs = stats.dispatches == 0
+            ? static_cast<double>(lateMs)
+            : stats.avgMs + LATENESS_EWMA_ALPHA * (static_cast<double>(lateMs) - stats.avgMs);
+        ++stats.dispatches;
+    }
+
+    static Clock::duration effectiveInterval(const PollEntry& entry, Clock::time_point now) {
+        if (entry.fastReadUntil != Clock::time_point{} && now < entry.fastReadUntil) {
+            return std::min<Clock::duration>(entry.interval, std::chrono::seconds(std::max(1, entry.fastReadIntervalSec)));
         }
-        return std::max(1, entry.intervalSec);
+        return entry.interval;
     }
 
     static std::string deviceLabel(const PollEntry& entry) {
@@ -404,10 +875,18 @@ private:
     }
 
     std::string logPrefix_;
+    const Clock::time_point epoch_ = Clock::now();
+    RateLimit defaultLimit_;
     std::map<int, PollEntry> pollEntries_;
+    std::unordered_map<std::string, Shaper> shapers_;
+    DueHeap dueHeap_;
+    uint64_t dueSeq_ = 0;
     EnqueueCallback enqueueCallback_;
     trantor::EventLoop* loop_ = nullptr;
-    trantor::TimerId tickTimerId_{0};
-    bool tickActive_ = false;
+    trantor::TimerId timerId_{0};
+    Clock::time_point timerAt_{};
+    Clock::time_point backlogPassAt_{};  // 积压时下一轮的最早时刻，无积压为 epoch
+    uint64_t timerToken_ = 0;
+    bool timerArmed_ = false;
     mutable std::mutex mutex_;
 };
@@ -193,6 +193,12 @@ public:
      */
     virtual void onMaintenanceTick() = 0;
     virtual ProtocolAdapterMetrics getMetrics() const { return {}; }
+
+    /**
+     * @brief 链路接收缓冲、多包会话、待发队列等运行态的近似占用字节数（内存监控用）
+     */
+    virtual size_t sessionBufferBytes() const { return 0; }
+
     virtual ProtocolLifecycleImpact onDeviceLifecycleEvent(const DeviceLifecycleEvent&) {
         return ProtocolLifecycleImpact::None;
     }
@@ -1,11 +1,13 @@
 #pragma once
 
 #include "common/database/DatabaseService.hpp"
+#include "common/protocol/IngestMetrics.hpp"
 #include "common/protocol/ProtocolAdapter.hpp"
 #include "common/protocol/ProtocolCommandCoordinator.hpp"
 #include "common/protocol/ProtocolCommandStore.hpp"
 #include "common/protocol/ProtocolLog.hpp"
 #include "common/protocol/ProtocolResultWriter.hpp"
+#include "common/network/FrameTrace.hpp"
 #include "common/network/TcpLinkManager.hpp"
 #include "common/network/WebSocketManager.hpp"
 #include "common/cache/DeviceCache.hpp"
@@ -16,6 +18,7 @@
 #include "common/utils/Constants.hpp"
 #include "common/utils/AppException.hpp"
 #include "common/utils/DrogonLoopSelector.hpp"
+#include "common/utils/LoopWatchdog.hpp"
 #include "modules/device/domain/CommandRepository.hpp"
 #include "modules/device/domain/Events.hpp"
 #include "modules/link/domain/Events.hpp"
@@ -56,6 +59,7 @@ public:
         return {
             [this](std::vector<ParsedFrameResult>&& results) {
                 if (results.empty()) return;
+                stampResults(results);
                 totalFramesProcessed_.fetch_add(
                     static_cast<int64_t>(results.size()), std::memory_order_relaxed);
                 if (resultWriter_) {
@@ -122,6 +126,7 @@ public:
         // 协议维护定时器（1 秒周期）— 运行在 TCP IO 池，与链路数据处理同域
         maintenanceLoop_ = TcpLinkManager::instance().getNextIoLoop();
         maintenanceLoop_->runEvery(1.0, [this]() {
+            LoopWatchdog::TaskScope task("protocol.maintenance");
             try {
                 runProtocolMaintenance();
             } catch (const std::exception& e) {
@@ -158,6 +163,7 @@ public:
     }
 
     void handleLinkData(int linkId, const std::string& clientAddr, const std::string& data) {
+        LoopWatchdog::TaskScope task("protocol.linkData");
         onDataReceived(linkId, clientAddr, data);
     }
 
@@ -175,6 +181,13 @@ public:
     void handleDeviceData(int deviceId, const std::string& clientAddr, const std::string& data) {
         if (deviceId <= 0 || data.empty()) return;
 
+        LoopWatchdog::TaskScope task("protocol.deviceData");
+        const auto ingressAt = ingest_metrics::Clock::now();
+        {
+            // Agent 转发的数据不经过 TcpLinkManager，在此记录（linkId = 0，设备已知）
+            FrameTrace::DeviceScope traceDevice(deviceId);
+            FrameTrace::instance().record(FrameTrace::Direction::Rx, 0, clientAddr, data);
+        }
         try {
             if (!DeviceCache::instance().isLoaded()) {
                 LOG_WARN << "[Agent] DeviceCache not loaded, dropping device data for deviceId=" << deviceId;
@@ -205,7 +218,12 @@ public:
             LOG_DEBUG << "[Agent] Device " << deviceId << " RX " << bytes.size()
                       << "B from " << clientAddr << " | " << bytesToHex(bytes);
 
+            ingest_metrics::countIngress(protocol, 0, bytes.size());
+            ingest_metrics::observe(ingest_metrics::Stage::Ingress, protocol, 0,
+                                    ingest_metrics::Clock::now() - ingressAt);
+
             // Agent 设备 link_id = 0，适配器通过帧内标识（device_code/slave_id）匹配具体设备
+            IngressScope scope(ingressAt);
             adapter->onDataReceived(0, clientAddr, std::move(bytes));
         } catch (const std::exception& e) {
             LOG_ERROR << "[Agent] handleDeviceData exception (deviceId=" << deviceId
@@ -219,7 +237,7 @@ public:
      * @brief Agent 端点连接事件
      *
      * 处理 Agent 端点的 TCP 连接/断开事件。
-     * 更新链路版本号并广播给前端 WebSocket 客户端。
+     * 更新链路连接状态版本号并广播给前端 WebSocket 客户端。
      */
     void handleEndpointConnection(int agentId, const std::string& endpointId,
                                   const std::string& clientAddr, bool connected) {
@@ -227,8 +245,8 @@ public:
                  << (connected ? "connected" : "disconnected")
                  << ": " << clientAddr << " (agentId=" << agentId << ")";
 
-        // 更新版本号通知前端
-        ResourceVersion::instance().incrementVersion("link");
+        // 更新连接状态版本号通知前端（不影响链路配置版本）
+        ResourceVersion::instance().incrementVersion("link:status");
 
         // 广播连接事件给 WebSocket 客户端
         if (WebSocketManager::instance().connectionCount() > 0) {
@@ -260,6 +278,7 @@ public:
      */
     void submitParsedResults(std::vector<ParsedFrameResult>&& results) {
         if (results.empty()) return;
+        stampResults(results);
         totalFramesProcessed_.fetch_add(
             static_cast<int64_t>(results.size()), std::memory_order_relaxed);
         if (resultWriter_) {
@@ -276,6 +295,24 @@ public:
         };
     }
 
+    /**
+     * @brief 各协议会话缓冲的近似占用（内存监控用）
+     */
+    size_t sessionBufferBytes() const {
+        size_t bytes = 0;
+        for (const auto& [_, adapter] : adapters_) {
+            bytes += adapter->sessionBufferBytes();
+        }
+        return bytes;
+    }
+
+    /**
+     * @brief 攒批写入中结果的近似占用（内存监控用）
+     */
+    size_t pendingResultBytes() const {
+        return resultWriter_ ? resultWriter_->approximatePendingBytes() : 0;
+    }
+
     std::optional<ProtocolAdapterMetrics> getAdapterMetrics(const std::string& protocol) const {
         auto* adapter = findAdapter(protocol);
         if (!adapter) {
@@ -469,6 +506,7 @@ private:
     }
 
     void onDataReceived(int linkId, const std::string& clientAddr, const std::string& data) {
+        const auto ingressAt = ingest_metrics::Clock::now();
         try {
             LOG_DEBUG << protocol_log::prefix("ProtocolDispatcher", "rx")
                       << " linkId=" << linkId
@@ -498,6 +536,11 @@ private:
                 return;
             }
 
+            ingest_metrics::countIngress(protocol, linkId, bytes.size());
+            ingest_metrics::observe(ingest_metrics::Stage::Ingress, protocol, linkId,
+                                    ingest_metrics::Clock::now() - ingressAt);
+
+            IngressScope scope(ingressAt);
             adapter->onDataReceived(linkId, clientAddr, std::move(bytes));
         } catch (const std::exception& e) {
             LOG_ERROR << "[ProtocolDispatcher] onDataReceived exception (link=" << linkId
@@ -527,7 +570,7 @@ private:
             if (!connected) {
                 DeviceConnectionCache::instance().removeByClient(linkId, clientAddr);
             }
-            ResourceVersion::instance().incrementVersion("link");
+            ResourceVersion::instance().incrementVersion("link:status", linkId);
 
             if (WebSocketManager::instance().connectionCount() > 0) {
                 Json::Value data;
@@ -545,6 +588,34 @@ private:
         }
     }
 
+    /**
+     * @brief 标记当前线程正在处理的报文接收时刻
+     *
+     * 适配器在 onDataReceived 内同步提交的解析结果以此作为端到端耗时起点；
+     * 定时轮询等不经过接收回调的结果以提交时刻为起点。
+     */
+    struct IngressScope {
+        explicit IngressScope(std::chrono::steady_clock::time_point at) {
+            currentIngressAt_ = at;
+        }
+        ~IngressScope() {
+            currentIngressAt_ = {};
+        }
+    };
+
+    static void stampResults(std::vector<ParsedFrameResult>& results) {
+        const auto now = std::chrono::steady_clock::now();
+        const auto receivedAt = currentIngressAt_ != std::chrono::steady_clock::time_point{}
+            ? currentIngressAt_
+            : now;
+        for (auto& r : results) {
+            if (r.receivedAt == std::chrono::steady_clock::time_point{}) {
+                r.receivedAt = receivedAt;
+            }
+            r.submittedAt = now;
+        }
+    }
+
     ProtocolAdapter* findAdapter(const std::string& protocol) const {
         auto it = adapters_.find(protocol);
         return it != adapters_.end() ? it->second.get() : nullptr;
@@ -687,6 +758,7 @@ private:
     trantor::EventLoop* backgroundLoop_ = nullptr;     // 后台任务（物化视图等）
 
     std::atomic<int64_t> totalFramesProcessed_{0};
+    static inline thread_local std::chrono::steady_clock::time_point currentIngressAt_{};
 
     std::atomic<bool> deviceCacheReloading_{false};
     std::atomic<int64_t> deviceCacheReloadCooldown_{0};
@@ -1,36 +1,107 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 enum class ProtocolJobPriority {
     High,
     Normal
 };
 
+/**
+ * @brief 队列等待时间直方图（毫秒分桶，最后一桶为 >5000ms）
+ */
+struct ProtocolQueueWaitHistogram {
+    static constexpr std::array<int64_t, 8> BOUNDS_MS{1, 5, 10, 50, 100, 500, 1000, 5000};
+
+    std::array<uint64_t, BOUNDS_MS.size() + 1> buckets{};
+    uint64_t count = 0;
+    int64_t sumMs = 0;
+    int64_t maxMs = 0;
+
+    void record(int64_t waitMs) {
+        waitMs = std::max<int64_t>(0, waitMs);
+        size_t index = 0;
+        while (index < BOUNDS_MS.size() && waitMs > BOUNDS_MS[index]) {
+            ++index;
+        }
+        ++buckets[index];
+        ++count;
+        sumMs += waitMs;
+        maxMs = std::max(maxMs, waitMs);
+    }
+
+    void merge(const ProtocolQueueWaitHistogram& other) {
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        sumMs += other.sumMs;
+        maxMs = std::max(maxMs, other.maxMs);
+    }
+
+    double avgMs() const {
+        return count > 0 ? static_cast<double>(sumMs) / static_cast<double>(count) : 0.0;
+    }
+};
+
+/** 队列统计：按优先级的等待时间、过期丢弃数、满队列拒绝数 */
+struct ProtocolJobQueueStats {
+    ProtocolQueueWaitHistogram highWait;
+    ProtocolQueueWaitHistogram normalWait;
+    uint64_t expired = 0;
+    uint64_t rejected = 0;
+
+    void merge(const ProtocolJobQueueStats& other) {
+        highWait.merge(other.highWait);
+        normalWait.merge(other.normalWait);
+        expired += other.expired;
+        rejected += other.rejected;
+    }
+};
+
 /**
  * @brief 协议 session 内优先级任务队列
  *
  * 统一“高优先级控制 / 普通轮询或发现”的排队语义。队列只负责优先级、容量和过滤，
  * 任务如何发送、如何匹配应答、如何超时仍由协议引擎决定。
+ *
+ * 每个优先级内按 key（通常为设备 ID）分子队列轮转出队，单个设备堆积的任务不会
+ * 挡住同 session 的其他设备；未指定 key 的任务共用一个子队列，保持原有 FIFO。
+ * 任务可带截止时间，出队时跳过已过期的任务并交还调用方处理（如结束轮询周期）。
  */
 template<typename Job>
 class ProtocolJobQueue {
 public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr int SHARED_KEY = 0;
+
     explicit ProtocolJobQueue(std::size_t maxSize = 256)
         : maxSize_(maxSize) {}
 
     bool push(Job job, ProtocolJobPriority priority = ProtocolJobPriority::Normal) {
+        return push(std::move(job), priority, SHARED_KEY);
+    }
+
+    bool push(Job job, ProtocolJobPriority priority, int key,
+              Clock::time_point deadline = Clock::time_point::max()) {
         if (isFull()) {
+            ++stats_.rejected;
             return false;
         }
-        queue(priority).push_back(std::move(job));
+        level(priority).push(key, Entry{std::move(job), Clock::now(), deadline});
         return true;
     }
 
     bool empty() const {
-        return high_.empty() && normal_.empty();
+        return size() == 0;
     }
 
     bool isFull() const {
@@ -59,42 +130,47 @@ public:
     }
 
     Job* peek() {
-        if (!high_.empty()) {
-            return &high_.front();
+        if (auto* entry = high_.front()) {
+            return &entry->job;
         }
-        if (!normal_.empty()) {
-            return &normal_.front();
+        if (auto* entry = normal_.front()) {
+            return &entry->job;
         }
         return nullptr;
     }
 
-    const Job* peek() const {
-        if (!high_.empty()) {
-            return &high_.front();
-        }
-        if (!normal_.empty()) {
-            return &normal_.front();
-        }
-        return nullptr;
+    bool popNext(Job& out) {
+        return popNext(out, nullptr);
     }
 
-    bool popNext(Job& out) {
-        auto* source = !high_.empty() ? &high_ : &normal_;
-        if (source->empty()) {
-            return false;
+    /**
+     * @brief 取下一个任务；途经的过期任务被丢弃并计数，expired 非空时移交给调用方
+     */
+    bool popNext(Job& out, std::vector<Job>* expired) {
+        const auto now = Clock::now();
+        for (auto priority : {ProtocolJobPriority::High, ProtocolJobPriority::Normal}) {
+            Entry entry;
+            while (level(priority).pop(entry)) {
+                if (entry.deadline <= now) {
+                    ++stats_.expired;
+                    if (expired) {
+                        expired->push_back(std::move(entry.job));
+                    }
+                    continue;
+                }
+                auto& histogram = priority == ProtocolJobPriority::High ? stats_.highWait : stats_.normalWait;
+                histogram.record(std::chrono::duration_cast<std::chrono::milliseconds>(now - entry.enqueuedAt).count());
+                out = std::move(entry.job);
+                return true;
+            }
         }
-        out = std::move(source->front());
-        source->pop_front();
-        return true;
+        return false;
     }
 
     void dropNext() {
-        if (!high_.empty()) {
-            high_.pop_front();
-            return;
-        }
-        if (!normal_.empty()) {
-            normal_.pop_front();
+        Entry entry;
+        if (!high_.pop(entry)) {
+            normal_.pop(entry);
         }
     }
 
@@ -105,30 +181,127 @@ public:
 
     template<typename Predicate>
     std::size_t removeIf(Predicate predicate) {
-        return filterQueue(high_, predicate) + filterQueue(normal_, predicate);
+        return high_.removeIf(predicate) + normal_.removeIf(predicate);
     }
 
-private:
-    std::deque<Job>& queue(ProtocolJobPriority priority) {
-        return priority == ProtocolJobPriority::High ? high_ : normal_;
+    /**
+     * @brief 移除某个 key 的全部任务（按 key 直接定位子队列）
+     */
+    std::size_t removeKey(int key) {
+        return high_.removeKey(key) + normal_.removeKey(key);
     }
 
-    template<typename Predicate>
-    static std::size_t filterQueue(std::deque<Job>& source, Predicate predicate) {
-        std::deque<Job> kept;
-        std::size_t removed = 0;
-        for (auto& job : source) {
-            if (!predicate(job)) {
-                kept.push_back(std::move(job));
+    const ProtocolJobQueueStats& stats() const {
+        return stats_;
+    }
+
+private:
+    struct Entry {
+        Job job{};
+        Clock::time_point enqueuedAt{};
+        Clock::time_point deadline = Clock::time_point::max();
+    };
+
+    /**
+     * @brief 单个优先级：key -> 子队列，ready_ 为待服务 key 的轮转顺序
+     *
+     * 子队列清空后不立即从 ready_ 摘除，轮到时再回收；queued 保证 key 在 ready_ 中至多一份。
+     */
+    class Level {
+    public:
+        void push(int key, Entry entry) {
+            auto& lane = lanes_[key];
+            if (!lane.queued) {
+                lane.queued = true;
+                ready_.push_back(key);
+            }
+            lane.jobs.push_back(std::move(entry));
+            ++size_;
+        }
+
+        Entry* front() {
+            while (!ready_.empty()) {
+                auto it = lanes_.find(ready_.front());
+                if (it != lanes_.end() && !it->second.jobs.empty()) {
+                    return &it->second.jobs.front();
+                }
+                if (it != lanes_.end()) {
+                    lanes_.erase(it);
+                }
+                ready_.pop_front();
+            }
+            return nullptr;
+        }
+
+        bool pop(Entry& out) {
+            if (!front()) {
+                return false;
+            }
+            const int key = ready_.front();
+            ready_.pop_front();
+            auto it = lanes_.find(key);
+            out = std::move(it->second.jobs.front());
+            it->second.jobs.pop_front();
+            --size_;
+            if (it->second.jobs.empty()) {
+                lanes_.erase(it);
             } else {
-                ++removed;
+                ready_.push_back(key);
             }
+            return true;
         }
-        source = std::move(kept);
-        return removed;
+
+        template<typename Predicate>
+        std::size_t removeIf(Predicate& predicate) {
+            std::size_t removed = 0;
+            for (auto& [key, lane] : lanes_) {
+                (void)key;
+                removed += static_cast<std::size_t>(std::erase_if(lane.jobs, [&predicate](Entry& entry) {
+                    return predicate(entry.job);
+                }));
+            }
+            size_ -= removed;
+            return removed;
+        }
+
+        std::size_t removeKey(int key) {
+            auto it = lanes_.find(key);
+            if (it == lanes_.end()) {
+                return 0;
+            }
+            const auto removed = it->second.jobs.size();
+            it->second.jobs.clear();
+            size_ -= removed;
+            return removed;
+        }
+
+        void clear() {
+            lanes_.clear();
+            ready_.clear();
+            size_ = 0;
+        }
+
+        std::size_t size() const {
+            return size_;
+        }
+
+    private:
+        struct Lane {
+            std::deque<Entry> jobs;
+            bool queued = false;
+        };
+
+        std::unordered_map<int, Lane> lanes_;
+        std::deque<int> ready_;
+        std::size_t size_ = 0;
+    };
+
+    Level& level(ProtocolJobPriority priority) {
+        return priority == ProtocolJobPriority::High ? high_ : normal_;
     }
 
     std::size_t maxSize_;
-    std::deque<Job> high_;
-    std::deque<Job> normal_;
+    Level high_;
+    Level normal_;
+    ProtocolJobQueueStats stats_;
 };
@@ -2,44 +2,53 @@
 
 #include <algorithm>
 #include <cctype>
-#include <iomanip>
-#include <sstream>
 #include <string>
 #include <string_view>
 
+// 以下辅助函数只应出现在 LOG_* 的 << 表达式中（级别未开启时不会求值），
+// 按拼接实现、一次预留容量，避免 ostringstream 的 locale 与多次分配开销。
 namespace protocol_log {
 
 inline std::string prefix(std::string_view protocol, std::string_view component, std::string_view event = {}) {
-    std::ostringstream oss;
-    oss << '[' << protocol << "][" << component << ']';
+    std::string out;
+    out.reserve(protocol.size() + component.size() + event.size() + 6);
+    out += '[';
+    out += protocol;
+    out += "][";
+    out += component;
+    out += ']';
     if (!event.empty()) {
-        oss << '[' << event << ']';
+        out += '[';
+        out += event;
+        out += ']';
     }
-    return oss.str();
+    return out;
 }
 
 inline std::string device(int deviceId, std::string_view deviceName = {}) {
-    std::ostringstream oss;
-    oss << "deviceId=" << deviceId;
+    std::string out = "deviceId=" + std::to_string(deviceId);
     if (!deviceName.empty()) {
-        oss << ", deviceName=" << deviceName;
+        out += ", deviceName=";
+        out += deviceName;
     }
-    return oss.str();
+    return out;
 }
 
 inline std::string bytesToHex(std::string_view data, std::size_t limit = 512) {
-    std::ostringstream oss;
+    static constexpr char HEX[] = "0123456789ABCDEF";
     const auto count = std::min(data.size(), limit);
+    std::string out;
+    out.reserve(count * 3 + 4);
     for (std::size_t i = 0; i < count; ++i) {
-        if (i > 0) oss << ' ';
+        if (i > 0) out += ' ';
         const auto byte = static_cast<unsigned char>(data[i]);
-        oss << std::uppercase << std::hex << std::setw(2) << std::setfill('0')
-            << static_cast<int>(byte);
+        out += HEX[byte >> 4];
+        out += HEX[byte & 0x0F];
     }
     if (data.size() > limit) {
-        oss << " ...";
+        out += " ...";
     }
-    return oss.str();
+    return out;
 }
 
 inline std::string bytesToPrintableAscii(std::string_view data, std::size_t limit = 256) {
@@ -64,11 +73,13 @@ inline std::string bytesToPrintableAscii(std::string_view data, std::size_t limi
 }
 
 inline std::string bytesSummary(std::string_view data) {
-    std::ostringstream oss;
-    oss << "bytes=" << data.size()
-        << ", hex=" << bytesToHex(data)
-        << ", ascii=\"" << bytesToPrintableAscii(data) << '"';
-    return oss.str();
+    std::string out = "bytes=" + std::to_string(data.size());
+    out += ", hex=";
+    out += bytesToHex(data);
+    out += ", ascii=\"";
+    out += bytesToPrintableAscii(data);
+    out += '"';
+    return out;
 }
 
 }  // namespace protocol_log
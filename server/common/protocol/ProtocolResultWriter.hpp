@@ -16,10 +16,13 @@
 #include <vector>
 
 #include "FrameResult.hpp"
+#include "IngestMetrics.hpp"
 #include "common/cache/DeviceCache.hpp"
 #include "common/cache/RealtimeDataCache.hpp"
 #include "common/cache/ResourceVersion.hpp"
 #include "common/network/WebSocketManager.hpp"
+#include "common/utils/LoopWatchdog.hpp"
+#include "common/utils/MemoryFootprint.hpp"
 #include "modules/alert/AlertEngine.hpp"
 #include "modules/device/DeviceDataTransformer.hpp"
 #include "modules/device/domain/CommandRepository.hpp"
@@ -78,6 +81,7 @@ public:
         if (!batchLoop_ || results.empty()) return;
 
         batchLoop_->queueInLoop([this, results = std::move(results)]() mutable {
+            LoopWatchdog::TaskScope task("resultWriter.enqueue");
             enqueueBatchResults(std::move(results));
         });
     }
@@ -90,15 +94,26 @@ public:
         return totalBatchFallbacks_.load(std::memory_order_relaxed);
     }
 
+    /**
+     * @brief 待写入与写入中结果的近似占用（单条大小按每批首条抽样，见 MemoryFootprint.hpp）
+     */
+    size_t approximatePendingBytes() const {
+        const auto results = pendingResults_.load(std::memory_order_relaxed)
+                           + inFlightResults_.load(std::memory_order_relaxed);
+        return results * sampledResultBytes_.load(std::memory_order_relaxed);
+    }
+
 private:
     void enqueueBatchResults(std::vector<ParsedFrameResult>&& results) {
         for (auto& r : results) {
             pendingBatch_.push_back(std::move(r));
         }
+        pendingResults_.store(pendingBatch_.size(), std::memory_order_relaxed);
 
         if (!batchTimerActive_ && !pendingBatch_.empty()) {
             batchTimerActive_ = true;
             batchTimerId_ = batchLoop_->runAfter(DEFAULT_FLUSH_INTERVAL_SEC, [this]() {
+                LoopWatchdog::TaskScope task("resultWriter.flush");
                 try {
                     batchTimerActive_ = false;
                     flushBatch();
@@ -126,16 +141,37 @@ private:
 
         std::vector<ParsedFrameResult> batch;
         batch.swap(pendingBatch_);
+        pendingResults_.store(0, std::memory_order_relaxed);
+        const size_t batchSize = batch.size();
+        inFlightResults_.fetch_add(batchSize, std::memory_order_relaxed);
+        sampledResultBytes_.store(approximateBytes(batch.front()), std::memory_order_relaxed);
+
+        const auto flushStart = ingest_metrics::Clock::now();
+        for (const auto& r : batch) {
+            if (r.submittedAt != ingest_metrics::Clock::time_point{}) {
+                ingest_metrics::observe(ingest_metrics::Stage::QueueWait, r.protocol, r.linkId,
+                                        flushStart - r.submittedAt);
+            }
+        }
 
-        drogon::async_run([this, batch = std::move(batch)]() -> Task<> {
+        drogon::async_run([this, batch = std::move(batch), batchSize, flushStart]() -> Task<> {
             try {
                 co_await saveBatchResults(batch);
             } catch (const std::exception& e) {
                 LOG_ERROR << "[ProtocolResultWriter] flushBatch failed: " << e.what();
             }
+            inFlightResults_.fetch_sub(batchSize, std::memory_order_relaxed);
+            ingest_metrics::observeBatch(ingest_metrics::Stage::BatchFlush,
+                                         ingest_metrics::Clock::now() - flushStart);
         });
     }
 
+    static size_t approximateBytes(const ParsedFrameResult& r) {
+        return sizeof(ParsedFrameResult)
+             + memory::heapBytes(r.protocol) + memory::heapBytes(r.funcCode) + memory::heapBytes(r.reportTime)
+             + memory::jsonBytes(r.data) - sizeof(Json::Value);
+    }
+
     Task<void> saveBatchResults(const std::vector<ParsedFrameResult>& batch) {
         std::vector<ParsedFrameResult> sanitizedBatch = batch;
         for (auto& r : sanitizedBatch) {
@@ -156,7 +192,10 @@ private:
                     items.push_back({r.deviceId, r.linkId, r.protocol, r.data, r.reportTime});
                 }
 
+                const auto insertStart = ingest_metrics::Clock::now();
                 persistedIds = co_await CommandRepository::saveBatch(items);
+                ingest_metrics::observeBatch(ingest_metrics::Stage::DbInsert,
+                                             ingest_metrics::Clock::now() - insertStart);
                 persistedBatch = persistBatch;
                 markPersistedResults(persistedBatch);
                 LOG_TRACE << "[ProtocolResultWriter] Batch saved: " << persistBatch.size() << " records";
@@ -197,7 +236,7 @@ private:
         }
 
         for (const auto& r : realtimeBatch) {
-
+            auto stageStart = ingest_metrics::Clock::now();
             try {
                 co_await RealtimeDataCache::instance().mergeUpdateAsync(
                     r.deviceId, r.funcCode, r.data, r.reportTime
@@ -206,13 +245,18 @@ private:
                 LOG_WARN << "[ProtocolResultWriter] mergeUpdateAsync failed for device="
                          << r.deviceId << ": " << e.what();
             }
+            auto stageEnd = ingest_metrics::Clock::now();
+            ingest_metrics::observe(ingest_metrics::Stage::CacheMerge, r.protocol, r.linkId, stageEnd - stageStart);
 
+            stageStart = stageEnd;
             try {
                 co_await AlertEngine::instance().checkData(r.deviceId, r.data);
             } catch (const std::exception& e) {
                 LOG_WARN << "[ProtocolResultWriter] checkData failed for device="
                          << r.deviceId << ": " << e.what();
             }
+            ingest_metrics::observe(ingest_metrics::Stage::AlertEval, r.protocol, r.linkId,
+                                    ingest_metrics::Clock::now() - stageStart);
         }
 
         for (size_t i = 0; i < persistedBatch.size(); ++i) {
@@ -229,10 +273,27 @@ private:
         }
 
         if (!realtimeBatch.empty()) {
-            ResourceVersion::instance().incrementVersion("device");
+            // 只推进本批次涉及设备的数据版本，设备配置版本与其他设备的 ETag 不受影响
+            std::vector<int> deviceIds;
+            deviceIds.reserve(realtimeBatch.size());
+            for (const auto& r : realtimeBatch) {
+                deviceIds.push_back(r.deviceId);
+            }
+            ResourceVersion::instance().incrementVersions("device:data", deviceIds);
+            const auto broadcastStart = ingest_metrics::Clock::now();
             co_await broadcastRealtimeViaWs(realtimeBatch);
+            ingest_metrics::observeBatch(ingest_metrics::Stage::WsBroadcast,
+                                         ingest_metrics::Clock::now() - broadcastStart);
             OpenWebhookDispatcher::instance().dispatchMergedDataReports(realtimeBatch);
             OpenWebhookDispatcher::instance().dispatch(realtimeBatch);
+
+            const auto done = ingest_metrics::Clock::now();
+            for (const auto& r : realtimeBatch) {
+                if (r.receivedAt != ingest_metrics::Clock::time_point{}) {
+                    ingest_metrics::observe(ingest_metrics::Stage::EndToEnd, r.protocol, r.linkId,
+                                            done - r.receivedAt);
+                }
+            }
         }
     }
 
@@ -328,6 +389,8 @@ private:
         }
     }
 
+public:
+    /** 非法 UTF-8 序列替换为 '?'（PostgreSQL JSONB 拒收非法编码） */
     static std::string sanitizeUtf8(std::string_view input) {
         std::string output;
         output.reserve(input.size());
@@ -407,6 +470,7 @@ private:
         }
     }
 
+private:
     void pruneRealtimeStoreWindowsLocked(std::chrono::steady_clock::time_point now) {
         for (auto it = realtimeStoreUntil_.begin(); it != realtimeStoreUntil_.end();) {
             if (now >= it->second) {
@@ -524,6 +588,9 @@ private:
     bool batchTimerActive_ = false;
     std::atomic<int64_t> totalBatchFlushes_{0};
     std::atomic<int64_t> totalBatchFallbacks_{0};
+    std::atomic<size_t> pendingResults_{0};
+    std::atomic<size_t> inFlightResults_{0};
+    std::atomic<size_t> sampledResultBytes_{0};
     mutable std::mutex storageMutex_;
     std::map<int, std::chrono::system_clock::time_point> lastStoredReportTimes_;
     std::map<int, Json::Value> lastStoredData_;
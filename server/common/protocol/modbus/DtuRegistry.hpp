@@ -152,6 +152,15 @@ inline ModbusDeviceDef buildDeviceDef(const DeviceCache::CachedDevice& device, c
     if (def.readInterval < 1 || def.readInterval > 3600) {
         def.readInterval = DTU_DEFAULT_READ_INTERVAL;
     }
+    def.readIntervalMs = config.get("readIntervalMs", 0).asInt();
+    if (def.readIntervalMs > 0) {
+        def.readIntervalMs = std::clamp(def.readIntervalMs, 100, 3600 * 1000);
+    }
+    if (config.isMember("rateLimit") && config["rateLimit"].isObject()) {
+        const auto& rateLimit = config["rateLimit"];
+        def.maxRequestsPerSec = std::max(0.0, rateLimit.get("requestsPerSec", 0.0).asDouble());
+        def.maxBytesPerSec = std::max(0.0, rateLimit.get("bytesPerSec", 0.0).asDouble());
+    }
     def.commandFastReadDuration = std::clamp(device.commandFastReadDuration, 0, 3600);
     def.commandFastReadInterval = std::clamp(device.commandFastReadInterval, 1, 60);
 
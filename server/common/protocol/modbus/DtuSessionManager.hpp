@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Modbus.SessionTypes.hpp"
+#include "common/utils/MemoryFootprint.hpp"
 
 #include <functional>
 #include <map>
@@ -70,12 +71,19 @@ public:
     /** 清除所有 session 的 inflight 请求和 PollRead 队列（配置热重载时调用） */
     void clearInflightAndPollQueues();
 
+    /** 全部 session 队列的累计统计（含已销毁 session，断连后不回退） */
+    ProtocolJobQueueStats jobQueueStats() const;
+
+    /** 会话、接收缓冲与待发队列的近似占用（见 MemoryFootprint.hpp） */
+    size_t approximateBytes() const;
+
 private:
     std::map<std::string, DtuSession> sessions_;
     std::map<std::string, std::string> dtuToSessionKey_;
     std::map<std::string, OnlineRoute> routeBySessionAndSlave_;
     std::map<int, OnlineRoute> routeByDeviceId_;
     OldSessionDisplacedCallback oldSessionDisplacedCallback_;
+    ProtocolJobQueueStats retiredQueueStats_;  // 已销毁 session 的队列统计
     mutable std::mutex mutex_;
 };
 
@@ -133,6 +141,7 @@ inline void DtuSessionManager::onDisconnected(int linkId, const std::string& cli
         }
     }
 
+    retiredQueueStats_.merge(sessionIt->second.jobQueue.stats());
     sessions_.erase(sessionIt);
 }
 
@@ -223,6 +232,20 @@ inline std::vector<DtuSession> DtuSessionManager::reconcileDefinitions(
                         }
                     }
 
+                    // 已从该 DTU 移除的设备：按设备 key 直接丢弃其排队任务（含写任务）
+                    std::set<int> removedDevices;
+                    for (const auto& [slaveId, deviceId] : session.deviceIdsBySlave) {
+                        (void)slaveId;
+                        removedDevices.insert(deviceId);
+                    }
+                    for (const auto& [slaveId, device] : defIt->second.devicesBySlave) {
+                        (void)slaveId;
+                        removedDevices.erase(device.deviceId);
+                    }
+                    for (int deviceId : removedDevices) {
+                        session.jobQueue.removeKey(deviceId);
+                    }
+
                     session.deviceIdsBySlave.clear();
                     for (const auto& [slaveId, device] : defIt->second.devicesBySlave) {
                         session.deviceIdsBySlave[slaveId] = device.deviceId;
@@ -261,6 +284,7 @@ inline std::vector<DtuSession> DtuSessionManager::reconcileDefinitions(
                     ++routeIt;
                 }
             }
+            retiredQueueStats_.merge(session.jobQueue.stats());
             sessionIt = sessions_.erase(sessionIt);
         }
     }
@@ -423,4 +447,36 @@ inline void DtuSessionManager::clearInflightAndPollQueues() {
     }
 }
 
+inline ProtocolJobQueueStats DtuSessionManager::jobQueueStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stats = retiredQueueStats_;
+    for (const auto& [sessionKey, session] : sessions_) {
+        (void)sessionKey;
+        stats.merge(session.jobQueue.stats());
+    }
+    return stats;
+}
+
+inline size_t DtuSessionManager::approximateBytes() const {
+    // 队列内任务只按定长估算：请求帧与写入元素都很小
+    constexpr size_t kQueuedJobBytes = sizeof(ModbusJob) + 2 * sizeof(void*) + 32;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t bytes = memory::treeBytes(sessions_) + memory::treeBytes(dtuToSessionKey_)
+                 + memory::treeBytes(routeBySessionAndSlave_) + memory::treeBytes(routeByDeviceId_);
+    for (const auto& [sessionKey, session] : sessions_) {
+        bytes += memory::heapBytes(sessionKey) + memory::heapBytes(session.clientAddr)
+               + memory::heapBytes(session.sessionKey) + memory::heapBytes(session.dtuKey)
+               + memory::vectorBytes(session.rxBuffer) + memory::treeBytes(session.deviceIdsBySlave)
+               + session.jobQueue.size() * kQueuedJobBytes;
+    }
+    for (const auto& [dtuKey, sessionKey] : dtuToSessionKey_) {
+        bytes += memory::heapBytes(dtuKey) + memory::heapBytes(sessionKey);
+    }
+    for (const auto& [routeKey, _] : routeBySessionAndSlave_) {
+        bytes += memory::heapBytes(routeKey);
+    }
+    return bytes;
+}
+
 }  // namespace modbus
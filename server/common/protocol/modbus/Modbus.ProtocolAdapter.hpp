@@ -274,6 +274,10 @@ public:
         driveDiscovery();
     }
 
+    size_t sessionBufferBytes() const override {
+        return sessionManager_ ? sessionManager_->approximateBytes() : 0;
+    }
+
     ProtocolAdapterMetrics getMetrics() const override {
         ProtocolAdapterMetrics metrics;
         metrics.available = sessionEngine_ != nullptr;
@@ -338,11 +342,19 @@ public:
         metrics.stats["discoveryRequestedSessionCount"] = discoveryRequestedSessions;
         metrics.stats["inflightSessionCount"] = inflightSessions;
         metrics.stats["queuedJobCount"] = queuedJobs;
+        const auto queueStats = sessionManager_ ? sessionManager_->jobQueueStats() : ProtocolJobQueueStats{};
+        metrics.stats["expiredPollJobCount"] = static_cast<Json::UInt64>(queueStats.expired);
+        metrics.stats["rejectedJobCount"] = static_cast<Json::UInt64>(queueStats.rejected);
+        metrics.stats["queueWaitHigh"] = waitHistogramJson(queueStats.highWait);
+        metrics.stats["queueWaitNormal"] = waitHistogramJson(queueStats.normalWait);
         metrics.stats["onlineRouteCount"] = onlineRoutes;
         metrics.stats["legacyMappingsCleanedLastReload"] =
             static_cast<Json::Int64>(legacyMappingsCleanedLast_.load(std::memory_order_relaxed));
         metrics.stats["legacyMappingsCleanedTotal"] =
             static_cast<Json::Int64>(legacyMappingsCleanedTotal_.load(std::memory_order_relaxed));
+        if (pollScheduler_) {
+            pollScheduler_->appendMetrics(metrics.stats);
+        }
         return metrics;
     }
 
@@ -662,6 +674,22 @@ private:
         }
     }
 
+    static Json::Value waitHistogramJson(const ProtocolQueueWaitHistogram& histogram) {
+        Json::Value result;
+        Json::Value buckets(Json::objectValue);
+        for (size_t i = 0; i < histogram.buckets.size(); ++i) {
+            const std::string label = i < ProtocolQueueWaitHistogram::BOUNDS_MS.size()
+                ? "le" + std::to_string(ProtocolQueueWaitHistogram::BOUNDS_MS[i])
+                : "inf";
+            buckets[label] = static_cast<Json::UInt64>(histogram.buckets[i]);
+        }
+        result["buckets"] = std::move(buckets);
+        result["count"] = static_cast<Json::UInt64>(histogram.count);
+        result["avgMs"] = histogram.avgMs();
+        result["maxMs"] = static_cast<Json::Int64>(histogram.maxMs);
+        return result;
+    }
+
     static const char* jobKindLabel(ModbusJobKind kind) {
         switch (kind) {
             case ModbusJobKind::DiscoveryRead:
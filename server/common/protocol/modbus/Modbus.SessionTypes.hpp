@@ -41,6 +41,9 @@ struct ModbusDeviceDef {
     FrameMode frameMode = FrameMode::TCP;
     ByteOrder byteOrder = ByteOrder::Big;
     int readInterval = 1;
+    int readIntervalMs = 0;  // >0 时按毫秒轮询，优先于 readInterval
+    double maxRequestsPerSec = 0.0;  // DTU 限速（rateLimit.requestsPerSec），0 表示取全局默认
+    double maxBytesPerSec = 0.0;     // DTU 限速（rateLimit.bytesPerSec），0 表示取全局默认
     int commandFastReadDuration = 60;
     int commandFastReadInterval = 1;
     std::vector<RegisterDef> registers;
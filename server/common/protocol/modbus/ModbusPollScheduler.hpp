@@ -14,6 +14,7 @@ namespace modbus {
  *
  * 协议无关的 tick、失败降频、快读窗口、多 step 推进由 ProtocolPollScheduler 统一处理。
  * 本类只负责把 Modbus DTU/读组配置映射成通用 PollTask，并保留 DTU 绑定启停语义。
+ * 同一 DTU 共用一条串口总线，以 DTU 为限速键，周期字节数按读组数量估算。
  */
 class ModbusPollScheduler {
 public:
@@ -44,6 +45,10 @@ public:
                 task.linkId = device.linkId;
                 task.stepCount = device.readGroups.size();
                 task.intervalSec = device.readInterval;
+                task.intervalMs = device.readIntervalMs;
+                task.rateKey = "dtu:" + dtu.dtuKey;
+                task.bytesPerCycle = estimateCycleBytes(device);
+                task.rateLimit = {device.maxRequestsPerSec, device.maxBytesPerSec};
                 task.fastReadDurationSec = device.commandFastReadDuration;
                 task.fastReadIntervalSec = device.commandFastReadInterval;
                 task.enabled = false;
@@ -74,7 +79,28 @@ public:
         scheduler_.onStepCompleted(deviceId, readGroupIndex, success);
     }
 
+    void appendMetrics(Json::Value& stats) const {
+        scheduler_.appendMetrics(stats);
+    }
+
 private:
+    /**
+     * @brief 估算一轮读组的上下行字节数（RTU：请求 8 + 应答 5 + 数据；TCP：请求 12 + 应答 9 + 数据）
+     */
+    static size_t estimateCycleBytes(const ModbusDeviceDef& device) {
+        const size_t overhead = device.frameMode == FrameMode::TCP ? 12 + 9 : 8 + 5;
+        size_t total = 0;
+        for (const auto& group : device.readGroups) {
+            const bool bitType = group.registerType == RegisterType::COIL
+                || group.registerType == RegisterType::DISCRETE_INPUT;
+            const size_t payload = bitType
+                ? (static_cast<size_t>(group.totalQuantity) + 7) / 8
+                : static_cast<size_t>(group.totalQuantity) * 2;
+            total += overhead + payload;
+        }
+        return total;
+    }
+
     ProtocolPollScheduler scheduler_;
 };
 
@@ -1,10 +1,13 @@
 #pragma once
 
 #include "RegistrationNormalizer.hpp"
+#include "common/protocol/IngestMetrics.hpp"
 #include "common/protocol/ParsedResult.hpp"
+#include "common/network/FrameTrace.hpp"
 #include "common/network/LinkTransportFacade.hpp"
 #include "common/utils/AppException.hpp"
 #include "common/utils/Constants.hpp"
+#include "common/utils/LogLimiter.hpp"
 
 #include <algorithm>
 #include <atomic>
@@ -36,6 +39,7 @@ public:
     inline static constexpr const char* FUNC_WRITE = "MODBUS_WRITE";
     inline static constexpr auto REQUEST_TIMEOUT = std::chrono::milliseconds(5000);
     inline static constexpr auto DISCOVERY_RETRY_DELAY = std::chrono::seconds(1);
+    inline static constexpr auto POLL_JOB_MIN_TTL = std::chrono::milliseconds(1000);
 
     struct ProcessResult {
         std::vector<ParsedFrameResult> parsedResults;
@@ -383,9 +387,9 @@ inline std::vector<ModbusResponse> ModbusSessionEngine::appendAndParseSessionFra
     // 防止 rxBuffer 无限增长（正常 Modbus 响应不超过 260 字节）
     static constexpr size_t MAX_RX_BUFFER_SIZE = 4096;
     if (session.rxBuffer.size() + payload.size() > MAX_RX_BUFFER_SIZE) {
-        LOG_WARN << "[Modbus][SessionEngine] rxBuffer overflow for session "
-                 << session.clientAddr << ", clearing ("
-                 << session.rxBuffer.size() + payload.size() << " bytes)";
+        LOG_LIMITED(kWarn, 1, 5) << "[Modbus][SessionEngine] rxBuffer overflow for session "
+                                 << session.clientAddr << ", clearing ("
+                                 << session.rxBuffer.size() + payload.size() << " bytes)";
         session.rxBuffer.clear();
     }
 
@@ -459,6 +463,7 @@ inline bool ModbusSessionEngine::sendFrame(
     ModbusJobKind jobKind) const {
 
     const std::string data(frame.begin(), frame.end());
+    FrameTrace::DeviceScope traceDevice(device.deviceId);
     bool ok;
     if (device.linkMode == Constants::LINK_MODE_TCP_CLIENT) {
         ok = LinkTransportFacade::instance().sendToTarget(device.linkId, device.targetId, data);
@@ -469,20 +474,23 @@ inline bool ModbusSessionEngine::sendFrame(
     const char* opLabel = (jobKind == ModbusJobKind::WriteRegisters) ? "控制" : "查询";
 
     if (ok) {
-        std::ostringstream hex;
-        for (size_t i = 0; i < frame.size(); ++i) {
-            if (i > 0) hex << ' ';
-            hex << std::uppercase << std::hex << std::setw(2) << std::setfill('0')
-                << static_cast<int>(frame[i]);
+        if (trantor::Logger::logLevel() <= trantor::Logger::kDebug) {
+            std::ostringstream hex;
+            for (size_t i = 0; i < frame.size(); ++i) {
+                if (i > 0) hex << ' ';
+                hex << std::uppercase << std::hex << std::setw(2) << std::setfill('0')
+                    << static_cast<int>(frame[i]);
+            }
+            LOG_DEBUG << "[Modbus][" << opLabel << "] TX " << device.deviceName
+                      << "(id=" << device.deviceId << ",slave=" << static_cast<int>(device.slaveId)
+                      << ") " << frame.size() << "B to "
+                      << session.clientAddr << " | " << hex.str();
         }
-        LOG_DEBUG << "[Modbus][" << opLabel << "] TX " << device.deviceName
-                  << "(id=" << device.deviceId << ",slave=" << static_cast<int>(device.slaveId)
-                  << ") " << frame.size() << "B to "
-                  << session.clientAddr << " | " << hex.str();
     } else {
-        LOG_WARN << "[Modbus][" << opLabel << "] TX failed " << device.deviceName
-                 << "(id=" << device.deviceId << ") to " << session.clientAddr
-                 << ", " << frame.size() << "B";
+        LOG_DEVICE_LIMITED(kWarn, device.deviceId)
+            << "[Modbus][" << opLabel << "] TX failed " << device.deviceName
+            << "(id=" << device.deviceId << ") to " << session.clientAddr
+            << ", " << frame.size() << "B";
         if (device.linkMode == Constants::LINK_MODE_TCP_CLIENT) {
             LinkTransportFacade::instance().forceDisconnectTarget(device.linkId, device.targetId);
         } else {
@@ -525,12 +533,13 @@ inline bool ModbusSessionEngine::tryDispatchNext(int linkId, const std::string&
     std::optional<DispatchCandidate> candidate;
     std::optional<ModbusJob> failedReadJob;
     std::optional<ModbusJob> failedWriteJob;
+    std::vector<ModbusJob> expiredJobs;
 
     sessions_.mutateSession(linkId, clientAddr, [&](DtuSession& session) {
         if (session.inflight) return;
 
         ModbusJob job;
-        if (!session.jobQueue.popNext(job)) return;
+        if (!session.jobQueue.popNext(job, &expiredJobs)) return;
 
         auto deviceOpt = registry_.findDevice(job.deviceId);
         if (!deviceOpt) {
@@ -566,6 +575,17 @@ inline bool ModbusSessionEngine::tryDispatchNext(int linkId, const std::string&
         candidate = DispatchCandidate{session, *deviceOpt, std::move(job)};
     });
 
+    // 排队超过截止时间的轮询读不再发送，按失败结束本轮周期，由调度器重新排期
+    for (const auto& expired : expiredJobs) {
+        if (expired.kind != ModbusJobKind::PollRead) {
+            continue;
+        }
+        clearPollCycle(expired.deviceId);
+        if (readCompletionCallback_) {
+            readCompletionCallback_(expired.deviceId, expired.readGroupIndex, false);
+        }
+    }
+
     if (candidate) {
         const bool sent = sendFrame(
             candidate->session,
@@ -913,8 +933,8 @@ inline ModbusSessionEngine::ProcessResult ModbusSessionEngine::onBytes(
     ProcessResult output;
     auto normalized = normalizer_.normalize(linkId, clientAddr, bytes);
     if (normalized.kind == RegistrationMatchKind::Conflict) {
-        LOG_WARN << "[Modbus][SessionEngine] Registration conflict: linkId="
-                 << linkId << ", client=" << clientAddr;
+        LOG_LIMITED(kWarn, 1, 5) << "[Modbus][SessionEngine] Registration conflict: linkId="
+                                 << linkId << ", client=" << clientAddr;
         return output;
     }
 
@@ -943,19 +963,24 @@ inline ModbusSessionEngine::ProcessResult ModbusSessionEngine::onPayload(
 
     auto modeOpt = getSessionFrameMode(*sessionOpt);
     if (!modeOpt) {
-        LOG_WARN << "[Modbus][SessionEngine] No frame mode for session: "
-                 << "linkId=" << linkId
-                 << ", client=" << clientAddr
-                 << ", dtuKey=" << sessionOpt->dtuKey
-                 << ", bytes=" << payload.size();
+        LOG_LIMITED(kWarn, 1, 5) << "[Modbus][SessionEngine] No frame mode for session: "
+                                 << "linkId=" << linkId
+                                 << ", client=" << clientAddr
+                                 << ", dtuKey=" << sessionOpt->dtuKey
+                                 << ", bytes=" << payload.size();
         return output;
     }
 
     std::vector<ModbusResponse> parsed;
-    sessions_.mutateSession(linkId, clientAddr, [&](DtuSession& session) {
-        parsed = appendAndParseSessionFrames(session, *modeOpt, payload);
-        session.lastSeen = std::chrono::steady_clock::now();
-    });
+    {
+        ingest_metrics::StageTimer timer(ingest_metrics::Stage::Framing, Constants::PROTOCOL_MODBUS, linkId);
+        sessions_.mutateSession(linkId, clientAddr, [&](DtuSession& session) {
+            parsed = appendAndParseSessionFrames(session, *modeOpt, payload);
+            session.lastSeen = std::chrono::steady_clock::now();
+        });
+    }
+
+    ingest_metrics::StageTimer parseTimer(ingest_metrics::Stage::Parse, Constants::PROTOCOL_MODBUS, linkId);
 
     for (const auto& response : parsed) {
         auto inflightOpt = takeMatchingInflight(linkId, clientAddr, response);
@@ -980,13 +1005,14 @@ inline ModbusSessionEngine::ProcessResult ModbusSessionEngine::onPayload(
         }
 
         if (!sessionOpt->dtuKey.empty() && deviceOpt->dtuKey != sessionOpt->dtuKey) {
-            LOG_WARN << "[Modbus][SessionEngine] Drop stale inflight response: "
-                     << deviceOpt->deviceName
-                     << "(id=" << deviceOpt->deviceId
-                     << ", dtuKey=" << deviceOpt->dtuKey
-                     << ") on session dtuKey=" << sessionOpt->dtuKey
-                     << ", client=" << clientAddr
-                     << ", slave=" << static_cast<int>(response.slaveId);
+            LOG_DEVICE_LIMITED(kWarn, deviceOpt->deviceId)
+                << "[Modbus][SessionEngine] Drop stale inflight response: "
+                << deviceOpt->deviceName
+                << "(id=" << deviceOpt->deviceId
+                << ", dtuKey=" << deviceOpt->dtuKey
+                << ") on session dtuKey=" << sessionOpt->dtuKey
+                << ", client=" << clientAddr
+                << ", slave=" << static_cast<int>(response.slaveId);
 
             if (inflightOpt->job.kind == ModbusJobKind::WriteRegisters) {
                 dropQueuedWriteJobsForCommand(linkId, clientAddr, inflightOpt->job.commandKey);
@@ -1028,11 +1054,12 @@ inline ModbusSessionEngine::ProcessResult ModbusSessionEngine::onPayload(
         }
 
         if (response.isException) {
-            LOG_WARN << "[Modbus][SessionEngine] RX frame exception: " << deviceOpt->deviceName
-                     << "(id=" << deviceOpt->deviceId
-                     << ",slave=" << static_cast<int>(response.slaveId)
-                     << ") fc=" << static_cast<int>(response.functionCode)
-                     << ", code=" << static_cast<int>(response.exceptionCode);
+            LOG_DEVICE_LIMITED(kWarn, deviceOpt->deviceId)
+                << "[Modbus][SessionEngine] RX frame exception: " << deviceOpt->deviceName
+                << "(id=" << deviceOpt->deviceId
+                << ",slave=" << static_cast<int>(response.slaveId)
+                << ") fc=" << static_cast<int>(response.functionCode)
+                << ", code=" << static_cast<int>(response.exceptionCode);
             if (inflightOpt->job.kind == ModbusJobKind::PollRead) {
                 // 单个读组异常时，不中断整轮轮询；
                 // 允许已成功读取的其他寄存器继续保留并在最后一组结束时落库。
@@ -1149,6 +1176,12 @@ inline bool ModbusSessionEngine::enqueuePoll(int deviceId, size_t readGroupIndex
     request.quantity = group.totalQuantity;
     request.transactionId = transactionCounter_.fetch_add(1, std::memory_order_relaxed);
 
+    // 等待超过一个轮询周期（至少 POLL_JOB_MIN_TTL）的读请求已无意义，出队时丢弃
+    const auto pollInterval = deviceOpt->readIntervalMs > 0
+        ? std::chrono::milliseconds(deviceOpt->readIntervalMs)
+        : std::chrono::milliseconds(deviceOpt->readInterval * 1000LL);
+    const auto deadline = std::chrono::steady_clock::now() + std::max<std::chrono::milliseconds>(pollInterval, POLL_JOB_MIN_TTL);
+
     ModbusJob job;
     job.kind = ModbusJobKind::PollRead;
     job.deviceId = deviceOpt->deviceId;
@@ -1160,7 +1193,7 @@ inline bool ModbusSessionEngine::enqueuePoll(int deviceId, size_t readGroupIndex
 
     bool rejected = false;
     const bool queued = sessions_.mutateSession(sessionOpt->linkId, sessionOpt->clientAddr, [&](DtuSession& session) {
-        if (!session.jobQueue.push(job, ProtocolJobPriority::Normal)) {
+        if (!session.jobQueue.push(job, ProtocolJobPriority::Normal, job.deviceId, deadline)) {
             rejected = true;
         }
     });
@@ -1358,10 +1391,11 @@ inline ModbusSessionEngine::ProcessResult ModbusSessionEngine::processTimeouts()
         } else if (timedOut->job.kind == ModbusJobKind::PollRead) {
             auto deviceOpt = registry_.findDevice(timedOut->job.deviceId);
         if (deviceOpt) {
-            LOG_WARN << "[Modbus][SessionEngine] Timeout waiting for frame: " << deviceOpt->deviceName
-                     << "(id=" << deviceOpt->deviceId
-                     << ",slave=" << static_cast<int>(deviceOpt->slaveId)
-                     << ") after " << REQUEST_TIMEOUT.count() << "ms";
+            LOG_DEVICE_LIMITED(kWarn, deviceOpt->deviceId)
+                << "[Modbus][SessionEngine] Timeout waiting for frame: " << deviceOpt->deviceName
+                << "(id=" << deviceOpt->deviceId
+                << ",slave=" << static_cast<int>(deviceOpt->slaveId)
+                << ") after " << REQUEST_TIMEOUT.count() << "ms";
         }
             clearPollCycle(timedOut->job.deviceId);
             if (readCompletionCallback_) {
@@ -1418,7 +1452,8 @@ inline bool ModbusSessionEngine::submitPreparedWrite(PreparedWrite prepared) {
             return;
         }
         for (auto& job : prepared.jobs) {
-            if (!session.jobQueue.push(std::move(job), ProtocolJobPriority::High)) {
+            const int deviceId = job.deviceId;
+            if (!session.jobQueue.push(std::move(job), ProtocolJobPriority::High, deviceId)) {
                 rejected = true;
                 return;
             }
@@ -14,13 +14,17 @@ namespace s7 {
  * @brief S7 轮询调度器适配层
  *
  * 统一轮询状态机在 ProtocolPollScheduler 中实现；S7 每个设备只有一个轮询 step。
+ * 按链路整形请求速率；读取字节数依赖 PDU 协商结果，不做字节整形。
  */
 class S7PollScheduler {
 public:
     struct DeviceConfig {
         int deviceId = 0;
         std::string deviceName;
+        int linkId = 0;
         int readIntervalSec = 5;
+        int readIntervalMs = 0;
+        double maxRequestsPerSec = 0.0;
         int fastReadDurationSec = 60;
         int fastReadIntervalSec = 1;
         bool enabled = true;
@@ -49,7 +53,10 @@ public:
             task.deviceName = device.deviceName;
             task.groupKey = std::to_string(device.deviceId);
             task.stepCount = 1;
+            task.linkId = device.linkId;
             task.intervalSec = std::max(1, device.readIntervalSec);
+            task.intervalMs = device.readIntervalMs;
+            task.rateLimit = {device.maxRequestsPerSec, 0.0};
             task.fastReadDurationSec = std::clamp(device.fastReadDurationSec, 0, 3600);
             task.fastReadIntervalSec = std::clamp(device.fastReadIntervalSec, 1, 60);
             task.enabled = device.enabled;
@@ -79,6 +86,10 @@ public:
         scheduler_.onStepCompleted(deviceId, 0, success);
     }
 
+    void appendMetrics(Json::Value& stats) const {
+        scheduler_.appendMetrics(stats);
+    }
+
 private:
     EnqueuePollCallback enqueuePollCallback_;
     ProtocolPollScheduler scheduler_;
@@ -6,6 +6,7 @@
 #include "S7.Client.hpp"
 #include "S7.PollScheduler.hpp"
 #include "common/cache/DeviceCache.hpp"
+#include "common/network/FrameTrace.hpp"
 #include "common/network/LinkTransportFacade.hpp"
 #include "common/network/TcpLinkManager.hpp"
 #include "common/protocol/ProtocolAdapter.hpp"
@@ -71,6 +72,8 @@ struct S7ConnectionConfig {
     int directProbeTimeoutMs = 5000;
     int retryDelayMs = 1000;
     int pollIntervalSec = 5;
+    int pollIntervalMs = 0;  // >0 时按毫秒轮询，优先于 pollIntervalSec
+    double maxRequestsPerSec = 0.0;  // 链路请求限速（rateLimit.requestsPerSec），0 表示取全局默认
     std::uint16_t pduRequestLength = kDefaultS7PduRequest;
     std::string connectionType = "PG";
     ProbeMode probeMode = ProbeMode::Standard;
@@ -90,6 +93,7 @@ inline bool sameS7Connection(const S7ConnectionConfig& lhs, const S7ConnectionCo
         && lhs.directProbeTimeoutMs == rhs.directProbeTimeoutMs
         && lhs.retryDelayMs == rhs.retryDelayMs
         && lhs.pollIntervalSec == rhs.pollIntervalSec
+        && lhs.pollIntervalMs == rhs.pollIntervalMs
         && lhs.pduRequestLength == rhs.pduRequestLength
         && lhs.connectionType == rhs.connectionType
         && lhs.probeMode == rhs.probeMode;
@@ -445,6 +449,9 @@ public:
         metrics.stats["sessionReadyCount"] = sessionReadyCount;
         metrics.stats["dtuOnlineCount"] = dtuOnlineCount;
         metrics.stats["plcOnlineCount"] = sessionReadyCount;
+        if (pollScheduler_) {
+            pollScheduler_->appendMetrics(metrics.stats);
+        }
         return metrics;
     }
 
@@ -1515,6 +1522,8 @@ private:
         buffer.push_back(static_cast<uint8_t>(value & 0xFF));
     }
 
+public:
+    /** 按区域定义解码读取到的字节（大端） */
     static Json::Value decodeAreaValue(const S7AreaDefinition& area, const std::vector<uint8_t>& buffer) {
         const std::string dataType = normalizeDataType(area.dataType);
 
@@ -1579,6 +1588,7 @@ private:
         return Json::Value(bytesToHex(buffer));
     }
 
+private:
     static Json::Value buildReadElement(const S7AreaDefinition& area,
                                         const std::vector<uint8_t>& buffer) {
         Json::Value element(Json::objectValue);
@@ -1916,6 +1926,13 @@ private:
         connection.directProbeTimeoutMs = std::clamp(connection.directProbeTimeoutMs, 1000, 30000);
         connection.pollIntervalSec = config.get("pollInterval", 5).asInt();
         if (connection.pollIntervalSec < 1) connection.pollIntervalSec = 1;
+        connection.pollIntervalMs = config.get("pollIntervalMs", 0).asInt();
+        if (connection.pollIntervalMs > 0) {
+            connection.pollIntervalMs = std::clamp(connection.pollIntervalMs, 100, 3600 * 1000);
+        }
+        if (config.isMember("rateLimit") && config["rateLimit"].isObject()) {
+            connection.maxRequestsPerSec = std::max(0.0, config["rateLimit"].get("requestsPerSec", 0.0).asDouble());
+        }
         return connection;
     }
 
@@ -2174,7 +2191,10 @@ private:
                 pollConfigs.push_back(S7PollScheduler::DeviceConfig{
                     .deviceId = runtime->deviceId,
                     .deviceName = runtime->deviceName,
+                    .linkId = runtime->linkId,
                     .readIntervalSec = runtime->connection.pollIntervalSec,
+                    .readIntervalMs = runtime->connection.pollIntervalMs,
+                    .maxRequestsPerSec = runtime->connection.maxRequestsPerSec,
                     .fastReadDurationSec = device.commandFastReadDuration,
                     .fastReadIntervalSec = device.commandFastReadInterval,
                     .enabled = true
@@ -2705,6 +2725,7 @@ private:
         }
 
         const std::string payload = bytesToString(frame);
+        FrameTrace::DeviceScope traceDevice(deviceId);
         if (sessionBound) {
             if (LinkTransportFacade::instance().sendToClient(sessionLinkId, sessionClientAddr, payload)) {
                 return true;
@@ -3370,6 +3391,7 @@ private:
                   << summarizePacket("s7.async.req", true, frame)
                   << " hex=" << bytesToHex(frame);
 
+        FrameTrace::DeviceScope traceDevice(deviceId);
         if (LinkTransportFacade::instance().sendToClient(linkId, clientAddr, bytesToString(frame))) {
             return true;
         }
@@ -28,9 +28,7 @@ public:
 
     Task<std::optional<DeviceConfig>> getAsync(int linkId, const std::string& remoteCode) const {
         try {
-            auto dbClient = AppDbConfig::useFast()
-                ? drogon::app().getFastDbClient("default")
-                : drogon::app().getDbClient("default");
+            auto dbClient = DatabaseService(DbWorkload::Ingest).requireClient();
 
             auto result = co_await dbClient->execSqlCoro(R"(
                 SELECT d.id, d.name, d.protocol_params, d.protocol_config_id, d.link_id,
@@ -9,6 +9,8 @@
 #include "common/cache/DeviceConnectionCache.hpp"
 #include "common/cache/ResourceVersion.hpp"
 #include "common/utils/Constants.hpp"
+#include "common/utils/LogLimiter.hpp"
+#include "common/utils/MemoryFootprint.hpp"
 
 namespace sl651 {
 
@@ -52,7 +54,7 @@ private:
     CommandCompletionCallback onCommandCompletion_;
 
     // 数据库服务
-    DatabaseService dbService_;
+    DatabaseService dbService_{DbWorkload::Ingest};
 
     // 统计计数器（原子操作，无锁）
     std::atomic<int64_t> totalFramesParsed_{0};
@@ -92,6 +94,34 @@ public:
         };
     }
 
+    /**
+     * @brief 链路缓冲区与多包会话的近似占用（见 MemoryFootprint.hpp）
+     */
+    size_t approximateBufferBytes() {
+        size_t bytes = 0;
+        {
+            std::lock_guard<std::mutex> lock(bufferMutex_);
+            bytes += memory::treeBytes(buffers_);
+            for (const auto& [_, buffer] : buffers_) {
+                bytes += memory::vectorBytes(buffer);
+            }
+        }
+        std::lock_guard<std::mutex> lock(sessionMutex_);
+        bytes += memory::treeBytes(multiPacketSessions_);
+        for (const auto& [key, session] : multiPacketSessions_) {
+            bytes += memory::heapBytes(key) + memory::heapBytes(session.remoteCode)
+                   + memory::heapBytes(session.funcCode) + memory::treeBytes(session.receivedPk)
+                   + memory::treeBytes(session.packets) + memory::treeBytes(session.rawFrames);
+            for (const auto& [_, packet] : session.packets) {
+                bytes += memory::vectorBytes(packet);
+            }
+            for (const auto& [_, frame] : session.rawFrames) {
+                bytes += memory::vectorBytes(frame);
+            }
+        }
+        return bytes;
+    }
+
     /**
      * @brief 定期维护：清理过期多包会话和过大的链路缓冲区
      * 由 onMaintenanceTick 定期调用，确保即使没有新数据也能回收资源
@@ -115,8 +145,8 @@ public:
                 auto& linkBuffer = buffers_[linkId];
                 linkBuffer.insert(linkBuffer.end(), data.begin(), data.end());
                 if (linkBuffer.size() > MAX_BUFFER_SIZE) {
-                    LOG_WARN << "[SL651][Parser] Buffer overflow for linkId=" << linkId
-                             << ", size=" << linkBuffer.size() << ", clearing";
+                    LOG_LIMITED(kWarn, 1, 5) << "[SL651][Parser] Buffer overflow for linkId=" << linkId
+                                             << ", size=" << linkBuffer.size() << ", clearing";
                     linkBuffer.clear();
                     co_return;
                 }
@@ -273,8 +303,8 @@ public:
                 auto& linkBuffer = buffers_[linkId];
                 linkBuffer.insert(linkBuffer.end(), data.begin(), data.end());
                 if (linkBuffer.size() > MAX_BUFFER_SIZE) {
-                    LOG_WARN << "[SL651][Parser] Buffer overflow (sync) for linkId=" << linkId
-                             << ", size=" << linkBuffer.size() << ", clearing";
+                    LOG_LIMITED(kWarn, 1, 5) << "[SL651][Parser] Buffer overflow (sync) for linkId=" << linkId
+                                             << ", size=" << linkBuffer.size() << ", clearing";
                     linkBuffer.clear();
                     return results;
                 }
@@ -459,7 +489,8 @@ private:
     std::optional<ParsedBody> parseBodySync(const Sl651Frame& frame,
                                              const std::optional<DeviceConfig>& configOpt) {
         if (!configOpt) {
-            LOG_WARN << "[SL651][Parser] parseBodySync: no device config, code=" << frame.remoteCode;
+            LOG_DEVICE_LIMITED(kWarn, frame.remoteCode)
+                << "[SL651][Parser] parseBodySync: no device config, code=" << frame.remoteCode;
             return std::nullopt;
         }
 
@@ -479,7 +510,8 @@ private:
         }
 
         if (elements.empty()) {
-            LOG_WARN << "[SL651][Parser] No element definition for funcCode=" << frame.funcCode;
+            LOG_DEVICE_LIMITED(kWarn, frame.remoteCode)
+                << "[SL651][Parser] No element definition for funcCode=" << frame.funcCode;
             return ParsedBody{};
         }
 
@@ -504,7 +536,8 @@ private:
             }
 
             if (offset + elem.length > frame.body.size()) {
-                LOG_WARN << "[SL651][Parser] Data too short: " << elem.name;
+                LOG_DEVICE_LIMITED(kWarn, frame.remoteCode)
+                    << "[SL651][Parser] Data too short: " << elem.name;
                 break;
             }
 
@@ -610,8 +643,8 @@ private:
             auto it = multiPacketSessions_.find(sessionKey);
             if (it == multiPacketSessions_.end() || it->second.totalPk != frame.totalPk) {
                 if (it == multiPacketSessions_.end() && multiPacketSessions_.size() >= MAX_SESSION_COUNT) {
-                    LOG_WARN << "[SL651][Parser] Session limit reached (" << MAX_SESSION_COUNT
-                             << "), dropping session: " << sessionKey;
+                    LOG_LIMITED(kWarn, 1, 5) << "[SL651][Parser] Session limit reached (" << MAX_SESSION_COUNT
+                                             << "), dropping session: " << sessionKey;
                     return {};
                 }
                 MultiPacketSession newSession;
@@ -906,8 +939,8 @@ private:
             auto it = multiPacketSessions_.find(sessionKey);
             if (it == multiPacketSessions_.end() || it->second.totalPk != frame.totalPk) {
                 if (it == multiPacketSessions_.end() && multiPacketSessions_.size() >= MAX_SESSION_COUNT) {
-                    LOG_WARN << "[SL651][Parser] Session limit reached (" << MAX_SESSION_COUNT
-                             << "), dropping session: " << sessionKey;
+                    LOG_LIMITED(kWarn, 1, 5) << "[SL651][Parser] Session limit reached (" << MAX_SESSION_COUNT
+                                             << "), dropping session: " << sessionKey;
                     co_return;
                 }
                 MultiPacketSession newSession;
@@ -947,7 +980,8 @@ private:
     Task<std::optional<ParsedBody>> parseBody(int linkId, const Sl651Frame& frame) {
         auto configOpt = co_await getDeviceConfig_(linkId, frame.remoteCode);
         if (!configOpt) {
-            LOG_WARN << "[SL651][Parser] No device config: linkId=" << linkId << ", code=" << frame.remoteCode;
+            LOG_DEVICE_LIMITED(kWarn, frame.remoteCode)
+                << "[SL651][Parser] No device config: linkId=" << linkId << ", code=" << frame.remoteCode;
             co_return std::nullopt;
         }
 
@@ -969,7 +1003,8 @@ private:
         }
 
         if (elements.empty()) {
-            LOG_WARN << "[SL651][Parser] No element definition for funcCode=" << frame.funcCode;
+            LOG_DEVICE_LIMITED(kWarn, frame.remoteCode)
+                << "[SL651][Parser] No element definition for funcCode=" << frame.funcCode;
             co_return ParsedBody{};
         }
 
@@ -1003,7 +1038,8 @@ private:
 
             // 定长要素
             if (offset + elem.length > frame.body.size()) {
-                LOG_WARN << "[SL651][Parser] Data too short: " << elem.name;
+                LOG_DEVICE_LIMITED(kWarn, frame.remoteCode)
+                    << "[SL651][Parser] Data too short: " << elem.name;
                 break;
             }
 
@@ -1065,6 +1101,9 @@ private:
      * @brief 打印解析后的正文
      */
     void printParsedBody(const ParsedBody& parsedBody) {
+        if (trantor::Logger::logLevel() > trantor::Logger::kDebug) {
+            return;
+        }
         if (parsedBody.data.empty()) {
             LOG_DEBUG << "[SL651][Parser] Parsed body: no elements";
             return;
@@ -1096,7 +1135,8 @@ private:
             // 获取设备配置（用于获取 funcName）
             auto configOpt = co_await getDeviceConfig_(linkId, frame.remoteCode);
             if (!configOpt) {
-                LOG_WARN << "[SL651][Parser] No device found: " << frame.remoteCode;
+                LOG_DEVICE_LIMITED(kWarn, frame.remoteCode)
+                    << "[SL651][Parser] No device found: " << frame.remoteCode;
                 co_return 0;
             }
 
@@ -1177,8 +1217,8 @@ private:
             // 更新实时数据缓存
             RealtimeDataCache::instance().update(deviceId, frame.funcCode, data, reportTime);
 
-            // 更新资源版本号，让前端知道有新数据（历史数据、设备列表等都会刷新）
-            ResourceVersion::instance().incrementVersion("device");
+            // 更新该设备的数据版本号，让前端知道有新数据（历史数据会刷新）
+            ResourceVersion::instance().incrementVersion("device:data", deviceId);
 
             LOG_DEBUG << "[SL651][Parser] Saved frame: " << deviceName
                       << "(id=" << deviceId << ",code=" << configOpt->deviceCode << ")"
@@ -1222,7 +1262,8 @@ private:
             std::string reportTime = extractReportTime(mergedBody);
             auto configOpt = co_await getDeviceConfig_(linkId, session.remoteCode);
             if (!configOpt) {
-                LOG_WARN << "[SL651][Parser] No device found: " << session.remoteCode;
+                LOG_DEVICE_LIMITED(kWarn, session.remoteCode)
+                    << "[SL651][Parser] No device found: " << session.remoteCode;
                 co_return;
             }
 
@@ -1299,8 +1340,8 @@ private:
             // 更新实时数据缓存
             RealtimeDataCache::instance().update(deviceId, session.funcCode, data, reportTime);
 
-            // 更新资源版本号，让前端知道有新数据
-            ResourceVersion::instance().incrementVersion("device");
+            // 更新该设备的数据版本号，让前端知道有新数据
+            ResourceVersion::instance().incrementVersion("device:data", deviceId);
 
             LOG_DEBUG << "[SL651][Parser] Saved multi-packet frame: " << deviceName
                       << "(id=" << deviceId << ",code=" << configOpt->deviceCode << ")"
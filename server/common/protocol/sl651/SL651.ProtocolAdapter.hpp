@@ -5,7 +5,9 @@
 #include "SL651.LinkIngress.hpp"
 #include "common/cache/DeviceCache.hpp"
 #include "common/cache/DeviceConnectionCache.hpp"
+#include "common/network/FrameTrace.hpp"
 #include "common/network/LinkTransportFacade.hpp"
+#include "common/protocol/IngestMetrics.hpp"
 #include "common/protocol/ProtocolAdapter.hpp"
 #include "common/utils/AppException.hpp"
 #include "common/utils/Constants.hpp"
@@ -71,11 +73,15 @@ public:
     void onConnectionChanged(int, const std::string&, bool) override {}
 
     void onDataReceived(int linkId, const std::string& clientAddr, std::vector<uint8_t> bytes) override {
-        auto ingress = linkIngress_.preprocess(linkId, clientAddr, std::move(bytes));
+        auto ingress = [&] {
+            ingest_metrics::StageTimer timer(ingest_metrics::Stage::Framing, Constants::PROTOCOL_SL651, linkId);
+            return linkIngress_.preprocess(linkId, clientAddr, std::move(bytes));
+        }();
         if (!ingress.shouldParse) {
             return;
         }
 
+        ingest_metrics::StageTimer timer(ingest_metrics::Stage::Parse, Constants::PROTOCOL_SL651, linkId);
         parseAndSubmit(linkId, clientAddr, std::move(ingress.payload));
     }
 
@@ -101,6 +107,10 @@ public:
         return metrics;
     }
 
+    size_t sessionBufferBytes() const override {
+        return parser_ ? parser_->approximateBufferBytes() : 0;
+    }
+
     ProtocolLifecycleImpact onDeviceLifecycleEvent(const DeviceLifecycleEvent& event) override {
         if (!acceptsLifecycleEvent(event.protocol)) {
             return ProtocolLifecycleImpact::None;
@@ -189,11 +199,15 @@ public:
             auto cachedDevice = DeviceCache::instance().findByIdSync(configOpt->deviceId);
             const bool tcpClient = cachedDevice
                 && cachedDevice->linkMode == Constants::LINK_MODE_TCP_CLIENT;
-            bool sent = tcpClient
-                ? LinkTransportFacade::instance().sendToTarget(
-                    connOpt->linkId, cachedDevice->targetId, data)
-                : LinkTransportFacade::instance().sendToClient(
-                    connOpt->linkId, connOpt->clientAddr, data);
+            bool sent;
+            {
+                FrameTrace::DeviceScope traceDevice(configOpt->deviceId);
+                sent = tcpClient
+                    ? LinkTransportFacade::instance().sendToTarget(
+                        connOpt->linkId, cachedDevice->targetId, data)
+                    : LinkTransportFacade::instance().sendToClient(
+                        connOpt->linkId, connOpt->clientAddr, data);
+            }
             if (!sent) {
                 if (tcpClient) {
                     LinkTransportFacade::instance().forceDisconnectTarget(
@@ -23,6 +23,8 @@ public:
     static bool load() {
         // 每次加载前重置为默认值，避免读取失败时沿用旧值
         AppDbConfig::useFast() = false;
+        AppDbConfig::bindPools({});
+        ReplicaRouter::instance().configure(false, false);
         numberOfThreads_ = 0;
 
         // 1. 查找配置文件
@@ -212,6 +214,15 @@ private:
             } else if (isPlaceholder(db["passwd"].asString())) {
                 warnings.push_back(prefix + "passwd 看起来是占位符，请填入实际密码");
             }
+
+            // 负载专用连接池（ingest/interactive/reporting/maintenance）建议配置语句超时
+            auto name = db.get("name", "").asString();
+            for (size_t w = 0; w < kDbWorkloadCount; ++w) {
+                if (name == dbWorkloadName(static_cast<DbWorkload>(w)) &&
+                    (!db.isMember("timeout") || !db["timeout"].isNumeric())) {
+                    warnings.push_back(prefix + "负载连接池 " + name + " 未设置 timeout，慢查询将无限占用连接");
+                }
+            }
         }
     }
 
@@ -292,6 +303,17 @@ private:
         if (root.isMember("db_clients") && root["db_clients"].isArray() &&
             !root["db_clients"].empty()) {
             AppDbConfig::useFast() = root["db_clients"][0].get("is_fast", false).asBool();
+
+            std::vector<std::pair<std::string, bool>> clients;
+            for (const auto& db : root["db_clients"]) {
+                auto name = db.get("name", "").asString();
+                auto isFast = db.get("is_fast", false).asBool();
+                if (name == "default") AppDbConfig::useFast() = isFast;
+                // 名为 replica 的连接为只读副本，报表查询优先路由到副本
+                if (name == "replica") ReplicaRouter::instance().configure(true, isFast);
+                clients.emplace_back(std::move(name), isFast);
+            }
+            AppDbConfig::bindPools(clients);
         }
         if (root.isMember("app") && root["app"].isMember("number_of_threads")) {
             numberOfThreads_ = static_cast<size_t>(root["app"]["number_of_threads"].asUInt());
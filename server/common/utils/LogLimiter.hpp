@@ -0,0 +1,218 @@
+#pragma once
+
+#include <trantor/utils/Logger.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * @brief 日志限流
+ *
+ * 接入热路径上的告警日志（设备报文异常、超时、缓冲溢出等）在设备异常时会逐帧刷屏。
+ * 这里提供两种限流，均在级别未开启时直接跳过，不求值任何 << 参数、不消耗令牌：
+ *
+ * - LOG_LIMITED(kWarn, 每秒条数, 突发)：按调用点令牌桶限流
+ * - LOG_DEVICE_LIMITED(kWarn, 设备键)：按设备共享的日志预算（跨调用点），
+ *   设备键为设备 ID 或任意字符串（如 GB28181 国标编码）
+ *
+ * 被丢弃的条数在下一次放行前以一条 "[LogLimit] ... suppressed" 汇总输出（同调用点/同设备），
+ * 并累计到 suppressedTotals() 供监控导出。
+ *
+ * 设备预算配置（custom_config.log_limit，可选）：
+ * - device_per_minute: 每设备每分钟条数，默认 60
+ * - device_burst: 突发上限，默认 20
+ */
+namespace log_limit {
+
+using Clock = std::chrono::steady_clock;
+
+struct SuppressedTotals {
+    uint64_t rateLimited = 0;
+    uint64_t deviceBudget = 0;
+};
+
+namespace detail {
+
+inline std::atomic<uint64_t> rateLimitedTotal{0};
+inline std::atomic<uint64_t> deviceBudgetTotal{0};
+inline std::atomic<double> devicePerMinute{60.0};
+inline std::atomic<double> deviceBurst{20.0};
+
+inline int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now().time_since_epoch()).count();
+}
+
+inline bool levelEnabled(trantor::Logger::LogLevel level) {
+    return trantor::Logger::logLevel() <= level;
+}
+
+/**
+ * @brief 令牌桶状态（调用方持锁）
+ */
+struct Bucket {
+    double tokens = 0;
+    int64_t lastMs = 0;
+    uint64_t suppressed = 0;
+
+    /** 放行返回 true；被拒时累计 suppressed */
+    bool take(int64_t now, double perSecond, double burst) {
+        if (lastMs == 0) {
+            tokens = burst;
+        } else if (now > lastMs) {
+            tokens = std::min(burst, tokens + static_cast<double>(now - lastMs) * perSecond / 1000.0);
+        }
+        lastMs = now;
+        if (tokens < 1.0) {
+            ++suppressed;
+            return false;
+        }
+        tokens -= 1.0;
+        return true;
+    }
+};
+
+}  // namespace detail
+
+inline SuppressedTotals suppressedTotals() {
+    return {
+        detail::rateLimitedTotal.load(std::memory_order_relaxed),
+        detail::deviceBudgetTotal.load(std::memory_order_relaxed)
+    };
+}
+
+/**
+ * @brief 设置设备日志预算（启动时由 LoggerManager 按配置调用）
+ */
+inline void configureDeviceBudget(double perMinute, double burst) {
+    detail::devicePerMinute.store(std::max(perMinute, 1.0), std::memory_order_relaxed);
+    detail::deviceBurst.store(std::max(burst, 1.0), std::memory_order_relaxed);
+}
+
+/**
+ * @brief 调用点令牌桶（由 LOG_LIMITED 以函数内静态对象创建）
+ */
+class CallSite {
+public:
+    CallSite(const char* file, int line, trantor::Logger::LogLevel level, double perSecond, double burst)
+        : file_(file), line_(line), level_(level),
+          perSecond_(std::max(perSecond, 0.001)), burst_(std::max(burst, 1.0)) {}
+
+    bool acquire() {
+        if (!detail::levelEnabled(level_)) return false;
+
+        uint64_t suppressed = 0;
+        {
+            std::lock_guard lock(mutex_);
+            if (!bucket_.take(detail::nowMs(), perSecond_, burst_)) {
+                detail::rateLimitedTotal.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            suppressed = std::exchange(bucket_.suppressed, 0);
+        }
+        if (suppressed > 0) {
+            trantor::Logger(trantor::Logger::SourceFile(file_), line_, level_).stream()
+                << "[LogLimit] " << suppressed << " similar messages suppressed";
+        }
+        return true;
+    }
+
+    CallSite(const CallSite&) = delete;
+    CallSite& operator=(const CallSite&) = delete;
+
+private:
+    const char* file_;
+    int line_;
+    trantor::Logger::LogLevel level_;
+    double perSecond_;
+    double burst_;
+    std::mutex mutex_;
+    detail::Bucket bucket_;
+};
+
+/**
+ * @brief 设备日志预算（按设备键分片加锁）
+ */
+class DeviceBudget {
+public:
+    static DeviceBudget& instance() {
+        static DeviceBudget inst;
+        return inst;
+    }
+
+    bool acquire(trantor::Logger::LogLevel level, uint64_t key, const char* file, int line) {
+        if (!detail::levelEnabled(level)) return false;
+
+        const double perSecond = detail::devicePerMinute.load(std::memory_order_relaxed) / 60.0;
+        const double burst = detail::deviceBurst.load(std::memory_order_relaxed);
+        uint64_t suppressed = 0;
+        {
+            auto& shard = shards_[key % SHARD_COUNT];
+            std::lock_guard lock(shard.mutex);
+            if (shard.buckets.size() >= MAX_DEVICES_PER_SHARD && !shard.buckets.contains(key)) {
+                // 键异常增长（如伪造的设备编码）时整体重置，避免无界占用
+                shard.buckets.clear();
+            }
+            auto& bucket = shard.buckets[key];
+            if (!bucket.take(detail::nowMs(), perSecond, burst)) {
+                detail::deviceBudgetTotal.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            suppressed = std::exchange(bucket.suppressed, 0);
+        }
+        if (suppressed > 0) {
+            trantor::Logger(trantor::Logger::SourceFile(file), line, level).stream()
+                << "[LogLimit] " << suppressed << " messages suppressed for this device";
+        }
+        return true;
+    }
+
+    static uint64_t key(int deviceId) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(deviceId));
+    }
+
+    static uint64_t key(std::string_view deviceKey) {
+        return std::hash<std::string_view>{}(deviceKey) | (uint64_t{1} << 63);
+    }
+
+private:
+    DeviceBudget() = default;
+
+    static constexpr size_t SHARD_COUNT = 16;
+    static constexpr size_t MAX_DEVICES_PER_SHARD = 4096;
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, detail::Bucket> buckets;
+    };
+
+    std::array<Shard, SHARD_COUNT> shards_;
+};
+
+}  // namespace log_limit
+
+/**
+ * 用法：LOG_LIMITED(kWarn, 1, 5) << "...";  每秒 1 条，突发 5 条
+ */
+#define LOG_LIMITED(level, perSecond, burst)                                                          \
+    if (static ::log_limit::CallSite logLimitSite_(__FILE__, __LINE__, trantor::Logger::level,         \
+                                                   (perSecond), (burst));                              \
+        !logLimitSite_.acquire()) {                                                                   \
+    } else                                                                                            \
+        trantor::Logger(__FILE__, __LINE__, trantor::Logger::level).stream()
+
+/**
+ * 用法：LOG_DEVICE_LIMITED(kWarn, deviceId) << "...";
+ */
+#define LOG_DEVICE_LIMITED(level, deviceKey)                                                          \
+    if (!::log_limit::DeviceBudget::instance().acquire(                                               \
+            trantor::Logger::level, ::log_limit::DeviceBudget::key(deviceKey), __FILE__, __LINE__)) { \
+    } else                                                                                            \
+        trantor::Logger(__FILE__, __LINE__, trantor::Logger::level).stream()
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "common/utils/LogLimiter.hpp"
+
 #include <limits>
 
 namespace fs = std::filesystem;
@@ -9,14 +11,27 @@ namespace fs = std::filesystem;
  *
  * 文件命名: logs/iot-manager_YYYY-MM-DD_HHMMSS.log
  * 轮转策略: 每天自动创建新文件，禁用按文件大小分段
+ * 自身统计: 写入条数/字节、尚未 flush 的缓冲字节、限流丢弃条数（见 getStats）
  */
 class LoggerManager {
+public:
+    struct LogStats {
+        uint64_t messages = 0;
+        uint64_t bytes = 0;
+        uint64_t bufferedBytes = 0;        // 已交给 AsyncFileLogger、尚未 flush 的字节
+        uint64_t suppressedRateLimit = 0;
+        uint64_t suppressedDeviceBudget = 0;
+    };
+
 private:
     static std::unique_ptr<trantor::AsyncFileLogger> fileLogger_;
     static std::shared_mutex loggerMutex_;
     static std::string logDir_;
     static std::atomic<int> currentDay_;
     static std::atomic<int64_t> lastFlushMs_;
+    static std::atomic<uint64_t> messageCount_;
+    static std::atomic<uint64_t> byteCount_;
+    static std::atomic<uint64_t> bufferedBytes_;
     static constexpr uint64_t NO_FILE_SIZE_LIMIT = std::numeric_limits<uint64_t>::max();
     static constexpr int64_t FLUSH_INTERVAL_MS = 200;
 
@@ -125,6 +140,9 @@ private:
         std::shared_lock lock(loggerMutex_);
         if (fileLogger_) {
             fileLogger_->output(formatted.c_str(), formatted.size());
+            messageCount_.fetch_add(1, std::memory_order_relaxed);
+            byteCount_.fetch_add(formatted.size(), std::memory_order_relaxed);
+            bufferedBytes_.fetch_add(formatted.size(), std::memory_order_relaxed);
             auto lastFlush = lastFlushMs_.load(std::memory_order_relaxed);
             if (currentMs - lastFlush >= FLUSH_INTERVAL_MS
                 && lastFlushMs_.compare_exchange_strong(
@@ -132,6 +150,7 @@ private:
                     currentMs,
                     std::memory_order_relaxed)) {
                 fileLogger_->flush();
+                bufferedBytes_.store(0, std::memory_order_relaxed);
             }
         }
     }
@@ -141,6 +160,7 @@ private:
         std::shared_lock lock(loggerMutex_);
         if (fileLogger_) {
             fileLogger_->flush();
+            bufferedBytes_.store(0, std::memory_order_relaxed);
         }
     }
 
@@ -181,6 +201,31 @@ public:
         }
     }
 
+    /**
+     * @brief 应用日志限流配置（custom_config.log_limit，见 LogLimiter.hpp）
+     */
+    static void configureLimits() {
+        auto& config = drogon::app().getCustomConfig();
+        if (!config.isMember("log_limit") || !config["log_limit"].isObject()) {
+            return;
+        }
+        const auto& section = config["log_limit"];
+        log_limit::configureDeviceBudget(
+            section.get("device_per_minute", 60).asDouble(),
+            section.get("device_burst", 20).asDouble());
+    }
+
+    static LogStats getStats() {
+        const auto suppressed = log_limit::suppressedTotals();
+        return {
+            messageCount_.load(std::memory_order_relaxed),
+            byteCount_.load(std::memory_order_relaxed),
+            bufferedBytes_.load(std::memory_order_relaxed),
+            suppressed.rateLimited,
+            suppressed.deviceBudget
+        };
+    }
+
     /**
      * @brief 关闭日志系统
      */
@@ -196,3 +241,6 @@ inline std::shared_mutex LoggerManager::loggerMutex_;
 inline std::string LoggerManager::logDir_;
 inline std::atomic<int> LoggerManager::currentDay_{0};
 inline std::atomic<int64_t> LoggerManager::lastFlushMs_{0};
+inline std::atomic<uint64_t> LoggerManager::messageCount_{0};
+inline std::atomic<uint64_t> LoggerManager::byteCount_{0};
+inline std::atomic<uint64_t> LoggerManager::bufferedBytes_{0};
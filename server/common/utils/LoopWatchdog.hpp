@@ -0,0 +1,253 @@
+#pragma once
+
+#include "common/utils/Metrics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 事件循环卡顿看门狗
+ *
+ * 由独立的看门狗线程按 probe_interval_ms 向每个已登记的 EventLoop 投递探针任务，
+ * 探针执行时记录投递到执行的调度延迟（iot_event_loop_lag_seconds{loop}）。
+ * 同一循环上一枚探针未执行前不再投递；探针滞留超过 stall_threshold_ms 即判定卡顿，
+ * 记录一次日志（含该循环当前正在执行的任务名及已执行时长），恢复时再记一次总时长。
+ *
+ * 任务名由热点回调通过 TaskScope 标注（字符串字面量，无分配）。未标注的回调卡顿时
+ * 只能定位到循环；已标注任务执行超过阈值时在结束处额外记录一次慢任务日志。
+ * TaskScope 只能用于同步代码段，不可跨 co_await（协程挂起后循环会执行其他任务）。
+ *
+ * 配置（custom_config.loop_watchdog，可选）：
+ * - enabled: 默认 true
+ * - probe_interval_ms: 探针间隔，默认 100
+ * - stall_threshold_ms: 卡顿阈值，默认 200
+ */
+class LoopWatchdog {
+    struct LoopState;
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static LoopWatchdog& instance() {
+        static LoopWatchdog inst;
+        return inst;
+    }
+
+    /**
+     * @brief 登记需要监测的循环（可在 start 前后调用，重复登记同一循环忽略）
+     */
+    void registerLoop(std::string name, trantor::EventLoop* loop) {
+        if (!loop) return;
+
+        std::lock_guard lock(mutex_);
+        for (const auto& state : loops_) {
+            if (state->loop == loop) return;
+        }
+
+        auto state = std::make_unique<LoopState>();
+        state->name = std::move(name);
+        state->loop = loop;
+        state->lag = &lagFamily().with({state->name});
+        state->stalls = &stallFamily().with({state->name});
+        loops_.push_back(std::move(state));
+    }
+
+    void start() {
+        if (thread_) return;
+
+        auto config = drogon::app().getCustomConfig();
+        bool enabled = true;
+        if (config.isMember("loop_watchdog") && config["loop_watchdog"].isObject()) {
+            const auto& section = config["loop_watchdog"];
+            enabled = section.get("enabled", enabled).asBool();
+            probeIntervalMs_ = section.get("probe_interval_ms", probeIntervalMs_).asInt();
+            stallThresholdMs_ = section.get("stall_threshold_ms", static_cast<Json::Int64>(stallThresholdMs_.load())).asInt64();
+        }
+        if (!enabled) {
+            LOG_INFO << "[LoopWatchdog] Disabled by config";
+            return;
+        }
+        probeIntervalMs_ = std::clamp(probeIntervalMs_, 10, 10000);
+        stallThresholdMs_ = std::max<int64_t>(stallThresholdMs_.load(), probeIntervalMs_);
+
+        thread_ = std::make_unique<trantor::EventLoopThread>("LoopWatchdog");
+        thread_->run();
+        timerId_ = thread_->getLoop()->runEvery(probeIntervalMs_ / 1000.0, [this]() { tick(); });
+        running_.store(true, std::memory_order_release);
+
+        std::lock_guard lock(mutex_);
+        LOG_INFO << "[LoopWatchdog] Started, loops=" << loops_.size()
+                 << ", probeInterval=" << probeIntervalMs_ << "ms"
+                 << ", stallThreshold=" << stallThresholdMs_.load() << "ms";
+    }
+
+    void stop() {
+        if (!thread_) return;
+        running_.store(false, std::memory_order_release);
+        thread_->getLoop()->invalidateTimer(timerId_);
+        thread_->getLoop()->quit();
+        thread_->wait();
+        thread_.reset();
+    }
+
+    /**
+     * @brief 取出并清零自上次调用以来各循环的最大调度延迟（微秒，监控采样用）
+     */
+    uint64_t takeMaxLagMicros() {
+        return maxLagMicros_.exchange(0, std::memory_order_acq_rel);
+    }
+
+    /**
+     * @brief 探针线程是否在运行（禁用时 takeMaxLagMicros 恒为 0）
+     */
+    bool running() const {
+        return running_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 标注当前线程正在执行的任务（仅在已登记循环的线程上生效）
+     */
+    class TaskScope {
+    public:
+        explicit TaskScope(const char* name)
+            : state_(current_) {
+            if (!state_) return;
+            previousName_ = state_->task.exchange(name, std::memory_order_relaxed);
+            previousStartNs_ = state_->taskStartNs.exchange(nowNs(), std::memory_order_relaxed);
+            name_ = name;
+        }
+
+        ~TaskScope() {
+            if (!state_) return;
+            const int64_t elapsedMs = (nowNs() - state_->taskStartNs.load(std::memory_order_relaxed)) / 1000000;
+            if (elapsedMs >= instance().stallThresholdMs_.load(std::memory_order_relaxed)) {
+                slowTaskFamily().with({name_}).inc();
+                LOG_WARN << "[LoopWatchdog] Slow task on " << state_->name << ": " << name_
+                         << " took " << elapsedMs << "ms";
+            }
+            state_->task.store(previousName_, std::memory_order_relaxed);
+            state_->taskStartNs.store(previousStartNs_, std::memory_order_relaxed);
+        }
+
+        TaskScope(const TaskScope&) = delete;
+        TaskScope& operator=(const TaskScope&) = delete;
+
+    private:
+        LoopState* state_;
+        const char* name_ = nullptr;
+        const char* previousName_ = nullptr;
+        int64_t previousStartNs_ = 0;
+    };
+
+private:
+    LoopWatchdog() = default;
+
+    struct LoopState {
+        std::string name;
+        trantor::EventLoop* loop = nullptr;
+        std::atomic<const char*> task{nullptr};
+        std::atomic<int64_t> taskStartNs{0};
+        std::atomic<int64_t> probePostedNs{0};   // 0 表示没有未执行的探针
+        bool stallReported = false;               // 仅看门狗线程读写
+        metrics::Histogram* lag = nullptr;
+        metrics::Counter* stalls = nullptr;
+    };
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    static metrics::Family<metrics::Histogram>& lagFamily() {
+        static auto& family = metrics::MetricsRegistry::instance().histogram(
+            "iot_event_loop_lag_seconds",
+            "Delay between posting a probe task to an event loop and it running",
+            {"loop"},
+            {0.0001, 0.0005, 0.001, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0});
+        return family;
+    }
+
+    static metrics::Family<metrics::Counter>& stallFamily() {
+        static auto& family = metrics::MetricsRegistry::instance().counter(
+            "iot_event_loop_stalls_total", "Probes that waited longer than the stall threshold", {"loop"});
+        return family;
+    }
+
+    static metrics::Family<metrics::Counter>& slowTaskFamily() {
+        static auto& family = metrics::MetricsRegistry::instance().counter(
+            "iot_event_loop_slow_tasks_total", "Tagged loop tasks that ran longer than the stall threshold", {"task"});
+        return family;
+    }
+
+    /**
+     * @brief 看门狗线程：检查滞留探针，向空闲的循环投递新探针
+     */
+    void tick() {
+        const int64_t now = nowNs();
+        const int64_t thresholdNs = stallThresholdMs_.load(std::memory_order_relaxed) * 1000000;
+
+        std::lock_guard lock(mutex_);
+        for (const auto& statePtr : loops_) {
+            auto* state = statePtr.get();
+            const int64_t postedNs = state->probePostedNs.load(std::memory_order_acquire);
+            if (postedNs != 0) {
+                if (!state->stallReported && now - postedNs >= thresholdNs) {
+                    state->stallReported = true;
+                    state->stalls->inc();
+                    reportStall(*state, now - postedNs);
+                }
+                continue;
+            }
+
+            if (state->stallReported) {
+                state->stallReported = false;
+            }
+            state->probePostedNs.store(now, std::memory_order_release);
+            state->loop->queueInLoop([this, state]() {
+                current_ = state;
+                const int64_t posted = state->probePostedNs.load(std::memory_order_acquire);
+                const int64_t lagNs = std::max<int64_t>(0, nowNs() - posted);
+                state->lag->observe(static_cast<double>(lagNs) / 1e9);
+
+                const auto lagMicros = static_cast<uint64_t>(lagNs / 1000);
+                auto prev = maxLagMicros_.load(std::memory_order_relaxed);
+                while (lagMicros > prev &&
+                       !maxLagMicros_.compare_exchange_weak(prev, lagMicros, std::memory_order_relaxed)) {
+                }
+
+                if (lagNs / 1000000 >= stallThresholdMs_.load(std::memory_order_relaxed)) {
+                    LOG_WARN << "[LoopWatchdog] " << state->name << " recovered, probe waited "
+                             << lagNs / 1000000 << "ms";
+                }
+                state->probePostedNs.store(0, std::memory_order_release);
+            });
+        }
+    }
+
+    static void reportStall(const LoopState& state, int64_t stalledNs) {
+        const char* task = state.task.load(std::memory_order_relaxed);
+        std::string running = "untagged";
+        if (task) {
+            const int64_t runningMs = (nowNs() - state.taskStartNs.load(std::memory_order_relaxed)) / 1000000;
+            running = std::string(task) + " (" + std::to_string(runningMs) + "ms)";
+        }
+        LOG_WARN << "[LoopWatchdog] " << state.name << " stalled for "
+                 << stalledNs / 1000000 << "ms, running task: " << running;
+    }
+
+    static inline thread_local LoopState* current_ = nullptr;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<LoopState>> loops_;
+    std::unique_ptr<trantor::EventLoopThread> thread_;
+    trantor::TimerId timerId_{0};
+    int probeIntervalMs_ = 100;
+    std::atomic<int64_t> stallThresholdMs_{200};
+    std::atomic<uint64_t> maxLagMicros_{0};
+    std::atomic<bool> running_{false};
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <json/value.h>
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief 内存占用估算
+ *
+ * 供各缓存/注册表按自身结构估算占用（MemoryMonitor 汇总导出）。
+ * 只计容器节点、桶数组与堆上内容，按 libstdc++ / jsoncpp 的布局取近似值，
+ * 不含分配器的对齐与元数据开销，用于观察趋势和比较子系统，不作精确计量。
+ */
+namespace memory {
+
+// 红黑树节点头（颜色 + 三个指针）、哈希表节点头（next 指针 + 缓存的哈希值）
+inline constexpr size_t kTreeNodeOverhead = 4 * sizeof(void*);
+inline constexpr size_t kHashNodeOverhead = 2 * sizeof(void*);
+
+/** 字符串堆上部分（短字符串优化时为 0） */
+inline size_t heapBytes(const std::string& s) {
+    static const size_t inlineCapacity = std::string().capacity();
+    return s.capacity() > inlineCapacity ? s.capacity() + 1 : 0;
+}
+
+/** std::map / std::set 的节点（不含元素自身的堆上内容） */
+template<typename Tree>
+size_t treeBytes(const Tree& tree) {
+    return tree.size() * (sizeof(typename Tree::value_type) + kTreeNodeOverhead);
+}
+
+/** std::unordered_map / std::unordered_set 的节点与桶数组（不含元素自身的堆上内容） */
+template<typename Table>
+size_t hashBytes(const Table& table) {
+    return table.bucket_count() * sizeof(void*)
+         + table.size() * (sizeof(typename Table::value_type) + kHashNodeOverhead);
+}
+
+/** std::vector 的元素数组（按容量） */
+template<typename Vector>
+size_t vectorBytes(const Vector& vec) {
+    return vec.capacity() * sizeof(typename Vector::value_type);
+}
+
+/**
+ * @brief Json::Value 树的近似占用（含根节点自身）
+ *
+ * jsoncpp 的对象与数组都以 std::map<CZString, Value> 存放，对象键另行复制一份。
+ */
+inline size_t jsonBytes(const Json::Value& value) {
+    size_t bytes = sizeof(Json::Value);
+    switch (value.type()) {
+    case Json::stringValue: {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        if (value.getString(&begin, &end)) {
+            bytes += static_cast<size_t>(end - begin) + sizeof(unsigned) + 1;
+        }
+        break;
+    }
+    case Json::arrayValue:
+    case Json::objectValue: {
+        const bool isObject = value.isObject();
+        for (auto it = value.begin(); it != value.end(); ++it) {
+            // 节点头 + CZString（指针 + 长度/索引）
+            bytes += kTreeNodeOverhead + 2 * sizeof(void*);
+            if (isObject) {
+                const char* keyEnd = nullptr;
+                const char* key = it.memberName(&keyEnd);
+                if (key) {
+                    bytes += static_cast<size_t>(keyEnd - key) + 1;
+                }
+            }
+            bytes += jsonBytes(*it);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return bytes;
+}
+
+}  // namespace memory
@@ -0,0 +1,301 @@
+#pragma once
+
+#include "common/utils/Metrics.hpp"
+
+#include <mimalloc.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief mimalloc 进程级统计
+ */
+struct AllocatorStats {
+    size_t committedBytes = 0;
+    size_t peakCommittedBytes = 0;
+    size_t rssBytes = 0;
+    size_t peakRssBytes = 0;
+    size_t pageFaults = 0;
+};
+
+/**
+ * @brief 子系统占用（最近一次检查）
+ */
+struct SubsystemMemory {
+    std::string name;
+    size_t bytes = 0;
+    size_t limitBytes = 0;  // 0 表示未单独设置上限
+    bool trimmable = false;
+};
+
+/**
+ * @brief 内存监控与软上限裁剪
+ *
+ * 分配器统计取自 mimalloc 公开接口：mi_process_info 给出提交量、RSS 及峰值、缺页次数；
+ * 各线程堆、段/页的分配与复用计数只在 mi_stats_print_out 的文本报告中提供
+ * （明细程度取决于 mimalloc 构建时的 MI_STAT 级别），由 allocatorReport() 按需输出。
+ *
+ * 各子系统由启动流程登记近似占用（见 MemoryFootprint.hpp）与可选的裁剪函数，
+ * 裁剪只丢弃可从数据库回源重建的缓存。检查在独立线程上执行，遍历不占用 IO 循环。
+ *
+ * 配置（custom_config.memory，可选）：
+ * - enabled: 默认 true
+ * - check_interval_sec: 检查周期，默认 30
+ * - soft_limit_mb: 进程提交内存软上限，0 表示不启用（默认）
+ * - subsystem_limits_mb: 子系统软上限，如 {"realtime_cache": 256}
+ * - trim_cooldown_sec: 两次裁剪的最小间隔，默认 300，避免持续高水位时反复清缓存
+ *
+ * 超过进程软上限时裁剪全部可裁剪子系统，超过子系统上限时只裁剪该子系统，
+ * 随后 mi_collect(true) 把空闲页归还系统。
+ */
+class MemoryMonitor {
+public:
+    using Clock = std::chrono::steady_clock;
+    using BytesFn = std::function<size_t()>;
+    using TrimFn = std::function<void()>;
+
+    static MemoryMonitor& instance() {
+        static MemoryMonitor inst;
+        return inst;
+    }
+
+    /**
+     * @brief 登记子系统（start 前调用，之后登记表只读）；trim 为空表示只统计不裁剪
+     */
+    void registerSubsystem(std::string name, BytesFn bytes, TrimFn trim = {}) {
+        if (thread_) {
+            LOG_WARN << "[MemoryMonitor] Subsystem registered after start ignored: " << name;
+            return;
+        }
+        std::lock_guard lock(mutex_);
+        Subsystem subsystem;
+        subsystem.usage.name = std::move(name);
+        subsystem.usage.trimmable = static_cast<bool>(trim);
+        subsystem.bytes = std::move(bytes);
+        subsystem.trim = std::move(trim);
+        subsystems_.push_back(std::move(subsystem));
+    }
+
+    void start() {
+        if (thread_) return;
+
+        auto config = drogon::app().getCustomConfig();
+        bool enabled = true;
+        int64_t softLimitMb = 0;
+        Json::Value subsystemLimits;
+        if (config.isMember("memory") && config["memory"].isObject()) {
+            const auto& section = config["memory"];
+            enabled = section.get("enabled", enabled).asBool();
+            checkIntervalSec_ = section.get("check_interval_sec", checkIntervalSec_).asInt();
+            softLimitMb = section.get("soft_limit_mb", 0).asInt64();
+            trimCooldownSec_ = section.get("trim_cooldown_sec", trimCooldownSec_).asInt();
+            subsystemLimits = section.get("subsystem_limits_mb", Json::Value());
+        }
+        if (!enabled) {
+            LOG_INFO << "[MemoryMonitor] Disabled by config";
+            return;
+        }
+        checkIntervalSec_ = std::clamp(checkIntervalSec_, 1, 3600);
+        trimCooldownSec_ = std::max(trimCooldownSec_, 0);
+        softLimitBytes_ = static_cast<size_t>(std::max<int64_t>(softLimitMb, 0)) << 20;
+
+        {
+            std::lock_guard lock(mutex_);
+            for (auto& subsystem : subsystems_) {
+                if (subsystemLimits.isObject() && subsystemLimits.isMember(subsystem.usage.name)) {
+                    const auto mb = subsystemLimits[subsystem.usage.name].asInt64();
+                    subsystem.usage.limitBytes = static_cast<size_t>(std::max<int64_t>(mb, 0)) << 20;
+                }
+            }
+        }
+        registerCollector();
+
+        thread_ = std::make_unique<trantor::EventLoopThread>("MemoryMonitor");
+        thread_->run();
+        thread_->getLoop()->queueInLoop([this]() { tick(); });
+        timerId_ = thread_->getLoop()->runEvery(static_cast<double>(checkIntervalSec_), [this]() { tick(); });
+
+        LOG_INFO << "[MemoryMonitor] Started, interval=" << checkIntervalSec_ << "s"
+                 << ", softLimit=" << (softLimitBytes_ >> 20) << "MB"
+                 << ", subsystems=" << subsystems_.size();
+    }
+
+    void stop() {
+        if (!thread_) return;
+        thread_->getLoop()->invalidateTimer(timerId_);
+        thread_->getLoop()->quit();
+        thread_->wait();
+        thread_.reset();
+    }
+
+    static AllocatorStats allocatorStats() {
+        size_t elapsedMs = 0, userMs = 0, systemMs = 0;
+        AllocatorStats stats;
+        mi_process_info(&elapsedMs, &userMs, &systemMs,
+                        &stats.rssBytes, &stats.peakRssBytes,
+                        &stats.committedBytes, &stats.peakCommittedBytes, &stats.pageFaults);
+        return stats;
+    }
+
+    /**
+     * @brief mimalloc 文本统计报告（各线程堆、段/页分配与复用、保留量等）
+     */
+    static std::string allocatorReport() {
+        std::string report;
+        mi_stats_print_out([](const char* msg, void* arg) {
+            static_cast<std::string*>(arg)->append(msg);
+        }, &report);
+        return report;
+    }
+
+    /**
+     * @brief 最近一次检查的子系统占用（登记顺序）
+     */
+    std::vector<SubsystemMemory> lastUsage() const {
+        std::lock_guard lock(mutex_);
+        std::vector<SubsystemMemory> usage;
+        usage.reserve(subsystems_.size());
+        for (const auto& subsystem : subsystems_) {
+            usage.push_back(subsystem.usage);
+        }
+        return usage;
+    }
+
+    size_t softLimitBytes() const { return softLimitBytes_; }
+
+    uint64_t trimCount() const {
+        return trims_.load(std::memory_order_relaxed);
+    }
+
+private:
+    MemoryMonitor() = default;
+
+    struct Subsystem {
+        SubsystemMemory usage;
+        BytesFn bytes;
+        TrimFn trim;
+    };
+
+    static metrics::Family<metrics::Gauge>& subsystemFamily() {
+        static auto& family = metrics::MetricsRegistry::instance().gauge(
+            "iot_memory_subsystem_bytes", "Approximate bytes held by in-process structures", {"subsystem"});
+        return family;
+    }
+
+    static metrics::Family<metrics::Counter>& trimFamily() {
+        static auto& family = metrics::MetricsRegistry::instance().counter(
+            "iot_memory_trims_total", "Subsystem trims triggered by memory soft limits", {"subsystem"});
+        return family;
+    }
+
+    void registerCollector() {
+        static std::once_flag once;
+        std::call_once(once, [this] {
+            auto& registry = metrics::MetricsRegistry::instance();
+            auto* allocator = &registry.gauge(
+                "iot_memory_allocator_bytes", "mimalloc process memory", {"kind"});
+            auto* pageFaults = &registry.mirroredCounter(
+                "iot_memory_page_faults_total", "Page faults reported by mimalloc");
+            auto* softLimit = &registry.gauge(
+                "iot_memory_soft_limit_bytes", "Committed memory soft limit (0 = disabled)");
+            subsystemFamily();
+            trimFamily();
+
+            registry.addCollector([this, allocator, pageFaults, softLimit] {
+                const auto stats = allocatorStats();
+                allocator->with({"committed"}).set(static_cast<double>(stats.committedBytes));
+                allocator->with({"committed_peak"}).set(static_cast<double>(stats.peakCommittedBytes));
+                allocator->with({"rss"}).set(static_cast<double>(stats.rssBytes));
+                allocator->with({"rss_peak"}).set(static_cast<double>(stats.peakRssBytes));
+                pageFaults->with({}).set(static_cast<uint64_t>(stats.pageFaults));
+                softLimit->with({}).set(static_cast<double>(softLimitBytes_));
+            });
+        });
+    }
+
+    /**
+     * @brief 监控线程：统计各子系统，超限时裁剪
+     *
+     * 统计在 mutex_ 外进行，接口读取 lastUsage() 不必等待遍历结束。
+     */
+    void tick() {
+        std::vector<size_t> bytes(subsystems_.size(), 0);
+        for (size_t i = 0; i < subsystems_.size(); ++i) {
+            const auto& subsystem = subsystems_[i];
+            try {
+                bytes[i] = subsystem.bytes();
+            } catch (const std::exception& e) {
+                LOG_WARN << "[MemoryMonitor] " << subsystem.usage.name << " accounting failed: " << e.what();
+                continue;
+            }
+            subsystemFamily().with({subsystem.usage.name}).set(static_cast<double>(bytes[i]));
+        }
+        {
+            std::lock_guard lock(mutex_);
+            for (size_t i = 0; i < subsystems_.size(); ++i) {
+                subsystems_[i].usage.bytes = bytes[i];
+            }
+        }
+
+        const auto committed = allocatorStats().committedBytes;
+        const bool overProcessLimit = softLimitBytes_ > 0 && committed > softLimitBytes_;
+        std::vector<const Subsystem*> targets;
+        for (size_t i = 0; i < subsystems_.size(); ++i) {
+            const auto& subsystem = subsystems_[i];
+            const auto limit = subsystem.usage.limitBytes;
+            if (subsystem.trim && (overProcessLimit || (limit > 0 && bytes[i] > limit))) {
+                targets.push_back(&subsystem);
+            }
+        }
+        if (targets.empty() && !overProcessLimit) return;
+
+        if (lastTrim_ != Clock::time_point{}
+            && Clock::now() - lastTrim_ < std::chrono::seconds(trimCooldownSec_)) {
+            return;
+        }
+        trim(targets, overProcessLimit
+            ? "committed " + std::to_string(committed >> 20) + "MB over soft limit "
+                + std::to_string(softLimitBytes_ >> 20) + "MB"
+            : std::string("subsystem over limit"));
+    }
+
+    void trim(const std::vector<const Subsystem*>& targets, const std::string& reason) {
+        std::string trimmed;
+        for (const auto* subsystem : targets) {
+            try {
+                subsystem->trim();
+            } catch (const std::exception& e) {
+                LOG_WARN << "[MemoryMonitor] " << subsystem->usage.name << " trim failed: " << e.what();
+                continue;
+            }
+            trimFamily().with({subsystem->usage.name}).inc();
+            if (!trimmed.empty()) trimmed += ", ";
+            trimmed += subsystem->usage.name;
+        }
+        const auto before = allocatorStats().committedBytes;
+        mi_collect(true);
+        const auto after = allocatorStats().committedBytes;
+
+        lastTrim_ = Clock::now();
+        trims_.fetch_add(1, std::memory_order_relaxed);
+        LOG_WARN << "[MemoryMonitor] Trimmed (" << reason << "): [" << trimmed << "]"
+                 << ", committed " << (before >> 20) << "MB -> " << (after >> 20) << "MB";
+    }
+
+    mutable std::mutex mutex_;  // 保护 usage.bytes；登记表本身在 start 后只读
+    std::vector<Subsystem> subsystems_;
+    std::unique_ptr<trantor::EventLoopThread> thread_;
+    trantor::TimerId timerId_{0};
+    int checkIntervalSec_ = 30;
+    int trimCooldownSec_ = 300;
+    size_t softLimitBytes_ = 0;
+    Clock::time_point lastTrim_{};  // 仅监控线程访问
+    std::atomic<uint64_t> trims_{0};
+};
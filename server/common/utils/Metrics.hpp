@@ -0,0 +1,448 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 进程内指标注册表（Prometheus 文本格式导出）
+ *
+ * - Counter / Histogram 按线程分片（SHARD_COUNT 个缓存行对齐的原子槽），
+ *   热路径只做一次 relaxed fetch_add，不同 IO 线程互不争用；抓取时再汇总
+ * - Gauge 为单个原子值，由抓取前的刷新回调或业务方直接写入
+ * - MirroredCounter 为模块自行累计的单调总量，由抓取前回调同步，按 counter 导出
+ * - 标签序列按值查找：读路径持共享锁，仅首次出现的新序列取独占锁创建
+ * - 每个指标族限制序列数（maxSeries），超出后最后一个标签（约定为链路等高基数标签）
+ *   折叠为 "other"，防止标签基数随链路/设备数量无限增长
+ */
+namespace metrics {
+
+inline constexpr size_t SHARD_COUNT = 16;
+inline constexpr size_t DEFAULT_MAX_SERIES = 512;
+inline constexpr std::string_view OVERFLOW_LABEL = "other";
+
+/** 当前线程固定映射到一个分片 */
+inline size_t shardIndex() {
+    thread_local const size_t index = std::hash<std::thread::id>{}(std::this_thread::get_id()) % SHARD_COUNT;
+    return index;
+}
+
+class Counter {
+public:
+    void inc(uint64_t n = 1) {
+        shards_[shardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        uint64_t total = 0;
+        for (const auto& shard : shards_) {
+            total += shard.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, SHARD_COUNT> shards_{};
+};
+
+/**
+ * @brief 由外部累计值同步的计数器
+ *
+ * 链路吞吐、批量写入次数等已由各模块自行累计，抓取前回调把当前累计值写入，
+ * 按 counter 类型导出（来源重置时表现为计数器重置，由 Prometheus rate() 处理）。
+ */
+class MirroredCounter {
+public:
+    void set(uint64_t total) {
+        value_.store(total, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+class Gauge {
+public:
+    void set(double v) {
+        value_.store(v, std::memory_order_relaxed);
+    }
+
+    void add(double delta) {
+        double current = value_.load(std::memory_order_relaxed);
+        while (!value_.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {}
+    }
+
+    double value() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<double> value_{0.0};
+};
+
+/**
+ * @brief 固定分桶直方图（上界升序，+Inf 桶隐含）
+ *
+ * 每个分片持有独立的桶计数与累计和（累计和以纳单位整数存放，避免浮点 CAS）。
+ */
+class Histogram {
+public:
+    explicit Histogram(std::vector<double> bounds)
+        : bounds_(std::move(bounds)) {
+        for (auto& shard : shards_) {
+            shard.buckets = std::make_unique<std::atomic<uint64_t>[]>(bounds_.size() + 1);
+        }
+    }
+
+    void observe(double v) {
+        const auto index = static_cast<size_t>(
+            std::lower_bound(bounds_.begin(), bounds_.end(), v) - bounds_.begin());
+        auto& shard = shards_[shardIndex()];
+        shard.buckets[index].fetch_add(1, std::memory_order_relaxed);
+        shard.count.fetch_add(1, std::memory_order_relaxed);
+        shard.sumNano.fetch_add(static_cast<uint64_t>(std::max(0.0, v) * 1e9), std::memory_order_relaxed);
+    }
+
+    void observeDuration(std::chrono::steady_clock::duration elapsed) {
+        observe(std::chrono::duration<double>(elapsed).count());
+    }
+
+    struct Snapshot {
+        std::vector<uint64_t> buckets;  // 非累计，最后一个为 +Inf
+        uint64_t count = 0;
+        double sum = 0.0;
+    };
+
+    Snapshot snapshot() const {
+        Snapshot out;
+        out.buckets.assign(bounds_.size() + 1, 0);
+        uint64_t sumNano = 0;
+        for (const auto& shard : shards_) {
+            for (size_t i = 0; i < out.buckets.size(); ++i) {
+                out.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+            }
+            out.count += shard.count.load(std::memory_order_relaxed);
+            sumNano += shard.sumNano.load(std::memory_order_relaxed);
+        }
+        out.sum = static_cast<double>(sumNano) / 1e9;
+        return out;
+    }
+
+    const std::vector<double>& bounds() const {
+        return bounds_;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sumNano{0};
+    };
+
+    std::vector<double> bounds_;
+    std::array<Shard, SHARD_COUNT> shards_{};
+};
+
+inline void appendEscapedLabel(std::string& out, std::string_view value) {
+    for (char c : value) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '"': out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            default: out += c;
+        }
+    }
+}
+
+inline void appendNumber(std::string& out, double v) {
+    std::ostringstream oss;
+    oss.precision(12);
+    oss << v;
+    out += oss.str();
+}
+
+/** 标签对渲染：{a="x",b="y"}，extra 为直方图附加的 le 标签 */
+inline void appendLabels(
+    std::string& out,
+    const std::vector<std::string>& names,
+    const std::vector<std::string>& values,
+    std::string_view extraName = {},
+    std::string_view extraValue = {}) {
+    if (names.empty() && extraName.empty()) return;
+    out += '{';
+    bool first = true;
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (!first) out += ',';
+        first = false;
+        out += names[i];
+        out += "=\"";
+        appendEscapedLabel(out, values[i]);
+        out += '"';
+    }
+    if (!extraName.empty()) {
+        if (!first) out += ',';
+        out += extraName;
+        out += "=\"";
+        out += extraValue;
+        out += '"';
+    }
+    out += '}';
+}
+
+class FamilyBase {
+public:
+    virtual ~FamilyBase() = default;
+    virtual void render(std::string& out) const = 0;
+};
+
+/**
+ * @brief 同名指标的一组标签序列
+ */
+template<typename Metric>
+class Family : public FamilyBase {
+public:
+    using Factory = std::function<std::unique_ptr<Metric>()>;
+
+    Family(std::string name, std::string help, std::string type,
+           std::vector<std::string> labelNames, Factory factory, size_t maxSeries)
+        : name_(std::move(name)), help_(std::move(help)), type_(std::move(type)),
+          labelNames_(std::move(labelNames)), factory_(std::move(factory)), maxSeries_(maxSeries) {}
+
+    /**
+     * @brief 按标签值取序列（值个数须与标签名一致），返回引用在进程生命期内有效
+     */
+    Metric& with(std::initializer_list<std::string_view> values) {
+        std::vector<std::string> labels(values.begin(), values.end());
+        labels.resize(labelNames_.size());
+        auto key = joinKey(labels);
+        {
+            std::shared_lock lock(mutex_);
+            if (auto it = series_.find(key); it != series_.end()) {
+                return *it->second.metric;
+            }
+        }
+
+        std::unique_lock lock(mutex_);
+        if (auto it = series_.find(key); it != series_.end()) {
+            return *it->second.metric;
+        }
+        if (series_.size() >= maxSeries_ && !labels.empty()) {
+            labels.back() = std::string(OVERFLOW_LABEL);
+            key = joinKey(labels);
+            if (auto it = series_.find(key); it != series_.end()) {
+                return *it->second.metric;
+            }
+        }
+        auto& entry = series_[key];
+        entry.labels = std::move(labels);
+        entry.metric = factory_();
+        return *entry.metric;
+    }
+
+    void render(std::string& out) const override {
+        out += "# HELP " + name_ + " " + help_ + "\n";
+        out += "# TYPE " + name_ + " " + type_ + "\n";
+
+        std::shared_lock lock(mutex_);
+        for (const auto& [key, entry] : series_) {
+            (void)key;
+            renderSeries(out, entry.labels, *entry.metric);
+        }
+    }
+
+private:
+    struct Entry {
+        std::vector<std::string> labels;
+        std::unique_ptr<Metric> metric;
+    };
+
+    static std::string joinKey(const std::vector<std::string>& labels) {
+        std::string key;
+        for (const auto& label : labels) {
+            key += label;
+            key += '\x1f';
+        }
+        return key;
+    }
+
+    void renderSeries(std::string& out, const std::vector<std::string>& labels, const Counter& counter) const {
+        out += name_;
+        appendLabels(out, labelNames_, labels);
+        out += ' ';
+        out += std::to_string(counter.value());
+        out += '\n';
+    }
+
+    void renderSeries(std::string& out, const std::vector<std::string>& labels, const MirroredCounter& counter) const {
+        out += name_;
+        appendLabels(out, labelNames_, labels);
+        out += ' ';
+        out += std::to_string(counter.value());
+        out += '\n';
+    }
+
+    void renderSeries(std::string& out, const std::vector<std::string>& labels, const Gauge& gauge) const {
+        out += name_;
+        appendLabels(out, labelNames_, labels);
+        out += ' ';
+        appendNumber(out, gauge.value());
+        out += '\n';
+    }
+
+    void renderSeries(std::string& out, const std::vector<std::string>& labels, const Histogram& histogram) const {
+        const auto snapshot = histogram.snapshot();
+        const auto& bounds = histogram.bounds();
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < snapshot.buckets.size(); ++i) {
+            cumulative += snapshot.buckets[i];
+            std::string le;
+            if (i < bounds.size()) {
+                appendNumber(le, bounds[i]);
+            } else {
+                le = "+Inf";
+            }
+            out += name_ + "_bucket";
+            appendLabels(out, labelNames_, labels, "le", le);
+            out += ' ' + std::to_string(cumulative) + '\n';
+        }
+        out += name_ + "_sum";
+        appendLabels(out, labelNames_, labels);
+        out += ' ';
+        appendNumber(out, snapshot.sum);
+        out += '\n';
+        out += name_ + "_count";
+        appendLabels(out, labelNames_, labels);
+        out += ' ' + std::to_string(snapshot.count) + '\n';
+    }
+
+    std::string name_;
+    std::string help_;
+    std::string type_;
+    std::vector<std::string> labelNames_;
+    Factory factory_;
+    size_t maxSeries_;
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, Entry> series_;
+};
+
+/**
+ * @brief 全局注册表
+ *
+ * 指标族在首次使用时注册（通常放在函数内 static 引用中），重复注册同名族返回已有实例。
+ * 抓取前回调（addCollector）用于把已有的统计量（链路吞吐、队列深度等）刷新到 Gauge。
+ */
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance() {
+        static MetricsRegistry inst;
+        return inst;
+    }
+
+    Family<Counter>& counter(const std::string& name, const std::string& help,
+                             std::vector<std::string> labelNames = {},
+                             size_t maxSeries = DEFAULT_MAX_SERIES) {
+        return family<Counter>(name, help, "counter", std::move(labelNames), maxSeries,
+                               [] { return std::make_unique<Counter>(); });
+    }
+
+    /**
+     * @brief 计数器，取值由抓取前回调从已有累计值同步（名称按约定以 _total 结尾）
+     */
+    Family<MirroredCounter>& mirroredCounter(const std::string& name, const std::string& help,
+                                             std::vector<std::string> labelNames = {},
+                                             size_t maxSeries = DEFAULT_MAX_SERIES) {
+        return family<MirroredCounter>(name, help, "counter", std::move(labelNames), maxSeries,
+                                       [] { return std::make_unique<MirroredCounter>(); });
+    }
+
+    Family<Gauge>& gauge(const std::string& name, const std::string& help,
+                         std::vector<std::string> labelNames = {},
+                         size_t maxSeries = DEFAULT_MAX_SERIES) {
+        return family<Gauge>(name, help, "gauge", std::move(labelNames), maxSeries,
+                             [] { return std::make_unique<Gauge>(); });
+    }
+
+    Family<Histogram>& histogram(const std::string& name, const std::string& help,
+                                 std::vector<std::string> labelNames,
+                                 std::vector<double> bounds,
+                                 size_t maxSeries = DEFAULT_MAX_SERIES) {
+        std::sort(bounds.begin(), bounds.end());
+        return family<Histogram>(name, help, "histogram", std::move(labelNames), maxSeries,
+                                 [bounds = std::move(bounds)] { return std::make_unique<Histogram>(bounds); });
+    }
+
+    void addCollector(std::function<void()> collector) {
+        std::lock_guard lock(mutex_);
+        collectors_.push_back(std::move(collector));
+    }
+
+    /**
+     * @brief 执行抓取前回调并渲染全部指标族
+     */
+    std::string renderText() {
+        std::vector<std::function<void()>> collectors;
+        {
+            std::lock_guard lock(mutex_);
+            collectors = collectors_;
+        }
+        for (const auto& collect : collectors) {
+            try {
+                collect();
+            } catch (const std::exception& e) {
+                LOG_WARN << "[Metrics] collector failed: " << e.what();
+            }
+        }
+
+        std::string out;
+        out.reserve(16 * 1024);
+        std::lock_guard lock(mutex_);
+        for (const auto& name : order_) {
+            families_.at(name)->render(out);
+        }
+        return out;
+    }
+
+private:
+    MetricsRegistry() = default;
+
+    template<typename Metric, typename Factory>
+    Family<Metric>& family(const std::string& name, const std::string& help, const char* type,
+                           std::vector<std::string> labelNames, size_t maxSeries, Factory factory) {
+        std::lock_guard lock(mutex_);
+        auto it = families_.find(name);
+        if (it == families_.end()) {
+            auto created = std::make_unique<Family<Metric>>(
+                name, help, type, std::move(labelNames), std::move(factory), std::max<size_t>(1, maxSeries));
+            it = families_.emplace(name, std::move(created)).first;
+            order_.push_back(name);
+        }
+        return static_cast<Family<Metric>&>(*it->second);
+    }
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<FamilyBase>> families_;
+    std::vector<std::string> order_;
+    std::vector<std::function<void()>> collectors_;
+};
+
+}  // namespace metrics
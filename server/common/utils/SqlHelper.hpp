@@ -47,6 +47,47 @@ std::pair<std::string, std::vector<std::string>> buildParameterizedIn(
     return {placeholders, params};
 }
 
+/**
+ * @brief 构建 PostgreSQL 数组字面量（如 "{1,2,3}"），配合 ANY(?::int[]) 使用
+ *
+ * 与 buildParameterizedIn 不同，SQL 文本不随列表长度变化，可作为预编译语句复用。
+ */
+template <typename T>
+std::string toPgArray(const std::vector<T>& ids) {
+    static_assert(std::is_arithmetic_v<T>, "toPgArray only accepts numeric types");
+    std::string out = "{";
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (i > 0) out += ',';
+        out += std::to_string(ids[i]);
+    }
+    out += '}';
+    return out;
+}
+
+/**
+ * @brief 构建文本类 PostgreSQL 数组字面量（text[]/jsonb[]/timestamptz[]）
+ *
+ * 每个元素加双引号并转义 \ 和 "，可安全承载任意 JSON 文本。
+ */
+inline std::string toPgTextArray(const std::vector<std::string>& values) {
+    size_t reserve = 2;
+    for (const auto& v : values) reserve += v.size() + 3;
+    std::string out;
+    out.reserve(reserve);
+    out += '{';
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i > 0) out += ',';
+        out += '"';
+        for (char c : values[i]) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        out += '"';
+    }
+    out += '}';
+    return out;
+}
+
 /**
  * @brief 构建批量插入的 VALUES 子句和参数
  *
@@ -1,10 +1,70 @@
 #pragma once
 
+/**
+ * @brief 不可变树快照
+ *
+ * 构建后只读，由 TreeCache 在多个请求间共享。
+ * 先序遍历下每个节点的子树是 order 中的连续区间 [begin, end)，
+ * 子孙判断与子树枚举直接按区间完成，不再递归查询。
+ */
+struct TreeSnapshot {
+    Json::Value items;  // 平铺列表（数据库原始顺序）
+    Json::Value tree;   // 按 sort_order 排序后的树
+    std::vector<int> order;  // 先序遍历的节点 ID
+    std::unordered_map<int, std::pair<size_t, size_t>> ranges;  // id -> 子树在 order 中的区间
+
+    bool contains(int id) const {
+        return ranges.count(id) > 0;
+    }
+
+    /** node 是否为 ancestor 的子孙（不含自身） */
+    bool isDescendant(int ancestor, int node) const {
+        auto ancestorIt = ranges.find(ancestor);
+        auto nodeIt = ranges.find(node);
+        if (ancestorIt == ranges.end() || nodeIt == ranges.end()) return false;
+        return nodeIt->second.first > ancestorIt->second.first
+            && nodeIt->second.first < ancestorIt->second.second;
+    }
+
+    /** 子树内全部节点 ID（含自身，先序） */
+    std::vector<int> subtreeIds(int id) const {
+        auto it = ranges.find(id);
+        if (it == ranges.end()) return {};
+        return std::vector<int>(order.begin() + static_cast<std::ptrdiff_t>(it->second.first),
+                                order.begin() + static_cast<std::ptrdiff_t>(it->second.second));
+    }
+};
+
 /**
  * @brief 树形结构构建工具
  */
 class TreeBuilder {
 public:
+    /**
+     * @brief 由平铺列表构建排序后的树快照，并计算先序子树区间
+     */
+    static TreeSnapshot snapshot(const Json::Value& items,
+                                 const std::string& sortField = "sort_order") {
+        TreeSnapshot result;
+        result.items = items.isArray() ? items : Json::Value(Json::arrayValue);
+        result.tree = build(result.items, "id", "parent_id", "children");
+        sort(result.tree, sortField, true);
+
+        std::function<void(const Json::Value&)> visit = [&result, &visit](const Json::Value& nodes) {
+            for (const auto& node : nodes) {
+                int id = node["id"].asInt();
+                size_t begin = result.order.size();
+                result.order.push_back(id);
+                if (node.isMember("children") && node["children"].isArray()) {
+                    visit(node["children"]);
+                }
+                result.ranges[id] = {begin, result.order.size()};
+            }
+        };
+        visit(result.tree);
+        return result;
+    }
+
     static Json::Value build(const Json::Value& items,
                               const std::string& idField = "id",
                               const std::string& parentField = "parent_id",
@@ -36,6 +36,7 @@
 
 // Controllers - Home Module
 #include "modules/home/Home.Controller.hpp"
+#include "modules/home/Metrics.Controller.hpp"
 
 // Controllers - Link Module
 #include "modules/link/Link.Controller.hpp"
@@ -359,6 +360,7 @@ int main() {
 
     // 4. 应用配置
     LoggerManager::setLogLevel(ConfigManager::getLogLevel());
+    LoggerManager::configureLimits();
 
     // 5. 启用静态文件压缩与大文件发送优化
     app().enableGzip(true)
@@ -5,6 +5,7 @@
 #include "domain/AlertRecord.hpp"
 #include "AlertEngine.hpp"
 #include "common/utils/Pagination.hpp"
+#include "modules/home/DashboardStats.hpp"
 
 /**
  * @brief 告警业务服务层
@@ -69,11 +70,13 @@ public:
     }
 
     Task<void> acknowledgeRecord(int64_t id, int userId) {
-        co_await AlertRecord::acknowledge(id, userId);
+        auto severities = co_await AlertRecord::acknowledge(id, userId);
+        DashboardStats::instance().onAlertsAcknowledged(severities);
     }
 
     Task<void> batchAcknowledge(const std::vector<int64_t>& ids, int userId) {
-        co_await AlertRecord::batchAcknowledge(ids, userId);
+        auto severities = co_await AlertRecord::batchAcknowledge(ids, userId);
+        DashboardStats::instance().onAlertsAcknowledged(severities);
     }
 
     // ==================== 统计 ====================
@@ -51,6 +51,31 @@ public:
         LOG_INFO << "[AlertEngine] Rules reloaded, count=" << ruleCount();
     }
 
+    /**
+     * @brief 从 JSON 规则数组替换内存规则（不访问数据库，供离线回放与基准测试）
+     *
+     * 字段同 alert_rule 表：id、name、device_id、severity、logic、silence_duration、
+     * recovery_condition、recovery_wait_seconds，conditions 为条件数组
+     */
+    void loadRules(const Json::Value& rules) {
+        std::unordered_map<int, std::vector<CachedRule>> newRules;
+        for (const auto& row : rules) {
+            CachedRule rule;
+            rule.id = row.get("id", 0).asInt();
+            rule.name = row.get("name", "").asString();
+            rule.deviceId = row.get("device_id", 0).asInt();
+            rule.deviceName = row.get("device_name", "").asString();
+            rule.severity = row.get("severity", "warning").asString();
+            rule.logic = row.get("logic", "and").asString();
+            rule.silenceDuration = row.get("silence_duration", rule.silenceDuration).asInt();
+            rule.recoveryCondition = row.get("recovery_condition", rule.recoveryCondition).asString();
+            rule.recoveryWaitSeconds = row.get("recovery_wait_seconds", rule.recoveryWaitSeconds).asInt();
+            rule.conditions = parseConditions(rule.id, row["conditions"]);
+            newRules[rule.deviceId].push_back(std::move(rule));
+        }
+        replaceRules(std::move(newRules));
+    }
+
     /**
      * @brief 启动离线检测定时器（60 秒周期）
      */
@@ -217,7 +242,7 @@ private:
     // ==================== 规则加载 ====================
 
     Task<void> loadRulesFromDb() {
-        DatabaseService db;
+        DatabaseService db(DbWorkload::Maintenance);
         auto result = co_await db.execSqlCoro(R"(
             SELECT r.*, d.name AS device_name
             FROM alert_rule r
@@ -253,39 +278,50 @@ private:
             std::string condStr = row["conditions"].as<std::string>();
             std::istringstream stream(condStr);
             Json::parseFromStream(builder, stream, &condJson, nullptr);
+            rule.conditions = parseConditions(rule.id, condJson);
 
-            for (const auto& cond : condJson) {
-                CachedCondition cc;
-                cc.type = cond.get("type", "").asString();
-                cc.elementKey = cond.get("elementKey", "").asString();
-                cc.op = cond.get("operator", ">").asString();
-
-                if (cond.isMember("value")) {
-                    try { cc.value = std::stod(cond["value"].asString()); }
-                    catch (const std::exception& e) {
-                        LOG_WARN << "[AlertEngine] Invalid threshold value for rule "
-                                 << rule.id << ": " << cond["value"].asString() << " - " << e.what();
-                    }
-                }
-                if (cond.isMember("duration")) {
-                    cc.duration = cond["duration"].asInt();
+            newRules[rule.deviceId].push_back(std::move(rule));
+        }
+
+        replaceRules(std::move(newRules));
+    }
+
+    static std::vector<CachedCondition> parseConditions(int ruleId, const Json::Value& condJson) {
+        std::vector<CachedCondition> conditions;
+        for (const auto& cond : condJson) {
+            CachedCondition cc;
+            cc.type = cond.get("type", "").asString();
+            cc.elementKey = cond.get("elementKey", "").asString();
+            cc.op = cond.get("operator", ">").asString();
+
+            if (cond.isMember("value")) {
+                try { cc.value = std::stod(cond["value"].asString()); }
+                catch (const std::exception& e) {
+                    LOG_WARN << "[AlertEngine] Invalid threshold value for rule "
+                             << ruleId << ": " << cond["value"].asString() << " - " << e.what();
                 }
-                if (cond.isMember("changeRate")) {
-                    try { cc.changeRate = std::stod(cond["changeRate"].asString()); }
-                    catch (const std::exception& e) {
-                        LOG_WARN << "[AlertEngine] Invalid changeRate for rule "
-                                 << rule.id << ": " << cond["changeRate"].asString() << " - " << e.what();
-                    }
+            }
+            if (cond.isMember("duration")) {
+                cc.duration = cond["duration"].asInt();
+            }
+            if (cond.isMember("changeRate")) {
+                try { cc.changeRate = std::stod(cond["changeRate"].asString()); }
+                catch (const std::exception& e) {
+                    LOG_WARN << "[AlertEngine] Invalid changeRate for rule "
+                             << ruleId << ": " << cond["changeRate"].asString() << " - " << e.what();
                 }
-                cc.changeDirection = cond.get("changeDirection", "any").asString();
-
-                rule.conditions.push_back(std::move(cc));
             }
+            cc.changeDirection = cond.get("changeDirection", "any").asString();
 
-            newRules[rule.deviceId].push_back(std::move(rule));
+            conditions.push_back(std::move(cc));
         }
+        return conditions;
+    }
 
-        // 替换内存规则，并清理已删除规则的触发状态和冷却缓存
+    /**
+     * @brief 替换内存规则，并清理已删除规则的触发状态和冷却缓存
+     */
+    void replaceRules(std::unordered_map<int, std::vector<CachedRule>>&& newRules) {
         {
             std::unique_lock lock(rulesMutex_);
             rulesByDevice_ = std::move(newRules);
@@ -330,7 +366,7 @@ private:
      * @brief 从数据库加载活跃告警记录到 triggerStates_（服务重启后恢复状态）
      */
     Task<void> loadActiveAlertsFromDb() {
-        DatabaseService db;
+        DatabaseService db(DbWorkload::Maintenance);
         auto result = co_await db.execSqlCoro(R"(
             SELECT DISTINCT ON (rule_id) rule_id, id, triggered_at
             FROM alert_record
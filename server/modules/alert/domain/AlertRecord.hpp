@@ -20,7 +20,7 @@ public:
      */
     static Task<int64_t> create(int ruleId, int deviceId, const std::string& severity,
                                  const std::string& message, const Json::Value& detail) {
-        DatabaseService db;
+        DatabaseService db(DbWorkload::Ingest);
         std::string detailStr = detail.toStyledString();
 
         // 条件插入：同一 rule_id 已有 active/acknowledged 记录时不创建（DB 级去重）
@@ -88,7 +88,9 @@ public:
 
         if (pageSize > 0) {
             int offset = (page - 1) * pageSize;
-            sql += " LIMIT " + std::to_string(pageSize) + " OFFSET " + std::to_string(offset);
+            sql += " LIMIT ? OFFSET ?";
+            params.push_back(std::to_string(pageSize));
+            params.push_back(std::to_string(offset));
         }
 
         auto result = co_await db.execSqlCoro(sql, params);
@@ -124,21 +126,25 @@ public:
 
     /**
      * @brief 确认告警
+     * @return 实际由 active 转为 acknowledged 的记录的严重级别
      */
-    static Task<void> acknowledge(int64_t recordId, int userId) {
+    static Task<std::vector<std::string>> acknowledge(int64_t recordId, int userId) {
         DatabaseService db;
         auto result = co_await db.execSqlCoro(R"(
             UPDATE alert_record
             SET status = 'acknowledged', acknowledged_at = CURRENT_TIMESTAMP, acknowledged_by = ?
             WHERE id = ? AND status = 'active'
+            RETURNING severity
         )", {std::to_string(userId), std::to_string(recordId)});
+        co_return severitiesOf(result);
     }
 
     /**
      * @brief 批量确认告警
+     * @return 实际由 active 转为 acknowledged 的记录的严重级别
      */
-    static Task<void> batchAcknowledge(const std::vector<int64_t>& ids, int userId) {
-        if (ids.empty()) co_return;
+    static Task<std::vector<std::string>> batchAcknowledge(const std::vector<int64_t>& ids, int userId) {
+        if (ids.empty()) co_return std::vector<std::string>{};
 
         DatabaseService db;
         std::string placeholders;
@@ -149,11 +155,12 @@ public:
             params.push_back(std::to_string(ids[i]));
         }
 
-        co_await db.execSqlCoro(
+        auto result = co_await db.execSqlCoro(
             "UPDATE alert_record SET status = 'acknowledged', acknowledged_at = CURRENT_TIMESTAMP, "
-            "acknowledged_by = ? WHERE id IN (" + placeholders + ") AND status = 'active'",
+            "acknowledged_by = ? WHERE id IN (" + placeholders + ") AND status = 'active' RETURNING severity",
             params
         );
+        co_return severitiesOf(result);
     }
 
     /**
@@ -227,4 +234,14 @@ public:
             ? resolvedResult[0]["today_resolved"].as<int>() : 0;
         co_return stats;
     }
+
+private:
+    static std::vector<std::string> severitiesOf(const drogon::orm::Result& result) {
+        std::vector<std::string> severities;
+        severities.reserve(result.size());
+        for (const auto& row : result) {
+            severities.push_back(row["severity"].as<std::string>());
+        }
+        return severities;
+    }
 };
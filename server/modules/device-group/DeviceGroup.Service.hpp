@@ -1,6 +1,9 @@
 #pragma once
 
 #include "domain/DeviceGroup.hpp"
+#include "common/cache/DeviceCache.hpp"
+
+#include <unordered_set>
 
 /**
  * @brief 设备分组服务
@@ -25,32 +28,30 @@ public:
 
     /**
      * @brief 分组树 + 每个节点的设备数量
+     *
+     * deviceCount 为直属设备数，totalDeviceCount 含全部子孙分组。
+     * 设备归属取自 DeviceCache，子树汇总按树快照的先序区间做前缀和，不查库、不递归。
      */
     Task<Json::Value> treeWithCount() {
-        auto tree = co_await DeviceGroup::tree();
-
-        // 查询每个分组的设备数量
-        DatabaseService db;
-        auto countResult = co_await db.execSqlCoro(R"(
-            SELECT group_id, COUNT(*) as device_count
-            FROM device
-            WHERE deleted_at IS NULL AND group_id IS NOT NULL
-            GROUP BY group_id
-        )");
-
-        // 构建 group_id -> count 映射
-        std::map<int, int> countMap;
-        for (const auto& row : countResult) {
-            int groupId = FieldHelper::getInt(row["group_id"]);
-            int count = FieldHelper::getInt(row["device_count"]);
-            countMap[groupId] = count;
+        auto snapshot = co_await DeviceGroup::treeSnapshot();
+        auto countMap = co_await countDevicesByGroup();
+
+        std::vector<int> prefix(snapshot->order.size() + 1, 0);
+        for (size_t i = 0; i < snapshot->order.size(); ++i) {
+            auto it = countMap.find(snapshot->order[i]);
+            prefix[i + 1] = prefix[i] + (it != countMap.end() ? it->second : 0);
         }
 
-        // 递归填充 deviceCount
+        Json::Value tree = snapshot->tree;
         std::function<void(Json::Value&)> fillCount = [&](Json::Value& nodes) {
             for (auto& node : nodes) {
                 int nodeId = node["id"].asInt();
-                node["deviceCount"] = countMap.count(nodeId) ? countMap[nodeId] : 0;
+                auto countIt = countMap.find(nodeId);
+                node["deviceCount"] = countIt != countMap.end() ? countIt->second : 0;
+                auto rangeIt = snapshot->ranges.find(nodeId);
+                if (rangeIt != snapshot->ranges.end()) {
+                    node["totalDeviceCount"] = prefix[rangeIt->second.second] - prefix[rangeIt->second.first];
+                }
                 if (node.isMember("children") && node["children"].isArray()) {
                     fillCount(node["children"]);
                 }
@@ -61,6 +62,24 @@ public:
         co_return tree;
     }
 
+    /**
+     * @brief 分组及其全部子孙分组下的设备 ID
+     */
+    Task<std::vector<int>> deviceIdsUnder(int groupId) {
+        auto snapshot = co_await DeviceGroup::treeSnapshot();
+        auto groupIds = snapshot->subtreeIds(groupId);
+        if (groupIds.empty()) {
+            co_return std::vector<int>{};
+        }
+
+        std::unordered_set<int> groups(groupIds.begin(), groupIds.end());
+        co_await DeviceCache::instance().ensureFresh();
+        co_return DeviceCache::instance().selectDevicesSync(
+            [&groups](const DeviceCache::CachedDevice& device) { return groups.count(device.groupId) > 0; },
+            DeviceCache::DeviceIdOf{}
+        );
+    }
+
     /**
      * @brief 分组详情
      */
@@ -105,4 +124,19 @@ public:
             .remove()
             .save();
     }
+
+private:
+    static Task<std::unordered_map<int, int>> countDevicesByGroup() {
+        co_await DeviceCache::instance().ensureFresh();
+        auto groupIds = DeviceCache::instance().selectDevicesSync(
+            [](const DeviceCache::CachedDevice& device) { return device.groupId > 0; },
+            [](const DeviceCache::CachedDevice& device) { return device.groupId; }
+        );
+
+        std::unordered_map<int, int> counts;
+        for (int groupId : groupIds) {
+            ++counts[groupId];
+        }
+        co_return counts;
+    }
 };
@@ -6,6 +6,7 @@
 #include "common/utils/FieldHelper.hpp"
 #include "common/utils/TimestampHelper.hpp"
 #include "common/utils/TreeBuilder.hpp"
+#include "common/cache/TreeCache.hpp"
 
 /**
  * @brief 设备分组聚合根
@@ -84,10 +85,18 @@ public:
      * @brief 获取分组树形结构
      */
     static Task<Json::Value> tree(const std::string& status = "") {
-        auto items = co_await list("", status);
-        auto tree = TreeBuilder::build(items, "id", "parent_id", "children");
-        TreeBuilder::sort(tree, "sort_order", true);
-        co_return tree;
+        auto snapshot = co_await treeSnapshot(status);
+        co_return snapshot->tree;
+    }
+
+    /**
+     * @brief 获取共享的分组树快照（分组变更事件失效）
+     */
+    static Task<std::shared_ptr<const TreeSnapshot>> treeSnapshot(const std::string& status = "") {
+        co_return co_await TreeCache::instance().get(
+            "deviceGroup", "status:" + status,
+            [status]() -> Task<Json::Value> { co_return co_await list("", status); }
+        );
     }
 
     // ==================== 声明式约束 ====================
@@ -172,20 +181,9 @@ public:
             throw ConflictException("不能将自己设为父分组");
         }
 
-        // 递归检查：获取所有子孙 ID，确认新 parent_id 不在其中
-        DatabaseService db;
-        auto result = co_await db.execSqlCoro(R"(
-            WITH RECURSIVE descendants AS (
-                SELECT id FROM device_group WHERE parent_id = ? AND deleted_at IS NULL
-                UNION ALL
-                SELECT dg.id FROM device_group dg
-                INNER JOIN descendants d ON dg.parent_id = d.id
-                WHERE dg.deleted_at IS NULL
-            )
-            SELECT id FROM descendants WHERE id = ?
-        )", {std::to_string(group.id()), std::to_string(group.parentId_)});
-
-        if (!result.empty()) {
+        // 按缓存树的子树区间判断新 parent_id 是否为当前分组的子孙
+        auto snapshot = co_await treeSnapshot();
+        if (snapshot->isDescendant(group.id(), group.parentId_)) {
             throw ConflictException("不能将子分组设为父分组，会造成循环引用");
         }
     }
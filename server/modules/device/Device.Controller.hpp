@@ -44,18 +44,21 @@ public:
         co_await PermissionChecker::checkPermission(userId, {"iot:device:query"});
 
         auto page = Pagination::fromRequest(req);
+        int groupId = ValidatorHelper::getIntParam(req, "groupId", 0);
 
         // 参数化 ETag 检查
         std::string params = std::to_string(userId) + ":" +
-                             std::to_string(page.page) + ":" + std::to_string(page.pageSize);
-        if (auto notModified = ETagUtils::checkParamETag(req, "device", params)) {
+                             std::to_string(page.page) + ":" + std::to_string(page.pageSize) + ":" +
+                             std::to_string(groupId);
+        auto version = co_await service_.listVersion(userId, groupId);
+        if (auto notModified = ETagUtils::checkVersionedETag(req, params, version)) {
             co_return notModified;
         }
 
-        auto items = co_await service_.listStatic(userId);
+        auto items = co_await service_.listStatic(userId, groupId);
         auto [pagedItems, total] = Pagination::paginate(items, page);
         auto resp = Pagination::buildResponse(pagedItems, total, page.page, page.pageSize);
-        ETagUtils::addParamETag(resp, "device", params);
+        ETagUtils::addVersionedETag(resp, params, version);
         co_return resp;
     }
 
@@ -145,14 +148,15 @@ public:
 
         std::string params = std::to_string(userId) + ":" +
                              std::to_string(page.page) + ":" + std::to_string(page.pageSize);
-        if (auto notModified = ETagUtils::checkParamETag(req, "device", params)) {
+        auto version = co_await service_.listVersion(userId);
+        if (auto notModified = ETagUtils::checkVersionedETag(req, params, version)) {
             co_return notModified;
         }
 
         auto items = co_await service_.options(userId);
         auto [pagedItems, total] = Pagination::paginate(items, page);
         auto resp = Pagination::buildResponse(pagedItems, total, page.page, page.pageSize);
-        ETagUtils::addParamETag(resp, "device", params);
+        ETagUtils::addVersionedETag(resp, params, version);
         co_return resp;
     }
 
@@ -183,17 +187,20 @@ public:
         std::string params = std::to_string(userId) + ":" + deviceIdStr + ":" + dataType + ":" +
                              startTime + ":" + endTime + ":" +
                              std::to_string(page.page) + ":" + std::to_string(page.pageSize);
-        if (auto notModified = ETagUtils::checkParamETag(req, "device", params)) {
+        // 只随本设备的数据上报/指令记录和配置变化，其他设备的数据不影响
+        auto& rv = ResourceVersion::instance();
+        std::string version = rv.getVersion("device:data", deviceId) + "." + rv.getVersion("device", deviceId);
+        if (auto notModified = ETagUtils::checkVersionedETag(req, params, version)) {
             co_return notModified;
         }
-
+
         // 非分页要素查询：Raw JSONB 透传（图表场景，零 JSON 解析）
         if (!page.isPaged() && dataType != "IMAGE") {
             auto rawBody = co_await service_.queryHistoryRaw(
                 startTime, endTime, deviceId, userId
             );
             auto resp = Response::rawJson(std::move(rawBody));
-            ETagUtils::addParamETag(resp, "device", params);
+            ETagUtils::addVersionedETag(resp, params, version);
             co_return resp;
         }
 
@@ -202,7 +209,7 @@ public:
         );
 
         auto resp = Pagination::buildResponse(items, total, page.page, page.pageSize);
-        ETagUtils::addParamETag(resp, "device", params);
+        ETagUtils::addVersionedETag(resp, params, version);
         co_return resp;
     }
 
@@ -4,6 +4,7 @@
 #include "DeviceDataTransformer.hpp"
 #include "common/database/DatabaseService.hpp"
 #include "common/cache/DeviceCache.hpp"
+#include "common/cache/DeviceVisibilityIndex.hpp"
 #include "common/cache/RealtimeDataCache.hpp"
 #include "common/utils/Pagination.hpp"
 #include "common/utils/FieldHelper.hpp"
@@ -15,6 +16,7 @@
 #include "common/utils/JsonHelper.hpp"
 #include "common/edgenode/AgentBridgeManager.hpp"
 #include "common/filters/ResourcePermission.hpp"
+#include "modules/device-group/DeviceGroup.Service.hpp"
 
 #include <algorithm>
 #include <cctype>
@@ -43,6 +45,7 @@ public:
 
 private:
     DatabaseService dbService_;
+    DatabaseService reportingDb_{DbWorkload::Reporting};  // 历史查询走报表连接池
 
     enum class DeviceAccessLevel {
         None,
@@ -126,43 +129,53 @@ private:
         std::stable_sort(devices.begin(), devices.end(), deviceDisplayLess);
     }
 
+    /**
+     * @brief 取用户可见的设备（已按展示顺序排序）
+     *
+     * 非超管用户经 DeviceVisibilityIndex 位图过滤，只拷贝可见设备；
+     * 分享权限取自权限快照，只包含可见设备中被分享的部分。
+     */
     Task<std::tuple<std::vector<DeviceCache::CachedDevice>, std::unordered_map<int, std::string>, bool>>
-    filterAccessibleDevices(const std::vector<DeviceCache::CachedDevice>& cachedDevices, int userId) {
-        if (cachedDevices.empty()) {
-            co_return {std::vector<DeviceCache::CachedDevice>{}, {}, false};
-        }
-
-        if (userId <= 0) {
-            auto visibleDevices = cachedDevices;
-            sortDevicesForDisplay(visibleDevices);
-            co_return {visibleDevices, {}, true};
+    filterAccessibleDevices(int userId) {
+        std::shared_ptr<const PermissionSnapshot> snapshot;
+        if (userId > 0) {
+            snapshot = co_await PermissionChecker::loadSnapshot(userId);
         }
 
-        const bool isSuperAdmin = co_await PermissionChecker::isSuperAdmin(userId);
-        if (isSuperAdmin) {
-            auto visibleDevices = cachedDevices;
+        if (!snapshot || snapshot->isSuperAdmin) {
+            auto visibleDevices = co_await DeviceCache::instance().getDevices();
             sortDevicesForDisplay(visibleDevices);
-            co_return {visibleDevices, {}, true};
+            co_return {std::move(visibleDevices), {}, true};
         }
 
-        std::vector<int> deviceIds;
-        deviceIds.reserve(cachedDevices.size());
-        for (const auto& device : cachedDevices) {
-            deviceIds.push_back(device.id);
-        }
-        auto sharePermissions = co_await ResourcePermission::loadDeviceSharePermissions(userId, deviceIds);
+        auto visibleDevices = co_await DeviceVisibilityIndex::instance().visibleDevices(userId, snapshot);
 
-        std::vector<DeviceCache::CachedDevice> visibleDevices;
-        visibleDevices.reserve(cachedDevices.size());
-        for (const auto& device : cachedDevices) {
-            const auto accessLevel = resolveDeviceAccessLevel(device, userId, false, sharePermissions);
-            if (accessLevel != DeviceAccessLevel::None) {
-                visibleDevices.push_back(device);
+        std::unordered_map<int, std::string> sharePermissions;
+        for (const auto& device : visibleDevices) {
+            auto permission = snapshot->sharePermission(device.id);
+            if (!permission.empty()) {
+                sharePermissions[device.id] = std::move(permission);
             }
         }
         sortDevicesForDisplay(visibleDevices);
 
-        co_return {visibleDevices, sharePermissions, false};
+        co_return {std::move(visibleDevices), std::move(sharePermissions), false};
+    }
+
+    Task<std::vector<int>> visibleDeviceIds(int userId) {
+        std::shared_ptr<const PermissionSnapshot> snapshot;
+        if (userId > 0) {
+            snapshot = co_await PermissionChecker::loadSnapshot(userId);
+        }
+
+        if (!snapshot || snapshot->isSuperAdmin) {
+            co_await DeviceCache::instance().ensureFresh();
+            co_return DeviceCache::instance().selectDevicesSync(
+                [](const DeviceCache::CachedDevice&) { return true; },
+                DeviceCache::DeviceIdOf{}
+            );
+        }
+        co_return co_await DeviceVisibilityIndex::instance().visibleDeviceIds(userId, snapshot);
     }
 
     struct CommandElementInput {
@@ -719,13 +732,32 @@ public:
         co_return item;
     }
 
+    /**
+     * @brief 设备列表版本（list / options 的 ETag 用）
+     *
+     * 取用户可见设备的最大配置版本与可见数量，叠加列表中展示的链路、协议配置，
+     * 以及影响分享可见性的用户本身与部门的版本；数据上报不改变该版本。
+     */
+    Task<std::string> listVersion(int userId, int groupId = 0) {
+        auto ids = co_await visibleDeviceIds(userId);
+        auto& rv = ResourceVersion::instance();
+        auto version = rv.maxVersion("device", ids) + "." + std::to_string(ids.size())
+            + "." + rv.getVersion("link") + "." + rv.getVersion("protocol")
+            + "." + rv.getVersion("auth:user:" + std::to_string(userId))
+            + "." + rv.getVersion("department");
+        if (groupId > 0) {
+            // 分组过滤依赖分组树结构，树变更也要让 ETag 失效
+            version += "." + rv.getVersion("deviceGroup");
+        }
+        co_return version;
+    }
+
     /**
      * @brief 设备选项（下拉选择用）
      */
     Task<Json::Value> options(int userId = 0) {
-        auto cachedDevices = co_await DeviceCache::instance().getDevices();
         auto [visibleDevices, sharePermissions, isSuperAdmin] =
-            co_await filterAccessibleDevices(cachedDevices, userId);
+            co_await filterAccessibleDevices(userId);
 
         Json::Value items(Json::arrayValue);
         for (const auto& device : visibleDevices) {
@@ -1032,7 +1064,7 @@ public:
             });
         }
 
-        ResourceVersion::instance().incrementVersion("device");
+        co_await EventBus::instance().publish(DeviceShareChanged(deviceId));
     }
 
     /**
@@ -1066,7 +1098,7 @@ public:
             throw NotFoundException("分享记录不存在");
         }
 
-        ResourceVersion::instance().incrementVersion("device");
+        co_await EventBus::instance().publish(DeviceShareChanged(deviceId));
     }
 
     // ==================== 查询接口 ====================
@@ -1074,20 +1106,23 @@ public:
     /**
      * @brief 获取设备静态数据列表（用于 ETag 缓存）
      * 只返回设备基本信息和协议配置，不查询实时数据
+     * groupId > 0 时只返回该分组及其子孙分组下的设备
      */
-    Task<Json::Value> listStatic(int userId = 0) {
-        auto cachedDevices = co_await DeviceCache::instance().getDevices();
+    Task<Json::Value> listStatic(int userId = 0, int groupId = 0) {
+        auto [visibleDevices, sharePermissions, isSuperAdmin] =
+            co_await filterAccessibleDevices(userId);
 
-        if (cachedDevices.empty()) {
-            co_return Json::Value(Json::arrayValue);
+        std::unordered_set<int> groupDeviceIds;
+        if (groupId > 0) {
+            auto ids = co_await DeviceGroupService().deviceIdsUnder(groupId);
+            groupDeviceIds.insert(ids.begin(), ids.end());
         }
 
-        auto [visibleDevices, sharePermissions, isSuperAdmin] =
-            co_await filterAccessibleDevices(cachedDevices, userId);
-
         Json::Value items(Json::arrayValue);
 
         for (const auto& device : visibleDevices) {
+            if (groupId > 0 && groupDeviceIds.count(device.id) == 0) continue;
+
             Json::Value item = DeviceDataTransformer::buildDeviceBaseInfo(device);
             auto access = resolveDeviceAccessLevel(device, userId, isSuperAdmin, sharePermissions);
             injectDeviceAccessFlags(item, access);
@@ -1119,14 +1154,8 @@ public:
      * - 实时查询直接从缓存返回，无需查询数据库
      */
     Task<Json::Value> listRealtime(int userId = 0) {
-        auto cachedDevices = co_await DeviceCache::instance().getDevices();
-
-        if (cachedDevices.empty()) {
-            co_return Json::Value(Json::arrayValue);
-        }
-
         auto [visibleDevices, sharePermissions, isSuperAdmin] =
-            co_await filterAccessibleDevices(cachedDevices, userId);
+            co_await filterAccessibleDevices(userId);
         if (visibleDevices.empty()) {
             co_return Json::Value(Json::arrayValue);
         }
@@ -1386,10 +1415,9 @@ public:
         )";
 
         if (effectivePageSize > 0) {
-            innerSql += " LIMIT " + std::to_string(effectivePageSize);
-            if (effectiveOffset > 0) {
-                innerSql += " OFFSET " + std::to_string(effectiveOffset);
-            }
+            innerSql += " LIMIT ? OFFSET ?";
+            queryParams.push_back(std::to_string(effectivePageSize));
+            queryParams.push_back(std::to_string(effectiveOffset));
         }
 
         // 外层查询：JOIN sys_user/device_data + jsonb_each 展开要素，消除预扫描和全部 C++ JSON 解析
@@ -1417,11 +1445,11 @@ public:
         // 不分页时跳过 COUNT 查询
         int total = 0;
         if (isPaged) {
-            auto countResult = co_await dbService_.execSqlCoro(countSql, countParams);
+            auto countResult = co_await reportingDb_.execSqlCoro(countSql, countParams);
             total = countResult.empty() ? 0 : FieldHelper::getInt(countResult[0]["cnt"]);
         }
 
-        auto result = co_await dbService_.execSqlCoro(sql, queryParams);
+        auto result = co_await reportingDb_.execSqlCoro(sql, queryParams);
 
         auto t1 = std::chrono::steady_clock::now();
         LOG_INFO << "[queryHistory] SQL execution: "
@@ -1655,7 +1683,7 @@ public:
         )";
 
         auto t0 = std::chrono::steady_clock::now();
-        auto result = co_await dbService_.execSqlCoro(sql, params);
+        auto result = co_await reportingDb_.execSqlCoro(sql, params);
         auto t1 = std::chrono::steady_clock::now();
 
         LOG_INFO << "[queryHistoryRaw] SQL: "
@@ -1722,8 +1750,8 @@ public:
 
         auto result = co_await ProtocolDispatcher::instance().sendCommand(req);
 
-        // 无论成功或失败，都已保存记录到数据库，需要更新版本号以刷新 ETag 缓存
-        ResourceVersion::instance().incrementVersion("device");
+        // 无论成功或失败，都已保存记录到数据库，需要更新该设备的数据版本号以刷新 ETag 缓存
+        ResourceVersion::instance().incrementVersion("device:data", device.id);
 
         co_return result;
     }
@@ -1,7 +1,8 @@
 #pragma once
 
-#include "common/database/DatabaseService.hpp"
+#include "common/database/PreparedStatements.hpp"
 #include "common/utils/JsonHelper.hpp"
+#include "common/utils/SqlHelper.hpp"
 
 /**
  * @brief 设备指令数据访问
@@ -36,15 +37,17 @@ public:
      */
     static Task<int64_t> save(int deviceId, int linkId, const std::string& protocol,
                               const Json::Value& data, const std::string& reportTime) {
-        DatabaseService dbService;
-
-        std::string jsonStr = JsonHelper::serialize(data);
-
-        auto result = co_await dbService.execSqlCoro(R"(
+        static const auto& stmt = PreparedStatementRegistry::instance().define("device_data.insert", R"(
             INSERT INTO device_data (device_id, link_id, protocol, data, report_time)
             VALUES (?, ?, ?, ?::jsonb, ?::timestamptz)
             RETURNING id
-        )", {std::to_string(deviceId), std::to_string(linkId), protocol, jsonStr, reportTime});
+        )");
+        DatabaseService dbService(DbWorkload::Ingest);
+
+        std::string jsonStr = JsonHelper::serialize(data);
+
+        auto result = co_await dbService.execPreparedCoro(
+            stmt, {std::to_string(deviceId), std::to_string(linkId), protocol, jsonStr, reportTime});
 
         int64_t id = 0;
         if (!result.empty()) {
@@ -56,36 +59,53 @@ public:
     }
 
     /**
-     * @brief 批量保存记录（多值 INSERT，单次 DB 往返）
+     * @brief 批量保存记录（unnest 数组 INSERT，单次 DB 往返）
+     *
+     * 五列各以一个数组参数传入，SQL 文本与批量大小无关，
+     * 每条连接只规划一次，不会因批量长度不同产生新语句。
+     *
      * @param items 待保存条目列表
      * @return 各记录的 ID（与 items 顺序对应）
      */
     static Task<std::vector<int64_t>> saveBatch(const std::vector<SaveItem>& items) {
         if (items.empty()) co_return {};
 
-        DatabaseService dbService;
-
-        // 构建多值 INSERT: VALUES (?,?,?,?::jsonb,?::timestamptz), (...), ...
-        std::ostringstream sql;
-        sql << "INSERT INTO device_data (device_id, link_id, protocol, data, report_time) VALUES ";
-
-        std::vector<std::string> params;
-        params.reserve(items.size() * 5);
-
-        for (size_t i = 0; i < items.size(); ++i) {
-            if (i > 0) sql << ", ";
-            sql << "(?, ?, ?, ?::jsonb, ?::timestamptz)";
-
-            params.push_back(std::to_string(items[i].deviceId));
-            params.push_back(std::to_string(items[i].linkId));
-            params.push_back(items[i].protocol);
-            params.push_back(JsonHelper::serialize(items[i].data));
-            params.push_back(items[i].reportTime);
+        static const auto& stmt = PreparedStatementRegistry::instance().define("device_data.insertBatch", R"(
+            INSERT INTO device_data (device_id, link_id, protocol, data, report_time)
+            SELECT t.device_id, t.link_id, t.protocol, t.data, t.report_time
+            FROM unnest(?::int[], ?::int[], ?::text[], ?::jsonb[], ?::timestamptz[])
+                 WITH ORDINALITY AS t(device_id, link_id, protocol, data, report_time, ord)
+            ORDER BY t.ord
+            RETURNING id
+        )");
+        DatabaseService dbService(DbWorkload::Ingest);
+
+        std::vector<int> deviceIds;
+        std::vector<int> linkIds;
+        std::vector<std::string> protocols;
+        std::vector<std::string> payloads;
+        std::vector<std::string> reportTimes;
+        deviceIds.reserve(items.size());
+        linkIds.reserve(items.size());
+        protocols.reserve(items.size());
+        payloads.reserve(items.size());
+        reportTimes.reserve(items.size());
+
+        for (const auto& item : items) {
+            deviceIds.push_back(item.deviceId);
+            linkIds.push_back(item.linkId);
+            protocols.push_back(item.protocol);
+            payloads.push_back(JsonHelper::serialize(item.data));
+            reportTimes.push_back(item.reportTime);
         }
 
-        sql << " RETURNING id";
-
-        auto result = co_await dbService.execSqlCoro(sql.str(), params);
+        auto result = co_await dbService.execPreparedCoro(stmt, {
+            SqlHelper::toPgArray(deviceIds),
+            SqlHelper::toPgArray(linkIds),
+            SqlHelper::toPgTextArray(protocols),
+            SqlHelper::toPgTextArray(payloads),
+            SqlHelper::toPgTextArray(reportTimes),
+        });
 
         std::vector<int64_t> ids;
         ids.reserve(result.size());
@@ -104,14 +124,16 @@ public:
         if (downCommandId <= 0) co_return;
 
         try {
-            DatabaseService dbService;
-            auto result = co_await dbService.execSqlCoro(R"(
+            static const auto& stmt = PreparedStatementRegistry::instance().define("device_data.linkResponse", R"(
                 UPDATE device_data
                 SET data = data || jsonb_build_object('responseId', ?::bigint)
                 WHERE id = ?
                   AND report_time >= now() - INTERVAL '2 days'
                 RETURNING id
-            )", {std::to_string(responseId), std::to_string(downCommandId)});
+            )");
+            DatabaseService dbService(DbWorkload::Ingest);
+            auto result = co_await dbService.execPreparedCoro(
+                stmt, {std::to_string(responseId), std::to_string(downCommandId)});
 
             if (result.empty()) {
                 LOG_WARN << "[CommandRepository] 关联应答未命中新近指令记录: downId="
@@ -135,7 +157,14 @@ public:
         if (downCommandId <= 0) co_return;
 
         try {
-            DatabaseService dbService;
+            static const auto& stmt = PreparedStatementRegistry::instance().define("device_data.updateStatus", R"(
+                UPDATE device_data
+                SET data = data || ?::jsonb
+                WHERE id = ?
+                  AND report_time >= now() - INTERVAL '2 days'
+                RETURNING id
+            )");
+            DatabaseService dbService(DbWorkload::Ingest);
             Json::Value updateFields;
             updateFields["status"] = status;
             if (!failReason.empty()) {
@@ -144,13 +173,8 @@ public:
 
             std::string updateJson = JsonHelper::serialize(updateFields);
 
-            auto result = co_await dbService.execSqlCoro(R"(
-                UPDATE device_data
-                SET data = data || ?::jsonb
-                WHERE id = ?
-                  AND report_time >= now() - INTERVAL '2 days'
-                RETURNING id
-            )", {updateJson, std::to_string(downCommandId)});
+            auto result = co_await dbService.execPreparedCoro(
+                stmt, {updateJson, std::to_string(downCommandId)});
 
             if (result.empty()) {
                 LOG_WARN << "[CommandRepository] 指令状态更新未命中新近记录: id="
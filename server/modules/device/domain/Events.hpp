@@ -54,3 +54,9 @@ struct DeviceDeleted : DomainEvent {
         , deviceCode(std::move(code))
         , agentId(agent) {}
 };
+
+// 设备分享授权变更（新增/修改/删除分享），失效用户权限快照
+struct DeviceShareChanged : DomainEvent {
+    DeviceShareChanged(int deviceId)
+        : DomainEvent("DeviceShareChanged", deviceId, "DeviceShare") {}
+};
@@ -168,3 +168,14 @@ bool Gb28181Module::started() const {
 const std::string& Gb28181Module::lastError() const {
     return impl_->lastErrorMessage;
 }
+
+std::size_t Gb28181Module::approximateBytes() const {
+    std::size_t bytes = 0;
+    if (impl_->deviceRegistry) {
+        bytes += impl_->deviceRegistry->approximateBytes();
+    }
+    if (impl_->streamRegistry) {
+        bytes += impl_->streamRegistry->approximateBytes();
+    }
+    return bytes;
+}
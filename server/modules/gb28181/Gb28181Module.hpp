@@ -20,6 +20,8 @@ public:
     bool enabled() const;
     bool started() const;
     const std::string& lastError() const;
+    // Approximate bytes held by the device and stream registries (0 when disabled).
+    std::size_t approximateBytes() const;
 
 private:
     Gb28181Module();
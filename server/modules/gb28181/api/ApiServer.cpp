@@ -8,6 +8,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <optional>
 #include <utility>
 
 namespace {
@@ -64,9 +65,13 @@ std::string remotePort(const std::string& remoteAddress) {
     return remoteAddress.substr(colon + 1);
 }
 
-boost::json::object deviceToJson(const Device& device) {
+boost::json::array channelsToJson(const ChannelListPtr& channelList) {
     boost::json::array channels;
-    for (const auto& channel : device.channels) {
+    if (!channelList) {
+        return channels;
+    }
+    channels.reserve(channelList->items.size());
+    for (const auto& channel : channelList->items) {
         channels.push_back({
             {"id", channel.id},
             {"name", channel.name},
@@ -76,6 +81,11 @@ boost::json::object deviceToJson(const Device& device) {
             {"ptz_capable", channel.ptzType > 0},
         });
     }
+    return channels;
+}
+
+boost::json::object deviceToJson(const Device& device) {
+    auto channels = channelsToJson(device.channels);
     boost::json::array records;
     for (const auto& record : device.records) {
         records.push_back({
@@ -104,6 +114,23 @@ boost::json::object deviceToJson(const Device& device) {
     };
 }
 
+boost::json::object histogramToJson(const LatencyHistogram::Snapshot& snapshot) {
+    boost::json::array buckets;
+    for (const auto& [boundMs, count] : snapshot.buckets) {
+        buckets.push_back({
+            {"le_ms", boundMs == 0 ? boost::json::value("+Inf") : boost::json::value(boundMs)},
+            {"count", count},
+        });
+    }
+    return {
+        {"count", snapshot.count},
+        {"sum_ms", snapshot.sumMs},
+        {"max_ms", snapshot.maxMs},
+        {"avg_ms", snapshot.count == 0 ? 0.0 : static_cast<double>(snapshot.sumMs) / static_cast<double>(snapshot.count)},
+        {"buckets", buckets},
+    };
+}
+
 boost::json::object streamToJson(const StreamStatus& status) {
     return {
         {"app", status.app},
@@ -184,6 +211,23 @@ void ApiServer::registerRoutes(const std::string& apiPrefix) {
         },
         {drogon::Get});
 
+    drogon::app().registerHandler(
+        prefix + "/devices/{1}/channels",
+        [this](const drogon::HttpRequestPtr&, std::function<void(const drogon::HttpResponsePtr&)>&& callback, const std::string& deviceId) {
+            // The list is shared with the registry; serialize without holding its lock.
+            const auto channels = deviceRegistry_.channelsOf(deviceId);
+            if (!channels && !deviceRegistry_.visitDevice(deviceId, [](const Device&) {})) {
+                callback(jsonNotFound("设备不存在"));
+                return;
+            }
+            callback(jsonResponse({
+                {"device_id", deviceId},
+                {"total", channels ? channels->items.size() : 0},
+                {"items", channelsToJson(channels)},
+            }));
+        },
+        {drogon::Get});
+
     drogon::app().registerHandler(
         prefix + "/devices/mock-register",
         [this](const drogon::HttpRequestPtr& request, std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
@@ -471,6 +515,22 @@ void ApiServer::registerRoutes(const std::string& apiPrefix) {
         },
         {drogon::Get});
 
+    drogon::app().registerHandler(
+        prefix + "/media/stats",
+        [this](const drogon::HttpRequestPtr&, std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+            const auto stats = sipServer_.mediaStats();
+            callback(jsonResponse({
+                {"rtp_ports", {
+                    {"capacity", stats.ports.capacity},
+                    {"in_use", stats.ports.inUse},
+                    {"single_port", stats.ports.singlePort},
+                }},
+                {"preview_start_latency", histogramToJson(stats.previewStart)},
+                {"first_frame_latency", histogramToJson(stats.firstFrame)},
+            }));
+        },
+        {drogon::Get});
+
     drogon::app().registerHandler(
         prefix + "/zlm/hook/on_stream_changed",
         [this](const drogon::HttpRequestPtr& request, std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
@@ -528,6 +588,9 @@ void ApiServer::registerRoutes(const std::string& apiPrefix) {
                                      << ", stream=" << stream
                                      << ", schema=" << schema;
                         }
+                        if (closeStream) {
+                            sipServer_.releaseRtpPort(stream);
+                        }
                     }
                 }
                 callback(jsonBody({{"code", 0}, {"close", closeStream}}));
@@ -564,10 +627,14 @@ void ApiServer::registerRoutes(const std::string& apiPrefix) {
                             LOG_DEBUG << "[GB28181][ZLM] RTP server timeout for unmanaged stream, stream=" << stream
                                      << ", ssrc=" << ssrc;
                         }
+                        std::optional<uint16_t> timedOutPort;
                         if (localPort != nullptr && localPort->is_int64()) {
+                            timedOutPort = static_cast<uint16_t>(localPort->as_int64());
                             LOG_DEBUG << "[GB28181][ZLM] RTP server timeout local_port=" << localPort->as_int64()
                                      << ", stream=" << stream;
                         }
+                        // ZLM has already dropped the server; free the lease even if no session matched.
+                        sipServer_.releaseRtpPort(stream, timedOutPort);
                     }
                 }
                 callback(jsonBody({{"code", 0}, {"closed", closed}}));
@@ -150,6 +150,9 @@ AppConfig AppConfig::loadFromFile(const std::string& path) {
     config.sip.port = getUInt16(sip, "port", config.sip.port);
     config.sip.password = getString(sip, "password");
     config.sip.transport = getString(sip, "transport", config.sip.transport);
+    config.sip.udpWorkers = getUInt(sip, "udp_workers", config.sip.udpWorkers);
+    config.sip.udpBatchSize = getUInt(sip, "udp_batch_size", config.sip.udpBatchSize);
+    config.sip.keepaliveTimeoutSec = getUInt(sip, "keepalive_timeout_sec", config.sip.keepaliveTimeoutSec);
     if (const auto* loggingValue = root.if_contains("logging");
         loggingValue != nullptr && !loggingValue->is_null()) {
         if (!loggingValue->is_bool()) {
@@ -164,6 +167,7 @@ AppConfig AppConfig::loadFromFile(const std::string& path) {
     config.media.rtpPublicIp = getString(media, "rtp_public_ip", config.sip.publicIp);
     config.media.rtpPortRangeStart = getUInt16(media, "rtp_port_range_start", config.media.rtpPortRangeStart);
     config.media.rtpPortRangeEnd = getUInt16(media, "rtp_port_range_end", config.media.rtpPortRangeEnd);
+    config.media.rtpSinglePort = getUInt16(media, "rtp_single_port", config.media.rtpSinglePort);
 
     return config;
 }
@@ -193,6 +197,9 @@ AppConfig AppConfig::fromJson(const Json::Value& root) {
     config.sip.port = getJsonUInt16(sip, "port", config.sip.port);
     config.sip.password = getJsonString(sip, "password");
     config.sip.transport = getJsonString(sip, "transport", config.sip.transport);
+    config.sip.udpWorkers = getJsonUInt(sip, "udp_workers", config.sip.udpWorkers);
+    config.sip.udpBatchSize = getJsonUInt(sip, "udp_batch_size", config.sip.udpBatchSize);
+    config.sip.keepaliveTimeoutSec = getJsonUInt(sip, "keepalive_timeout_sec", config.sip.keepaliveTimeoutSec);
 
     if (root.isMember("logging") && !root["logging"].isNull()) {
         if (!root["logging"].isBool()) {
@@ -208,6 +215,7 @@ AppConfig AppConfig::fromJson(const Json::Value& root) {
     config.media.rtpPublicIp = getJsonString(media, "rtp_public_ip", config.sip.publicIp);
     config.media.rtpPortRangeStart = getJsonUInt16(media, "rtp_port_range_start", config.media.rtpPortRangeStart);
     config.media.rtpPortRangeEnd = getJsonUInt16(media, "rtp_port_range_end", config.media.rtpPortRangeEnd);
+    config.media.rtpSinglePort = getJsonUInt16(media, "rtp_single_port", config.media.rtpSinglePort);
 
     return config;
 }
@@ -19,6 +19,14 @@ struct SipConfig {
     std::string password;
     std::string transport{"udp"};
     bool logging{true};
+    // Number of UDP ingress loops. Values above 1 bind one SO_REUSEPORT socket
+    // per loop (Linux only); other platforms always use a single socket.
+    unsigned int udpWorkers{1};
+    // Datagrams drained per recvmmsg/sendmmsg call.
+    unsigned int udpBatchSize{32};
+    // A device with no keepalive or REGISTER for this long is marked offline
+    // (GB/T 28181 default: 60 s interval x 3 missed heartbeats).
+    unsigned int keepaliveTimeoutSec{180};
 };
 
 struct MediaConfig {
@@ -28,6 +36,9 @@ struct MediaConfig {
     std::string rtpPublicIp;
     uint16_t rtpPortRangeStart{30000};
     uint16_t rtpPortRangeEnd{30500};
+    // Non-zero: every stream shares this ZLM port and is told apart by SSRC
+    // (openRtpServer re_use_port=1). Zero: one leased port per stream.
+    uint16_t rtpSinglePort{0};
 };
 
 struct AppConfig {
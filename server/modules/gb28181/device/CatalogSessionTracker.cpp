@@ -0,0 +1,128 @@
+#include "device/CatalogSessionTracker.h"
+
+#include <iterator>
+#include <utility>
+
+namespace {
+
+// Items without a DeviceID still count toward SumNum but are not channels.
+std::vector<Channel> publishableChannels(std::vector<Channel> channels) {
+    std::erase_if(channels, [](const Channel& channel) { return channel.id.empty(); });
+    return channels;
+}
+
+} // namespace
+
+CatalogSessionTracker::CatalogSessionTracker(std::chrono::seconds idleTimeout)
+    : idleTimeout_(idleTimeout) {}
+
+std::string CatalogSessionTracker::keyOf(const std::string& deviceId, const std::string& sn) {
+    return deviceId + "#" + sn;
+}
+
+void CatalogSessionTracker::eraseSession(std::unordered_map<std::string, Session>::iterator iter) {
+    const auto perDevice = sessionsPerDevice_.find(iter->second.deviceId);
+    if (perDevice != sessionsPerDevice_.end() && --perDevice->second == 0) {
+        sessionsPerDevice_.erase(perDevice);
+    }
+    sessions_.erase(iter);
+}
+
+bool CatalogSessionTracker::tryBegin(const std::string& deviceId, const std::string& sn, Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    if (sessionsPerDevice_.contains(deviceId)) {
+        return false;
+    }
+    Session session;
+    session.deviceId = deviceId;
+    session.sn = sn;
+    session.deadline = now + idleTimeout_;
+    sessions_.emplace(keyOf(deviceId, sn), std::move(session));
+    ++sessionsPerDevice_[deviceId];
+    return true;
+}
+
+std::optional<CatalogSessionTracker::Completed> CatalogSessionTracker::addPart(
+    const std::string& deviceId,
+    const std::string& sn,
+    std::optional<std::size_t> sumNum,
+    std::vector<Channel> items,
+    Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    const auto key = keyOf(deviceId, sn);
+    auto iter = sessions_.find(key);
+    if (iter == sessions_.end()) {
+        Session session;
+        session.deviceId = deviceId;
+        session.sn = sn;
+        iter = sessions_.emplace(key, std::move(session)).first;
+        ++sessionsPerDevice_[deviceId];
+    }
+
+    auto& session = iter->second;
+    if (sumNum.has_value()) {
+        session.sumNum = sumNum;
+    }
+    session.deadline = now + idleTimeout_;
+    for (auto& item : items) {
+        if (item.id.empty()) {
+            session.channels.push_back(std::move(item));
+            continue;
+        }
+        // Some NVRs resend a slice when our 200 OK is late; keep the newest copy.
+        const auto existing = session.index.find(item.id);
+        if (existing != session.index.end()) {
+            session.channels[existing->second] = std::move(item);
+            continue;
+        }
+        session.index.emplace(item.id, session.channels.size());
+        session.channels.push_back(std::move(item));
+    }
+
+    // Without SumNum the device sent a single-part catalog.
+    const auto expected = session.sumNum.value_or(session.channels.size());
+    if (session.channels.size() < expected) {
+        return std::nullopt;
+    }
+
+    Completed completed;
+    completed.deviceId = session.deviceId;
+    completed.sn = session.sn;
+    completed.sumNum = expected;
+    completed.channels = publishableChannels(std::move(session.channels));
+    eraseSession(iter);
+    return completed;
+}
+
+std::vector<CatalogSessionTracker::Completed> CatalogSessionTracker::collectExpired(Clock::time_point now) {
+    std::vector<Completed> expired;
+    std::lock_guard lock(mutex_);
+    for (auto iter = sessions_.begin(); iter != sessions_.end();) {
+        if (iter->second.deadline > now) {
+            ++iter;
+            continue;
+        }
+        Completed completed;
+        completed.deviceId = iter->second.deviceId;
+        completed.sn = iter->second.sn;
+        completed.sumNum = iter->second.sumNum.value_or(0);
+        completed.channels = publishableChannels(std::move(iter->second.channels));
+        completed.timedOut = true;
+        expired.push_back(std::move(completed));
+        auto next = std::next(iter);
+        eraseSession(iter);
+        iter = next;
+    }
+    return expired;
+}
+
+void CatalogSessionTracker::clear() {
+    std::lock_guard lock(mutex_);
+    sessions_.clear();
+    sessionsPerDevice_.clear();
+}
+
+std::size_t CatalogSessionTracker::inFlightCount() const {
+    std::lock_guard lock(mutex_);
+    return sessions_.size();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "device/Device.h"
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Collects multi-part Catalog responses (one MESSAGE per slice of SumNum
+// items) per device and SN, so the registry only ever sees a complete list.
+// Sessions start either from our own query (tryBegin) or from the first part
+// of an unsolicited catalog. A session whose parts stop arriving is handed
+// back by collectExpired() with whatever it has gathered.
+class CatalogSessionTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Completed {
+        std::string deviceId;
+        std::string sn;
+        std::size_t sumNum{0};
+        std::vector<Channel> channels;
+        bool timedOut{false};
+    };
+
+    explicit CatalogSessionTracker(std::chrono::seconds idleTimeout = std::chrono::seconds(15));
+
+    // Registers an outgoing query. Returns false while another catalog
+    // session for the device is still in flight.
+    bool tryBegin(const std::string& deviceId, const std::string& sn, Clock::time_point now);
+    // Adds one response slice. Every item counts toward SumNum; items
+    // without a DeviceID are dropped only from the returned channel list.
+    // Returns the assembled catalog once SumNum items have arrived.
+    std::optional<Completed> addPart(
+        const std::string& deviceId,
+        const std::string& sn,
+        std::optional<std::size_t> sumNum,
+        std::vector<Channel> items,
+        Clock::time_point now);
+    std::vector<Completed> collectExpired(Clock::time_point now);
+    void clear();
+    std::size_t inFlightCount() const;
+
+private:
+    struct Session {
+        std::string deviceId;
+        std::string sn;
+        std::optional<std::size_t> sumNum;
+        std::vector<Channel> channels;
+        std::unordered_map<std::string, std::size_t> index;
+        Clock::time_point deadline;
+    };
+
+    std::chrono::seconds idleTimeout_;
+    mutable std::mutex mutex_;
+    // Keyed by "<deviceId>#<sn>".
+    std::unordered_map<std::string, Session> sessions_;
+    std::unordered_map<std::string, std::size_t> sessionsPerDevice_;
+
+    static std::string keyOf(const std::string& deviceId, const std::string& sn);
+    void eraseSession(std::unordered_map<std::string, Session>::iterator iter);
+};
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <chrono>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 struct Channel {
@@ -12,6 +15,27 @@ struct Channel {
     int ptzType{-1};
 };
 
+// Published catalog of one device. Immutable once stored in the registry, so
+// readers share it by pointer instead of copying large NVR channel lists.
+struct ChannelList {
+    std::vector<Channel> items;
+    std::unordered_map<std::string, std::size_t> index;
+
+    explicit ChannelList(std::vector<Channel> channels) : items(std::move(channels)) {
+        index.reserve(items.size());
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            index.emplace(items[i].id, i);
+        }
+    }
+
+    const Channel* find(const std::string& channelId) const {
+        const auto iter = index.find(channelId);
+        return iter == index.end() ? nullptr : &items[iter->second];
+    }
+};
+
+using ChannelListPtr = std::shared_ptr<const ChannelList>;
+
 struct RecordItem {
     std::string deviceId;
     std::string name;
@@ -31,6 +55,12 @@ struct Device {
     std::string registrationSource{"sip"};
     bool online{false};
     std::chrono::system_clock::time_point lastSeen{};
-    std::vector<Channel> channels;
+    // Zero when the registration never expires (mock / API registrations).
+    std::chrono::system_clock::time_point registrationExpiresAt{};
+    ChannelListPtr channels;
     std::vector<RecordItem> records;
+
+    std::size_t channelCount() const {
+        return channels ? channels->items.size() : 0;
+    }
 };
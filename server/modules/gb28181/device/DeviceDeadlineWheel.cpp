@@ -0,0 +1,125 @@
+#include "device/DeviceDeadlineWheel.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+constexpr std::uint64_t kNoDeadline = 0;
+
+std::size_t kindIndex(DeviceDeadlineWheel::Kind kind) {
+    return static_cast<std::size_t>(kind);
+}
+
+} // namespace
+
+DeviceDeadlineWheel::DeviceDeadlineWheel(std::size_t slotCount, std::chrono::milliseconds tick)
+    : slots_(std::max<std::size_t>(slotCount, 1)),
+      tick_(std::max(tick, std::chrono::milliseconds(1))),
+      origin_(Clock::now()) {}
+
+std::uint64_t DeviceDeadlineWheel::tickFor(Clock::time_point deadline) const {
+    if (deadline <= origin_) {
+        return currentTick_ + 1;
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - origin_);
+    // Round up so a deadline never fires early.
+    const auto tick = static_cast<std::uint64_t>((elapsed.count() + tick_.count() - 1) / tick_.count());
+    return std::max(tick, currentTick_ + 1);
+}
+
+void DeviceDeadlineWheel::place(const std::string& deviceId, Kind kind, std::uint64_t tick) {
+    slots_[tick % slots_.size()].push_back(Entry{deviceId, kind, tick});
+}
+
+void DeviceDeadlineWheel::arm(const std::string& deviceId, Kind kind, Clock::time_point deadline) {
+    const auto tick = tickFor(deadline);
+    auto& deadlines = deadlines_[deviceId];
+    auto& current = deadlines[kindIndex(kind)];
+    if (current == kNoDeadline) {
+        ++armedCount_;
+        place(deviceId, kind, tick);
+    } else if (tick < current) {
+        // The queued entry is too late; the new one fires first and the old
+        // one is discarded once it finds the deadline already consumed.
+        place(deviceId, kind, tick);
+    }
+    current = tick;
+}
+
+void DeviceDeadlineWheel::cancel(const std::string& deviceId, Kind kind) {
+    const auto iter = deadlines_.find(deviceId);
+    if (iter == deadlines_.end()) {
+        return;
+    }
+    auto& current = iter->second[kindIndex(kind)];
+    if (current != kNoDeadline) {
+        current = kNoDeadline;
+        --armedCount_;
+    }
+    if (std::all_of(iter->second.begin(), iter->second.end(), [](std::uint64_t tick) { return tick == kNoDeadline; })) {
+        deadlines_.erase(iter);
+    }
+}
+
+void DeviceDeadlineWheel::cancelAll(const std::string& deviceId) {
+    cancel(deviceId, Kind::Registration);
+    cancel(deviceId, Kind::Keepalive);
+}
+
+void DeviceDeadlineWheel::clear() {
+    for (auto& slot : slots_) {
+        slot.clear();
+    }
+    deadlines_.clear();
+    armedCount_ = 0;
+}
+
+void DeviceDeadlineWheel::advance(Clock::time_point now, const ExpireCallback& onExpire) {
+    if (now < origin_) {
+        return;
+    }
+    const auto target = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - origin_).count() / tick_.count());
+
+    std::vector<std::pair<std::string, Kind>> expired;
+    std::vector<Entry> due;
+    while (currentTick_ < target) {
+        ++currentTick_;
+        auto& slot = slots_[currentTick_ % slots_.size()];
+        if (slot.empty()) {
+            continue;
+        }
+        due.clear();
+        due.swap(slot);
+        for (auto& entry : due) {
+            if (entry.tick > currentTick_) {
+                // Later lap of the wheel.
+                slot.push_back(std::move(entry));
+                continue;
+            }
+            const auto iter = deadlines_.find(entry.deviceId);
+            if (iter == deadlines_.end()) {
+                continue;
+            }
+            const auto current = iter->second[kindIndex(entry.kind)];
+            if (current == kNoDeadline || current < entry.tick) {
+                continue;
+            }
+            if (current > currentTick_) {
+                place(entry.deviceId, entry.kind, current);
+                continue;
+            }
+            expired.emplace_back(entry.deviceId, entry.kind);
+            cancel(entry.deviceId, entry.kind);
+        }
+    }
+
+    for (const auto& [deviceId, kind] : expired) {
+        onExpire(deviceId, kind);
+    }
+}
+
+std::size_t DeviceDeadlineWheel::armedCount() const {
+    return armedCount_;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Hashed timer wheel for per-device deadlines. Not thread-safe: the SIP
+// server owns one instance and only touches it on its IO loop.
+//
+// Re-arming to a later deadline only records the new tick; the entry already
+// in the wheel is moved forward when its slot comes up. Keepalive refreshes
+// therefore cost one hash lookup instead of a wheel insert.
+class DeviceDeadlineWheel {
+public:
+    enum class Kind : std::uint8_t {
+        Registration = 0,
+        Keepalive = 1,
+    };
+
+    using Clock = std::chrono::steady_clock;
+    using ExpireCallback = std::function<void(const std::string& deviceId, Kind kind)>;
+
+    explicit DeviceDeadlineWheel(std::size_t slotCount = 512, std::chrono::milliseconds tick = std::chrono::seconds(1));
+
+    void arm(const std::string& deviceId, Kind kind, Clock::time_point deadline);
+    void cancel(const std::string& deviceId, Kind kind);
+    void cancelAll(const std::string& deviceId);
+    void clear();
+    // Fires every deadline that is due at `now`, each exactly once.
+    void advance(Clock::time_point now, const ExpireCallback& onExpire);
+    std::size_t armedCount() const;
+
+private:
+    static constexpr std::size_t kKindCount = 2;
+
+    struct Entry {
+        std::string deviceId;
+        Kind kind;
+        std::uint64_t tick;
+    };
+
+    std::vector<std::vector<Entry>> slots_;
+    std::unordered_map<std::string, std::array<std::uint64_t, kKindCount>> deadlines_;
+    std::chrono::milliseconds tick_;
+    Clock::time_point origin_;
+    std::uint64_t currentTick_{0};
+    std::size_t armedCount_{0};
+
+    std::uint64_t tickFor(Clock::time_point deadline) const;
+    void place(const std::string& deviceId, Kind kind, std::uint64_t tick);
+};
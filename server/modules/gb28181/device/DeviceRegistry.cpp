@@ -1,87 +1,114 @@
 #include "device/DeviceRegistry.h"
 
-#include <algorithm>
+#include "common/utils/MemoryFootprint.hpp"
+
 #include <chrono>
 #include <utility>
 
-void DeviceRegistry::upsertRegistration(const std::string& deviceId, const std::string& remoteAddress, const std::string& source) {
-    std::lock_guard lock(mutex_);
-    auto& device = devices_[deviceId];
+namespace {
+
+// Records traffic from a device without changing its online state. Only
+// REGISTER and keepalive arm the expiry deadlines, so only they may mark a
+// device online; a late catalog or record answer must not revive it.
+Device& seeDevice(std::unordered_map<std::string, Device>& devices, const std::string& deviceId) {
+    auto& device = devices[deviceId];
     device.id = deviceId;
     if (device.name.empty()) {
         device.name = deviceId;
     }
+    device.lastSeen = std::chrono::system_clock::now();
+    return device;
+}
+
+Device& touchDevice(std::unordered_map<std::string, Device>& devices, const std::string& deviceId) {
+    auto& device = seeDevice(devices, deviceId);
+    device.online = true;
+    return device;
+}
+
+} // namespace
+
+DeviceRegistry::Shard& DeviceRegistry::shardFor(const std::string& deviceId) {
+    return shards_[std::hash<std::string>{}(deviceId) % kShardCount];
+}
+
+const DeviceRegistry::Shard& DeviceRegistry::shardFor(const std::string& deviceId) const {
+    return shards_[std::hash<std::string>{}(deviceId) % kShardCount];
+}
+
+void DeviceRegistry::upsertRegistration(
+    const std::string& deviceId,
+    const std::string& remoteAddress,
+    const std::string& source,
+    std::chrono::system_clock::time_point expiresAt) {
+    auto& shard = shardFor(deviceId);
+    std::lock_guard lock(shard.mutex);
+    auto& device = touchDevice(shard.devices, deviceId);
     device.remoteAddress = remoteAddress;
     device.registrationSource = source;
-    device.online = true;
-    device.lastSeen = std::chrono::system_clock::now();
+    device.registrationExpiresAt = expiresAt;
 }
 
 void DeviceRegistry::updateKeepalive(const std::string& deviceId, const std::string& remoteAddress) {
-    std::lock_guard lock(mutex_);
-    auto& device = devices_[deviceId];
-    device.id = deviceId;
-    if (device.name.empty()) {
-        device.name = deviceId;
-    }
+    auto& shard = shardFor(deviceId);
+    std::lock_guard lock(shard.mutex);
+    auto& device = touchDevice(shard.devices, deviceId);
     device.remoteAddress = remoteAddress;
     device.registrationSource = "sip";
-    device.online = true;
-    device.lastSeen = std::chrono::system_clock::now();
 }
 
 bool DeviceRegistry::updateKeepaliveAndNeedsCatalog(const std::string& deviceId, const std::string& remoteAddress) {
-    std::lock_guard lock(mutex_);
-    const auto iter = devices_.find(deviceId);
-    const auto needsCatalog = iter == devices_.end() || iter->second.channels.empty();
+    auto& shard = shardFor(deviceId);
+    std::lock_guard lock(shard.mutex);
+    const auto iter = shard.devices.find(deviceId);
+    const auto needsCatalog = iter == shard.devices.end() || iter->second.channelCount() == 0;
 
-    auto& device = devices_[deviceId];
-    device.id = deviceId;
-    if (device.name.empty()) {
-        device.name = deviceId;
-    }
+    auto& device = touchDevice(shard.devices, deviceId);
     device.remoteAddress = remoteAddress;
     device.registrationSource = "sip";
-    device.online = true;
-    device.lastSeen = std::chrono::system_clock::now();
     return needsCatalog;
 }
 
 void DeviceRegistry::updateCatalog(const std::string& deviceId, std::vector<Channel> channels) {
-    std::lock_guard lock(mutex_);
-    auto& device = devices_[deviceId];
-    device.id = deviceId;
-    if (device.name.empty()) {
-        device.name = deviceId;
+    // Build the index outside the shard lock; publishing is a pointer swap.
+    auto published = std::make_shared<const ChannelList>(std::move(channels));
+    auto& shard = shardFor(deviceId);
+    std::lock_guard lock(shard.mutex);
+    auto& device = seeDevice(shard.devices, deviceId);
+    device.channels = std::move(published);
+}
+
+ChannelListPtr DeviceRegistry::channelsOf(const std::string& deviceId) const {
+    const auto& shard = shardFor(deviceId);
+    std::lock_guard lock(shard.mutex);
+    const auto iter = shard.devices.find(deviceId);
+    if (iter == shard.devices.end()) {
+        return nullptr;
     }
-    device.online = true;
-    device.lastSeen = std::chrono::system_clock::now();
-    device.channels = std::move(channels);
+    return iter->second.channels;
 }
 
 void DeviceRegistry::updateRecords(const std::string& deviceId, std::vector<RecordItem> records) {
-    std::lock_guard lock(mutex_);
-    auto& device = devices_[deviceId];
-    device.id = deviceId;
-    if (device.name.empty()) {
-        device.name = deviceId;
-    }
-    device.online = true;
-    device.lastSeen = std::chrono::system_clock::now();
+    auto& shard = shardFor(deviceId);
+    std::lock_guard lock(shard.mutex);
+    auto& device = seeDevice(shard.devices, deviceId);
     device.records = std::move(records);
 }
 
 void DeviceRegistry::forEachDevice(const std::function<void(const Device&)>& visitor) const {
-    std::lock_guard lock(mutex_);
-    for (const auto& [_, device] : devices_) {
-        visitor(device);
+    for (const auto& shard : shards_) {
+        std::lock_guard lock(shard.mutex);
+        for (const auto& [_, device] : shard.devices) {
+            visitor(device);
+        }
     }
 }
 
 bool DeviceRegistry::visitDevice(const std::string& deviceId, const std::function<void(const Device&)>& visitor) const {
-    std::lock_guard lock(mutex_);
-    const auto iter = devices_.find(deviceId);
-    if (iter == devices_.end()) {
+    const auto& shard = shardFor(deviceId);
+    std::lock_guard lock(shard.mutex);
+    const auto iter = shard.devices.find(deviceId);
+    if (iter == shard.devices.end()) {
         return false;
     }
     visitor(iter->second);
@@ -89,28 +116,32 @@ bool DeviceRegistry::visitDevice(const std::string& deviceId, const std::functio
 }
 
 std::vector<Device> DeviceRegistry::listDevices() const {
-    std::lock_guard lock(mutex_);
     std::vector<Device> result;
-    result.reserve(devices_.size());
-    for (const auto& [_, device] : devices_) {
-        result.push_back(device);
+    for (const auto& shard : shards_) {
+        std::lock_guard lock(shard.mutex);
+        result.reserve(result.size() + shard.devices.size());
+        for (const auto& [_, device] : shard.devices) {
+            result.push_back(device);
+        }
     }
     return result;
 }
 
 std::optional<Device> DeviceRegistry::findDevice(const std::string& deviceId) const {
-    std::lock_guard lock(mutex_);
-    const auto iter = devices_.find(deviceId);
-    if (iter == devices_.end()) {
+    const auto& shard = shardFor(deviceId);
+    std::lock_guard lock(shard.mutex);
+    const auto iter = shard.devices.find(deviceId);
+    if (iter == shard.devices.end()) {
         return std::nullopt;
     }
     return iter->second;
 }
 
 std::optional<DeviceRouteSnapshot> DeviceRegistry::findRouteSnapshot(const std::string& deviceId, const std::string& channelId) const {
-    std::lock_guard lock(mutex_);
-    const auto iter = devices_.find(deviceId);
-    if (iter == devices_.end()) {
+    const auto& shard = shardFor(deviceId);
+    std::lock_guard lock(shard.mutex);
+    const auto iter = shard.devices.find(deviceId);
+    if (iter == shard.devices.end()) {
         return std::nullopt;
     }
 
@@ -118,19 +149,73 @@ std::optional<DeviceRouteSnapshot> DeviceRegistry::findRouteSnapshot(const std::
     DeviceRouteSnapshot snapshot;
     snapshot.online = device.online;
     snapshot.remoteAddress = device.remoteAddress;
-    snapshot.hasChannels = !device.channels.empty();
-    if (!channelId.empty()) {
-        snapshot.channelExists = std::any_of(device.channels.begin(), device.channels.end(), [&](const Channel& channel) {
-            return channel.id == channelId;
-        });
+    snapshot.hasChannels = device.channelCount() > 0;
+    if (!channelId.empty() && device.channels) {
+        snapshot.channelExists = device.channels->find(channelId) != nullptr;
     }
     return snapshot;
 }
 
 void DeviceRegistry::markOffline(const std::string& deviceId) {
-    std::lock_guard lock(mutex_);
-    const auto iter = devices_.find(deviceId);
-    if (iter != devices_.end()) {
+    auto& shard = shardFor(deviceId);
+    std::lock_guard lock(shard.mutex);
+    const auto iter = shard.devices.find(deviceId);
+    if (iter != shard.devices.end()) {
         iter->second.online = false;
     }
 }
+
+bool DeviceRegistry::expireRegistration(const std::string& deviceId, std::chrono::system_clock::time_point now) {
+    auto& shard = shardFor(deviceId);
+    std::lock_guard lock(shard.mutex);
+    const auto iter = shard.devices.find(deviceId);
+    if (iter == shard.devices.end() || !iter->second.online) {
+        return false;
+    }
+    const auto expiresAt = iter->second.registrationExpiresAt;
+    if (expiresAt == std::chrono::system_clock::time_point{} || expiresAt > now) {
+        return false;
+    }
+    iter->second.online = false;
+    return true;
+}
+
+bool DeviceRegistry::markOfflineIfIdle(const std::string& deviceId, std::chrono::system_clock::time_point idleSince) {
+    auto& shard = shardFor(deviceId);
+    std::lock_guard lock(shard.mutex);
+    const auto iter = shard.devices.find(deviceId);
+    if (iter == shard.devices.end() || !iter->second.online || iter->second.lastSeen > idleSince) {
+        return false;
+    }
+    iter->second.online = false;
+    return true;
+}
+
+std::size_t DeviceRegistry::approximateBytes() const {
+    std::size_t bytes = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard lock(shard.mutex);
+        bytes += memory::hashBytes(shard.devices);
+        for (const auto& [key, device] : shard.devices) {
+            bytes += memory::heapBytes(key) + memory::heapBytes(device.id) + memory::heapBytes(device.name)
+                + memory::heapBytes(device.manufacturer) + memory::heapBytes(device.remoteAddress)
+                + memory::heapBytes(device.registrationSource) + memory::vectorBytes(device.records);
+            for (const auto& record : device.records) {
+                for (const auto* field : {&record.deviceId, &record.name, &record.filePath, &record.address,
+                                          &record.startTime, &record.endTime, &record.type, &record.recorderId}) {
+                    bytes += memory::heapBytes(*field);
+                }
+            }
+            // Channel lists are shared with readers but owned here; count each once.
+            if (device.channels) {
+                bytes += sizeof(ChannelList) + memory::vectorBytes(device.channels->items)
+                    + memory::hashBytes(device.channels->index);
+                for (const auto& channel : device.channels->items) {
+                    bytes += 2 * memory::heapBytes(channel.id) + memory::heapBytes(channel.name)
+                        + memory::heapBytes(channel.manufacturer);
+                }
+            }
+        }
+    }
+    return bytes;
+}
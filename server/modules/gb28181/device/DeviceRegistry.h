@@ -2,6 +2,8 @@
 
 #include "device/Device.h"
 
+#include <array>
+#include <chrono>
 #include <functional>
 #include <mutex>
 #include <optional>
@@ -16,12 +18,21 @@ struct DeviceRouteSnapshot {
     bool channelExists{false};
 };
 
+// Devices are spread over fixed shards keyed by device ID hash, so keepalives
+// from different cameras only contend when they land on the same shard.
+// Whole-registry walks lock one shard at a time and are not a global snapshot.
 class DeviceRegistry {
 public:
-    void upsertRegistration(const std::string& deviceId, const std::string& remoteAddress, const std::string& source = "sip");
+    void upsertRegistration(
+        const std::string& deviceId,
+        const std::string& remoteAddress,
+        const std::string& source = "sip",
+        std::chrono::system_clock::time_point expiresAt = {});
     void updateKeepalive(const std::string& deviceId, const std::string& remoteAddress);
     bool updateKeepaliveAndNeedsCatalog(const std::string& deviceId, const std::string& remoteAddress);
     void updateCatalog(const std::string& deviceId, std::vector<Channel> channels);
+    // Shared, immutable channel list; null when the device is unknown.
+    ChannelListPtr channelsOf(const std::string& deviceId) const;
     void updateRecords(const std::string& deviceId, std::vector<RecordItem> records);
     void forEachDevice(const std::function<void(const Device&)>& visitor) const;
     bool visitDevice(const std::string& deviceId, const std::function<void(const Device&)>& visitor) const;
@@ -29,8 +40,25 @@ public:
     std::optional<Device> findDevice(const std::string& deviceId) const;
     std::optional<DeviceRouteSnapshot> findRouteSnapshot(const std::string& deviceId, const std::string& channelId = {}) const;
     void markOffline(const std::string& deviceId);
+    // Deadline transitions; each re-checks the device under its shard lock so a
+    // refresh that raced the timer keeps the device online. Returns true when
+    // the device went offline.
+    bool expireRegistration(const std::string& deviceId, std::chrono::system_clock::time_point now);
+    bool markOfflineIfIdle(const std::string& deviceId, std::chrono::system_clock::time_point idleSince);
+    // Rough heap footprint of all devices, channel lists and records; locks
+    // one shard at a time like forEachDevice.
+    std::size_t approximateBytes() const;
 
 private:
-    mutable std::mutex mutex_;
-    std::unordered_map<std::string, Device> devices_;
+    static constexpr std::size_t kShardCount = 16;
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Device> devices;
+    };
+
+    std::array<Shard, kShardCount> shards_;
+
+    Shard& shardFor(const std::string& deviceId);
+    const Shard& shardFor(const std::string& deviceId) const;
 };
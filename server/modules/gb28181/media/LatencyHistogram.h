@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Lock-free fixed-bucket latency histogram (milliseconds). Buckets are upper
+// bounds; the last one catches everything slower.
+class LatencyHistogram {
+public:
+    static constexpr std::array<uint64_t, 11> kBucketBoundsMs{50, 100, 200, 300, 500, 800, 1200, 2000, 3000, 5000, 10000};
+
+    struct Snapshot {
+        std::vector<std::pair<uint64_t, uint64_t>> buckets;  // {upper bound ms, count}; bound 0 = +Inf
+        uint64_t count{0};
+        uint64_t sumMs{0};
+        uint64_t maxMs{0};
+    };
+
+    void record(std::chrono::steady_clock::duration elapsed) {
+        const auto ms = static_cast<uint64_t>(std::max<int64_t>(
+            0, std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()));
+        std::size_t bucket = 0;
+        while (bucket < kBucketBoundsMs.size() && ms > kBucketBoundsMs[bucket]) {
+            ++bucket;
+        }
+        counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sumMs_.fetch_add(ms, std::memory_order_relaxed);
+        auto currentMax = maxMs_.load(std::memory_order_relaxed);
+        while (ms > currentMax && !maxMs_.compare_exchange_weak(currentMax, ms, std::memory_order_relaxed)) {
+        }
+    }
+
+    Snapshot snapshot() const {
+        Snapshot result;
+        result.buckets.reserve(counts_.size());
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            result.buckets.emplace_back(
+                i < kBucketBoundsMs.size() ? kBucketBoundsMs[i] : 0,
+                counts_[i].load(std::memory_order_relaxed));
+        }
+        result.count = count_.load(std::memory_order_relaxed);
+        result.sumMs = sumMs_.load(std::memory_order_relaxed);
+        result.maxMs = maxMs_.load(std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketBoundsMs.size() + 1> counts_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sumMs_{0};
+    std::atomic<uint64_t> maxMs_{0};
+};
@@ -0,0 +1,97 @@
+#include "media/RtpPortPool.h"
+
+#include <algorithm>
+
+RtpPortPool::RtpPortPool(uint16_t rangeStart, uint16_t rangeEnd)
+    : rangeStart_(static_cast<uint16_t>(rangeStart + rangeStart % 2)),
+      rangeEnd_(rangeEnd) {
+    for (uint32_t port = rangeStart_; port + 1 <= rangeEnd_; port += 2) {
+        free_.push_back(static_cast<uint16_t>(port));
+    }
+    capacity_ = free_.size();
+}
+
+bool RtpPortPool::inRange(uint16_t port) const {
+    return port >= rangeStart_ && port + 1 <= rangeEnd_ && port % 2 == 0;
+}
+
+std::optional<uint16_t> RtpPortPool::acquire(const std::string& streamId) {
+    std::lock_guard lock(mutex_);
+    const auto existing = leasesByStream_.find(streamId);
+    if (existing != leasesByStream_.end()) {
+        return existing->second;
+    }
+    if (free_.empty()) {
+        return std::nullopt;
+    }
+    const auto port = free_.front();
+    free_.pop_front();
+    leasesByStream_.emplace(streamId, port);
+    leasesByPort_.emplace(port, streamId);
+    return port;
+}
+
+bool RtpPortPool::rebind(const std::string& streamId, uint16_t port) {
+    std::lock_guard lock(mutex_);
+    const auto iter = leasesByStream_.find(streamId);
+    if (iter == leasesByStream_.end() || iter->second == port) {
+        return true;
+    }
+    const auto holder = leasesByPort_.find(port);
+    if (holder != leasesByPort_.end()) {
+        // The requested port was never bound, so it goes back to the pool.
+        leasesByPort_.erase(iter->second);
+        releaseLocked(iter->second);
+        leasesByStream_.erase(iter);
+        return false;
+    }
+    releaseLocked(iter->second);
+    leasesByPort_.erase(iter->second);
+    iter->second = port;
+    if (inRange(port)) {
+        // ZLM picked a port from our range on its own; take it off the free list.
+        free_.erase(std::remove(free_.begin(), free_.end(), port), free_.end());
+    }
+    leasesByPort_[port] = streamId;
+    return true;
+}
+
+bool RtpPortPool::release(const std::string& streamId) {
+    std::lock_guard lock(mutex_);
+    const auto iter = leasesByStream_.find(streamId);
+    if (iter == leasesByStream_.end()) {
+        return false;
+    }
+    const auto port = iter->second;
+    leasesByStream_.erase(iter);
+    leasesByPort_.erase(port);
+    releaseLocked(port);
+    return true;
+}
+
+bool RtpPortPool::releasePort(uint16_t port) {
+    std::lock_guard lock(mutex_);
+    const auto iter = leasesByPort_.find(port);
+    if (iter == leasesByPort_.end()) {
+        return false;
+    }
+    leasesByStream_.erase(iter->second);
+    leasesByPort_.erase(iter);
+    releaseLocked(port);
+    return true;
+}
+
+void RtpPortPool::releaseLocked(uint16_t port) {
+    if (inRange(port)) {
+        free_.push_back(port);
+    }
+}
+
+std::size_t RtpPortPool::capacity() const {
+    return capacity_;
+}
+
+std::size_t RtpPortPool::inUse() const {
+    std::lock_guard lock(mutex_);
+    return leasesByStream_.size();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+// Lease table for the RTP receive ports handed to ZLMediaKit. Only even
+// ports are leased (RTCP takes the odd neighbour). Released ports go to the
+// back of the free queue so a port that ZLM is still tearing down is not
+// handed out again straight away.
+class RtpPortPool {
+public:
+    RtpPortPool(uint16_t rangeStart, uint16_t rangeEnd);
+
+    std::optional<uint16_t> acquire(const std::string& streamId);
+    // Moves a lease to the port ZLM actually bound, when it differs. Returns
+    // false if that port is leased to another stream; the other lease is
+    // left alone and this stream's lease is dropped.
+    bool rebind(const std::string& streamId, uint16_t port);
+    bool release(const std::string& streamId);
+    bool releasePort(uint16_t port);
+
+    std::size_t capacity() const;
+    std::size_t inUse() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::deque<uint16_t> free_;
+    std::unordered_map<std::string, uint16_t> leasesByStream_;
+    std::unordered_map<uint16_t, std::string> leasesByPort_;
+    std::size_t capacity_{0};
+    uint16_t rangeStart_{0};
+    uint16_t rangeEnd_{0};
+
+    bool inRange(uint16_t port) const;
+    void releaseLocked(uint16_t port);
+};
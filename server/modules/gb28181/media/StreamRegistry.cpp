@@ -1,5 +1,7 @@
 #include "media/StreamRegistry.h"
 
+#include "common/utils/MemoryFootprint.hpp"
+
 void StreamRegistry::updateStreamChanged(const std::string& app, const std::string& stream, const std::string& schema, bool online) {
     std::lock_guard lock(mutex_);
     auto& status = streams_[keyFor(app, stream, schema)];
@@ -39,6 +41,16 @@ std::vector<StreamStatus> StreamRegistry::listStreams() const {
     return result;
 }
 
+std::size_t StreamRegistry::approximateBytes() const {
+    std::lock_guard lock(mutex_);
+    std::size_t bytes = memory::hashBytes(streams_);
+    for (const auto& [key, status] : streams_) {
+        bytes += memory::heapBytes(key) + memory::heapBytes(status.app)
+            + memory::heapBytes(status.stream) + memory::heapBytes(status.schema);
+    }
+    return bytes;
+}
+
 std::string StreamRegistry::keyFor(const std::string& app, const std::string& stream, const std::string& schema) {
     return app + "/" + stream + "/" + schema;
 }
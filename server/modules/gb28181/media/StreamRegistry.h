@@ -20,6 +20,7 @@ public:
     void updateNoneReader(const std::string& app, const std::string& stream, const std::string& schema);
     std::optional<StreamStatus> findStream(const std::string& stream) const;
     std::vector<StreamStatus> listStreams() const;
+    std::size_t approximateBytes() const;
 
 private:
     static std::string keyFor(const std::string& app, const std::string& stream, const std::string& schema);
@@ -4,6 +4,8 @@
 #include <trantor/utils/Logger.h>
 #include <drogon/drogon.h>
 
+#include <algorithm>
+#include <cctype>
 #include <sstream>
 #include <utility>
 
@@ -54,6 +56,23 @@ std::optional<boost::json::object> parseObject(const std::string& body) {
     return value.as_object();
 }
 
+// ZLM reports a failed RTP socket bind as a generic exception (code -400)
+// whose message names the bind/port failure. Auth errors, bad arguments
+// and "stream already exists" carry other codes and are not port problems.
+bool isPortBindFailure(const boost::json::object& object) {
+    const auto code = object.if_contains("code");
+    const auto msg = object.if_contains("msg");
+    if (code == nullptr || !code->is_int64() || code->as_int64() != -400 ||
+        msg == nullptr || !msg->is_string()) {
+        return false;
+    }
+    std::string text(msg->as_string());
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text.find("bind") != std::string::npos ||
+           text.find("address already in use") != std::string::npos;
+}
+
 std::string compactForLog(std::string value, std::size_t limit = 512) {
     const auto truncated = value.size() > limit;
     if (truncated) {
@@ -82,39 +101,35 @@ std::string compactForLog(std::string value, std::size_t limit = 512) {
 } // namespace
 
 ZlmClient::ZlmClient(MediaConfig config)
-    : config_(std::move(config)) {
-    nextRtpPort_.store(config_.rtpPortRangeStart);
-}
+    : config_(std::move(config)),
+      portPool_(config_.rtpPortRangeStart, config_.rtpPortRangeEnd) {}
 
-drogon::Task<std::optional<OpenRtpServerResult>> ZlmClient::openRtpServerCoro(const std::string& deviceId, const std::string& channelId, const std::string& ssrc, const std::string& mode) {
-    const auto baseUrl = trimTrailingSlash(config_.zlmBaseUrl);
-    const auto streamId = makeStreamId(deviceId, channelId, ssrc, mode);
-    const auto requestedPort = allocateRtpPort();
-    auto client = drogon::HttpClient::newHttpClient(baseUrl);
+const drogon::HttpClientPtr& ZlmClient::apiClient() {
+    std::call_once(clientOnce_, [this]() {
+        client_ = drogon::HttpClient::newHttpClient(trimTrailingSlash(config_.zlmBaseUrl), drogon::app().getLoop());
+    });
+    return client_;
+}
 
+drogon::Task<ZlmClient::OpenAttempt> ZlmClient::sendOpenRtpServer(const std::string& streamId, const std::string& ssrc, uint16_t requestedPort) {
     std::ostringstream path;
     path << "/index/api/openRtpServer?secret=" << config_.zlmSecret
          << "&port=" << requestedPort
          << "&enable_tcp=1"
          << "&stream_id=" << streamId;
+    if (config_.rtpSinglePort != 0) {
+        path << "&re_use_port=1&ssrc=" << ssrc;
+    }
 
     auto request = drogon::HttpRequest::newHttpRequest();
     request->setMethod(drogon::Get);
     request->setPath(path.str());
 
-    LOG_DEBUG << "[GB28181][ZLM] openRtpServer request, device=" << deviceId
-             << ", channel=" << channelId
-             << ", mode=" << mode
-             << ", stream_id=" << streamId
-             << ", ssrc=" << ssrc
-             << ", requested_port=" << requestedPort
-             << ", base_url=" << baseUrl;
-
-    auto response = co_await client->sendRequestCoro(request, 3.0);
+    auto response = co_await apiClient()->sendRequestCoro(request, 3.0);
     if (response == nullptr) {
         LOG_WARN << "[GB28181][ZLM] openRtpServer request failed, stream_id=" << streamId
                  << ", requested_port=" << requestedPort;
-        co_return std::nullopt;
+        co_return OpenAttempt{};
     }
 
     LOG_DEBUG << "[GB28181][ZLM] openRtpServer response, stream_id=" << streamId
@@ -126,7 +141,7 @@ drogon::Task<std::optional<OpenRtpServerResult>> ZlmClient::openRtpServerCoro(co
         LOG_WARN << "[GB28181][ZLM] openRtpServer returned invalid JSON, stream_id=" << streamId
                  << ", http_status=" << static_cast<int>(response->getStatusCode())
                  << ", body=\"" << compactForLog(std::string(response->body()), 800) << "\"";
-        co_return std::nullopt;
+        co_return OpenAttempt{};
     }
 
     const auto& object = *parsed;
@@ -134,27 +149,76 @@ drogon::Task<std::optional<OpenRtpServerResult>> ZlmClient::openRtpServerCoro(co
     const auto port = object.if_contains("port");
     if (code == nullptr || !code->is_int64() || code->as_int64() != 0) {
         LOG_WARN << "[GB28181][ZLM] openRtpServer failed, stream_id=" << streamId
+                 << ", requested_port=" << requestedPort
                  << ", http_status=" << static_cast<int>(response->getStatusCode())
                  << ", body=\"" << compactForLog(std::string(response->body()), 800) << "\"";
-        co_return std::nullopt;
-    }
-
-    OpenRtpServerResult openResult;
-    openResult.streamId = streamId;
-    openResult.port = port != nullptr && port->is_int64() ? static_cast<uint16_t>(port->as_int64()) : requestedPort;
-    openResult.playUrls = buildPlayUrls(streamId);
-    LOG_DEBUG << "[GB28181][ZLM] openRtpServer success, stream_id=" << streamId
-             << ", requested_port=" << requestedPort
-             << ", actual_port=" << openResult.port
-             << ", http_flv=" << openResult.playUrls.httpFlv
-             << ", ws_flv=" << openResult.playUrls.wsFlv;
-    co_return openResult;
+        // Only a port that failed to bind is worth another lease; anything
+        // else would fail the same way on every attempt.
+        co_return OpenAttempt{std::nullopt, isPortBindFailure(object)};
+    }
+    co_return OpenAttempt{
+        port != nullptr && port->is_int64() ? static_cast<uint16_t>(port->as_int64()) : requestedPort,
+        false,
+    };
 }
 
-drogon::Task<bool> ZlmClient::closeRtpServerCoro(const std::string& streamId) {
-    const auto baseUrl = trimTrailingSlash(config_.zlmBaseUrl);
-    auto client = drogon::HttpClient::newHttpClient(baseUrl);
+drogon::Task<std::optional<OpenRtpServerResult>> ZlmClient::openRtpServerCoro(const std::string& deviceId, const std::string& channelId, const std::string& ssrc, const std::string& mode) {
+    constexpr int maxAttempts = 3;
+    const auto streamId = makeStreamId(deviceId, channelId, ssrc, mode);
+    const auto singlePort = config_.rtpSinglePort != 0;
+
+    for (int attempt = 1; attempt <= maxAttempts; ++attempt) {
+        uint16_t requestedPort = config_.rtpSinglePort;
+        if (!singlePort) {
+            const auto lease = portPool_.acquire(streamId);
+            if (!lease.has_value()) {
+                LOG_WARN << "[GB28181][ZLM] openRtpServer skipped, stream_id=" << streamId
+                         << ", reason=rtp_port_pool_exhausted"
+                         << ", capacity=" << portPool_.capacity();
+                co_return std::nullopt;
+            }
+            requestedPort = *lease;
+        }
+
+        LOG_DEBUG << "[GB28181][ZLM] openRtpServer request, device=" << deviceId
+                 << ", channel=" << channelId
+                 << ", mode=" << mode
+                 << ", stream_id=" << streamId
+                 << ", ssrc=" << ssrc
+                 << ", requested_port=" << requestedPort
+                 << ", single_port=" << singlePort
+                 << ", attempt=" << attempt;
 
+        const auto result = co_await sendOpenRtpServer(streamId, ssrc, requestedPort);
+        if (!result.port.has_value()) {
+            portPool_.release(streamId);
+            if (result.retryable && !singlePort) {
+                continue;
+            }
+            co_return std::nullopt;
+        }
+
+        if (!singlePort && !portPool_.rebind(streamId, *result.port)) {
+            LOG_WARN << "[GB28181][ZLM] openRtpServer bound a port leased to another stream, stream_id=" << streamId
+                     << ", requested_port=" << requestedPort
+                     << ", actual_port=" << *result.port;
+        }
+        OpenRtpServerResult openResult;
+        openResult.streamId = streamId;
+        openResult.port = *result.port;
+        openResult.playUrls = buildPlayUrls(streamId);
+        LOG_DEBUG << "[GB28181][ZLM] openRtpServer success, stream_id=" << streamId
+                 << ", requested_port=" << requestedPort
+                 << ", actual_port=" << openResult.port
+                 << ", ports_in_use=" << portPool_.inUse()
+                 << ", http_flv=" << openResult.playUrls.httpFlv
+                 << ", ws_flv=" << openResult.playUrls.wsFlv;
+        co_return openResult;
+    }
+    co_return std::nullopt;
+}
+
+drogon::Task<bool> ZlmClient::closeRtpServerCoro(const std::string& streamId) {
     std::ostringstream path;
     path << "/index/api/closeRtpServer?secret=" << config_.zlmSecret
          << "&stream_id=" << streamId;
@@ -163,10 +227,12 @@ drogon::Task<bool> ZlmClient::closeRtpServerCoro(const std::string& streamId) {
     request->setMethod(drogon::Get);
     request->setPath(path.str());
 
-    LOG_DEBUG << "[GB28181][ZLM] closeRtpServer request, stream_id=" << streamId
-             << ", base_url=" << baseUrl;
+    LOG_DEBUG << "[GB28181][ZLM] closeRtpServer request, stream_id=" << streamId;
 
-    auto response = co_await client->sendRequestCoro(request, 3.0);
+    auto response = co_await apiClient()->sendRequestCoro(request, 3.0);
+    // Even if ZLM did not answer, the lease goes back to the tail of the
+    // free list; ZLM's own rtp timeout frees the socket long before reuse.
+    portPool_.release(streamId);
     if (response == nullptr) {
         LOG_WARN << "[GB28181][ZLM] closeRtpServer request failed, stream_id=" << streamId;
         co_return false;
@@ -178,6 +244,21 @@ drogon::Task<bool> ZlmClient::closeRtpServerCoro(const std::string& streamId) {
     co_return true;
 }
 
+void ZlmClient::releaseRtpPort(const std::string& streamId, std::optional<uint16_t> localPort) {
+    auto released = portPool_.release(streamId);
+    if (!released && localPort.has_value()) {
+        released = portPool_.releasePort(*localPort);
+    }
+    if (released) {
+        LOG_DEBUG << "[GB28181][ZLM] RTP port lease released, stream_id=" << streamId
+                 << ", ports_in_use=" << portPool_.inUse();
+    }
+}
+
+ZlmClient::PortStats ZlmClient::portStats() const {
+    return PortStats{portPool_.capacity(), portPool_.inUse(), config_.rtpSinglePort};
+}
+
 PlayUrls ZlmClient::buildPlayUrls(const std::string& streamId) const {
     const auto baseUrl = trimTrailingSlash(config_.zlmPublicBaseUrl.empty() ? config_.zlmBaseUrl : config_.zlmPublicBaseUrl);
     const auto wsBaseUrl = httpToWs(baseUrl);
@@ -198,15 +279,3 @@ std::string ZlmClient::makeStreamId(const std::string& deviceId, const std::stri
     const std::string prefix = mode == "playback" ? "gb_playback" : "gb";
     return prefix + "_" + deviceId + "_" + channelId + "_" + ssrc;
 }
-
-uint16_t ZlmClient::allocateRtpPort() {
-    auto port = nextRtpPort_.fetch_add(2);
-    if (port > config_.rtpPortRangeEnd || port < config_.rtpPortRangeStart) {
-        nextRtpPort_.store(config_.rtpPortRangeStart + 2);
-        port = config_.rtpPortRangeStart;
-    }
-    if (port % 2 != 0) {
-        ++port;
-    }
-    return static_cast<uint16_t>(port);
-}
@@ -2,25 +2,44 @@
 
 #include "config/AppConfig.h"
 #include "media/MediaTypes.h"
+#include "media/RtpPortPool.h"
 
 #include <drogon/drogon.h>
 
-#include <atomic>
+#include <mutex>
 #include <optional>
 #include <string>
 
 class ZlmClient {
 public:
+    struct PortStats {
+        std::size_t capacity{0};
+        std::size_t inUse{0};
+        uint16_t singlePort{0};
+    };
+
     explicit ZlmClient(MediaConfig config);
 
     drogon::Task<std::optional<OpenRtpServerResult>> openRtpServerCoro(const std::string& deviceId, const std::string& channelId, const std::string& ssrc, const std::string& mode = "preview");
     drogon::Task<bool> closeRtpServerCoro(const std::string& streamId);
     PlayUrls buildPlayUrls(const std::string& streamId) const;
+    // Hook-driven release for RTP servers ZLM closed on its own.
+    void releaseRtpPort(const std::string& streamId, std::optional<uint16_t> localPort = std::nullopt);
+    PortStats portStats() const;
 
 private:
+    struct OpenAttempt {
+        std::optional<uint16_t> port;
+        bool retryable{false};
+    };
+
     MediaConfig config_;
-    std::atomic_uint nextRtpPort_{0};
+    RtpPortPool portPool_;
+    std::once_flag clientOnce_;
+    drogon::HttpClientPtr client_;
 
+    // One keep-alive connection to the ZLM API shared by every request.
+    const drogon::HttpClientPtr& apiClient();
+    drogon::Task<OpenAttempt> sendOpenRtpServer(const std::string& streamId, const std::string& ssrc, uint16_t requestedPort);
     std::string makeStreamId(const std::string& deviceId, const std::string& channelId, const std::string& ssrc, const std::string& mode) const;
-    uint16_t allocateRtpPort();
 };
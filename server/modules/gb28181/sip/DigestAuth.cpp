@@ -106,7 +106,7 @@ bool DigestAuth::verifyRegister(const SipMessage& message, const std::string& re
     }
 
     const auto ha1 = md5Hex(username->second + ":" + realm + ":" + password);
-    const auto ha2 = md5Hex(message.method + ":" + uri->second);
+    const auto ha2 = md5Hex(std::string(message.method) + ":" + uri->second);
 
     const auto qop = params.find("qop");
     std::string expected;
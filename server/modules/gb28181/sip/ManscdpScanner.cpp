@@ -0,0 +1,59 @@
+#include "sip/ManscdpScanner.h"
+
+#include <string>
+
+namespace {
+
+std::string_view trim(std::string_view value) {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t' || value.front() == '\r' || value.front() == '\n')) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t' || value.back() == '\r' || value.back() == '\n')) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+bool isPlainText(std::string_view value) {
+    return value.find_first_of("<&") == std::string_view::npos;
+}
+
+} // namespace
+
+std::string_view ManscdpScanner::elementText(std::string_view body, std::string_view name) {
+    std::string open;
+    open.reserve(name.size() + 2);
+    open.append("<").append(name).append(">");
+    const auto begin = body.find(open);
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    const auto valueStart = begin + open.size();
+    const auto end = body.find("</", valueStart);
+    if (end == std::string_view::npos || body.substr(end + 2, name.size()) != name) {
+        return {};
+    }
+    return trim(body.substr(valueStart, end - valueStart));
+}
+
+std::optional<ManscdpScanner::Keepalive> ManscdpScanner::scanKeepalive(std::string_view body) {
+    if (elementText(body, "CmdType") != "Keepalive") {
+        return std::nullopt;
+    }
+    if (body.find("<Info") != std::string_view::npos
+        || body.find("<!") != std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    Keepalive keepalive;
+    keepalive.deviceId = elementText(body, "DeviceID");
+    keepalive.status = elementText(body, "Status");
+    keepalive.sn = elementText(body, "SN");
+    if (keepalive.deviceId.empty()
+        || !isPlainText(keepalive.deviceId)
+        || !isPlainText(keepalive.status)
+        || !isPlainText(keepalive.sn)) {
+        return std::nullopt;
+    }
+    return keepalive;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+// Tag scanner for the small MANSCDP bodies that dominate SIP traffic.
+// Anything it is not sure about (entities, CDATA, comments, nested Info
+// blocks) returns std::nullopt so the caller falls back to pugixml.
+class ManscdpScanner {
+public:
+    struct Keepalive {
+        std::string_view deviceId;
+        std::string_view status;
+        std::string_view sn;
+    };
+
+    static std::optional<Keepalive> scanKeepalive(std::string_view body);
+    static std::string_view elementText(std::string_view body, std::string_view name);
+};
@@ -1,80 +1,161 @@
 #include "sip/SipMessage.h"
 
-#include <algorithm>
-#include <cctype>
-#include <sstream>
+#include <array>
+#include <charconv>
 
 namespace {
 
-std::string trim(std::string value) {
-    const auto notSpace = [](unsigned char c) { return !std::isspace(c); };
-    value.erase(value.begin(), std::find_if(value.begin(), value.end(), notSpace));
-    value.erase(std::find_if(value.rbegin(), value.rend(), notSpace).base(), value.end());
-    return value;
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
 }
 
-std::string lower(std::string value) {
-    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) {
-        return static_cast<char>(std::tolower(c));
-    });
+std::string_view trim(std::string_view value) {
+    while (!value.empty() && isSpace(value.front())) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && isSpace(value.back())) {
+        value.remove_suffix(1);
+    }
     return value;
 }
 
+char lowerAscii(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool equalsIgnoreCase(std::string_view left, std::string_view right) {
+    if (left.size() != right.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < left.size(); ++i) {
+        if (lowerAscii(left[i]) != lowerAscii(right[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct CompactForm {
+    char shortName;
+    std::string_view longName;
+};
+
+constexpr std::array<CompactForm, 10> compactForms{{
+    {'i', "call-id"},
+    {'f', "from"},
+    {'t', "to"},
+    {'v', "via"},
+    {'m', "contact"},
+    {'l', "content-length"},
+    {'c', "content-type"},
+    {'k', "supported"},
+    {'s', "subject"},
+    {'e', "content-encoding"},
+}};
+
+// Returns the compact letter for a long header name, or '\0'.
+char compactFormOf(std::string_view name) {
+    for (const auto& form : compactForms) {
+        if (equalsIgnoreCase(name, form.longName)) {
+            return form.shortName;
+        }
+    }
+    if (name.size() == 1) {
+        for (const auto& form : compactForms) {
+            if (lowerAscii(name.front()) == form.shortName) {
+                return form.shortName;
+            }
+        }
+    }
+    return '\0';
+}
+
+bool headerNameMatches(std::string_view candidate, std::string_view name, char compact) {
+    if (equalsIgnoreCase(candidate, name)) {
+        return true;
+    }
+    if (compact == '\0') {
+        return false;
+    }
+    if (candidate.size() == 1) {
+        return lowerAscii(candidate.front()) == compact;
+    }
+    return compactFormOf(candidate) == compact;
+}
+
+std::string_view nextLine(std::string_view& text) {
+    const auto end = text.find('\n');
+    auto line = text.substr(0, end);
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    return line;
+}
+
+std::string_view nextToken(std::string_view& text) {
+    text = trim(text);
+    const auto end = text.find_first_of(" \t");
+    const auto token = text.substr(0, end);
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end);
+    return token;
+}
+
 } // namespace
 
-std::optional<SipMessage> SipMessage::parse(const std::string& raw) {
+std::optional<SipMessage> SipMessage::parse(std::string_view raw) {
     const auto headerEnd = raw.find("\r\n\r\n");
-    if (headerEnd == std::string::npos) {
+    if (headerEnd == std::string_view::npos) {
         return std::nullopt;
     }
 
     SipMessage message;
     message.body = raw.substr(headerEnd + 4);
 
-    std::istringstream lines(raw.substr(0, headerEnd));
-    if (!std::getline(lines, message.startLine)) {
+    auto head = raw.substr(0, headerEnd);
+    message.startLine = nextLine(head);
+    message.headerBlock = head;
+    if (message.startLine.empty()) {
         return std::nullopt;
     }
-    if (!message.startLine.empty() && message.startLine.back() == '\r') {
-        message.startLine.pop_back();
-    }
 
-    std::istringstream start(message.startLine);
-    if (message.startLine.rfind("SIP/2.0", 0) == 0) {
-        std::string version;
-        start >> version >> message.statusCode;
-        std::getline(start, message.reasonPhrase);
-        message.reasonPhrase = trim(message.reasonPhrase);
+    auto start = message.startLine;
+    if (start.substr(0, 7) == "SIP/2.0") {
+        nextToken(start);
+        const auto code = nextToken(start);
+        int statusCode = 0;
+        const auto [ptr, error] = std::from_chars(code.data(), code.data() + code.size(), statusCode);
+        if (error == std::errc() && ptr == code.data() + code.size()) {
+            message.statusCode = statusCode;
+        }
+        message.reasonPhrase = trim(start);
     } else {
-        start >> message.method >> message.requestUri;
+        message.method = nextToken(start);
+        message.requestUri = nextToken(start);
     }
 
     if (message.method.empty() && message.statusCode == 0) {
         return std::nullopt;
     }
+    return message;
+}
 
-    std::string line;
-    while (std::getline(lines, line)) {
-        if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
-        }
+std::string_view SipMessage::headerView(std::string_view name) const {
+    const auto compact = compactFormOf(name);
+    auto lines = headerBlock;
+    while (!lines.empty()) {
+        const auto line = nextLine(lines);
         const auto colon = line.find(':');
-        if (colon == std::string::npos) {
+        if (colon == std::string_view::npos) {
             continue;
         }
-        auto name = lower(trim(line.substr(0, colon)));
-        auto value = trim(line.substr(colon + 1));
-        message.headers[name] = value;
+        if (headerNameMatches(trim(line.substr(0, colon)), name, compact)) {
+            return trim(line.substr(colon + 1));
+        }
     }
-
-    return message;
+    return {};
 }
 
-std::string SipMessage::header(const std::string& name) const {
-    auto key = lower(name);
-    const auto iter = headers.find(key);
-    if (iter == headers.end()) {
-        return {};
-    }
-    return iter->second;
+std::string SipMessage::header(std::string_view name) const {
+    return std::string(headerView(name));
 }
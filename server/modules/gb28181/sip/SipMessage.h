@@ -2,18 +2,25 @@
 
 #include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
+// Non-owning view over one SIP packet. Every field points into the buffer
+// passed to parse(), which must outlive the message. Headers are not split
+// up front; header()/headerView() scan the header block on demand.
 class SipMessage {
 public:
-    std::string startLine;
-    std::string method;
-    std::string requestUri;
+    std::string_view startLine;
+    std::string_view method;
+    std::string_view requestUri;
     int statusCode{0};
-    std::string reasonPhrase;
-    std::unordered_map<std::string, std::string> headers;
-    std::string body;
+    std::string_view reasonPhrase;
+    std::string_view headerBlock;
+    std::string_view body;
 
-    static std::optional<SipMessage> parse(const std::string& raw);
-    std::string header(const std::string& name) const;
+    static std::optional<SipMessage> parse(std::string_view raw);
+
+    // Case-insensitive lookup that also accepts RFC 3261 compact forms
+    // (i, f, t, v, m, l, c, k, s, e). Returns the first occurrence.
+    std::string_view headerView(std::string_view name) const;
+    std::string header(std::string_view name) const;
 };
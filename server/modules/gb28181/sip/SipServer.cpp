@@ -1,7 +1,9 @@
 #include "sip/SipServer.h"
 
 #include "common/network/TcpLinkManager.hpp"
+#include "common/utils/LogLimiter.hpp"
 #include "sip/DigestAuth.h"
+#include "sip/ManscdpScanner.h"
 #include "sip/SipMessage.h"
 
 #include <trantor/utils/Logger.h>
@@ -12,12 +14,16 @@
 #include <chrono>
 #include <coroutine>
 #include <cctype>
+#include <charconv>
 #include <cstring>
+#include <exception>
+#include <functional>
 #include <random>
 #include <sstream>
 #include <iomanip>
 #include <locale>
 #include <stdexcept>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -27,6 +33,10 @@
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <sys/uio.h>
+#endif
+
 namespace {
 
 #ifdef _WIN32
@@ -39,6 +49,15 @@ constexpr NativeSocket invalidSocket = -1;
 using SockLen = socklen_t;
 #endif
 
+constexpr std::size_t kMaxUdpDatagramSize = 8192;
+constexpr std::size_t kMaxUdpBatch = 64;
+// Datagrams held per worker while the socket buffer is full.
+constexpr std::size_t kMaxPendingUdpSends = 4096;
+constexpr double kUdpSendRetryDelaySec = 0.01;
+constexpr unsigned int kDefaultRegisterExpiresSec = 3600;
+// Devices usually refresh right at Expires; give the REGISTER time to arrive.
+constexpr std::chrono::seconds kRegistrationGrace{15};
+
 struct TcpConnectionContext {
     std::string pending;
     SipServer::SipPeer peer;
@@ -119,10 +138,10 @@ std::optional<std::size_t> contentLengthOf(const std::string& headerText) {
     return 0;
 }
 
-std::string compactForLog(std::string value, std::size_t limit = 512) {
+std::string compactForLog(std::string_view value, std::size_t limit = 512) {
     const auto truncated = value.size() > limit;
     if (truncated) {
-        value.resize(limit);
+        value = value.substr(0, limit);
     }
 
     std::string output;
@@ -201,6 +220,10 @@ void logSipPacket(
 }
 
 void logSipSend(const std::string& packet, const SipServer::SipPeer& remote, bool includeBody) {
+    // Re-parsing the outgoing packet is only worth it when the line will actually be written.
+    if (trantor::Logger::logLevel() > trantor::Logger::kDebug) {
+        return;
+    }
     const auto message = SipMessage::parse(packet);
     if (!message.has_value()) {
         LOG_DEBUG << "[GB28181][SIP][TX] " << transportName(remote.transport)
@@ -231,7 +254,33 @@ int xmlInt(const pugi::xml_node& node, const char* name, int fallback = -1) {
     }
 }
 
-bool statusOnline(const std::string& status) {
+std::optional<unsigned int> parseUnsigned(std::string_view text) {
+    unsigned int value = 0;
+    while (!text.empty() && (text.front() == ' ' || text.front() == '"')) {
+        text.remove_prefix(1);
+    }
+    const auto [ptr, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || ptr == text.data()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+unsigned int registerExpiresOf(const SipMessage& message) {
+    if (const auto expires = parseUnsigned(message.headerView("Expires"))) {
+        return *expires;
+    }
+    const auto contact = message.headerView("Contact");
+    const auto param = contact.find(";expires=");
+    if (param != std::string_view::npos) {
+        if (const auto expires = parseUnsigned(contact.substr(param + 9))) {
+            return *expires;
+        }
+    }
+    return kDefaultRegisterExpiresSec;
+}
+
+bool statusOnline(std::string_view status) {
     return status == "ON" || status == "ONLINE" || status == "OK";
 }
 
@@ -335,6 +384,40 @@ bool wouldBlock() {
 #endif
 }
 
+// How to continue after a UDP send fails with the current socket error.
+enum class UdpSendFailure {
+    Interrupted,  // retry the same datagram now
+    Blocked,      // socket buffer full: wait until the socket is writable
+    NoBuffers,    // transient kernel shortage: retry after a short delay
+    Datagram,     // this datagram cannot be sent (EMSGSIZE, EINVAL, ...): skip it
+};
+
+UdpSendFailure classifyUdpSendFailure() {
+#ifdef _WIN32
+    const auto error = WSAGetLastError();
+    if (error == WSAEWOULDBLOCK) {
+        return UdpSendFailure::Blocked;
+    }
+    if (error == WSAEINTR) {
+        return UdpSendFailure::Interrupted;
+    }
+    if (error == WSAENOBUFS) {
+        return UdpSendFailure::NoBuffers;
+    }
+#else
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return UdpSendFailure::Blocked;
+    }
+    if (errno == EINTR) {
+        return UdpSendFailure::Interrupted;
+    }
+    if (errno == ENOBUFS) {
+        return UdpSendFailure::NoBuffers;
+    }
+#endif
+    return UdpSendFailure::Datagram;
+}
+
 void setNonBlocking(NativeSocket socket) {
 #ifdef _WIN32
     u_long mode = 1;
@@ -367,6 +450,25 @@ std::string socketAddressToIp(const sockaddr_in& address) {
     return buffer;
 }
 
+// Dialog traffic follows its Call-ID. Device-originated REGISTER and MESSAGE
+// follow the device ID instead, so registration, keepalive, catalog and record
+// state for one device always lands on the same worker.
+std::string routingKeyOf(const SipMessage& message) {
+    if (message.statusCode == 0 && message.method == "MESSAGE") {
+        const auto deviceId = ManscdpScanner::elementText(message.body, "DeviceID");
+        if (!deviceId.empty()) {
+            return std::string(deviceId);
+        }
+    }
+    if (message.statusCode == 0 && (message.method == "REGISTER" || message.method == "MESSAGE")) {
+        auto deviceId = extractUserFromSipUri(message.header("From"));
+        if (!deviceId.empty()) {
+            return deviceId;
+        }
+    }
+    return message.header("Call-ID");
+}
+
 class LoopDispatchAwaiter {
 public:
     using Work = std::function<void()>;
@@ -464,16 +566,58 @@ drogon::Task<> SipServer::startCoro() {
              << ", rtp_port_range=" << mediaConfig_.rtpPortRangeStart << "-" << mediaConfig_.rtpPortRangeEnd
              << ", zlm_base_url=" << mediaConfig_.zlmBaseUrl;
 
-    ioLoop_ = TcpLinkManager::instance().getNextIoLoop();
-    auto startWork = [this]() {
-        try {
+    auto workerCount = static_cast<std::size_t>(std::max(1U, sipConfig_.udpWorkers));
+#ifndef __linux__
+    if (workerCount > 1) {
+        LOG_WARN << "[GB28181][SIP] udp_workers=" << workerCount
+                 << " requires SO_REUSEPORT load balancing (Linux); using a single UDP worker";
+        workerCount = 1;
+    }
+#endif
+    const auto batchSize = std::clamp<std::size_t>(sipConfig_.udpBatchSize, 1, kMaxUdpBatch);
+
+    udpWorkers_.clear();
+    for (std::size_t i = 0; i < workerCount; ++i) {
+        auto worker = std::make_unique<UdpWorker>();
+        worker->index = i;
+        worker->loop = TcpLinkManager::instance().getNextIoLoop();
+        worker->recvBuffer.resize(batchSize * kMaxUdpDatagramSize);
+        worker->recvAddresses.resize(batchSize);
+        udpWorkers_.push_back(std::move(worker));
+    }
+    ioLoop_ = udpWorkers_.front()->loop;
+
+    std::exception_ptr startError;
+    try {
+        co_await LoopDispatchAwaiter(ioLoop_, [this]() {
             startInLoop();
-        } catch (...) {
-            running_.store(false);
-            throw;
+        });
+        for (const auto& worker : udpWorkers_) {
+            if (worker->loop == ioLoop_) {
+                continue;
+            }
+            auto* target = worker.get();
+            co_await LoopDispatchAwaiter(target->loop, [this, target]() {
+                startUdpWorkerInLoop(*target);
+            });
         }
-    };
-    co_await LoopDispatchAwaiter(ioLoop_, std::move(startWork));
+    } catch (...) {
+        startError = std::current_exception();
+    }
+
+    if (startError) {
+        for (const auto& worker : udpWorkers_) {
+            auto* target = worker.get();
+            co_await LoopDispatchAwaiter(target->loop, [this, target]() {
+                stopUdpWorkerInLoop(*target);
+            });
+        }
+        co_await LoopDispatchAwaiter(ioLoop_, [this]() {
+            stopInLoop();
+        });
+        running_.store(false);
+        std::rethrow_exception(startError);
+    }
 }
 
 void SipServer::stop() {
@@ -496,6 +640,15 @@ drogon::Task<> SipServer::stopCoro() {
     co_await LoopDispatchAwaiter(ioLoop_, [this]() {
         stopInLoop();
     });
+    for (const auto& worker : udpWorkers_) {
+        if (worker->loop == ioLoop_) {
+            continue;
+        }
+        auto* target = worker.get();
+        co_await LoopDispatchAwaiter(target->loop, [this, target]() {
+            stopUdpWorkerInLoop(*target);
+        });
+    }
 }
 
 void SipServer::startInLoop() {
@@ -503,26 +656,12 @@ void SipServer::startInLoop() {
         throw std::runtime_error("GB28181 SIP IO loop is not available");
     }
 
-    udpSocket_ = ::socket(AF_INET, SOCK_DGRAM, 0);
-    if (isInvalidSocket(udpSocket_)) {
-        throw std::runtime_error("Could not create GB28181 UDP socket: " + socketErrorMessage());
-    }
-    int reuse = 1;
-    ::setsockopt(udpSocket_, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
-    setNonBlocking(udpSocket_);
-
-    const auto udpAddress = makeSocketAddress(sipConfig_.host, sipConfig_.port);
-    if (::bind(udpSocket_, reinterpret_cast<const sockaddr*>(&udpAddress), sizeof(udpAddress)) != 0) {
-        const auto message = socketErrorMessage();
-        closeSocket(udpSocket_);
-        udpSocket_ = invalidSocket;
-        throw std::runtime_error("Could not bind GB28181 UDP socket: " + message);
+    for (const auto& worker : udpWorkers_) {
+        if (worker->loop == ioLoop_) {
+            startUdpWorkerInLoop(*worker);
+        }
     }
 
-    udpChannel_ = std::make_unique<trantor::Channel>(ioLoop_, static_cast<int>(udpSocket_));
-    udpChannel_->setReadCallback([this]() { handleUdpReadable(); });
-    udpChannel_->enableReading();
-
     const auto tcpAddress = trantor::InetAddress(sipConfig_.host, sipConfig_.port);
 #ifdef _WIN32
     tcpServer_ = std::make_shared<trantor::TcpServer>(ioLoop_, tcpAddress, "Gb28181SipTcpServer", true, false);
@@ -537,26 +676,18 @@ void SipServer::startInLoop() {
     });
     tcpServer_->start();
 
-    LOG_DEBUG << "[GB28181][SIP] UDP listening on " << sipConfig_.host << ":" << sipConfig_.port << " via TcpIoPool";
+    LOG_DEBUG << "[GB28181][SIP] UDP listening on " << sipConfig_.host << ":" << sipConfig_.port
+              << " via TcpIoPool, workers=" << udpWorkers_.size()
+              << ", batch=" << (udpWorkers_.empty() ? 0 : udpWorkers_.front()->recvAddresses.size());
     LOG_DEBUG << "[GB28181][SIP] TCP listening on " << sipConfig_.host << ":" << sipConfig_.port << " via TcpIoPool";
 }
 
 void SipServer::stopInLoop() {
-    std::size_t sessionCount = 0;
-    std::size_t viewerCount = 0;
-    {
-        std::lock_guard lock(sessionMutex_);
-        sessionCount = previewSessions_.size();
-        viewerCount = previewViewers_.size();
-    }
-
-    if (udpChannel_) {
-        udpChannel_->disableAll();
-        udpChannel_->remove();
-        udpChannel_.reset();
+    for (const auto& worker : udpWorkers_) {
+        if (worker->loop == ioLoop_) {
+            stopUdpWorkerInLoop(*worker);
+        }
     }
-    closeSocket(udpSocket_);
-    udpSocket_ = invalidSocket;
 
     if (tcpServer_) {
         tcpServer_->stop();
@@ -575,40 +706,150 @@ void SipServer::stopInLoop() {
         tcpConnections_.clear();
     }
 
-    LOG_DEBUG << "[GB28181][SIP] Stopped, active_sessions=" << sessionCount
-             << ", active_viewers=" << viewerCount
-             << ", tcp_connections=" << tcpConnectionCount;
+    LOG_DEBUG << "[GB28181][SIP] Stopped, tcp_connections=" << tcpConnectionCount;
 }
 
-void SipServer::handleUdpReadable() {
-    while (running_) {
-        std::array<char, 8192> buffer{};
-        sockaddr_in remoteAddress{};
-        SockLen remoteLength = sizeof(remoteAddress);
+void SipServer::startUdpWorkerInLoop(UdpWorker& worker) {
+    worker.socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (isInvalidSocket(worker.socket)) {
+        throw std::runtime_error("Could not create GB28181 UDP socket: " + socketErrorMessage());
+    }
+    int reuse = 1;
+    ::setsockopt(worker.socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+#ifdef __linux__
+    if (udpWorkers_.size() > 1
+        && ::setsockopt(worker.socket, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) != 0) {
+        const auto message = socketErrorMessage();
+        closeSocket(worker.socket);
+        worker.socket = invalidSocket;
+        throw std::runtime_error("Could not enable SO_REUSEPORT on GB28181 UDP socket: " + message);
+    }
+#endif
+    setNonBlocking(worker.socket);
+
+    const auto udpAddress = makeSocketAddress(sipConfig_.host, sipConfig_.port);
+    if (::bind(worker.socket, reinterpret_cast<const sockaddr*>(&udpAddress), sizeof(udpAddress)) != 0) {
+        const auto message = socketErrorMessage();
+        closeSocket(worker.socket);
+        worker.socket = invalidSocket;
+        throw std::runtime_error("Could not bind GB28181 UDP socket: " + message);
+    }
+
+    worker.channel = std::make_unique<trantor::Channel>(worker.loop, static_cast<int>(worker.socket));
+    worker.channel->setReadCallback([this, target = &worker]() { handleUdpReadable(*target); });
+    worker.channel->setWriteCallback([this, target = &worker]() { resumeUdpSends(*target); });
+    worker.channel->enableReading();
+
+    worker.deviceDeadlines.clear();
+    worker.catalogSessions.clear();
+    worker.deadlineTimerId = worker.loop->runEvery(1.0, [this, target = &worker]() {
+        target->deviceDeadlines.advance(DeviceDeadlineWheel::Clock::now(), [this, target](const std::string& deviceId, DeviceDeadlineWheel::Kind kind) {
+            handleDeviceDeadline(*target, deviceId, kind);
+        });
+        expireCatalogSessions(*target);
+    });
+    LOG_DEBUG << "[GB28181][SIP] UDP worker started, worker=" << worker.index;
+}
+
+void SipServer::stopUdpWorkerInLoop(UdpWorker& worker) {
+    if (worker.sendRetryTimerId != trantor::TimerId{0}) {
+        worker.loop->invalidateTimer(worker.sendRetryTimerId);
+        worker.sendRetryTimerId = trantor::TimerId{0};
+    }
+    if (worker.deadlineTimerId != trantor::TimerId{0}) {
+        worker.loop->invalidateTimer(worker.deadlineTimerId);
+        worker.deadlineTimerId = trantor::TimerId{0};
+    }
+    if (worker.channel) {
+        worker.channel->disableAll();
+        worker.channel->remove();
+        worker.channel.reset();
+    }
+    closeSocket(worker.socket);
+    worker.socket = invalidSocket;
+    worker.pendingSends.clear();
+    worker.flushQueued = false;
+    worker.sendBlocked = false;
+
+    LOG_DEBUG << "[GB28181][SIP] UDP worker stopped, worker=" << worker.index
+              << ", active_sessions=" << worker.previewSessions.size()
+              << ", active_viewers=" << worker.previewViewers.size();
+    worker.previewSessions.clear();
+    worker.previewViewers.clear();
+    worker.pendingRecordQueries.clear();
+    worker.deviceDeadlines.clear();
+    worker.catalogSessions.clear();
+}
+
+void SipServer::handleUdpReadable(UdpWorker& worker) {
+    const auto batchSize = worker.recvAddresses.size();
+    while (running_ && !isInvalidSocket(worker.socket)) {
+#ifdef __linux__
+        std::array<mmsghdr, kMaxUdpBatch> messages{};
+        std::array<iovec, kMaxUdpBatch> vectors{};
+        for (std::size_t i = 0; i < batchSize; ++i) {
+            vectors[i].iov_base = worker.recvBuffer.data() + i * kMaxUdpDatagramSize;
+            vectors[i].iov_len = kMaxUdpDatagramSize;
+            messages[i].msg_hdr.msg_name = &worker.recvAddresses[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        const auto received = ::recvmmsg(
+            worker.socket,
+            messages.data(),
+            static_cast<unsigned int>(batchSize),
+            MSG_DONTWAIT,
+            nullptr);
+        if (received < 0) {
+            if (!wouldBlock() && running_) {
+                LOG_LIMITED(kWarn, 1, 5) << "[GB28181][SIP] UDP receive failed: " << socketErrorMessage();
+            }
+            return;
+        }
+        const auto count = static_cast<std::size_t>(received);
+        const auto sizeOf = [&messages](std::size_t i) {
+            return static_cast<std::size_t>(messages[i].msg_len);
+        };
+#else
+        SockLen remoteLength = sizeof(sockaddr_in);
         const auto size = ::recvfrom(
-            udpSocket_,
-            buffer.data(),
-            static_cast<int>(buffer.size()),
+            worker.socket,
+            worker.recvBuffer.data(),
+            static_cast<int>(kMaxUdpDatagramSize),
             0,
-            reinterpret_cast<sockaddr*>(&remoteAddress),
+            reinterpret_cast<sockaddr*>(&worker.recvAddresses[0]),
             &remoteLength);
         if (size < 0) {
             if (!wouldBlock() && running_) {
-                LOG_WARN << "[GB28181][SIP] UDP receive failed: " << socketErrorMessage();
+                LOG_LIMITED(kWarn, 1, 5) << "[GB28181][SIP] UDP receive failed: " << socketErrorMessage();
             }
             return;
         }
+        const std::size_t count = 1;
+        const auto sizeOf = [size](std::size_t) {
+            return static_cast<std::size_t>(size);
+        };
+#endif
 
-        SipPeer peer;
-        peer.transport = SipTransport::Udp;
-        peer.udp = remoteAddress;
-        peer.address = socketAddressToIp(remoteAddress);
-        peer.port = ntohs(remoteAddress.sin_port);
-        if (sipConfig_.logging) {
-            LOG_DEBUG << "[GB28181][SIP][UDP_RX] remote=" << peerToString(peer)
-                      << ", bytes=" << size;
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto& remoteAddress = worker.recvAddresses[i];
+            SipPeer peer;
+            peer.transport = SipTransport::Udp;
+            peer.udp = remoteAddress;
+            peer.address = socketAddressToIp(remoteAddress);
+            peer.port = ntohs(remoteAddress.sin_port);
+            if (sipConfig_.logging) {
+                LOG_DEBUG << "[GB28181][SIP][UDP_RX] remote=" << peerToString(peer)
+                          << ", worker=" << worker.index
+                          << ", bytes=" << sizeOf(i);
+            }
+            dispatchPacket(std::string_view(worker.recvBuffer.data() + i * kMaxUdpDatagramSize, sizeOf(i)), peer);
+        }
+
+        if (count < batchSize) {
+            return;
         }
-        handlePacket(std::string(buffer.data(), static_cast<size_t>(size)), peer);
     }
 }
 
@@ -665,8 +906,8 @@ void SipServer::handleTcpMessage(const trantor::TcpConnectionPtr& connection, tr
         }
         const auto contentLength = contentLengthOf(context->pending.substr(0, headerEnd));
         if (!contentLength.has_value()) {
-            LOG_WARN << "[GB28181][SIP] TCP message with invalid Content-Length from " << key
-                     << ", header=\"" << compactForLog(context->pending.substr(0, headerEnd), 300) << "\"";
+            LOG_LIMITED(kWarn, 1, 5) << "[GB28181][SIP] TCP message with invalid Content-Length from " << key
+                                     << ", header=\"" << compactForLog(context->pending.substr(0, headerEnd), 300) << "\"";
             context->pending.clear();
             break;
         }
@@ -674,54 +915,73 @@ void SipServer::handleTcpMessage(const trantor::TcpConnectionPtr& connection, tr
         if (context->pending.size() < packetSize) {
             break;
         }
-        auto packet = context->pending.substr(0, packetSize);
+        dispatchPacket(std::string_view(context->pending).substr(0, packetSize), context->peer);
         context->pending.erase(0, packetSize);
-        handlePacket(packet, context->peer);
     }
 }
 
-void SipServer::handlePacket(const std::string& packet, const SipPeer& remote) {
+void SipServer::dispatchPacket(std::string_view packet, const SipPeer& remote) {
     const auto message = SipMessage::parse(packet);
     if (!message.has_value()) {
-        LOG_WARN << "[GB28181][SIP] Ignored malformed packet from " << transportName(remote.transport)
-                 << " " << peerToString(remote)
-                 << ", bytes=" << packet.size()
-                 << ", first_bytes=\"" << compactForLog(packet, 200) << "\"";
+        LOG_LIMITED(kWarn, 1, 5) << "[GB28181][SIP] Ignored malformed packet from " << transportName(remote.transport)
+                                 << " " << peerToString(remote)
+                                 << ", bytes=" << packet.size()
+                                 << ", first_bytes=\"" << compactForLog(packet, 200) << "\"";
         return;
     }
 
+    auto* owner = ownerOf(routingKeyOf(*message));
+    if (owner == nullptr) {
+        return;
+    }
+    if (owner->loop->isInLoopThread()) {
+        handlePacket(*owner, *message, packet.size(), remote);
+        return;
+    }
+    // The view points into the receive buffer; the owner re-parses its own copy.
+    owner->loop->queueInLoop([this, owner, data = std::string(packet), remote]() {
+        if (!running_) {
+            return;
+        }
+        if (const auto routed = SipMessage::parse(data)) {
+            handlePacket(*owner, *routed, data.size(), remote);
+        }
+    });
+}
+
+void SipServer::handlePacket(UdpWorker& worker, const SipMessage& message, std::size_t bytes, const SipPeer& remote) {
     if (sipConfig_.logging) {
-        logSipPacket("RX", *message, remote, packet.size(), true);
+        logSipPacket("RX", message, remote, bytes, true);
     }
 
-    if (message->statusCode > 0) {
-        handleResponse(*message, remote);
+    if (message.statusCode > 0) {
+        handleResponse(worker, message, remote);
         return;
     }
 
-    if (message->method == "REGISTER") {
-        handleRegister(*message, remote);
+    if (message.method == "REGISTER") {
+        handleRegister(worker, message, remote);
         return;
     }
 
-    if (message->method == "MESSAGE") {
-        handleMessage(*message, remote);
+    if (message.method == "MESSAGE") {
+        handleMessage(worker, message, remote);
         return;
     }
 
     if (sipConfig_.logging) {
-        LOG_WARN << "[GB28181][SIP] Unsupported method, method=" << message->method
+        LOG_WARN << "[GB28181][SIP] Unsupported method, method=" << message.method
                  << ", remote=" << transportName(remote.transport) << " " << peerToString(remote)
-                 << ", call_id=" << message->header("Call-ID")
-                 << ", cseq=\"" << message->header("CSeq") << "\"";
+                 << ", call_id=" << message.header("Call-ID")
+                 << ", cseq=\"" << message.header("CSeq") << "\"";
     }
-    sendResponse(*message, remote, 405, "Method Not Allowed");
+    sendResponse(worker, message, remote, 405, "Method Not Allowed");
 }
 
-void SipServer::handleResponse(const SipMessage& message, const SipPeer& remote) {
+void SipServer::handleResponse(UdpWorker& worker, const SipMessage& message, const SipPeer& remote) {
     const auto cseq = message.header("CSeq");
     if (message.statusCode == 200 && cseq.find("INVITE") != std::string::npos) {
-        handleInviteOk(message, remote);
+        handleInviteOk(worker, message, remote);
         return;
     }
 
@@ -741,7 +1001,7 @@ void SipServer::handleResponse(const SipMessage& message, const SipPeer& remote)
               << ", cseq=\"" << cseq << "\"";
 }
 
-void SipServer::handleInviteOk(const SipMessage& message, const SipPeer& remote) {
+void SipServer::handleInviteOk(UdpWorker& worker, const SipMessage& message, const SipPeer& remote) {
     const auto callId = message.header("Call-ID");
     if (callId.empty()) {
         LOG_WARN << "[GB28181][Invite] 200 OK without Call-ID from "
@@ -749,20 +1009,15 @@ void SipServer::handleInviteOk(const SipMessage& message, const SipPeer& remote)
         return;
     }
 
-    PreviewSession session;
-    bool found = false;
-    {
-        std::lock_guard lock(sessionMutex_);
-        for (auto& [_, candidate] : previewSessions_) {
-            if (candidate.callId == callId) {
-                session = candidate;
-                found = true;
-                break;
-            }
+    PreviewSession* found = nullptr;
+    for (auto& [_, candidate] : worker.previewSessions) {
+        if (candidate.callId == callId) {
+            found = &candidate;
+            break;
         }
     }
 
-    if (!found) {
+    if (found == nullptr) {
         LOG_WARN << "[GB28181][Invite] 200 OK for unknown Call-ID, call_id=" << callId
                  << ", remote=" << transportName(remote.transport) << " " << peerToString(remote)
                  << ", cseq=\"" << message.header("CSeq") << "\"";
@@ -772,6 +1027,9 @@ void SipServer::handleInviteOk(const SipMessage& message, const SipPeer& remote)
     const auto to = message.header("To");
     const auto cseq = extractCSeqNumber(message.header("CSeq"));
     const auto toTag = extractTag(to);
+    found->toTag = toTag;
+    found->established = true;
+    const auto session = *found;
     if (!message.body.empty()) {
         LOG_DEBUG << "[GB28181][Invite] 200 OK SDP received, session=" << session.sessionId
                  << ", mode=" << session.mode
@@ -781,16 +1039,6 @@ void SipServer::handleInviteOk(const SipMessage& message, const SipPeer& remote)
                  << ", call_id=" << callId
                  << ", body=\"" << compactForLog(message.body, 1200) << "\"";
     }
-    {
-        std::lock_guard lock(sessionMutex_);
-        for (auto& [_, candidate] : previewSessions_) {
-            if (candidate.callId == callId) {
-                candidate.toTag = toTag;
-                candidate.established = true;
-                break;
-            }
-        }
-    }
 
     const auto host = remote.address;
     const auto port = remote.port;
@@ -810,7 +1058,7 @@ void SipServer::handleInviteOk(const SipMessage& message, const SipPeer& remote)
         << "User-Agent: gb28181-platform-cpp\r\n"
         << "Content-Length: 0\r\n\r\n";
 
-    sendRequest(ack.str(), remote);
+    sendRequest(&worker, ack.str(), remote);
     LOG_DEBUG << "[GB28181][Invite] ACK sent, session=" << session.sessionId
              << ", mode=" << session.mode
              << ", device=" << session.deviceId
@@ -822,14 +1070,14 @@ void SipServer::handleInviteOk(const SipMessage& message, const SipPeer& remote)
              << ", remote=" << transportName(remote.transport) << " " << peerToString(remote);
 }
 
-void SipServer::handleRegister(const SipMessage& message, const SipPeer& remote) {
+void SipServer::handleRegister(UdpWorker& worker, const SipMessage& message, const SipPeer& remote) {
     if (!DigestAuth::verifyRegister(message, sipConfig_.domain, sipConfig_.password)) {
         const auto nonce = DigestAuth::makeNonce();
         std::ostringstream auth;
         auth << "WWW-Authenticate: Digest realm=\"" << sipConfig_.domain
              << "\", nonce=\"" << nonce
              << "\", algorithm=MD5, qop=\"auth\"\r\n";
-        sendResponse(message, remote, 401, "Unauthorized", auth.str());
+        sendResponse(worker, message, remote, 401, "Unauthorized", auth.str());
         if (sipConfig_.logging) {
             LOG_DEBUG << "[GB28181][Register] Auth challenge sent, device_hint="
                      << extractUserFromSipUri(message.header("From"))
@@ -848,29 +1096,150 @@ void SipServer::handleRegister(const SipMessage& message, const SipPeer& remote)
         deviceId = remote.address;
     }
 
-    deviceRegistry_.upsertRegistration(deviceId, peerToString(remote));
+    const auto expires = registerExpiresOf(message);
+    if (expires == 0) {
+        deviceRegistry_.markOffline(deviceId);
+        cancelDeviceDeadlines(deviceId);
+        LOG_INFO << "[GB28181][Register] Device unregistered, device=" << deviceId
+                 << ", remote=" << transportName(remote.transport) << " " << peerToString(remote)
+                 << ", call_id=" << message.header("Call-ID");
+        sendResponse(worker, message, remote, 200, "OK", "Expires: 0\r\n");
+        return;
+    }
+
+    const auto expiresAfter = std::chrono::seconds(expires);
+    deviceRegistry_.upsertRegistration(deviceId, peerToString(remote), "sip", std::chrono::system_clock::now() + expiresAfter);
+    armDeviceDeadline(deviceId, DeviceDeadlineWheel::Kind::Registration, expiresAfter + kRegistrationGrace);
+    armDeviceDeadline(deviceId, DeviceDeadlineWheel::Kind::Keepalive, std::chrono::seconds(sipConfig_.keepaliveTimeoutSec));
     LOG_INFO << "[GB28181][Register] Device registered, device=" << deviceId
              << ", remote=" << transportName(remote.transport) << " " << peerToString(remote)
              << ", contact=\"" << message.header("Contact") << "\""
-             << ", expires=\"" << message.header("Expires") << "\""
+             << ", expires=" << expires
              << ", call_id=" << message.header("Call-ID")
              << ", cseq=\"" << message.header("CSeq") << "\"";
 
-    sendResponse(message, remote, 200, "OK");
+    sendResponse(worker, message, remote, 200, "OK", "Expires: " + std::to_string(expires) + "\r\n");
 
     scheduleCatalogQuery(deviceId);
 }
 
-void SipServer::handleMessage(const SipMessage& message, const SipPeer& remote) {
-    sendResponse(message, remote, 200, "OK");
+void SipServer::handleKeepalive(const std::string& deviceId, std::string_view status, const SipPeer& remote) {
+    const auto online = statusOnline(status);
+    bool shouldQueryCatalog = false;
+    if (online) {
+        shouldQueryCatalog = deviceRegistry_.updateKeepaliveAndNeedsCatalog(deviceId, peerToString(remote));
+        armDeviceDeadline(deviceId, DeviceDeadlineWheel::Kind::Keepalive, std::chrono::seconds(sipConfig_.keepaliveTimeoutSec));
+        if (shouldQueryCatalog) {
+            scheduleCatalogQuery(deviceId);
+        }
+    } else {
+        deviceRegistry_.markOffline(deviceId);
+    }
+    LOG_DEBUG << "[GB28181][Keepalive] device=" << deviceId
+             << ", status=" << status
+             << ", online=" << online
+             << ", catalog_scheduled=" << shouldQueryCatalog
+             << ", remote=" << transportName(remote.transport) << " " << peerToString(remote);
+}
+
+void SipServer::armDeviceDeadline(const std::string& deviceId, DeviceDeadlineWheel::Kind kind, std::chrono::seconds timeout) {
+    if (timeout.count() <= 0) {
+        return;
+    }
+    const auto deadline = DeviceDeadlineWheel::Clock::now() + timeout;
+    runOnOwner(deviceId, [this, deviceId, kind, deadline](UdpWorker& worker) {
+        if (running_) {
+            worker.deviceDeadlines.arm(deviceId, kind, deadline);
+        }
+    });
+}
+
+void SipServer::cancelDeviceDeadlines(const std::string& deviceId) {
+    runOnOwner(deviceId, [deviceId](UdpWorker& worker) {
+        worker.deviceDeadlines.cancelAll(deviceId);
+    });
+}
+
+void SipServer::handleDeviceDeadline(UdpWorker& worker, const std::string& deviceId, DeviceDeadlineWheel::Kind kind) {
+    const auto now = std::chrono::system_clock::now();
+    if (kind == DeviceDeadlineWheel::Kind::Registration) {
+        if (deviceRegistry_.expireRegistration(deviceId, now)) {
+            worker.deviceDeadlines.cancel(deviceId, DeviceDeadlineWheel::Kind::Keepalive);
+            LOG_INFO << "[GB28181][Register] Registration expired, device=" << deviceId;
+        }
+        return;
+    }
+
+    const auto timeout = std::chrono::seconds(sipConfig_.keepaliveTimeoutSec);
+    if (deviceRegistry_.markOfflineIfIdle(deviceId, now - timeout)) {
+        LOG_INFO << "[GB28181][Keepalive] Keepalive timed out, device=" << deviceId
+                 << ", timeout_sec=" << sipConfig_.keepaliveTimeoutSec;
+        return;
+    }
+
+    // Catalog/record responses also refresh lastSeen without re-arming; keep
+    // watching the device from its latest activity.
+    bool online = false;
+    std::chrono::system_clock::time_point lastSeen{};
+    deviceRegistry_.visitDevice(deviceId, [&](const Device& device) {
+        online = device.online;
+        lastSeen = device.lastSeen;
+    });
+    if (online) {
+        const auto remaining = std::max(
+            std::chrono::duration_cast<std::chrono::seconds>(lastSeen + timeout - now),
+            std::chrono::seconds(1));
+        worker.deviceDeadlines.arm(deviceId, DeviceDeadlineWheel::Kind::Keepalive, DeviceDeadlineWheel::Clock::now() + remaining);
+    }
+}
+
+void SipServer::publishCatalog(CatalogSessionTracker::Completed catalog) {
+    std::size_t onlineCount = 0;
+    for (const auto& channel : catalog.channels) {
+        if (channel.online) {
+            ++onlineCount;
+        }
+    }
+    const auto channelCount = catalog.channels.size();
+    deviceRegistry_.updateCatalog(catalog.deviceId, std::move(catalog.channels));
+    LOG_DEBUG << "[GB28181][Catalog] Updated, device=" << catalog.deviceId
+             << ", sn=" << catalog.sn
+             << ", channels=" << channelCount
+             << ", sum_num=" << catalog.sumNum
+             << ", online_channels=" << onlineCount
+             << ", timed_out=" << catalog.timedOut;
+}
+
+void SipServer::expireCatalogSessions(UdpWorker& worker) {
+    for (auto& catalog : worker.catalogSessions.collectExpired(CatalogSessionTracker::Clock::now())) {
+        if (catalog.channels.empty()) {
+            LOG_WARN << "[GB28181][Catalog] Query timed out without response, device=" << catalog.deviceId
+                     << ", sn=" << catalog.sn;
+            continue;
+        }
+        LOG_WARN << "[GB28181][Catalog] Incomplete catalog published after timeout, device=" << catalog.deviceId
+                 << ", sn=" << catalog.sn
+                 << ", received=" << catalog.channels.size()
+                 << ", sum_num=" << catalog.sumNum;
+        publishCatalog(std::move(catalog));
+    }
+}
+
+void SipServer::handleMessage(UdpWorker& worker, const SipMessage& message, const SipPeer& remote) {
+    sendResponse(worker, message, remote, 200, "OK");
+
+    if (const auto keepalive = ManscdpScanner::scanKeepalive(message.body)) {
+        handleKeepalive(std::string(keepalive->deviceId), keepalive->status, remote);
+        return;
+    }
 
     pugi::xml_document document;
-    const auto result = document.load_string(message.body.c_str());
+    const auto result = document.load_buffer(message.body.data(), message.body.size());
     if (!result) {
-        LOG_WARN << "[GB28181][Message] Ignored invalid XML from " << transportName(remote.transport)
-                 << " " << peerToString(remote)
-                 << ", error=" << result.description()
-                 << ", body=\"" << compactForLog(message.body, 500) << "\"";
+        LOG_LIMITED(kWarn, 1, 5) << "[GB28181][Message] Ignored invalid XML from " << transportName(remote.transport)
+                                 << " " << peerToString(remote)
+                                 << ", error=" << result.description()
+                                 << ", body=\"" << compactForLog(message.body, 500) << "\"";
         return;
     }
 
@@ -878,9 +1247,9 @@ void SipServer::handleMessage(const SipMessage& message, const SipPeer& remote)
     const auto cmdType = xmlText(root, "CmdType");
     auto deviceId = xmlText(root, "DeviceID");
     if (deviceId.empty()) {
-        LOG_WARN << "[GB28181][Message] Ignored MESSAGE without DeviceID, cmd_type=" << cmdType
-                 << ", remote=" << transportName(remote.transport) << " " << peerToString(remote)
-                 << ", body=\"" << compactForLog(message.body, 500) << "\"";
+        LOG_LIMITED(kWarn, 1, 5) << "[GB28181][Message] Ignored MESSAGE without DeviceID, cmd_type=" << cmdType
+                                 << ", remote=" << transportName(remote.transport) << " " << peerToString(remote)
+                                 << ", body=\"" << compactForLog(message.body, 500) << "\"";
         return;
     }
     const auto snText = xmlText(root, "SN");
@@ -891,27 +1260,12 @@ void SipServer::handleMessage(const SipMessage& message, const SipPeer& remote)
              << ", body_bytes=" << message.body.size();
 
     if (cmdType == "Keepalive") {
-        const auto status = xmlText(root, "Status");
-        bool shouldQueryCatalog = false;
-        if (statusOnline(status)) {
-            shouldQueryCatalog = deviceRegistry_.updateKeepaliveAndNeedsCatalog(deviceId, peerToString(remote));
-            if (shouldQueryCatalog) {
-                scheduleCatalogQuery(deviceId);
-            }
-        } else {
-            deviceRegistry_.markOffline(deviceId);
-        }
-        LOG_DEBUG << "[GB28181][Keepalive] device=" << deviceId
-                 << ", status=" << status
-                 << ", online=" << statusOnline(status)
-                 << ", catalog_scheduled=" << shouldQueryCatalog
-                 << ", remote=" << transportName(remote.transport) << " " << peerToString(remote);
+        handleKeepalive(deviceId, xmlText(root, "Status"), remote);
         return;
     }
 
     if (cmdType == "Catalog") {
         std::vector<Channel> channels;
-        std::size_t onlineCount = 0;
         for (auto item : root.child("DeviceList").children("Item")) {
             Channel channel;
             channel.id = xmlText(item, "DeviceID");
@@ -920,25 +1274,33 @@ void SipServer::handleMessage(const SipMessage& message, const SipPeer& remote)
             channel.online = statusOnline(xmlText(item, "Status"));
             channel.ptzType = xmlInt(item, "PTZType");
             if (!channel.id.empty()) {
-                if (channel.online) {
-                    ++onlineCount;
-                }
                 LOG_DEBUG << "[GB28181][Catalog] Channel, device=" << deviceId
                           << ", channel=" << channel.id
                           << ", name=\"" << channel.name << "\""
                           << ", manufacturer=\"" << channel.manufacturer << "\""
                           << ", online=" << channel.online
                           << ", ptz_type=" << channel.ptzType;
-                channels.push_back(std::move(channel));
             }
+            // Empty-ID items still count toward SumNum; the tracker drops them on publish.
+            channels.push_back(std::move(channel));
         }
-        const auto channelCount = channels.size();
-        deviceRegistry_.updateCatalog(deviceId, std::move(channels));
-        LOG_DEBUG << "[GB28181][Catalog] Updated, device=" << deviceId
+        const auto partSize = channels.size();
+        const auto sumNum = xmlInt(root, "SumNum");
+        auto completed = worker.catalogSessions.addPart(
+            deviceId,
+            snText,
+            sumNum >= 0 ? std::optional<std::size_t>(static_cast<std::size_t>(sumNum)) : std::nullopt,
+            std::move(channels),
+            CatalogSessionTracker::Clock::now());
+        LOG_DEBUG << "[GB28181][Catalog] Part received, device=" << deviceId
                  << ", sn=" << snText
-                 << ", channels=" << channelCount
-                 << ", online_channels=" << onlineCount
+                 << ", items=" << partSize
+                 << ", sum_num=" << sumNum
+                 << ", complete=" << completed.has_value()
                  << ", remote=" << transportName(remote.transport) << " " << peerToString(remote);
+        if (completed.has_value()) {
+            publishCatalog(std::move(*completed));
+        }
         return;
     }
 
@@ -947,11 +1309,10 @@ void SipServer::handleMessage(const SipMessage& message, const SipPeer& remote)
         if (!snText.empty()) {
             try {
                 const auto sn = static_cast<unsigned int>(std::stoul(snText));
-                std::lock_guard lock(sessionMutex_);
-                const auto iter = pendingRecordQueries_.find(sn);
-                if (iter != pendingRecordQueries_.end()) {
+                const auto iter = worker.pendingRecordQueries.find(sn);
+                if (iter != worker.pendingRecordQueries.end()) {
                     deviceId = iter->second;
-                    pendingRecordQueries_.erase(iter);
+                    worker.pendingRecordQueries.erase(iter);
                 }
             } catch (...) {
             }
@@ -987,10 +1348,11 @@ void SipServer::handleMessage(const SipMessage& message, const SipPeer& remote)
         return;
     }
 
-    LOG_WARN << "[GB28181][Message] Unhandled CmdType, cmd_type=" << cmdType
-             << ", device=" << deviceId
-             << ", sn=" << snText
-             << ", remote=" << transportName(remote.transport) << " " << peerToString(remote);
+    LOG_DEVICE_LIMITED(kWarn, deviceId)
+        << "[GB28181][Message] Unhandled CmdType, cmd_type=" << cmdType
+        << ", device=" << deviceId
+        << ", sn=" << snText
+        << ", remote=" << transportName(remote.transport) << " " << peerToString(remote);
 }
 
 bool SipServer::queryCatalog(const std::string& deviceId) {
@@ -1021,40 +1383,48 @@ bool SipServer::queryCatalog(const std::string& deviceId) {
     }
 
     const auto sn = cseq_.fetch_add(1);
-    std::ostringstream body;
-    body << "<?xml version=\"1.0\" encoding=\"GB2312\"?>\r\n"
-         << "<Query>\r\n"
-         << "<CmdType>Catalog</CmdType>\r\n"
-         << "<SN>" << sn << "</SN>\r\n"
-         << "<DeviceID>" << deviceId << "</DeviceID>\r\n"
-         << "</Query>\r\n";
-
-    const auto bodyText = body.str();
-    const auto publicHost = sipConfig_.publicIp.empty() || sipConfig_.publicIp == "YOUR_PUBLIC_SERVER_IP" ? sipConfig_.host : sipConfig_.publicIp;
-    const auto branch = "z9hG4bK-" + makeToken("branch");
-    const auto tag = makeToken("tag");
-    const auto callId = makeToken("catalog") + "@" + sipConfig_.domain;
-
-    std::ostringstream request;
-    request << "MESSAGE sip:" << deviceId << "@" << endpoint->host << ":" << endpoint->port << " SIP/2.0\r\n"
-            << "Via: SIP/2.0/" << transportName(remote->transport) << " " << publicHost << ":" << sipConfig_.port << ";branch=" << branch << "\r\n"
-            << "From: <sip:" << sipConfig_.id << "@" << sipConfig_.domain << ">;tag=" << tag << "\r\n"
-            << "To: <sip:" << deviceId << "@" << sipConfig_.domain << ">\r\n"
-            << "Call-ID: " << callId << "\r\n"
-            << "CSeq: " << sn << " MESSAGE\r\n"
-            << "Max-Forwards: 70\r\n"
-            << "User-Agent: gb28181-platform-cpp\r\n"
-            << "Content-Type: Application/MANSCDP+xml\r\n"
-            << "Content-Length: " << bodyText.size() << "\r\n\r\n"
-            << bodyText;
-
-    sendRequest(request.str(), *remote);
-    LOG_DEBUG << "[GB28181][Catalog] Query sent, device=" << deviceId
-             << ", sn=" << sn
-             << ", call_id=" << callId
-             << ", branch=" << branch
-             << ", remote=" << transportName(remote->transport) << " " << peerToString(*remote)
-             << ", body_bytes=" << bodyText.size();
+    runOnOwner(deviceId, [this, deviceId, sn, endpoint = *endpoint, remote = *remote](UdpWorker& worker) {
+        if (!worker.catalogSessions.tryBegin(deviceId, std::to_string(sn), CatalogSessionTracker::Clock::now())) {
+            LOG_DEBUG << "[GB28181][Catalog] Query skipped, device=" << deviceId
+                     << ", reason=catalog_in_flight";
+            return;
+        }
+        std::ostringstream body;
+        body << "<?xml version=\"1.0\" encoding=\"GB2312\"?>\r\n"
+             << "<Query>\r\n"
+             << "<CmdType>Catalog</CmdType>\r\n"
+             << "<SN>" << sn << "</SN>\r\n"
+             << "<DeviceID>" << deviceId << "</DeviceID>\r\n"
+             << "</Query>\r\n";
+
+        const auto bodyText = body.str();
+        const auto publicHost = sipConfig_.publicIp.empty() || sipConfig_.publicIp == "YOUR_PUBLIC_SERVER_IP" ? sipConfig_.host : sipConfig_.publicIp;
+        const auto branch = "z9hG4bK-" + makeToken("branch");
+        const auto tag = makeToken("tag");
+        const auto callId = makeToken("catalog") + "@" + sipConfig_.domain;
+
+        std::ostringstream request;
+        request << "MESSAGE sip:" << deviceId << "@" << endpoint.host << ":" << endpoint.port << " SIP/2.0\r\n"
+                << "Via: SIP/2.0/" << transportName(remote.transport) << " " << publicHost << ":" << sipConfig_.port << ";branch=" << branch << "\r\n"
+                << "From: <sip:" << sipConfig_.id << "@" << sipConfig_.domain << ">;tag=" << tag << "\r\n"
+                << "To: <sip:" << deviceId << "@" << sipConfig_.domain << ">\r\n"
+                << "Call-ID: " << callId << "\r\n"
+                << "CSeq: " << sn << " MESSAGE\r\n"
+                << "Max-Forwards: 70\r\n"
+                << "User-Agent: gb28181-platform-cpp\r\n"
+                << "Content-Type: Application/MANSCDP+xml\r\n"
+                << "Content-Length: " << bodyText.size() << "\r\n\r\n"
+                << bodyText;
+
+        sendRequest(&worker, request.str(), remote);
+        LOG_DEBUG << "[GB28181][Catalog] Query sent, device=" << deviceId
+                 << ", sn=" << sn
+                 << ", call_id=" << callId
+                 << ", branch=" << branch
+                 << ", worker=" << worker.index
+                 << ", remote=" << transportName(remote.transport) << " " << peerToString(remote)
+                 << ", body_bytes=" << bodyText.size();
+    });
     return true;
 }
 
@@ -1109,10 +1479,6 @@ bool SipServer::queryRecords(const std::string& deviceId, const std::string& cha
     const auto branch = "z9hG4bK-" + makeToken("record");
     const auto tag = makeToken("tag");
     const auto callId = makeToken("record") + "@" + sipConfig_.domain;
-    {
-        std::lock_guard lock(sessionMutex_);
-        pendingRecordQueries_[sn] = deviceId;
-    }
 
     std::ostringstream request;
     request << "MESSAGE sip:" << channelId << "@" << endpoint->host << ":" << endpoint->port << " SIP/2.0\r\n"
@@ -1127,7 +1493,11 @@ bool SipServer::queryRecords(const std::string& deviceId, const std::string& cha
             << "Content-Length: " << bodyText.size() << "\r\n\r\n"
             << bodyText;
 
-    sendRequest(request.str(), *remote);
+    // The RecordInfo response carries the channel as DeviceID, so the channel's worker owns the SN.
+    runOnOwner(channelId, [this, deviceId, sn, data = request.str(), remote = *remote](UdpWorker& worker) {
+        worker.pendingRecordQueries[sn] = deviceId;
+        sendRequest(&worker, data, remote);
+    });
     LOG_DEBUG << "[GB28181][Record] Query sent, device=" << deviceId
              << ", channel=" << channelId
              << ", sn=" << sn
@@ -1207,7 +1577,7 @@ bool SipServer::sendPtzControl(const std::string& deviceId, const std::string& c
             << "Content-Length: " << bodyText.size() << "\r\n\r\n"
             << bodyText;
 
-    sendRequest(request.str(), *remote);
+    sendRequest(ownerOf(deviceId), request.str(), *remote);
     LOG_DEBUG << "[GB28181][PTZ] Control sent, device=" << deviceId
              << ", channel=" << channelId
              << ", action=" << action
@@ -1295,7 +1665,7 @@ bool SipServer::sendPtzPreciseControl(
             << "Content-Length: " << bodyText.size() << "\r\n\r\n"
             << bodyText;
 
-    sendRequest(request.str(), *remote);
+    sendRequest(ownerOf(deviceId), request.str(), *remote);
     LOG_DEBUG << "[GB28181][PTZ] Precise control sent, device=" << deviceId
               << ", channel=" << channelId
               << ", pan=" << pan
@@ -1312,6 +1682,7 @@ bool SipServer::sendPtzPreciseControl(
 drogon::Task<std::optional<SipServer::PreviewStartResult>> SipServer::startPreviewCoro(const std::string& deviceId, const std::string& channelId) {
     LOG_DEBUG << "[GB28181][Preview] Start requested, device=" << deviceId
              << ", channel=" << channelId;
+    const auto startedAt = std::chrono::steady_clock::now();
 
     const auto route = deviceRegistry_.findRouteSnapshot(deviceId, channelId);
     const auto unavailableReason = routeUnavailableReason(route);
@@ -1347,9 +1718,9 @@ drogon::Task<std::optional<SipServer::PreviewStartResult>> SipServer::startPrevi
     }
 
     std::vector<std::string> staleSessionIds;
-    {
-        std::lock_guard lock(sessionMutex_);
-        for (auto& [_, session] : previewSessions_) {
+    std::optional<PreviewStartResult> reused;
+    co_await findInWorkers([&](UdpWorker& worker) {
+        for (auto& [_, session] : worker.previewSessions) {
             if (session.mode == "preview" && session.deviceId == deviceId && session.channelId == channelId) {
                 if (!session.mediaOnline) {
                     staleSessionIds.push_back(session.sessionId);
@@ -1357,14 +1728,14 @@ drogon::Task<std::optional<SipServer::PreviewStartResult>> SipServer::startPrevi
                 }
                 const auto viewerId = makeToken("viewer");
                 ++session.viewerCount;
-                previewViewers_[viewerId] = session.sessionId;
+                worker.previewViewers[viewerId] = session.sessionId;
                 LOG_DEBUG << "[GB28181][Preview] Stream reused, device=" << deviceId
                          << ", channel=" << channelId
                          << ", viewer_session=" << viewerId
                          << ", stream_session=" << session.sessionId
                          << ", stream_id=" << session.streamId
                          << ", viewers=" << session.viewerCount;
-                co_return PreviewStartResult{
+                reused = PreviewStartResult{
                     viewerId,
                     session.deviceId,
                     session.channelId,
@@ -1373,8 +1744,13 @@ drogon::Task<std::optional<SipServer::PreviewStartResult>> SipServer::startPrevi
                     session.rtpPort,
                     session.playUrls,
                 };
+                return true;
             }
         }
+        return false;
+    });
+    if (reused.has_value()) {
+        co_return reused;
     }
 
     for (const auto& staleSessionId : staleSessionIds) {
@@ -1394,6 +1770,13 @@ drogon::Task<std::optional<SipServer::PreviewStartResult>> SipServer::startPrevi
     const auto branch = "z9hG4bK-" + makeToken("branch");
     const auto fromTag = makeToken("tag");
     const auto callId = sessionId + "@" + sipConfig_.domain;
+    auto* owner = ownerOf(callId);
+    if (owner == nullptr) {
+        LOG_WARN << "[GB28181][Preview] Start skipped, device=" << deviceId
+                 << ", channel=" << channelId
+                 << ", reason=sip_not_running";
+        co_return std::nullopt;
+    }
     const auto nowMs = static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
     const auto ssrcNumber = 1000000000ULL + ((nowMs + cseq) % 899999999ULL);
     const auto ssrc = std::to_string(ssrcNumber);
@@ -1455,21 +1838,22 @@ drogon::Task<std::optional<SipServer::PreviewStartResult>> SipServer::startPrevi
     session.playUrls = rtpServer->playUrls;
     session.remote = *remote;
     session.viewerCount = 1;
+    session.startedAt = startedAt;
 
     const auto viewerId = makeToken("viewer");
 
-    {
-        std::lock_guard lock(sessionMutex_);
-        previewSessions_.emplace(sessionId, session);
-        previewViewers_.emplace(viewerId, sessionId);
-    }
+    // Store and send on the dialog's owner so its 200 OK cannot overtake the session.
+    co_await LoopDispatchAwaiter(owner->loop, [&]() {
+        owner->previewSessions.emplace(sessionId, session);
+        owner->previewViewers.emplace(viewerId, sessionId);
+        sendRequest(owner, request.str(), *remote);
+    });
     LOG_DEBUG << "[GB28181][Preview] Session stored, viewer_session=" << viewerId
              << ", stream_session=" << sessionId
              << ", stream_id=" << session.streamId
              << ", call_id=" << callId
-             << ", cseq=" << cseq;
-
-    sendRequest(request.str(), *remote);
+             << ", cseq=" << cseq
+             << ", worker=" << owner->index;
     LOG_DEBUG << "[GB28181][Preview] INVITE sent, device=" << deviceId
              << ", channel=" << channelId
              << ", viewer_session=" << viewerId
@@ -1481,6 +1865,7 @@ drogon::Task<std::optional<SipServer::PreviewStartResult>> SipServer::startPrevi
              << ", branch=" << branch
              << ", remote=" << transportName(remote->transport) << " " << peerToString(*remote)
              << ", sdp=\"" << compactForLog(bodyText, 700) << "\"";
+    previewStartLatency_.record(std::chrono::steady_clock::now() - startedAt);
 
     co_return PreviewStartResult{
         viewerId,
@@ -1494,27 +1879,52 @@ drogon::Task<std::optional<SipServer::PreviewStartResult>> SipServer::startPrevi
 }
 
 void SipServer::markStreamOnline(const std::string& streamId, bool online) {
-    std::lock_guard lock(sessionMutex_);
-    bool found = false;
-    for (auto& [_, session] : previewSessions_) {
-        if (session.streamId == streamId) {
-            found = true;
-            session.mediaOnline = online;
-            LOG_DEBUG << "[GB28181][Media] Session media state changed, session=" << session.sessionId
-                     << ", mode=" << session.mode
-                     << ", device=" << session.deviceId
-                     << ", channel=" << session.channelId
-                     << ", stream_id=" << streamId
-                     << ", online=" << online
-                     << ", viewers=" << session.viewerCount;
-        }
+    if (udpWorkers_.empty()) {
+        return;
     }
-    if (!found) {
-        LOG_DEBUG << "[GB28181][Media] Stream state ignored because session was not found, stream_id="
-                  << streamId << ", online=" << online;
+    // Sessions are spread across workers; the last worker to look reports a miss.
+    auto remaining = std::make_shared<std::atomic<std::size_t>>(udpWorkers_.size());
+    auto found = std::make_shared<std::atomic_bool>(false);
+    for (const auto& worker : udpWorkers_) {
+        auto* target = worker.get();
+        target->loop->runInLoop([this, target, streamId, online, remaining, found]() {
+            for (auto& [_, session] : target->previewSessions) {
+                if (session.streamId == streamId) {
+                    found->store(true);
+                    if (online && !session.mediaOnline && session.mode == "preview"
+                        && session.startedAt != std::chrono::steady_clock::time_point{}) {
+                        firstFrameLatency_.record(std::chrono::steady_clock::now() - session.startedAt);
+                    }
+                    session.mediaOnline = online;
+                    LOG_DEBUG << "[GB28181][Media] Session media state changed, session=" << session.sessionId
+                             << ", mode=" << session.mode
+                             << ", device=" << session.deviceId
+                             << ", channel=" << session.channelId
+                             << ", stream_id=" << streamId
+                             << ", online=" << online
+                             << ", viewers=" << session.viewerCount;
+                }
+            }
+            if (remaining->fetch_sub(1) == 1 && !found->load()) {
+                LOG_DEBUG << "[GB28181][Media] Stream state ignored because session was not found, stream_id="
+                          << streamId << ", online=" << online;
+            }
+        });
     }
 }
 
+void SipServer::releaseRtpPort(const std::string& streamId, std::optional<uint16_t> localPort) {
+    zlmClient_.releaseRtpPort(streamId, localPort);
+}
+
+SipServer::MediaStats SipServer::mediaStats() const {
+    return MediaStats{
+        previewStartLatency_.snapshot(),
+        firstFrameLatency_.snapshot(),
+        zlmClient_.portStats(),
+    };
+}
+
 drogon::Task<std::optional<SipServer::PreviewStartResult>> SipServer::startPlaybackCoro(const std::string& deviceId, const std::string& channelId, const std::string& startTime, const std::string& endTime) {
     LOG_DEBUG << "[GB28181][Playback] Start requested, device=" << deviceId
              << ", channel=" << channelId
@@ -1555,6 +1965,13 @@ drogon::Task<std::optional<SipServer::PreviewStartResult>> SipServer::startPlayb
     const auto branch = "z9hG4bK-" + makeToken("branch");
     const auto fromTag = makeToken("tag");
     const auto callId = sessionId + "@" + sipConfig_.domain;
+    auto* owner = ownerOf(callId);
+    if (owner == nullptr) {
+        LOG_WARN << "[GB28181][Playback] Start skipped, device=" << deviceId
+                 << ", channel=" << channelId
+                 << ", reason=sip_not_running";
+        co_return std::nullopt;
+    }
     const auto nowMs = static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
     const auto ssrcNumber = 2000000000ULL + ((nowMs + cseq) % 899999999ULL);
     const auto ssrc = std::to_string(ssrcNumber);
@@ -1629,12 +2046,10 @@ drogon::Task<std::optional<SipServer::PreviewStartResult>> SipServer::startPlayb
     session.remote = *remote;
     session.mode = "playback";
 
-    {
-        std::lock_guard lock(sessionMutex_);
-        previewSessions_[sessionId] = session;
-    }
-
-    sendRequest(request.str(), *remote);
+    co_await LoopDispatchAwaiter(owner->loop, [&]() {
+        owner->previewSessions[sessionId] = session;
+        sendRequest(owner, request.str(), *remote);
+    });
     LOG_DEBUG << "[GB28181][Playback] INVITE sent, device=" << deviceId
              << ", channel=" << channelId
              << ", session=" << sessionId
@@ -1660,21 +2075,20 @@ drogon::Task<std::optional<SipServer::PreviewStopResult>> SipServer::stopPreview
     LOG_DEBUG << "[GB28181][Preview] Stop requested, session=" << sessionId;
 
     PreviewSession session;
+    UdpWorker* owner = nullptr;
     std::string streamSessionId = sessionId;
-    {
-        std::lock_guard lock(sessionMutex_);
-        const auto viewerIter = previewViewers_.find(sessionId);
-        if (viewerIter != previewViewers_.end()) {
+    std::optional<PreviewStopResult> viewerReleased;
+    co_await findInWorkers([&](UdpWorker& worker) {
+        const auto viewerIter = worker.previewViewers.find(sessionId);
+        if (viewerIter != worker.previewViewers.end()) {
             streamSessionId = viewerIter->second;
-            previewViewers_.erase(viewerIter);
+            worker.previewViewers.erase(viewerIter);
         }
 
-        const auto iter = previewSessions_.find(streamSessionId);
-        if (iter == previewSessions_.end()) {
-            LOG_WARN << "[GB28181][Preview] Stop skipped, session=" << sessionId
-                     << ", resolved_stream_session=" << streamSessionId
-                     << ", reason=session_not_found";
-            co_return std::nullopt;
+        const auto iter = worker.previewSessions.find(streamSessionId);
+        if (iter == worker.previewSessions.end()) {
+            // A viewer always lives next to its stream session; stop looking once it was found.
+            return streamSessionId != sessionId;
         }
 
         if (iter->second.mode == "preview" && iter->second.viewerCount > 1 && streamSessionId != sessionId) {
@@ -1683,23 +2097,36 @@ drogon::Task<std::optional<SipServer::PreviewStopResult>> SipServer::stopPreview
                      << ", stream_session=" << streamSessionId
                      << ", stream_id=" << iter->second.streamId
                      << ", viewers=" << iter->second.viewerCount;
-            co_return PreviewStopResult{
+            viewerReleased = PreviewStopResult{
                 sessionId,
                 iter->second.streamId,
                 false,
                 false,
             };
+            return true;
         }
 
         session = iter->second;
-        for (auto viewer = previewViewers_.begin(); viewer != previewViewers_.end();) {
+        owner = &worker;
+        for (auto viewer = worker.previewViewers.begin(); viewer != worker.previewViewers.end();) {
             if (viewer->second == streamSessionId) {
-                viewer = previewViewers_.erase(viewer);
+                viewer = worker.previewViewers.erase(viewer);
             } else {
                 ++viewer;
             }
         }
-        previewSessions_.erase(iter);
+        worker.previewSessions.erase(iter);
+        return true;
+    });
+
+    if (viewerReleased.has_value()) {
+        co_return viewerReleased;
+    }
+    if (owner == nullptr) {
+        LOG_WARN << "[GB28181][Preview] Stop skipped, session=" << sessionId
+                 << ", resolved_stream_session=" << streamSessionId
+                 << ", reason=session_not_found";
+        co_return std::nullopt;
     }
 
     LOG_DEBUG << "[GB28181][Preview] Stream session removed, requested_session=" << sessionId
@@ -1732,7 +2159,7 @@ drogon::Task<std::optional<SipServer::PreviewStopResult>> SipServer::stopPreview
             << "User-Agent: gb28181-platform-cpp\r\n"
             << "Content-Length: 0\r\n\r\n";
 
-        sendRequest(bye.str(), session.remote);
+        sendRequest(owner, bye.str(), session.remote);
         byeSent = true;
         LOG_DEBUG << "[GB28181][Preview] BYE sent, session=" << streamSessionId
                  << ", mode=" << session.mode
@@ -1765,15 +2192,15 @@ drogon::Task<std::optional<SipServer::PreviewStopResult>> SipServer::stopPreview
     LOG_DEBUG << "[GB28181][Preview] Stop by stream requested, stream_id=" << streamId;
 
     std::string sessionId;
-    {
-        std::lock_guard lock(sessionMutex_);
-        for (const auto& [candidateSessionId, session] : previewSessions_) {
+    co_await findInWorkers([&](UdpWorker& worker) {
+        for (const auto& [candidateSessionId, session] : worker.previewSessions) {
             if (session.streamId == streamId) {
                 sessionId = candidateSessionId;
-                break;
+                return true;
             }
         }
-    }
+        return false;
+    });
 
     if (sessionId.empty()) {
         LOG_WARN << "[GB28181][Preview] Stop by stream skipped, stream_id=" << streamId
@@ -1795,7 +2222,7 @@ drogon::Task<bool> SipServer::forceCloseRtpServerCoro(const std::string& streamI
     co_return closed;
 }
 
-void SipServer::sendResponse(const SipMessage& request, const SipPeer& remote, int statusCode, const std::string& reason, const std::string& extraHeaders) {
+void SipServer::sendResponse(UdpWorker& worker, const SipMessage& request, const SipPeer& remote, int statusCode, const std::string& reason, const std::string& extraHeaders) {
     std::ostringstream response;
     response << "SIP/2.0 " << statusCode << ' ' << reason << "\r\n";
 
@@ -1826,7 +2253,7 @@ void SipServer::sendResponse(const SipMessage& request, const SipPeer& remote, i
     response << "Content-Length: 0\r\n\r\n";
 
     const auto data = response.str();
-    sendRequest(data, remote);
+    sendRequest(&worker, data, remote);
     if (sipConfig_.logging) {
         LOG_DEBUG << "[GB28181][SIP] Response sent, status=" << statusCode
                   << ", reason=\"" << reason << "\""
@@ -1836,12 +2263,11 @@ void SipServer::sendResponse(const SipMessage& request, const SipPeer& remote, i
     }
 }
 
-void SipServer::sendRequest(const std::string& request, const SipPeer& remote) {
+void SipServer::sendRequest(UdpWorker* worker, const std::string& request, const SipPeer& remote) {
     if (sipConfig_.logging) {
         logSipSend(request, remote, true);
     }
 
-    std::lock_guard lock(sendMutex_);
     if (remote.transport == SipTransport::Tcp) {
         if (!remote.tcp || !remote.tcp->connected()) {
             LOG_WARN << "[GB28181][SIP] TCP send failed: connection is closed, remote="
@@ -1856,30 +2282,178 @@ void SipServer::sendRequest(const std::string& request, const SipPeer& remote) {
         return;
     }
 
-    if (ioLoop_ == nullptr || isInvalidSocket(udpSocket_)) {
+    if (worker == nullptr || worker->loop == nullptr || isInvalidSocket(worker->socket)) {
         LOG_WARN << "[GB28181][SIP] UDP send failed: socket is not ready, remote="
                  << peerToString(remote);
         return;
     }
 
-    ioLoop_->queueInLoop([this, request, remoteAddress = remote.udp]() {
-        if (!running_ || isInvalidSocket(udpSocket_)) {
-            return;
+    worker->loop->runInLoop([this, worker, request, remoteAddress = remote.udp]() mutable {
+        queueUdpSend(*worker, std::move(request), remoteAddress);
+    });
+}
+
+SipServer::UdpWorker* SipServer::ownerOf(std::string_view key) {
+    if (udpWorkers_.empty()) {
+        return nullptr;
+    }
+    if (udpWorkers_.size() == 1) {
+        return udpWorkers_.front().get();
+    }
+    return udpWorkers_[std::hash<std::string_view>{}(key) % udpWorkers_.size()].get();
+}
+
+void SipServer::runOnOwner(std::string_view key, std::function<void(UdpWorker&)> work) {
+    auto* owner = ownerOf(key);
+    if (owner == nullptr || owner->loop == nullptr) {
+        return;
+    }
+    if (owner->loop->isInLoopThread()) {
+        work(*owner);
+        return;
+    }
+    owner->loop->queueInLoop([owner, work = std::move(work)]() {
+        work(*owner);
+    });
+}
+
+drogon::Task<bool> SipServer::findInWorkers(std::function<bool(UdpWorker&)> work) {
+    // One hop per worker; stops at the first worker whose state matched.
+    for (const auto& worker : udpWorkers_) {
+        auto* target = worker.get();
+        bool matched = false;
+        co_await LoopDispatchAwaiter(target->loop, [&]() {
+            matched = work(*target);
+        });
+        if (matched) {
+            co_return true;
         }
+    }
+    co_return false;
+}
+
+void SipServer::queueUdpSend(UdpWorker& worker, std::string data, const sockaddr_in& remote) {
+    if (!running_ || isInvalidSocket(worker.socket)) {
+        return;
+    }
+    if (worker.pendingSends.size() >= kMaxPendingUdpSends) {
+        LOG_LIMITED(kWarn, 1, 5) << "[GB28181][SIP] UDP send queue full, datagram dropped, worker=" << worker.index
+                                 << ", remote=" << socketAddressToIp(remote) << ":" << ntohs(remote.sin_port);
+        return;
+    }
+    worker.pendingSends.push_back(PendingUdpSend{std::move(data), remote});
+    // While blocked the writable callback (or retry timer) flushes the queue.
+    if (worker.flushQueued || worker.sendBlocked) {
+        return;
+    }
+    worker.flushQueued = true;
+    worker.loop->queueInLoop([this, target = &worker]() { flushUdpSends(*target); });
+}
+
+void SipServer::resumeUdpSends(UdpWorker& worker) {
+    if (worker.channel && worker.channel->isWriting()) {
+        worker.channel->disableWriting();
+    }
+    worker.sendRetryTimerId = trantor::TimerId{0};
+    worker.sendBlocked = false;
+    flushUdpSends(worker);
+}
+
+void SipServer::flushUdpSends(UdpWorker& worker) {
+    worker.flushQueued = false;
+    auto pending = std::move(worker.pendingSends);
+    worker.pendingSends.clear();
+    if (!running_ || isInvalidSocket(worker.socket) || pending.empty()) {
+        return;
+    }
+
+    std::size_t sentCount = 0;
+    std::size_t sentBytes = 0;
+    std::size_t failed = 0;
+    std::size_t offset = 0;
+    std::optional<UdpSendFailure> stalled;
+#ifdef __linux__
+    std::array<mmsghdr, kMaxUdpBatch> messages{};
+    std::array<iovec, kMaxUdpBatch> vectors{};
+#endif
+    while (offset < pending.size()) {
+#ifdef __linux__
+        const auto chunk = std::min(kMaxUdpBatch, pending.size() - offset);
+        for (std::size_t i = 0; i < chunk; ++i) {
+            auto& item = pending[offset + i];
+            vectors[i].iov_base = item.data.data();
+            vectors[i].iov_len = item.data.size();
+            messages[i] = mmsghdr{};
+            messages[i].msg_hdr.msg_name = &item.remote;
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        const auto sent = ::sendmmsg(worker.socket, messages.data(), static_cast<unsigned int>(chunk), 0);
+        if (sent > 0) {
+            for (int i = 0; i < sent; ++i) {
+                sentBytes += messages[i].msg_len;
+            }
+            sentCount += static_cast<std::size_t>(sent);
+            offset += static_cast<std::size_t>(sent);
+            continue;
+        }
+#else
+        const auto& item = pending[offset];
         const auto sent = ::sendto(
-            udpSocket_,
-            request.data(),
-            static_cast<int>(request.size()),
+            worker.socket,
+            item.data.data(),
+            static_cast<int>(item.data.size()),
             0,
-            reinterpret_cast<const sockaddr*>(&remoteAddress),
-            sizeof(remoteAddress));
-        if (sent < 0) {
-            LOG_WARN << "[GB28181][SIP] UDP send failed: " << socketErrorMessage();
-        } else if (sipConfig_.logging) {
-            LOG_DEBUG << "[GB28181][SIP][UDP_TX] bytes=" << sent;
+            reinterpret_cast<const sockaddr*>(&item.remote),
+            sizeof(item.remote));
+        if (sent >= 0) {
+            sentBytes += static_cast<std::size_t>(sent);
+            ++sentCount;
+            ++offset;
+            continue;
         }
-    });
+#endif
+        // sendmmsg reports the error of the first unsent datagram.
+        const auto failure = classifyUdpSendFailure();
+        if (failure == UdpSendFailure::Interrupted) {
+            continue;
+        }
+        if (failure == UdpSendFailure::Datagram) {
+            const auto& item = pending[offset];
+            LOG_LIMITED(kWarn, 1, 5) << "[GB28181][SIP] UDP datagram dropped: " << socketErrorMessage()
+                                     << ", remote=" << socketAddressToIp(item.remote) << ":" << ntohs(item.remote.sin_port)
+                                     << ", bytes=" << item.data.size();
+            ++failed;
+            ++offset;
+            continue;
+        }
+        stalled = failure;
+        break;
+    }
+
+    if (stalled.has_value()) {
+        // Keep the unsent tail in order; later sends queue behind it until resumeUdpSends().
+        pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(offset));
+        worker.pendingSends = std::move(pending);
+        worker.sendBlocked = true;
+        if (*stalled == UdpSendFailure::Blocked && worker.channel) {
+            worker.channel->enableWriting();
+        } else {
+            worker.sendRetryTimerId = worker.loop->runAfter(kUdpSendRetryDelaySec, [this, target = &worker]() {
+                resumeUdpSends(*target);
+            });
+        }
+    }
+    if (sipConfig_.logging) {
+        LOG_DEBUG << "[GB28181][SIP][UDP_TX] worker=" << worker.index
+                  << ", datagrams=" << sentCount
+                  << ", bytes=" << sentBytes
+                  << ", dropped=" << failed
+                  << ", queued=" << worker.pendingSends.size();
+    }
 }
+
 std::optional<SipServer::SipPeer> SipServer::peerFromAddress(const std::string& remoteAddress) const {
     const auto endpoint = parseRemoteEndpoint(remoteAddress);
     if (!endpoint.has_value()) {
@@ -1905,14 +2479,15 @@ std::optional<SipServer::SipPeer> SipServer::peerFromAddress(const std::string&
 }
 
 void SipServer::scheduleCatalogQuery(const std::string& deviceId) {
-    if (ioLoop_ == nullptr) {
+    auto* owner = ownerOf(deviceId);
+    if (owner == nullptr || owner->loop == nullptr) {
         LOG_WARN << "[GB28181][Catalog] Schedule skipped, device=" << deviceId
                  << ", reason=io_loop_unavailable";
         return;
     }
     LOG_DEBUG << "[GB28181][Catalog] Query scheduled, device=" << deviceId
              << ", delay_seconds=0.5";
-    ioLoop_->runAfter(0.5, [this, deviceId]() {
+    owner->loop->runAfter(0.5, [this, deviceId]() {
         if (!running_) {
             LOG_DEBUG << "[GB28181][Catalog] Scheduled query skipped, device=" << deviceId
                      << ", reason=server_stopped";
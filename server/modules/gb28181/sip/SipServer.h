@@ -1,22 +1,29 @@
 #pragma once
 
 #include "config/AppConfig.h"
+#include "device/CatalogSessionTracker.h"
+#include "device/DeviceDeadlineWheel.h"
 #include "device/DeviceRegistry.h"
+#include "media/LatencyHistogram.h"
 #include "media/ZlmClient.h"
 #include "sip/SipMessage.h"
 
 #include <atomic>
+#include <chrono>
 #include <drogon/drogon.h>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <string_view>
 #include <trantor/net/Channel.h>
 #include <trantor/net/EventLoop.h>
 #include <trantor/net/TcpConnection.h>
 #include <trantor/net/TcpServer.h>
 #include <trantor/utils/MsgBuffer.h>
 #include <unordered_map>
+#include <vector>
 
 #ifdef _WIN32
 #include <winsock2.h>
@@ -45,6 +52,12 @@ public:
         bool rtpServerClosed{false};
     };
 
+    struct MediaStats {
+        LatencyHistogram::Snapshot previewStart;
+        LatencyHistogram::Snapshot firstFrame;
+        ZlmClient::PortStats ports;
+    };
+
     SipServer(SipConfig sipConfig, MediaConfig mediaConfig, DeviceRegistry& deviceRegistry, ZlmClient& zlmClient);
     ~SipServer();
 
@@ -62,6 +75,8 @@ public:
     drogon::Task<std::optional<PreviewStopResult>> stopPreviewByStreamCoro(const std::string& streamId);
     drogon::Task<bool> forceCloseRtpServerCoro(const std::string& streamId);
     void markStreamOnline(const std::string& streamId, bool online);
+    void releaseRtpPort(const std::string& streamId, std::optional<uint16_t> localPort = std::nullopt);
+    MediaStats mediaStats() const;
 
     enum class SipTransport {
         Udp,
@@ -79,6 +94,19 @@ public:
     };
 
 private:
+#ifdef _WIN32
+    using UdpSocket = SOCKET;
+    static constexpr UdpSocket kInvalidUdpSocket = INVALID_SOCKET;
+#else
+    using UdpSocket = int;
+    static constexpr UdpSocket kInvalidUdpSocket = -1;
+#endif
+
+    struct PendingUdpSend {
+        std::string data;
+        sockaddr_in remote{};
+    };
+
     struct PreviewSession {
         std::string sessionId;
         std::string deviceId;
@@ -97,6 +125,37 @@ private:
         bool established{false};
         bool mediaOnline{false};
         unsigned int viewerCount{0};
+        std::chrono::steady_clock::time_point startedAt{};
+    };
+
+    // One UDP ingress loop and the SIP state it owns. With several workers
+    // every socket binds the SIP port with SO_REUSEPORT. A dialog belongs to
+    // ownerOf(Call-ID) and device state (deadlines, catalog sessions, record
+    // queries) to ownerOf(device ID); packets are handed to the owner before
+    // handling and every send for that dialog or device leaves through the
+    // owner's socket. All of it is only touched on the worker's own loop
+    // thread, so none of it needs a lock. When the socket buffer fills, the
+    // unsent tail stays queued (sendBlocked) until the channel is writable
+    // again or, after ENOBUFS, the retry timer fires.
+    struct UdpWorker {
+        std::size_t index{0};
+        trantor::EventLoop* loop{nullptr};
+        UdpSocket socket{kInvalidUdpSocket};
+        std::unique_ptr<trantor::Channel> channel;
+        std::vector<char> recvBuffer;
+        std::vector<sockaddr_in> recvAddresses;
+        std::vector<PendingUdpSend> pendingSends;
+        bool flushQueued{false};
+        bool sendBlocked{false};
+        trantor::TimerId sendRetryTimerId{0};
+        // Preview/playback dialogs keyed by stream session id, and viewer id -> stream session id.
+        std::map<std::string, PreviewSession> previewSessions;
+        std::map<std::string, std::string> previewViewers;
+        // RecordInfo SN -> queried device, owned by the queried channel's worker.
+        std::map<unsigned int, std::string> pendingRecordQueries;
+        DeviceDeadlineWheel deviceDeadlines;
+        trantor::TimerId deadlineTimerId{0};
+        CatalogSessionTracker catalogSessions;
     };
 
     SipConfig sipConfig_;
@@ -105,34 +164,42 @@ private:
     ZlmClient& zlmClient_;
     std::atomic_bool running_{false};
     trantor::EventLoop* ioLoop_{nullptr};
-    std::unique_ptr<trantor::Channel> udpChannel_;
+    std::vector<std::unique_ptr<UdpWorker>> udpWorkers_;
     std::shared_ptr<trantor::TcpServer> tcpServer_;
-#ifdef _WIN32
-    SOCKET udpSocket_{INVALID_SOCKET};
-#else
-    int udpSocket_{-1};
-#endif
-    std::mutex sendMutex_;
     mutable std::mutex tcpConnectionsMutex_;
-    std::mutex sessionMutex_;
     std::atomic_uint cseq_{1};
     std::unordered_map<std::string, TcpConnectionPtr> tcpConnections_;
-    std::map<std::string, PreviewSession> previewSessions_;
-    std::map<std::string, std::string> previewViewers_;
-    std::map<unsigned int, std::string> pendingRecordQueries_;
+    // API request -> INVITE sent, and API request -> first media (on_stream_changed).
+    LatencyHistogram previewStartLatency_;
+    LatencyHistogram firstFrameLatency_;
 
     void startInLoop();
     void stopInLoop();
-    void handleUdpReadable();
+    void startUdpWorkerInLoop(UdpWorker& worker);
+    void stopUdpWorkerInLoop(UdpWorker& worker);
+    void handleUdpReadable(UdpWorker& worker);
+    void queueUdpSend(UdpWorker& worker, std::string data, const sockaddr_in& remote);
+    void flushUdpSends(UdpWorker& worker);
+    void resumeUdpSends(UdpWorker& worker);
+    UdpWorker* ownerOf(std::string_view key);
+    void runOnOwner(std::string_view key, std::function<void(UdpWorker&)> work);
+    drogon::Task<bool> findInWorkers(std::function<bool(UdpWorker&)> work);
     void handleTcpConnection(const TcpConnectionPtr& connection);
     void handleTcpMessage(const TcpConnectionPtr& connection, trantor::MsgBuffer* buffer);
-    void handlePacket(const std::string& packet, const SipPeer& remote);
-    void handleRegister(const SipMessage& message, const SipPeer& remote);
-    void handleMessage(const SipMessage& message, const SipPeer& remote);
-    void handleResponse(const SipMessage& message, const SipPeer& remote);
-    void handleInviteOk(const SipMessage& message, const SipPeer& remote);
-    void sendResponse(const SipMessage& request, const SipPeer& remote, int statusCode, const std::string& reason, const std::string& extraHeaders = {});
-    void sendRequest(const std::string& request, const SipPeer& remote);
+    void dispatchPacket(std::string_view packet, const SipPeer& remote);
+    void handlePacket(UdpWorker& worker, const SipMessage& message, std::size_t bytes, const SipPeer& remote);
+    void handleRegister(UdpWorker& worker, const SipMessage& message, const SipPeer& remote);
+    void handleMessage(UdpWorker& worker, const SipMessage& message, const SipPeer& remote);
+    void handleKeepalive(const std::string& deviceId, std::string_view status, const SipPeer& remote);
+    void armDeviceDeadline(const std::string& deviceId, DeviceDeadlineWheel::Kind kind, std::chrono::seconds timeout);
+    void cancelDeviceDeadlines(const std::string& deviceId);
+    void handleDeviceDeadline(UdpWorker& worker, const std::string& deviceId, DeviceDeadlineWheel::Kind kind);
+    void publishCatalog(CatalogSessionTracker::Completed catalog);
+    void expireCatalogSessions(UdpWorker& worker);
+    void handleResponse(UdpWorker& worker, const SipMessage& message, const SipPeer& remote);
+    void handleInviteOk(UdpWorker& worker, const SipMessage& message, const SipPeer& remote);
+    void sendResponse(UdpWorker& worker, const SipMessage& request, const SipPeer& remote, int statusCode, const std::string& reason, const std::string& extraHeaders = {});
+    void sendRequest(UdpWorker* worker, const std::string& request, const SipPeer& remote);
     std::optional<SipPeer> peerFromAddress(const std::string& remoteAddress) const;
     void scheduleCatalogQuery(const std::string& deviceId);
 };
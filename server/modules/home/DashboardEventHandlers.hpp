@@ -0,0 +1,69 @@
+#pragma once
+
+#include "DashboardStats.hpp"
+#include "common/domain/EventBus.hpp"
+#include "modules/alert/domain/Events.hpp"
+#include "modules/device/domain/Events.hpp"
+#include "modules/link/domain/Events.hpp"
+#include "modules/system/domain/Events.hpp"
+
+/**
+ * @brief 首页统计事件处理器
+ *
+ * 将领域事件折算为 DashboardStats 的计数增量：
+ * - 用户/角色/部门/设备/链路的创建、删除：精确 ±1
+ * - 菜单变更：首页只统计 page 类型菜单，事件不带类型，标记对账
+ * - 告警触发：活跃数、对应严重级别、今日新增 +1
+ * - 告警恢复/规则删除：标记对账
+ */
+class DashboardEventHandlers {
+public:
+    template<typename T = void> using Task = drogon::Task<T>;
+    using Counter = DashboardStats::Counter;
+
+    static void registerAll() {
+        auto& bus = EventBus::instance();
+
+        countLifecycle<UserCreated, UserDeleted>(bus, Counter::Users);
+        countLifecycle<RoleCreated, RoleDeleted>(bus, Counter::Roles);
+        countLifecycle<DepartmentCreated, DepartmentDeleted>(bus, Counter::Departments);
+        countLifecycle<DeviceCreated, DeviceDeleted>(bus, Counter::Devices);
+        countLifecycle<LinkCreated, LinkDeleted>(bus, Counter::Links);
+
+        markDirtyOn<MenuCreated>(bus);
+        markDirtyOn<MenuUpdated>(bus);
+        markDirtyOn<MenuDeleted>(bus);
+        markDirtyOn<AlertRuleDeleted>(bus);
+
+        bus.subscribe<AlertTriggered>([](const AlertTriggered& event) -> Task<void> {
+            DashboardStats::instance().onAlertTriggered(event.severity);
+            co_return;
+        });
+
+        bus.subscribe<AlertResolved>([](const AlertResolved&) -> Task<void> {
+            DashboardStats::instance().onAlertResolved();
+            co_return;
+        });
+    }
+
+private:
+    template<typename Created, typename Deleted>
+    static void countLifecycle(EventBus& bus, Counter counter) {
+        bus.subscribe<Created>([counter](const Created&) -> Task<void> {
+            DashboardStats::instance().add(counter, 1);
+            co_return;
+        });
+        bus.subscribe<Deleted>([counter](const Deleted&) -> Task<void> {
+            DashboardStats::instance().add(counter, -1);
+            co_return;
+        });
+    }
+
+    template<typename E>
+    static void markDirtyOn(EventBus& bus) {
+        bus.subscribe<E>([](const E&) -> Task<void> {
+            DashboardStats::instance().markDirty();
+            co_return;
+        });
+    }
+};
@@ -2,6 +2,7 @@
 
 #include "Home.Service.hpp"
 #include "common/utils/Response.hpp"
+#include "common/utils/ValidatorHelper.hpp"
 #include "common/filters/PermissionFilter.hpp"
 
 /**
@@ -25,6 +26,8 @@ public:
     ADD_METHOD_TO(HomeController::systemInfo, "/api/home/system", Get, "AuthFilter");
     ADD_METHOD_TO(HomeController::clearCache, "/api/home/cache/clear", Post, "AuthFilter");
     ADD_METHOD_TO(HomeController::monitor, "/api/home/monitor", Get, "AuthFilter");
+    ADD_METHOD_TO(HomeController::monitorHistory, "/api/home/monitor/history", Get, "AuthFilter");
+    ADD_METHOD_TO(HomeController::memory, "/api/home/memory", Get, "AuthFilter");
     METHOD_LIST_END
 
     /**
@@ -84,4 +87,32 @@ public:
         auto data = co_await service_.getMonitorData();
         co_return Response::ok(data);
     }
+
+    /**
+     * @brief 获取监控历史采样
+     * @param window 时间窗口（秒），默认 3600
+     */
+    Task<HttpResponsePtr> monitorHistory(HttpRequestPtr req) {
+        co_await PermissionChecker::checkPermission(
+            req->attributes()->get<int>("userId"),
+            {"home:dashboard:query"}
+        );
+
+        int window = std::clamp(ValidatorHelper::getIntParam(req, "window", 3600), 1, 86400 * 7);
+        co_return Response::ok(service_.getMonitorHistory(window));
+    }
+
+    /**
+     * @brief 获取内存占用
+     * @param detail 非 0 时附带 mimalloc 统计报告（各线程堆、页复用等）
+     */
+    Task<HttpResponsePtr> memory(HttpRequestPtr req) {
+        co_await PermissionChecker::checkPermission(
+            req->attributes()->get<int>("userId"),
+            {"home:dashboard:query"}
+        );
+
+        bool detail = ValidatorHelper::getIntParam(req, "detail", 0) != 0;
+        co_return Response::ok(service_.getMemoryData(detail));
+    }
 };
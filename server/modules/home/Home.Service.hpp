@@ -1,36 +1,22 @@
 #pragma once
 
-#include "common/database/DatabaseService.hpp"
+#include "common/database/PreparedStatements.hpp"
 #include "common/cache/AuthCache.hpp"
 #include "common/cache/DeviceCache.hpp"
+#include "common/cache/DeviceVisibilityIndex.hpp"
 #include "common/cache/RealtimeDataCache.hpp"
 #include "common/cache/ResourceVersion.hpp"
+#include "common/cache/TreeCache.hpp"
 #include "common/cache/DeviceConnectionCache.hpp"
+#include "common/edgenode/AgentBridgeManager.hpp"
 #include "common/network/TcpLinkManager.hpp"
 #include "common/network/WebSocketManager.hpp"
 #include "common/protocol/ProtocolDispatcher.hpp"
 #include "common/utils/Constants.hpp"
-
-#ifdef _MSC_VER
-#include <psapi.h>
-#pragma comment(lib, "psapi.lib")
-#elif defined(_WIN32)
-#include <psapi.h>
-#elif defined(__APPLE__)
-#include <mach/mach.h>
-#include <mach/mach_host.h>
-#include <mach/task_info.h>
-#include <stdlib.h>
-#include <sys/statvfs.h>
-#include <sys/sysctl.h>
-#include <sys/utsname.h>
-#include <unistd.h>
-#else
-#include <stdlib.h>
-#include <sys/statvfs.h>
-#include <sys/utsname.h>
-#include <unistd.h>
-#endif
+#include "common/utils/MemoryMonitor.hpp"
+#include "modules/home/DashboardStats.hpp"
+#include "modules/home/MonitorSampler.hpp"
+#include "modules/home/SystemMetrics.hpp"
 
 /**
  * @brief 首页业务服务层
@@ -39,7 +25,7 @@
  */
 class HomeService {
 private:
-    DatabaseService db_;
+    DatabaseService db_{DbWorkload::Reporting};
     AuthCache authCache_;
 
 public:
@@ -49,191 +35,10 @@ public:
     // ==================== 统计数据 ====================
 
     /**
-     * @brief 获取首页统计数据
+     * @brief 获取首页统计数据（内存快照，由 DashboardStats 维护）
      */
     Task<Json::Value> getStats() {
-        // 合并所有统计查询为单条 SQL（减少 DB 往返）
-        auto result = co_await db_.execSqlCoro(R"(
-            SELECT
-                (SELECT COUNT(*) FROM sys_user WHERE deleted_at IS NULL) AS user_count,
-                (SELECT COUNT(*) FROM sys_role WHERE deleted_at IS NULL) AS role_count,
-                (SELECT COUNT(*) FROM sys_menu WHERE deleted_at IS NULL AND type = 'page') AS menu_count,
-                (SELECT COUNT(*) FROM sys_department WHERE deleted_at IS NULL) AS dept_count,
-                (SELECT COUNT(*) FROM device WHERE deleted_at IS NULL) AS device_count,
-                (SELECT COUNT(*) FROM link WHERE deleted_at IS NULL) AS link_count,
-                (SELECT COUNT(*) FROM alert_record WHERE status = 'active') AS active_alert_count,
-                (SELECT COUNT(*) FROM alert_record WHERE status = 'active' AND severity = 'critical') AS critical_alert_count,
-                (SELECT COUNT(*) FROM alert_record WHERE status = 'active' AND severity = 'warning') AS warning_alert_count,
-                (SELECT COUNT(*) FROM alert_record WHERE status = 'active' AND severity = 'info') AS info_alert_count,
-                (SELECT COUNT(*) FROM alert_record WHERE created_at >= date_trunc('day', now())) AS today_new_alert_count,
-                (SELECT COUNT(*) FROM alert_record WHERE status = 'resolved' AND resolved_at >= date_trunc('day', now())) AS today_resolved_alert_count
-        )");
-
-        Json::Value data;
-        data["userCount"] = result[0]["user_count"].as<int>();
-        data["roleCount"] = result[0]["role_count"].as<int>();
-        data["menuCount"] = result[0]["menu_count"].as<int>();
-        data["departmentCount"] = result[0]["dept_count"].as<int>();
-        data["deviceCount"] = result[0]["device_count"].as<int>();
-        data["linkCount"] = result[0]["link_count"].as<int>();
-        data["activeAlertCount"] = result[0]["active_alert_count"].as<int>();
-        data["criticalAlertCount"] = result[0]["critical_alert_count"].as<int>();
-        data["warningAlertCount"] = result[0]["warning_alert_count"].as<int>();
-        data["infoAlertCount"] = result[0]["info_alert_count"].as<int>();
-        data["todayNewAlertCount"] = result[0]["today_new_alert_count"].as<int>();
-        data["todayResolvedAlertCount"] = result[0]["today_resolved_alert_count"].as<int>();
-
-        // 今日数据量：优先从连续聚合读取，回退到直接 COUNT
-        // 注意：MSVC 不支持 catch 块中使用 co_await，用标志位重构
-        bool useFallbackCount = false;
-        try {
-            auto todayResult = co_await db_.execSqlCoro(R"(
-                SELECT COALESCE(SUM(record_count), 0) AS today_count
-                FROM device_data_hourly
-                WHERE bucket >= date_trunc('day', now())
-            )");
-            data["todayDataCount"] = static_cast<Json::Int64>(todayResult[0]["today_count"].as<int64_t>());
-        } catch (...) {
-            useFallbackCount = true;
-        }
-        if (useFallbackCount) {
-            // 连续聚合不可用，回退到直接查询
-            auto todayResult = co_await db_.execSqlCoro(R"(
-                SELECT COUNT(*) AS today_count
-                FROM device_data
-                WHERE report_time >= date_trunc('day', now())
-            )");
-            data["todayDataCount"] = static_cast<Json::Int64>(todayResult[0]["today_count"].as<int64_t>());
-        }
-
-        // P0: 合并 3 个热点分析查询为单条 CTE（3 次 DB 往返 → 1 次）
-        auto hotspotResult = co_await db_.execSqlCoro(R"(
-            WITH top_devices AS (
-                SELECT d.name AS device_name, COUNT(*) AS alert_count
-                FROM alert_record r
-                JOIN device d ON r.device_id = d.id
-                WHERE r.triggered_at >= NOW() - INTERVAL '7 days'
-                  AND d.deleted_at IS NULL
-                GROUP BY d.name
-                ORDER BY alert_count DESC
-                LIMIT 3
-            ),
-            top_rules AS (
-                SELECT ar.name AS rule_name, COUNT(*) AS alert_count
-                FROM alert_record r
-                JOIN alert_rule ar ON r.rule_id = ar.id
-                WHERE r.triggered_at >= NOW() - INTERVAL '7 days'
-                  AND ar.deleted_at IS NULL
-                GROUP BY ar.name
-                ORDER BY alert_count DESC
-                LIMIT 3
-            ),
-            top_failures AS (
-                SELECT d.name AS device_name,
-                       COUNT(DISTINCT DATE(dd.report_time)) AS online_days,
-                       LEAST(30, GREATEST(1, EXTRACT(EPOCH FROM NOW() - d.created_at) / 86400))::int AS total_days
-                FROM device d
-                LEFT JOIN device_data dd ON d.id = dd.device_id
-                  AND dd.report_time >= GREATEST(d.created_at, NOW() - INTERVAL '30 days')
-                WHERE d.deleted_at IS NULL
-                GROUP BY d.id, d.name, d.created_at
-                HAVING COUNT(dd.id) > 0
-                ORDER BY COUNT(DISTINCT DATE(dd.report_time))::float
-                       / LEAST(30, GREATEST(1, EXTRACT(EPOCH FROM NOW() - d.created_at) / 86400)) ASC
-                LIMIT 5
-            )
-            SELECT 'device' AS source, device_name AS name, alert_count AS count, 0 AS online_days, 0 AS total_days FROM top_devices
-            UNION ALL
-            SELECT 'rule' AS source, rule_name AS name, alert_count AS count, 0 AS online_days, 0 AS total_days FROM top_rules
-            UNION ALL
-            SELECT 'failure' AS source, device_name AS name, 0 AS count, online_days, total_days FROM top_failures
-        )");
-
-        Json::Value topDevices(Json::arrayValue);
-        Json::Value topRules(Json::arrayValue);
-        Json::Value topFailures(Json::arrayValue);
-        for (const auto& row : hotspotResult) {
-            std::string source = row["source"].as<std::string>();
-            if (source == "device") {
-                Json::Value item;
-                item["deviceName"] = row["name"].as<std::string>();
-                item["count"] = row["count"].as<int>();
-                topDevices.append(item);
-            } else if (source == "rule") {
-                Json::Value item;
-                item["ruleName"] = row["name"].as<std::string>();
-                item["count"] = row["count"].as<int>();
-                topRules.append(item);
-            } else if (source == "failure") {
-                Json::Value item;
-                item["deviceName"] = row["name"].as<std::string>();
-                int onlineDays = row["online_days"].as<int>();
-                int totalDays = std::max(1, row["total_days"].as<int>());
-                item["onlineDays"] = onlineDays;
-                item["uptimeRate"] = std::min(100.0, (static_cast<double>(onlineDays) / totalDays) * 100.0);
-                topFailures.append(item);
-            }
-        }
-        data["topAlertDevices"] = topDevices;
-        data["topAlertRules"] = topRules;
-        data["topFailureDevices"] = topFailures;
-
-        // P1: 数据趋势 - 近7天每日数据量
-        bool useTrendFallback = false;
-        try {
-            auto dataTrend = co_await db_.execSqlCoro(R"(
-                SELECT DATE(bucket) AS day,
-                       SUM(record_count) AS daily_count
-                FROM device_data_hourly
-                WHERE bucket >= date_trunc('day', now()) - INTERVAL '6 days'
-                GROUP BY DATE(bucket)
-                ORDER BY day ASC
-            )");
-            Json::Value trend(Json::arrayValue);
-            for (const auto& row : dataTrend) {
-                Json::Value item;
-                item["date"] = row["day"].as<std::string>();
-                item["count"] = static_cast<Json::Int64>(row["daily_count"].as<int64_t>());
-                trend.append(item);
-            }
-            data["dataGrowthTrend"] = trend;
-        } catch (...) {
-            useTrendFallback = true;
-        }
-        if (useTrendFallback) {
-            // 回退到直接 COUNT
-            auto dataTrend = co_await db_.execSqlCoro(R"(
-                SELECT DATE(report_time) AS day,
-                       COUNT(*) AS daily_count
-                FROM device_data
-                WHERE report_time >= date_trunc('day', now()) - INTERVAL '6 days'
-                GROUP BY DATE(report_time)
-                ORDER BY day ASC
-            )");
-            Json::Value trend(Json::arrayValue);
-            for (const auto& row : dataTrend) {
-                Json::Value item;
-                item["date"] = row["day"].as<std::string>();
-                item["count"] = static_cast<Json::Int64>(row["daily_count"].as<int64_t>());
-                trend.append(item);
-            }
-            data["dataGrowthTrend"] = trend;
-        }
-
-        // P1: 容量预测 - 磁盘增长速率（基于数据库大小变化）
-        auto diskGrowth = co_await db_.execSqlCoro(R"(
-            SELECT pg_database_size(current_database()) AS current_size
-        )");
-        int64_t currentDbSize = diskGrowth[0]["current_size"].as<int64_t>();
-        data["databaseSizeBytes"] = static_cast<Json::Int64>(currentDbSize);
-
-        // 简单估算：假设每天增长与今日数据量成正比
-        // 实际生产环境应该从历史记录中计算真实增长率
-        int64_t todayCount = data["todayDataCount"].asInt64();
-        int64_t estimatedDailyGrowthBytes = todayCount * 1000; // 假设每条数据约 1KB
-        data["estimatedDailyGrowthMB"] = static_cast<double>(estimatedDailyGrowthBytes) / (1024.0 * 1024.0);
-
-        co_return data;
+        co_return co_await DashboardStats::instance().getStats();
     }
 
     // ==================== 系统信息 ====================
@@ -284,7 +89,10 @@ public:
         // 清理认证相关缓存
         co_await authCache_.clearAllUserSessionsCache();
         co_await authCache_.clearAllUserRolesCache();
-        co_await authCache_.clearAllUserMenusCache();
+        co_await authCache_.deleteAllMenus();
+        authCache_.clearAllPermissionSnapshots();
+        DeviceVisibilityIndex::instance().clear();
+        TreeCache::instance().clear();
 
         // 清理设备缓存
         DeviceCache::instance().markStale();
@@ -300,27 +108,19 @@ public:
 
     /**
      * @brief 获取系统监控数据
+     *
+     * 链路汇总、pg_stat 指标、近 1 小时数据量取自 MonitorSampler 最新采样，不查询数据库。
      */
     Task<Json::Value> getMonitorData() {
         Json::Value data;
+        auto sample = MonitorSampler::instance().latest().value_or(MonitorSample{});
 
         // 1. TCP 链路状态
-        auto allStatus = TcpLinkManager::instance().getAllStatus();
-        int totalLinks = allStatus.size();
-        int activeLinks = 0;
-        int totalConnections = 0;
-        for (const auto& link : allStatus) {
-            auto connStatus = link["conn_status"].asString();
-            if (connStatus == "listening" || connStatus == "connected" || connStatus == "partial") {
-                activeLinks++;
-            }
-            totalConnections += link["client_count"].asInt();
-        }
         auto tcpStats = TcpLinkManager::instance().getTcpStats();
         Json::Value tcp;
-        tcp["totalLinks"] = totalLinks;
-        tcp["activeLinks"] = activeLinks;
-        tcp["totalConnections"] = totalConnections;
+        tcp["totalLinks"] = sample.totalLinks;
+        tcp["activeLinks"] = sample.activeLinks;
+        tcp["totalConnections"] = sample.totalConnections;
         tcp["bytesRx"] = static_cast<Json::Int64>(tcpStats.bytesRx);
         tcp["bytesTx"] = static_cast<Json::Int64>(tcpStats.bytesTx);
         tcp["packetsRx"] = static_cast<Json::Int64>(tcpStats.packetsRx);
@@ -333,47 +133,23 @@ public:
         ws["onlineUsers"] = static_cast<int>(WebSocketManager::instance().onlineUserCount());
         data["websocket"] = ws;
 
-        // 3. PostgreSQL 连接 + 性能状态
+        // 3. PostgreSQL 连接 + 性能状态（后台采样，主库统计）
         Json::Value pg;
-        bool pgOk = true;
-        try {
-            auto connResult = co_await db_.execSqlCoro(R"(
-                SELECT
-                    (SELECT count(*) FROM pg_stat_activity
-                     WHERE state = 'active') AS active_connections,
-                    (SELECT count(*) FROM pg_stat_activity
-                     WHERE state = 'idle') AS idle_connections,
-                    (SELECT setting::int FROM pg_settings
-                     WHERE name = 'max_connections') AS max_connections,
-                    (SELECT ROUND(
-                        sum(heap_blks_hit)::numeric / NULLIF(sum(heap_blks_hit) + sum(heap_blks_read), 0) * 100, 2
-                    ) FROM pg_statio_user_tables) AS cache_hit_ratio,
-                    (SELECT xact_commit FROM pg_stat_database
-                     WHERE datname = current_database()) AS xact_commit,
-                    (SELECT xact_rollback FROM pg_stat_database
-                     WHERE datname = current_database()) AS xact_rollback,
-                    (SELECT pg_size_pretty(pg_database_size(current_database()))) AS db_size
-            )");
-            pg["activeConnections"] = connResult[0]["active_connections"].as<int>();
-            pg["idleConnections"] = connResult[0]["idle_connections"].as<int>();
-            pg["maxConnections"] = connResult[0]["max_connections"].as<int>();
-            if (!connResult[0]["cache_hit_ratio"].isNull()) {
-                pg["cacheHitRatio"] = connResult[0]["cache_hit_ratio"].as<double>();
-            } else {
-                pg["cacheHitRatio"] = 0.0;
-            }
-            pg["xactCommit"] = static_cast<Json::Int64>(connResult[0]["xact_commit"].as<int64_t>());
-            pg["xactRollback"] = static_cast<Json::Int64>(connResult[0]["xact_rollback"].as<int64_t>());
-            pg["databaseSize"] = connResult[0]["db_size"].as<std::string>();
-        } catch (...) {
-            pgOk = false;
-        }
-        pg["status"] = pgOk ? "ok" : "error";
-        if (!pgOk) {
-            pg["activeConnections"] = 0;
-            pg["idleConnections"] = 0;
-            pg["maxConnections"] = 0;
+        pg["status"] = sample.pgOk ? "ok" : "error";
+        pg["activeConnections"] = sample.pgActiveConnections;
+        pg["idleConnections"] = sample.pgIdleConnections;
+        pg["maxConnections"] = sample.pgMaxConnections;
+        if (sample.pgOk) {
+            pg["cacheHitRatio"] = sample.pgCacheHitRatio;
+            pg["xactCommit"] = static_cast<Json::Int64>(sample.pgXactCommit);
+            pg["xactRollback"] = static_cast<Json::Int64>(sample.pgXactRollback);
+            pg["databaseSize"] = formatBytes(sample.pgDatabaseSizeBytes);
+            pg["commitsPerSec"] = sample.pgCommitsPerSec;
         }
+        pg["sampledAt"] = static_cast<Json::Int64>(sample.pgAtMs);
+        pg["pools"] = DbPoolMetrics::instance().toJson();
+        pg["statements"] = PreparedStatementRegistry::instance().toJson();
+        pg["replica"] = ReplicaRouter::instance().toJson();
         data["postgres"] = pg;
 
         // 5. 设备健康度统计
@@ -390,25 +166,13 @@ public:
             }
         }
 
-        // 来源2: 数据上报（5分钟内有写入 device_data 的设备）
-        auto deviceHealthResult = co_await db_.execSqlCoro(R"(
-            SELECT
-                (SELECT COUNT(*) FROM device WHERE deleted_at IS NULL) AS total_devices,
-                (SELECT COUNT(DISTINCT device_id) FROM device_data
-                 WHERE report_time < now() - interval '5 minutes'
-                   AND report_time >= now() - interval '1 hour') AS timeout_devices
-        )");
-        auto dataOnlineResult = co_await db_.execSqlCoro(R"(
-            SELECT DISTINCT device_id FROM device_data
-            WHERE report_time >= now() - interval '5 minutes'
-        )");
-        for (const auto& row : dataOnlineResult) {
-            onlineIds.insert(row["device_id"].as<int>());
-        }
+        // 来源2: 数据上报（5分钟内有写入 device_data 的设备，后台周期预计算）
+        auto health = co_await DashboardStats::instance().deviceHealth();
+        onlineIds.insert(health->dataOnlineIds.begin(), health->dataOnlineIds.end());
 
         // 合并两个来源：TCP 连接 ∪ 数据上报 = 在线设备
-        int totalDevices = deviceHealthResult[0]["total_devices"].as<int>();
-        int timeoutDevices = deviceHealthResult[0]["timeout_devices"].as<int>();
+        int totalDevices = DashboardStats::instance().count(DashboardStats::Counter::Devices);
+        int timeoutDevices = health->timeoutDevices;
         int onlineDevices = static_cast<int>(onlineIds.size());
         int offlineDevices = totalDevices - onlineDevices;
         double onlineRate = totalDevices > 0 ? (static_cast<double>(onlineDevices) / totalDevices * 100.0) : 0.0;
@@ -426,27 +190,8 @@ public:
         // 6. 协议处理统计 + 数据质量指标
         auto protoStats = ProtocolDispatcher::instance().getProtocolStats();
 
-        // 查询最近1小时数据量（优先使用连续聚合）
-        int64_t recentDataCount = 0;
-        bool useRecentFallback = false;
-        try {
-            auto recentResult = co_await db_.execSqlCoro(R"(
-                SELECT COALESCE(SUM(record_count), 0) AS recent_count
-                FROM device_data_hourly
-                WHERE bucket >= now() - interval '1 hour'
-            )");
-            recentDataCount = recentResult[0]["recent_count"].as<int64_t>();
-        } catch (...) {
-            useRecentFallback = true;
-        }
-        if (useRecentFallback) {
-            auto recentResult = co_await db_.execSqlCoro(R"(
-                SELECT COUNT(*) AS recent_count
-                FROM device_data
-                WHERE report_time >= now() - interval '1 hour'
-            )");
-            recentDataCount = recentResult[0]["recent_count"].as<int64_t>();
-        }
+        // 最近1小时数据量（后台采样）
+        int64_t recentDataCount = sample.recentDataCount;
 
         // 计算数据采集频率（条/分钟）
         double dataRatePerMin = static_cast<double>(recentDataCount) / 60.0;
@@ -466,6 +211,16 @@ public:
         protocol["batchFallbackRate"] = batchFallbackRate;
         data["protocol"] = protocol;
 
+        // 6a. Agent 状态/事件攒批写入队列
+        const auto agentWriterStats = AgentBridgeManager::instance().getStateWriterStats();
+        Json::Value agentWriter;
+        agentWriter["backlog"] = static_cast<Json::UInt64>(agentWriterStats.backlog);
+        agentWriter["flushes"] = static_cast<Json::Int64>(agentWriterStats.flushes);
+        agentWriter["rowsWritten"] = static_cast<Json::Int64>(agentWriterStats.rowsWritten);
+        agentWriter["droppedEvents"] = static_cast<Json::Int64>(agentWriterStats.droppedEvents);
+        agentWriter["failedStatements"] = static_cast<Json::Int64>(agentWriterStats.failedStatements);
+        data["agentWriter"] = agentWriter;
+
         // 6b. Modbus 性能统计
         auto& dispatcher = ProtocolDispatcher::instance();
         if (auto modbusMetrics = dispatcher.getAdapterMetrics(Constants::PROTOCOL_MODBUS);
@@ -502,184 +257,94 @@ public:
 
         // 7. 服务器系统状态
         Json::Value server;
-        server["processMemory"] = getProcessMemoryMB();
-        server["hostname"] = getHostname();
-        server["os"] = getOsInfo();
-        server["cpuCores"] = getCpuCoreCount();
-
-        auto [memTotal, memUsed] = getSystemMemory();
+        server["processMemory"] = SystemMetrics::getProcessMemoryMB();
+        server["cpuPercent"] = sample.cpuPercent;
+        server["loopLagMs"] = sample.loopLagMs;
+        server["hostname"] = SystemMetrics::getHostname();
+        server["os"] = SystemMetrics::getOsInfo();
+        server["cpuCores"] = SystemMetrics::getCpuCoreCount();
+
+        auto [memTotal, memUsed] = SystemMetrics::getSystemMemory();
         server["memoryTotal"] = memTotal;
         server["memoryUsed"] = memUsed;
 
-        auto [diskTotal, diskUsed] = getDiskUsage();
+        auto [diskTotal, diskUsed] = SystemMetrics::getDiskUsage();
         server["diskTotal"] = diskTotal;
         server["diskUsed"] = diskUsed;
 
 #ifndef _WIN32
-        server["loadAvg"] = getLoadAverage();
+        server["loadAvg"] = SystemMetrics::getLoadAverage();
 #endif
 
         data["server"] = server;
+        data["sampledAt"] = static_cast<Json::Int64>(sample.timestampMs);
 
         co_return data;
     }
 
-private:
-    // ==================== 系统信息助手 ====================
-
-    /** 获取进程内存使用（MB） */
-    static double getProcessMemoryMB() {
-#ifdef _WIN32
-        PROCESS_MEMORY_COUNTERS pmc;
-        if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
-            return static_cast<double>(pmc.WorkingSetSize) / (1024.0 * 1024.0);
-        }
-        return 0.0;
-#elif defined(__APPLE__)
-        mach_task_basic_info_data_t taskInfo{};
-        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
-        auto status = task_info(
-            mach_task_self(),
-            MACH_TASK_BASIC_INFO,
-            reinterpret_cast<task_info_t>(&taskInfo),
-            &count);
-        if (status == KERN_SUCCESS) {
-            return static_cast<double>(taskInfo.resident_size) / (1024.0 * 1024.0);
-        }
-        return 0.0;
-#else
-        std::ifstream f("/proc/self/status");
-        std::string line;
-        while (std::getline(f, line)) {
-            if (line.rfind("VmRSS:", 0) == 0) {
-                std::istringstream iss(line.substr(6));
-                double kb = 0;
-                iss >> kb;
-                return kb / 1024.0;
-            }
-        }
-        return 0.0;
-#endif
-    }
-
-    /** 获取主机名 */
-    static std::string getHostname() {
-        char buf[256]{};
-#ifdef _WIN32
-        DWORD size = sizeof(buf);
-        GetComputerNameA(buf, &size);
-#else
-        gethostname(buf, sizeof(buf));
-#endif
-        return buf;
-    }
-
-    /** 获取操作系统信息 */
-    static std::string getOsInfo() {
-#ifdef _WIN32
-        return "Windows";
-#else
-        struct utsname info{};
-        if (uname(&info) == 0) {
-            return std::string(info.sysname) + " " + info.release;
+    /**
+     * @brief 获取监控历史（内存环形缓冲区中最近 windowSec 秒的采样）
+     */
+    Json::Value getMonitorHistory(int windowSec) {
+        auto& sampler = MonitorSampler::instance();
+        Json::Value samples(Json::arrayValue);
+        for (const auto& sample : sampler.window(windowSec)) {
+            samples.append(MonitorSampler::toJson(sample));
         }
-        return "Linux";
-#endif
-    }
 
-    /** 获取 CPU 核心数 */
-    static int getCpuCoreCount() {
-        int cores = static_cast<int>(std::thread::hardware_concurrency());
-        return cores > 0 ? cores : 1;
+        Json::Value data;
+        data["intervalSec"] = sampler.sampleIntervalSec();
+        data["capacity"] = static_cast<Json::UInt64>(sampler.historySize());
+        data["samples"] = samples;
+        return data;
     }
 
-    /** 获取系统内存（MB）：{total, used} */
-    static std::pair<double, double> getSystemMemory() {
-#ifdef _WIN32
-        MEMORYSTATUSEX mem{};
-        mem.dwLength = sizeof(mem);
-        if (GlobalMemoryStatusEx(&mem)) {
-            double total = static_cast<double>(mem.ullTotalPhys) / (1024.0 * 1024.0);
-            double avail = static_cast<double>(mem.ullAvailPhys) / (1024.0 * 1024.0);
-            return {total, total - avail};
-        }
-        return {0.0, 0.0};
-#elif defined(__APPLE__)
-        uint64_t totalBytes = 0;
-        size_t totalSize = sizeof(totalBytes);
-        if (sysctlbyname("hw.memsize", &totalBytes, &totalSize, nullptr, 0) != 0) {
-            return {0.0, 0.0};
-        }
-
-        mach_port_t hostPort = mach_host_self();
-        vm_size_t pageSize = 0;
-        if (host_page_size(hostPort, &pageSize) != KERN_SUCCESS) {
-            mach_port_deallocate(mach_task_self(), hostPort);
-            return {static_cast<double>(totalBytes) / (1024.0 * 1024.0), 0.0};
-        }
-
-        vm_statistics64_data_t vmStats{};
-        mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
-        if (host_statistics64(hostPort, HOST_VM_INFO64, reinterpret_cast<host_info64_t>(&vmStats), &count) !=
-            KERN_SUCCESS) {
-            mach_port_deallocate(mach_task_self(), hostPort);
-            return {static_cast<double>(totalBytes) / (1024.0 * 1024.0), 0.0};
+    /**
+     * @brief 获取内存占用（分配器统计 + 各子系统最近一次近似统计）
+     * @param withReport 是否附带 mimalloc 文本统计报告
+     */
+    Json::Value getMemoryData(bool withReport) {
+        auto& monitor = MemoryMonitor::instance();
+        const auto stats = MemoryMonitor::allocatorStats();
+
+        Json::Value allocator;
+        allocator["committedBytes"] = static_cast<Json::UInt64>(stats.committedBytes);
+        allocator["peakCommittedBytes"] = static_cast<Json::UInt64>(stats.peakCommittedBytes);
+        allocator["rssBytes"] = static_cast<Json::UInt64>(stats.rssBytes);
+        allocator["peakRssBytes"] = static_cast<Json::UInt64>(stats.peakRssBytes);
+        allocator["pageFaults"] = static_cast<Json::UInt64>(stats.pageFaults);
+
+        Json::Value subsystems(Json::arrayValue);
+        for (const auto& usage : monitor.lastUsage()) {
+            Json::Value item;
+            item["name"] = usage.name;
+            item["bytes"] = static_cast<Json::UInt64>(usage.bytes);
+            item["limitBytes"] = static_cast<Json::UInt64>(usage.limitBytes);
+            item["trimmable"] = usage.trimmable;
+            subsystems.append(item);
         }
 
-        const auto availablePages = static_cast<uint64_t>(vmStats.free_count) +
-            static_cast<uint64_t>(vmStats.inactive_count) +
-            static_cast<uint64_t>(vmStats.speculative_count);
-        const auto availableBytes = availablePages * static_cast<uint64_t>(pageSize);
-        mach_port_deallocate(mach_task_self(), hostPort);
-        const double total = static_cast<double>(totalBytes) / (1024.0 * 1024.0);
-        const double available = static_cast<double>(availableBytes) / (1024.0 * 1024.0);
-        const double used = std::clamp(total - available, 0.0, total);
-        return {total, used};
-#else
-        std::ifstream f("/proc/meminfo");
-        std::string line;
-        double total = 0, available = 0;
-        while (std::getline(f, line)) {
-            if (line.rfind("MemTotal:", 0) == 0) {
-                std::istringstream iss(line.substr(9));
-                iss >> total;
-                total /= 1024.0; // kB → MB
-            } else if (line.rfind("MemAvailable:", 0) == 0) {
-                std::istringstream iss(line.substr(13));
-                iss >> available;
-                available /= 1024.0;
-            }
+        Json::Value data;
+        data["allocator"] = allocator;
+        data["softLimitBytes"] = static_cast<Json::UInt64>(monitor.softLimitBytes());
+        data["trimCount"] = static_cast<Json::UInt64>(monitor.trimCount());
+        data["subsystems"] = subsystems;
+        if (withReport) {
+            data["report"] = MemoryMonitor::allocatorReport();
         }
-        return {total, total - available};
-#endif
+        return data;
     }
 
-    /** 获取磁盘使用（GB）：{total, used} */
-    static std::pair<double, double> getDiskUsage() {
-#ifdef _WIN32
-        ULARGE_INTEGER freeBytesAvailable, totalBytes, totalFreeBytes;
-        if (GetDiskFreeSpaceExW(L"C:\\", &freeBytesAvailable, &totalBytes, &totalFreeBytes)) {
-            double total = static_cast<double>(totalBytes.QuadPart) / (1024.0 * 1024.0 * 1024.0);
-            double free = static_cast<double>(totalFreeBytes.QuadPart) / (1024.0 * 1024.0 * 1024.0);
-            return {total, total - free};
-        }
-        return {0.0, 0.0};
-#else
-        struct statvfs stat{};
-        if (statvfs("/", &stat) == 0) {
-            double total = static_cast<double>(stat.f_blocks) * stat.f_frsize / (1024.0 * 1024.0 * 1024.0);
-            double free = static_cast<double>(stat.f_bavail) * stat.f_frsize / (1024.0 * 1024.0 * 1024.0);
-            return {total, total - free};
+private:
+    /** 与 pg_size_pretty 一致的容量格式 */
+    static std::string formatBytes(int64_t bytes) {
+        static constexpr const char* kUnits[] = {"bytes", "kB", "MB", "GB", "TB"};
+        double value = static_cast<double>(bytes);
+        size_t unit = 0;
+        while (value >= 10240.0 && unit + 1 < std::size(kUnits)) {
+            value /= 1024.0;
+            ++unit;
         }
-        return {0.0, 0.0};
-#endif
+        return std::to_string(static_cast<int64_t>(std::llround(value))) + " " + kUnits[unit];
     }
-
-#ifndef _WIN32
-    /** 获取系统负载（Linux only）：1min 平均负载 */
-    static double getLoadAverage() {
-        double loads[3]{};
-        return getloadavg(loads, 1) == 1 ? loads[0] : 0.0;
-    }
-#endif
 };
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "common/network/TcpLinkManager.hpp"
+#include "common/network/WebSocketManager.hpp"
+#include "common/protocol/ProtocolDispatcher.hpp"
+#include "common/utils/LoggerManager.hpp"
+#include "common/utils/Metrics.hpp"
+#include "common/utils/Response.hpp"
+
+#include <openssl/crypto.h>
+
+/**
+ * @brief Prometheus 指标导出
+ *
+ * GET /metrics 输出文本格式（text/plain; version=0.0.4），不走 JWT：
+ * 抓取器无法登录，改由 custom_config.metrics 控制：
+ * - enabled: 是否开放，默认 false（指标含链路 ID、流量与队列深度，需显式开启）
+ * - token: 非空时要求 Authorization: Bearer <token>（常量时间比较）；
+ *   为空时只接受本机回环地址的抓取
+ *
+ * 链路吞吐、批量写入、日志写入与限流等累计值在每次抓取时同步为 *_total 计数器，
+ * WebSocket 连接数、待响应指令等瞬时值刷新到 Gauge，
+ * 接入各阶段耗时直方图由热路径直接写入（见 common/protocol/IngestMetrics.hpp）。
+ */
+class MetricsController : public drogon::HttpController<MetricsController> {
+public:
+    using enum drogon::HttpMethod;
+    using HttpRequestPtr = drogon::HttpRequestPtr;
+    using HttpResponsePtr = drogon::HttpResponsePtr;
+    template<typename T = void> using Task = drogon::Task<T>;
+
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(MetricsController::scrape, "/metrics", Get);
+    METHOD_LIST_END
+
+    MetricsController() {
+        auto config = drogon::app().getCustomConfig();
+        if (config.isMember("metrics") && config["metrics"].isObject()) {
+            const auto& section = config["metrics"];
+            enabled_ = section.get("enabled", enabled_).asBool();
+            token_ = section.get("token", "").asString();
+        }
+        registerCollector();
+    }
+
+    Task<HttpResponsePtr> scrape(HttpRequestPtr req) {
+        if (!enabled_) {
+            co_return Response::notFound();
+        }
+        if (token_.empty() ? !req->peerAddr().isLoopbackIp() : !bearerMatches(req->getHeader("Authorization"))) {
+            co_return Response::unauthorized();
+        }
+
+        auto resp = drogon::HttpResponse::newHttpResponse();
+        resp->setContentTypeString("text/plain; version=0.0.4; charset=utf-8");
+        resp->setBody(metrics::MetricsRegistry::instance().renderText());
+        co_return resp;
+    }
+
+private:
+    bool bearerMatches(const std::string& header) const {
+        const std::string expected = "Bearer " + token_;
+        // 常量时间比较，防止时序攻击
+        return header.size() == expected.size()
+            && CRYPTO_memcmp(header.data(), expected.data(), expected.size()) == 0;
+    }
+
+    static void registerCollector() {
+        static std::once_flag once;
+        std::call_once(once, [] {
+            auto& registry = metrics::MetricsRegistry::instance();
+            auto* tcpBytes = &registry.mirroredCounter(
+                "iot_tcp_bytes_total", "TCP bytes since start", {"direction"});
+            auto* tcpPackets = &registry.mirroredCounter(
+                "iot_tcp_packets_total", "TCP packets since start", {"direction"});
+            auto* wsConnections = &registry.gauge(
+                "iot_websocket_connections", "Open WebSocket connections");
+            auto* framesProcessed = &registry.mirroredCounter(
+                "iot_protocol_frames_processed_total", "Parsed frame results submitted for storage");
+            auto* batchFlushes = &registry.mirroredCounter(
+                "iot_protocol_batch_flushes_total", "Result writer batch flushes");
+            auto* batchFallbacks = &registry.mirroredCounter(
+                "iot_protocol_batch_fallbacks_total", "Batches that fell back to per-row inserts");
+            auto* pendingCommands = &registry.gauge(
+                "iot_protocol_pending_commands", "Commands waiting for a device response");
+            auto* logMessages = &registry.mirroredCounter(
+                "iot_log_messages_total", "Log lines handed to the file logger since start");
+            auto* logBytes = &registry.mirroredCounter(
+                "iot_log_bytes_total", "Log bytes handed to the file logger since start");
+            auto* logBuffered = &registry.gauge(
+                "iot_log_buffered_bytes", "Log bytes written since the last file logger flush");
+            auto* logSuppressed = &registry.mirroredCounter(
+                "iot_log_suppressed_total", "Log lines dropped by rate limiting since start", {"reason"});
+
+            registry.addCollector([=] {
+                const auto tcp = TcpLinkManager::instance().getTcpStats();
+                tcpBytes->with({"rx"}).set(static_cast<uint64_t>(tcp.bytesRx));
+                tcpBytes->with({"tx"}).set(static_cast<uint64_t>(tcp.bytesTx));
+                tcpPackets->with({"rx"}).set(static_cast<uint64_t>(tcp.packetsRx));
+                tcpPackets->with({"tx"}).set(static_cast<uint64_t>(tcp.packetsTx));
+
+                wsConnections->with({}).set(static_cast<double>(WebSocketManager::instance().connectionCount()));
+
+                const auto protocol = ProtocolDispatcher::instance().getProtocolStats();
+                framesProcessed->with({}).set(static_cast<uint64_t>(protocol.framesProcessed));
+                batchFlushes->with({}).set(static_cast<uint64_t>(protocol.batchFlushes));
+                batchFallbacks->with({}).set(static_cast<uint64_t>(protocol.batchFallbacks));
+                pendingCommands->with({}).set(static_cast<double>(protocol.pendingCommands));
+
+                const auto log = LoggerManager::getStats();
+                logMessages->with({}).set(static_cast<uint64_t>(log.messages));
+                logBytes->with({}).set(static_cast<uint64_t>(log.bytes));
+                logBuffered->with({}).set(static_cast<double>(log.bufferedBytes));
+                logSuppressed->with({"call_site"}).set(static_cast<uint64_t>(log.suppressedRateLimit));
+                logSuppressed->with({"device_budget"}).set(static_cast<uint64_t>(log.suppressedDeviceBudget));
+            });
+        });
+    }
+
+    bool enabled_ = false;
+    std::string token_;
+};
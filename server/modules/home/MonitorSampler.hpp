@@ -0,0 +1,391 @@
+#pragma once
+
+#include "common/database/DatabaseService.hpp"
+#include "common/network/TcpLinkManager.hpp"
+#include "common/protocol/ProtocolDispatcher.hpp"
+#include "common/utils/DrogonLoopSelector.hpp"
+#include "common/utils/LoopWatchdog.hpp"
+#include "modules/home/SystemMetrics.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief 监控采样点
+ *
+ * 速率类字段为相邻两次采样之间的增量 / 间隔；pg 字段按 pg_interval_sec 刷新，
+ * 其间沿用上一次的值（pgAt 为对应的采样时间）。
+ */
+struct MonitorSample {
+    int64_t timestampMs = 0;
+
+    // 进程
+    double cpuPercent = 0.0;     // 进程 CPU 占用（单核 100%）
+    double rssMB = 0.0;
+    double loopLagMs = 0.0;      // 采样周期内各事件循环最大调度延迟（LoopWatchdog 探针，禁用时退回采样器自身探针）
+
+    // 数据库连接池（按 DbWorkload 下标）
+    std::array<int64_t, kDbWorkloadCount> dbInFlight{};
+    double dbQueriesPerSec = 0.0;
+
+    // 接入
+    int totalLinks = 0;
+    int activeLinks = 0;
+    int totalConnections = 0;
+    double framesPerSec = 0.0;
+    double bytesRxPerSec = 0.0;
+    double bytesTxPerSec = 0.0;
+
+    // PostgreSQL
+    bool pgOk = false;
+    int64_t pgAtMs = 0;
+    int pgActiveConnections = 0;
+    int pgIdleConnections = 0;
+    int pgMaxConnections = 0;
+    double pgCacheHitRatio = 0.0;
+    int64_t pgXactCommit = 0;
+    int64_t pgXactRollback = 0;
+    double pgCommitsPerSec = 0.0;
+    int64_t pgDatabaseSizeBytes = 0;
+    int64_t recentDataCount = 0;  // 最近 1 小时入库条数
+};
+
+/**
+ * @brief 监控后台采样器
+ *
+ * 监控页原先每次刷新都查询 pg_stat_activity / pg_settings / pg_statio_user_tables /
+ * pg_stat_database / pg_database_size，并遍历全部链路状态，且没有历史。
+ * 现由后台按固定间隔采样，写入定长环形缓冲区：
+ * - 监控接口只读最新采样或一段时间窗口，刷新频率和在线人数不再影响数据库
+ * - 进程 CPU、RSS、事件循环调度延迟、连接池占用、接入速率每次采样
+ * - pg_stat 类指标按 pg_interval_sec 采样（走 Maintenance 负载直连主库）
+ *
+ * 配置（custom_config.monitor，可选）：
+ * - sample_interval_sec: 采样间隔，默认 10 秒
+ * - pg_interval_sec: pg_stat 采样间隔，默认 30 秒
+ * - history_size: 环形缓冲区容量，默认 360（10 秒间隔即 1 小时）
+ */
+class MonitorSampler {
+public:
+    template<typename T = void> using Task = drogon::Task<T>;
+
+    static MonitorSampler& instance() {
+        static MonitorSampler inst;
+        return inst;
+    }
+
+    void start() {
+        if (loop_) return;
+
+        auto config = drogon::app().getCustomConfig();
+        if (config.isMember("monitor") && config["monitor"].isObject()) {
+            const auto& monitor = config["monitor"];
+            sampleIntervalSec_ = monitor.get("sample_interval_sec", sampleIntervalSec_).asInt();
+            pgIntervalSec_ = monitor.get("pg_interval_sec", pgIntervalSec_).asInt();
+            historySize_ = monitor.get("history_size", static_cast<Json::UInt64>(historySize_)).asUInt64();
+        }
+        sampleIntervalSec_ = std::max(1, sampleIntervalSec_);
+        pgIntervalSec_ = std::max(sampleIntervalSec_, pgIntervalSec_);
+        historySize_ = std::clamp<size_t>(historySize_, 2, 86400);
+        {
+            std::lock_guard lock(mutex_);
+            ring_.assign(historySize_, MonitorSample{});
+            head_ = 0;
+            size_ = 0;
+        }
+
+        prev_ = Counters::read();
+
+        // FastDbClient 只能在 IO 线程上取用
+        loop_ = DrogonLoopSelector::fixed(0);
+        loop_->queueInLoop([this]() { tick(); });
+        timerId_ = loop_->runEvery(static_cast<double>(sampleIntervalSec_), [this]() { tick(); });
+
+        LOG_INFO << "[MonitorSampler] Started, interval=" << sampleIntervalSec_
+                 << "s, pgInterval=" << pgIntervalSec_ << "s, history=" << historySize_;
+    }
+
+    void stop() {
+        if (loop_) {
+            loop_->invalidateTimer(timerId_);
+            loop_ = nullptr;
+        }
+    }
+
+    /**
+     * @brief 最新采样（采样器尚未产出时为空）
+     */
+    std::optional<MonitorSample> latest() const {
+        std::lock_guard lock(mutex_);
+        if (size_ == 0) return std::nullopt;
+        return ring_[(head_ + ring_.size() - 1) % ring_.size()];
+    }
+
+    /**
+     * @brief 最近 windowSec 秒内的采样（按时间升序）
+     */
+    std::vector<MonitorSample> window(int windowSec) const {
+        auto cutoff = nowMs() - static_cast<int64_t>(windowSec) * 1000;
+        std::vector<MonitorSample> samples;
+        std::lock_guard lock(mutex_);
+        samples.reserve(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            const auto& sample = ring_[(head_ + ring_.size() - size_ + i) % ring_.size()];
+            if (sample.timestampMs >= cutoff) {
+                samples.push_back(sample);
+            }
+        }
+        return samples;
+    }
+
+    int sampleIntervalSec() const { return sampleIntervalSec_; }
+
+    size_t historySize() const { return historySize_; }
+
+    static Json::Value toJson(const MonitorSample& sample) {
+        Json::Value item;
+        item["timestamp"] = static_cast<Json::Int64>(sample.timestampMs);
+        item["cpuPercent"] = sample.cpuPercent;
+        item["rssMB"] = sample.rssMB;
+        item["loopLagMs"] = sample.loopLagMs;
+        Json::Value pools(Json::objectValue);
+        for (size_t i = 0; i < kDbWorkloadCount; ++i) {
+            pools[dbWorkloadName(static_cast<DbWorkload>(i))] = static_cast<Json::Int64>(sample.dbInFlight[i]);
+        }
+        item["dbInFlight"] = pools;
+        item["dbQueriesPerSec"] = sample.dbQueriesPerSec;
+        item["framesPerSec"] = sample.framesPerSec;
+        item["bytesRxPerSec"] = sample.bytesRxPerSec;
+        item["bytesTxPerSec"] = sample.bytesTxPerSec;
+        item["totalConnections"] = sample.totalConnections;
+        item["pgActiveConnections"] = sample.pgActiveConnections;
+        item["pgCommitsPerSec"] = sample.pgCommitsPerSec;
+        item["pgCacheHitRatio"] = sample.pgCacheHitRatio;
+        return item;
+    }
+
+private:
+    MonitorSampler() = default;
+
+    /** 累计型计数（求速率用） */
+    struct Counters {
+        std::chrono::steady_clock::time_point at;
+        double cpuSeconds = 0.0;
+        int64_t frames = 0;
+        int64_t bytesRx = 0;
+        int64_t bytesTx = 0;
+        uint64_t dbQueries = 0;
+
+        static Counters read() {
+            Counters c;
+            c.at = std::chrono::steady_clock::now();
+            c.cpuSeconds = SystemMetrics::getProcessCpuSeconds();
+            c.frames = ProtocolDispatcher::instance().getProtocolStats().framesProcessed;
+            auto tcp = TcpLinkManager::instance().getTcpStats();
+            c.bytesRx = tcp.bytesRx;
+            c.bytesTx = tcp.bytesTx;
+            for (size_t i = 0; i < kDbWorkloadCount; ++i) {
+                c.dbQueries += DbPoolMetrics::instance().total(static_cast<DbWorkload>(i));
+            }
+            return c;
+        }
+    };
+
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    void tick() {
+        if (busy_.exchange(true, std::memory_order_acq_rel)) return;
+        LoopWatchdog::TaskScope task("monitor.sample");
+
+        drogon::async_run([this]() -> Task<> {
+            MonitorSample sample;
+            try {
+                sample = co_await collect();
+                push(sample);
+            } catch (const std::exception& e) {
+                LOG_WARN << "[MonitorSampler] Sample failed: " << e.what();
+            }
+            if (!LoopWatchdog::instance().running()) {
+                probeLoopLag();
+            }
+            busy_.store(false, std::memory_order_release);
+        });
+    }
+
+    Task<MonitorSample> collect() {
+        MonitorSample sample;
+        sample.timestampMs = nowMs();
+
+        // 进程 / 速率
+        auto cur = Counters::read();
+        double elapsed = std::chrono::duration<double>(cur.at - prev_.at).count();
+        if (elapsed > 0.0) {
+            sample.cpuPercent = (cur.cpuSeconds - prev_.cpuSeconds) / elapsed * 100.0;
+            sample.framesPerSec = static_cast<double>(cur.frames - prev_.frames) / elapsed;
+            sample.bytesRxPerSec = static_cast<double>(cur.bytesRx - prev_.bytesRx) / elapsed;
+            sample.bytesTxPerSec = static_cast<double>(cur.bytesTx - prev_.bytesTx) / elapsed;
+            sample.dbQueriesPerSec = static_cast<double>(cur.dbQueries - prev_.dbQueries) / elapsed;
+        }
+        prev_ = cur;
+        sample.rssMB = SystemMetrics::getProcessMemoryMB();
+        auto& watchdog = LoopWatchdog::instance();
+        const auto lagMicros = watchdog.running()
+            ? watchdog.takeMaxLagMicros()
+            : maxLagMicros_.exchange(0, std::memory_order_acq_rel);
+        sample.loopLagMs = static_cast<double>(lagMicros) / 1000.0;
+
+        for (size_t i = 0; i < kDbWorkloadCount; ++i) {
+            sample.dbInFlight[i] = DbPoolMetrics::instance().inFlight(static_cast<DbWorkload>(i));
+        }
+
+        // 链路
+        for (const auto& link : TcpLinkManager::instance().getAllStatus()) {
+            auto connStatus = link["conn_status"].asString();
+            if (connStatus == "listening" || connStatus == "connected" || connStatus == "partial") {
+                sample.activeLinks++;
+            }
+            sample.totalConnections += link["client_count"].asInt();
+            sample.totalLinks++;
+        }
+
+        // PostgreSQL：到期才查，否则沿用上一次
+        auto last = latest();
+        bool pgDue = !last || !last->pgOk || sample.timestampMs - last->pgAtMs >= pgIntervalSec_ * 1000LL;
+        if (!pgDue) {
+            copyPg(*last, sample);
+        } else {
+            co_await samplePg(sample, last);
+        }
+        co_return sample;
+    }
+
+    Task<> samplePg(MonitorSample& sample, const std::optional<MonitorSample>& last) {
+        DatabaseService db(DbWorkload::Maintenance);
+        try {
+            auto result = co_await db.execSqlCoro(R"(
+                SELECT
+                    (SELECT count(*) FROM pg_stat_activity
+                     WHERE state = 'active') AS active_connections,
+                    (SELECT count(*) FROM pg_stat_activity
+                     WHERE state = 'idle') AS idle_connections,
+                    (SELECT setting::int FROM pg_settings
+                     WHERE name = 'max_connections') AS max_connections,
+                    (SELECT ROUND(
+                        sum(heap_blks_hit)::numeric / NULLIF(sum(heap_blks_hit) + sum(heap_blks_read), 0) * 100, 2
+                    ) FROM pg_statio_user_tables) AS cache_hit_ratio,
+                    (SELECT xact_commit FROM pg_stat_database
+                     WHERE datname = current_database()) AS xact_commit,
+                    (SELECT xact_rollback FROM pg_stat_database
+                     WHERE datname = current_database()) AS xact_rollback,
+                    (SELECT pg_database_size(current_database())) AS db_size
+            )");
+            const auto& row = result[0];
+            sample.pgActiveConnections = row["active_connections"].as<int>();
+            sample.pgIdleConnections = row["idle_connections"].as<int>();
+            sample.pgMaxConnections = row["max_connections"].as<int>();
+            sample.pgCacheHitRatio = row["cache_hit_ratio"].isNull() ? 0.0 : row["cache_hit_ratio"].as<double>();
+            sample.pgXactCommit = row["xact_commit"].as<int64_t>();
+            sample.pgXactRollback = row["xact_rollback"].as<int64_t>();
+            sample.pgDatabaseSizeBytes = row["db_size"].as<int64_t>();
+            sample.pgOk = true;
+        } catch (const std::exception& e) {
+            LOG_WARN << "[MonitorSampler] pg_stat sample failed: " << e.what();
+            sample.pgOk = false;
+        }
+        sample.pgAtMs = sample.timestampMs;
+
+        if (sample.pgOk && last && last->pgOk && sample.pgAtMs > last->pgAtMs) {
+            sample.pgCommitsPerSec = static_cast<double>(sample.pgXactCommit - last->pgXactCommit)
+                / (static_cast<double>(sample.pgAtMs - last->pgAtMs) / 1000.0);
+        }
+
+        // 最近 1 小时入库量（优先使用连续聚合）
+        // 注意：MSVC 不支持 catch 块中使用 co_await，用标志位重构
+        bool useRecentFallback = false;
+        try {
+            auto recentResult = co_await db.execSqlCoro(R"(
+                SELECT COALESCE(SUM(record_count), 0) AS recent_count
+                FROM device_data_hourly
+                WHERE bucket >= now() - interval '1 hour'
+            )");
+            sample.recentDataCount = recentResult[0]["recent_count"].as<int64_t>();
+        } catch (...) {
+            useRecentFallback = true;
+        }
+        if (useRecentFallback) {
+            try {
+                auto recentResult = co_await db.execSqlCoro(R"(
+                    SELECT COUNT(*) AS recent_count
+                    FROM device_data
+                    WHERE report_time >= now() - interval '1 hour'
+                )");
+                sample.recentDataCount = recentResult[0]["recent_count"].as<int64_t>();
+            } catch (const std::exception& e) {
+                LOG_WARN << "[MonitorSampler] Recent data count failed: " << e.what();
+            }
+        }
+    }
+
+    static void copyPg(const MonitorSample& from, MonitorSample& to) {
+        to.pgOk = from.pgOk;
+        to.pgAtMs = from.pgAtMs;
+        to.pgActiveConnections = from.pgActiveConnections;
+        to.pgIdleConnections = from.pgIdleConnections;
+        to.pgMaxConnections = from.pgMaxConnections;
+        to.pgCacheHitRatio = from.pgCacheHitRatio;
+        to.pgXactCommit = from.pgXactCommit;
+        to.pgXactRollback = from.pgXactRollback;
+        to.pgCommitsPerSec = from.pgCommitsPerSec;
+        to.pgDatabaseSizeBytes = from.pgDatabaseSizeBytes;
+        to.recentDataCount = from.recentDataCount;
+    }
+
+    void push(const MonitorSample& sample) {
+        std::lock_guard lock(mutex_);
+        if (ring_.empty()) return;
+        ring_[head_] = sample;
+        head_ = (head_ + 1) % ring_.size();
+        size_ = std::min(size_ + 1, ring_.size());
+    }
+
+    /**
+     * @brief LoopWatchdog 未运行时的退路：向每个 IO 线程投递一个空任务，
+     *        执行时记录排队时长，下一次采样取最大值
+     */
+    void probeLoopLag() {
+        size_t n = drogon::app().getThreadNum();
+        for (size_t i = 0; i < n; ++i) {
+            auto postedAt = std::chrono::steady_clock::now();
+            drogon::app().getIOLoop(i)->queueInLoop([this, postedAt]() {
+                auto lag = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - postedAt).count());
+                auto prev = maxLagMicros_.load(std::memory_order_relaxed);
+                while (lag > prev &&
+                       !maxLagMicros_.compare_exchange_weak(prev, lag, std::memory_order_relaxed)) {
+                }
+            });
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::vector<MonitorSample> ring_;
+    size_t head_{0};
+    size_t size_{0};
+
+    Counters prev_;  // 仅在采样协程（busy_ 保护）中访问
+    std::atomic<uint64_t> maxLagMicros_{0};  // 自身探针结果（LoopWatchdog 未运行时）
+    std::atomic<bool> busy_{false};
+
+    int sampleIntervalSec_{10};
+    int pgIntervalSec_{30};
+    size_t historySize_{360};
+    trantor::EventLoop* loop_{nullptr};
+    trantor::TimerId timerId_{0};
+};
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef _MSC_VER
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#elif defined(_WIN32)
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <mach/mach_host.h>
+#include <mach/task_info.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/statvfs.h>
+#include <sys/sysctl.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#else
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/statvfs.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief 进程/主机系统指标（跨平台）
+ */
+class SystemMetrics {
+public:
+    /** 获取进程内存使用（MB） */
+    static double getProcessMemoryMB() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS pmc;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+            return static_cast<double>(pmc.WorkingSetSize) / (1024.0 * 1024.0);
+        }
+        return 0.0;
+#elif defined(__APPLE__)
+        mach_task_basic_info_data_t taskInfo{};
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        auto status = task_info(
+            mach_task_self(),
+            MACH_TASK_BASIC_INFO,
+            reinterpret_cast<task_info_t>(&taskInfo),
+            &count);
+        if (status == KERN_SUCCESS) {
+            return static_cast<double>(taskInfo.resident_size) / (1024.0 * 1024.0);
+        }
+        return 0.0;
+#else
+        std::ifstream f("/proc/self/status");
+        std::string line;
+        while (std::getline(f, line)) {
+            if (line.rfind("VmRSS:", 0) == 0) {
+                std::istringstream iss(line.substr(6));
+                double kb = 0;
+                iss >> kb;
+                return kb / 1024.0;
+            }
+        }
+        return 0.0;
+#endif
+    }
+
+    /** 获取主机名 */
+    static std::string getHostname() {
+        char buf[256]{};
+#ifdef _WIN32
+        DWORD size = sizeof(buf);
+        GetComputerNameA(buf, &size);
+#else
+        gethostname(buf, sizeof(buf));
+#endif
+        return buf;
+    }
+
+    /** 获取操作系统信息 */
+    static std::string getOsInfo() {
+#ifdef _WIN32
+        return "Windows";
+#else
+        struct utsname info{};
+        if (uname(&info) == 0) {
+            return std::string(info.sysname) + " " + info.release;
+        }
+        return "Linux";
+#endif
+    }
+
+    /** 获取 CPU 核心数 */
+    static int getCpuCoreCount() {
+        int cores = static_cast<int>(std::thread::hardware_concurrency());
+        return cores > 0 ? cores : 1;
+    }
+
+    /** 获取系统内存（MB）：{total, used} */
+    static std::pair<double, double> getSystemMemory() {
+#ifdef _WIN32
+        MEMORYSTATUSEX mem{};
+        mem.dwLength = sizeof(mem);
+        if (GlobalMemoryStatusEx(&mem)) {
+            double total = static_cast<double>(mem.ullTotalPhys) / (1024.0 * 1024.0);
+            double avail = static_cast<double>(mem.ullAvailPhys) / (1024.0 * 1024.0);
+            return {total, total - avail};
+        }
+        return {0.0, 0.0};
+#elif defined(__APPLE__)
+        uint64_t totalBytes = 0;
+        size_t totalSize = sizeof(totalBytes);
+        if (sysctlbyname("hw.memsize", &totalBytes, &totalSize, nullptr, 0) != 0) {
+            return {0.0, 0.0};
+        }
+
+        mach_port_t hostPort = mach_host_self();
+        vm_size_t pageSize = 0;
+        if (host_page_size(hostPort, &pageSize) != KERN_SUCCESS) {
+            mach_port_deallocate(mach_task_self(), hostPort);
+            return {static_cast<double>(totalBytes) / (1024.0 * 1024.0), 0.0};
+        }
+
+        vm_statistics64_data_t vmStats{};
+        mach_msg_type_number_t count = HOST_VM_INFO64_COUNT;
+        if (host_statistics64(hostPort, HOST_VM_INFO64, reinterpret_cast<host_info64_t>(&vmStats), &count) !=
+            KERN_SUCCESS) {
+            mach_port_deallocate(mach_task_self(), hostPort);
+            return {static_cast<double>(totalBytes) / (1024.0 * 1024.0), 0.0};
+        }
+
+        const auto availablePages = static_cast<uint64_t>(vmStats.free_count) +
+            static_cast<uint64_t>(vmStats.inactive_count) +
+            static_cast<uint64_t>(vmStats.speculative_count);
+        const auto availableBytes = availablePages * static_cast<uint64_t>(pageSize);
+        mach_port_deallocate(mach_task_self(), hostPort);
+        const double total = static_cast<double>(totalBytes) / (1024.0 * 1024.0);
+        const double available = static_cast<double>(availableBytes) / (1024.0 * 1024.0);
+        const double used = std::clamp(total - available, 0.0, total);
+        return {total, used};
+#else
+        std::ifstream f("/proc/meminfo");
+        std::string line;
+        double total = 0, available = 0;
+        while (std::getline(f, line)) {
+            if (line.rfind("MemTotal:", 0) == 0) {
+                std::istringstream iss(line.substr(9));
+                iss >> total;
+                total /= 1024.0; // kB → MB
+            } else if (line.rfind("MemAvailable:", 0) == 0) {
+                std::istringstream iss(line.substr(13));
+                iss >> available;
+                available /= 1024.0;
+            }
+        }
+        return {total, total - available};
+#endif
+    }
+
+    /** 获取磁盘使用（GB）：{total, used} */
+    static std::pair<double, double> getDiskUsage() {
+#ifdef _WIN32
+        ULARGE_INTEGER freeBytesAvailable, totalBytes, totalFreeBytes;
+        if (GetDiskFreeSpaceExW(L"C:\\", &freeBytesAvailable, &totalBytes, &totalFreeBytes)) {
+            double total = static_cast<double>(totalBytes.QuadPart) / (1024.0 * 1024.0 * 1024.0);
+            double free = static_cast<double>(totalFreeBytes.QuadPart) / (1024.0 * 1024.0 * 1024.0);
+            return {total, total - free};
+        }
+        return {0.0, 0.0};
+#else
+        struct statvfs stat{};
+        if (statvfs("/", &stat) == 0) {
+            double total = static_cast<double>(stat.f_blocks) * stat.f_frsize / (1024.0 * 1024.0 * 1024.0);
+            double free = static_cast<double>(stat.f_bavail) * stat.f_frsize / (1024.0 * 1024.0 * 1024.0);
+            return {total, total - free};
+        }
+        return {0.0, 0.0};
+#endif
+    }
+
+#ifndef _WIN32
+    /** 获取系统负载（Linux only）：1min 平均负载 */
+    static double getLoadAverage() {
+        double loads[3]{};
+        return getloadavg(loads, 1) == 1 ? loads[0] : 0.0;
+    }
+#endif
+
+    /** 获取进程累计 CPU 时间（用户态 + 内核态，秒） */
+    static double getProcessCpuSeconds() {
+#ifdef _WIN32
+        FILETIME creation, exitTime, kernel, user;
+        if (GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user)) {
+            auto toSeconds = [](const FILETIME& ft) {
+                ULARGE_INTEGER v;
+                v.LowPart = ft.dwLowDateTime;
+                v.HighPart = ft.dwHighDateTime;
+                return static_cast<double>(v.QuadPart) / 1e7; // 100ns → s
+            };
+            return toSeconds(kernel) + toSeconds(user);
+        }
+        return 0.0;
+#else
+        struct rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+            return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+                + static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+        }
+        return 0.0;
+#endif
+    }
+};
@@ -7,6 +7,7 @@
 #include "common/utils/ValidatorHelper.hpp"
 #include "common/utils/Constants.hpp"
 #include "common/cache/ResourceVersion.hpp"
+#include "common/network/FrameTrace.hpp"
 #include "common/filters/PermissionFilter.hpp"
 #include "common/filters/ResourcePermission.hpp"
 
@@ -47,6 +48,7 @@ public:
     ADD_METHOD_TO(LinkController::options, "/api/link/options", Get, "AuthFilter");
     ADD_METHOD_TO(LinkController::enums, "/api/link/enums", Get, "AuthFilter");
     ADD_METHOD_TO(LinkController::publicIp, "/api/link/public-ip", Get, "AuthFilter");
+    ADD_METHOD_TO(LinkController::trace, "/api/link/trace", Get, "AuthFilter");
     METHOD_LIST_END
 
     /**
@@ -60,14 +62,17 @@ public:
 
         // 参数化 ETag 检查
         std::string params = mode + ":" + std::to_string(page.page) + ":" + std::to_string(page.pageSize);
-        if (auto notModified = ETagUtils::checkParamETag(req, "link", params)) {
+        // 列表含连接状态，配置版本之外还要叠加连接状态版本
+        auto& rv = ResourceVersion::instance();
+        std::string version = rv.getVersion("link") + "." + rv.getVersion("link:status");
+        if (auto notModified = ETagUtils::checkVersionedETag(req, params, version)) {
             co_return notModified;
         }
 
         auto result = co_await service_.list(page, mode);
         auto [items, total] = result;
         auto resp = Pagination::buildResponse(items, total, page.page, page.pageSize);
-        ETagUtils::addParamETag(resp, "link", params);
+        ETagUtils::addVersionedETag(resp, params, version);
         co_return resp;
     }
 
@@ -198,6 +203,71 @@ public:
         co_return resp;
     }
 
+    /**
+     * @brief 导出原始报文追踪快照
+     *
+     * 参数：linkId / deviceId（可选过滤）、limit（默认 500，最多 5000）、
+     * format=json|hex|pcap（默认 json）。
+     */
+    Task<HttpResponsePtr> trace(HttpRequestPtr req) {
+        co_await PermissionChecker::checkPermission(ControllerUtils::getUserId(req), {"iot:link:edit"});
+
+        FrameTrace::Filter filter;
+        auto parseInt = [&req](const std::string& name) -> std::optional<int> {
+            auto value = req->getParameter(name);
+            if (value.empty()) return std::nullopt;
+            try { return std::stoi(value); } catch (...) { return std::nullopt; }
+        };
+        filter.linkId = parseInt("linkId");
+        filter.deviceId = parseInt("deviceId");
+        if (auto limit = parseInt("limit")) {
+            filter.limit = static_cast<size_t>(std::clamp(*limit, 1, 5000));
+        }
+
+        const auto records = FrameTrace::instance().snapshot(filter);
+        const auto format = req->getParameter("format");
+
+        if (format == "pcap") {
+            auto resp = drogon::HttpResponse::newHttpResponse();
+            resp->setContentTypeString("application/vnd.tcpdump.pcap");
+            resp->addHeader("Content-Disposition", "attachment; filename=\"frame-trace.pcap\"");
+            resp->setBody(FrameTrace::toPcap(records));
+            co_return resp;
+        }
+        if (format == "hex") {
+            auto resp = drogon::HttpResponse::newHttpResponse();
+            resp->setContentTypeString("text/plain; charset=utf-8");
+            resp->setBody(FrameTrace::toHexDump(records));
+            co_return resp;
+        }
+
+        static constexpr char HEX[] = "0123456789ABCDEF";
+        Json::Value items(Json::arrayValue);
+        for (const auto& r : records) {
+            Json::Value item;
+            item["timeUs"] = static_cast<Json::Int64>(r.timeUs);
+            item["direction"] = r.direction == FrameTrace::Direction::Rx ? "RX" : "TX";
+            item["linkId"] = r.linkId;
+            item["deviceId"] = r.deviceId;
+            item["connection"] = r.connection;
+            item["size"] = r.originalSize;
+            std::string hex;
+            hex.reserve(r.payload.size() * 2);
+            for (unsigned char byte : r.payload) {
+                hex += HEX[byte >> 4];
+                hex += HEX[byte & 0x0F];
+            }
+            item["payload"] = hex;
+            item["truncated"] = r.payload.size() < r.originalSize;
+            items.append(item);
+        }
+
+        Json::Value result;
+        result["enabled"] = FrameTrace::instance().enabled();
+        result["items"] = items;
+        co_return Response::ok(result);
+    }
+
     /**
      * @brief 获取服务器公网 IP（缓存 5 分钟）
      */
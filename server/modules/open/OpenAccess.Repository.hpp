@@ -2,7 +2,7 @@
 
 #include "OpenAccess.DataTransformer.hpp"
 #include "OpenAccess.Shared.hpp"
-#include "common/database/DatabaseService.hpp"
+#include "common/database/PreparedStatements.hpp"
 #include "common/filters/ResourcePermission.hpp"
 #include "common/utils/Constants.hpp"
 #include "common/utils/FieldHelper.hpp"
@@ -541,7 +541,7 @@ public:
             params.push_back(eventType);
         }
 
-        auto countResult = co_await dbService_.execSqlCoro(
+        auto countResult = co_await reportingDb_.execSqlCoro(
             "SELECT COUNT(*) AS count FROM open_access_log l" + where,
             params
         );
@@ -575,10 +575,12 @@ public:
 
         if (pageSize > 0) {
             int offset = std::max(0, (page - 1) * pageSize);
-            sql += " LIMIT " + std::to_string(pageSize) + " OFFSET " + std::to_string(offset);
+            sql += " LIMIT ? OFFSET ?";
+            params.push_back(std::to_string(pageSize));
+            params.push_back(std::to_string(offset));
         }
 
-        auto result = co_await dbService_.execSqlCoro(sql, params);
+        auto result = co_await reportingDb_.execSqlCoro(sql, params);
 
         Json::Value items(Json::arrayValue);
         for (const auto& row : result) {
@@ -676,7 +678,7 @@ public:
             params.push_back(severity);
         }
 
-        auto countResult = co_await dbService_.execSqlCoro(
+        auto countResult = co_await reportingDb_.execSqlCoro(
             "SELECT COUNT(*) AS count FROM alert_record r" + where,
             params
         );
@@ -699,10 +701,12 @@ public:
 
         if (pageSize > 0) {
             int offset = std::max(0, (page - 1) * pageSize);
-            sql += " LIMIT " + std::to_string(pageSize) + " OFFSET " + std::to_string(offset);
+            sql += " LIMIT ? OFFSET ?";
+            params.push_back(std::to_string(pageSize));
+            params.push_back(std::to_string(offset));
         }
 
-        auto result = co_await dbService_.execSqlCoro(sql, params);
+        auto result = co_await reportingDb_.execSqlCoro(sql, params);
 
         Json::Value items(Json::arrayValue);
         for (const auto& row : result) {
@@ -748,7 +752,7 @@ public:
 
         int total = 0;
         if (isPaged) {
-            auto countResult = co_await dbService_.execSqlCoro(
+            auto countResult = co_await reportingDb_.execSqlCoro(
                 "SELECT COUNT(*) AS count FROM " + tableName + " " + where,
                 params
             );
@@ -762,12 +766,15 @@ public:
         )";
 
         if (isPaged) {
-            sql += " LIMIT " + std::to_string(pageSize) + " OFFSET " + std::to_string(effectiveOffset);
+            sql += " LIMIT ? OFFSET ?";
+            params.push_back(std::to_string(pageSize));
+            params.push_back(std::to_string(effectiveOffset));
         } else {
-            sql += " LIMIT " + std::to_string(Constants::MAX_UNPAGED_ROWS);
+            sql += " LIMIT ?";
+            params.push_back(std::to_string(Constants::MAX_UNPAGED_ROWS));
         }
 
-        auto result = co_await dbService_.execSqlCoro(sql, params);
+        auto result = co_await reportingDb_.execSqlCoro(sql, params);
 
         Json::Value items(Json::arrayValue);
         for (const auto& row : result) {
@@ -876,13 +883,14 @@ public:
             co_return 0;
         }
 
-        auto result = co_await dbService_.execSqlCoro(R"(
+        static const auto& stmt = PreparedStatementRegistry::instance().define("openAccessKey.resolveId", R"(
             SELECT id
             FROM open_access_key
             WHERE access_key_hash = ?
               AND deleted_at IS NULL
             LIMIT 1
-        )", {OpenAccess::sha256Hex(accessKey)});
+        )");
+        auto result = co_await dbService_.execPreparedCoro(stmt, {OpenAccess::sha256Hex(accessKey)});
 
         co_return result.empty() ? 0 : FieldHelper::getInt(result[0]["id"], 0);
     }
@@ -891,8 +899,8 @@ public:
         if (accessKey.empty()) {
             throw AppException(ErrorCodes::UNAUTHORIZED, "缺少 AccessKey", drogon::k401Unauthorized);
         }
-
-        auto result = co_await dbService_.execSqlCoro(R"(
+
+        static const auto& stmt = PreparedStatementRegistry::instance().define("openAccessKey.authenticate", R"(
             SELECT
                 id,
                 name,
@@ -906,10 +914,11 @@ public:
                     ELSE FALSE
                 END AS expired
             FROM open_access_key
-            WHERE access_key_hash = ?
-              AND deleted_at IS NULL
-            LIMIT 1
-        )", {OpenAccess::sha256Hex(accessKey)});
+            WHERE access_key_hash = ?
+              AND deleted_at IS NULL
+            LIMIT 1
+        )");
+        auto result = co_await dbService_.execPreparedCoro(stmt, {OpenAccess::sha256Hex(accessKey)});
 
         if (result.empty()) {
             throw AppException(ErrorCodes::UNAUTHORIZED, "AccessKey 无效", drogon::k401Unauthorized);
@@ -975,14 +984,8 @@ public:
             co_return std::vector<OpenAccess::WebhookTarget>{};
         }
 
-        std::vector<std::string> params;
-        params.reserve(deviceIds.size());
-        for (int deviceId : deviceIds) {
-            params.push_back(std::to_string(deviceId));
-        }
-
-        auto inClause = "(" + OpenAccess::buildPlaceholders(deviceIds.size()) + ")";
-        std::string sql = R"(
+        // 设备 ID 以数组参数传入，SQL 文本与设备个数无关（每批上报都会调用）
+        static const auto& stmt = PreparedStatementRegistry::instance().define("openWebhook.activeTargets", R"(
             SELECT
                 w.id,
                 w.access_key_id,
@@ -1005,11 +1008,12 @@ public:
               AND ak.deleted_at IS NULL
               AND ak.status = 'enabled'
               AND (ak.expires_at IS NULL OR ak.expires_at > CURRENT_TIMESTAMP)
-              AND akd.device_id IN )" + inClause + R"(
+              AND akd.device_id = ANY(?::int[])
             GROUP BY w.id, ak.id, ak.name
-        )";
+        )");
 
-        auto result = co_await dbService_.execSqlCoro(sql, params);
+        std::vector<int> ids(deviceIds.begin(), deviceIds.end());
+        auto result = co_await dbService_.execPreparedCoro(stmt, {SqlHelper::toPgArray(ids)});
 
         std::vector<OpenAccess::WebhookTarget> targets;
         targets.reserve(result.size());
@@ -1086,6 +1090,7 @@ public:
 
 private:
     DatabaseService dbService_;
+    DatabaseService reportingDb_{DbWorkload::Reporting};  // 日志/告警/历史分页查询走报表连接池
 
     static bool shouldUseArchive(const std::string& startTime) {
         if (startTime.empty()) return false;
@@ -1255,12 +1260,13 @@ private:
     }
 
     Task<std::vector<int>> loadAccessKeyDeviceIds(int accessKeyId) {
-        auto result = co_await dbService_.execSqlCoro(R"(
+        static const auto& stmt = PreparedStatementRegistry::instance().define("openAccessKey.deviceIds", R"(
             SELECT device_id
             FROM open_access_key_device
             WHERE access_key_id = ?::int
             ORDER BY device_id ASC
-        )", {std::to_string(accessKeyId)});
+        )");
+        auto result = co_await dbService_.execPreparedCoro(stmt, {std::to_string(accessKeyId)});
 
         std::vector<int> ids;
         ids.reserve(result.size());
@@ -6,6 +6,7 @@
 #include "common/cache/DeviceCache.hpp"
 #include "common/cache/RealtimeDataCache.hpp"
 #include "common/protocol/FrameResult.hpp"
+#include "common/protocol/IngestMetrics.hpp"
 #include "common/utils/DrogonLoopSelector.hpp"
 
 #include <cstddef>
@@ -475,7 +476,13 @@ private:
                     );
                 }
 
-                auto resp = co_await client->sendRequestCoro(req, static_cast<double>(target.timeoutSeconds));
+                drogon::HttpResponsePtr resp;
+                {
+                    // 超时/连接失败以异常返回，同样计入投递耗时
+                    ingest_metrics::StageTimer timer(
+                        ingest_metrics::Stage::Webhook, ingest_metrics::ALL_LABEL, -1);
+                    resp = co_await client->sendRequestCoro(req, static_cast<double>(target.timeoutSeconds));
+                }
                 if (!resp) {
                     failureReason = "Webhook 无响应";
                 } else {
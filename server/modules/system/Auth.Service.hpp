@@ -5,6 +5,9 @@
 #include "common/utils/AppException.hpp"
 #include "common/database/DatabaseService.hpp"
 #include "common/cache/AuthCache.hpp"
+#include "common/cache/TreeCache.hpp"
+#include "common/database/PreparedStatements.hpp"
+#include "common/utils/SqlHelper.hpp"
 #include "common/utils/FieldHelper.hpp"
 #include "common/utils/Constants.hpp"
 
@@ -342,38 +345,57 @@ private:
         co_return menus;
     }
 
+    /**
+     * @brief 用户菜单（按角色集合缓存）
+     *
+     * 角色集合相同的用户共享同一份菜单视图（TreeCache "menu" 族，菜单/角色变更时失效），
+     * 登录和页面加载不再按用户查库。
+     */
     Task<Json::Value> getUserMenus(int userId) {
-        auto cached = co_await authCache_.getUserMenus(userId);
-        if (cached) {
-            LOG_DEBUG << "User menus cache hit for userId: " << userId;
-            co_return *cached;
+        auto roles = co_await getUserRoles(userId);
+
+        std::vector<int> roleIds;
+        roleIds.reserve(roles.size());
+        for (const auto& role : roles) {
+            roleIds.push_back(role["id"].asInt());
+        }
+        std::sort(roleIds.begin(), roleIds.end());
+        roleIds.erase(std::unique(roleIds.begin(), roleIds.end()), roleIds.end());
+
+        auto view = co_await TreeCache::instance().get(
+            "menu", "roles:" + SqlHelper::toPgArray(roleIds),
+            [this, roleIds]() -> Task<Json::Value> { co_return co_await loadRoleMenus(roleIds); }
+        );
+        co_return view->items;
+    }
+
+    Task<Json::Value> loadRoleMenus(const std::vector<int>& roleIds) {
+        Json::Value menus(Json::arrayValue);
+        if (roleIds.empty()) {
+            co_return menus;
         }
 
-        LOG_DEBUG << "User menus cache miss for userId: " << userId;
+        LOG_DEBUG << "Role menus cache miss for roles: " << SqlHelper::toPgArray(roleIds);
 
-        std::string sql = R"(
+        static const auto& stmt = PreparedStatementRegistry::instance().define("auth.menus.byRoles", R"(
             SELECT DISTINCT m.id, m.name, m.parent_id, m.type, m.path, m.component,
                    m.permission_code, m.icon, m.status, m.sort_order, 1 as visible
             FROM sys_menu m
             INNER JOIN sys_role_menu rm ON m.id = rm.menu_id
-            INNER JOIN sys_user_role ur ON rm.role_id = ur.role_id
-            INNER JOIN sys_role r ON ur.role_id = r.id
-            WHERE ur.user_id = ?
+            INNER JOIN sys_role r ON rm.role_id = r.id
+            WHERE rm.role_id = ANY(?::int[])
               AND r.status = 'enabled' AND r.deleted_at IS NULL
               AND m.status = 'enabled' AND m.deleted_at IS NULL
             ORDER BY m.sort_order ASC, m.id ASC
-        )";
+        )");
 
-        auto result = co_await dbService_.execSqlCoro(sql, {std::to_string(userId)});
+        auto result = co_await dbService_.execPreparedCoro(stmt, {SqlHelper::toPgArray(roleIds)});
 
-        Json::Value menus(Json::arrayValue);
         for (const auto& row : result) {
             Json::Value menu;
             buildMenuJson(row, menu);
             menus.append(menu);
         }
-
-        co_await authCache_.cacheUserMenus(userId, menus);
         co_return menus;
     }
 };
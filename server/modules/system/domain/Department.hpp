@@ -6,6 +6,7 @@
 #include "common/utils/FieldHelper.hpp"
 #include "common/utils/TimestampHelper.hpp"
 #include "common/utils/TreeBuilder.hpp"
+#include "common/cache/TreeCache.hpp"
 
 /**
  * @brief 部门聚合根
@@ -84,10 +85,18 @@ public:
      * @brief 获取部门树形结构
      */
     static Task<Json::Value> tree(const std::string& status = "") {
-        auto items = co_await list("", status);
-        auto tree = TreeBuilder::build(items, "id", "parent_id", "children");
-        TreeBuilder::sort(tree, "sort_order", true);
-        co_return tree;
+        auto snapshot = co_await treeSnapshot(status);
+        co_return snapshot->tree;
+    }
+
+    /**
+     * @brief 获取共享的部门树快照（部门变更事件失效）
+     */
+    static Task<std::shared_ptr<const TreeSnapshot>> treeSnapshot(const std::string& status = "") {
+        co_return co_await TreeCache::instance().get(
+            "department", "status:" + status,
+            [status]() -> Task<Json::Value> { co_return co_await list("", status); }
+        );
     }
 
     // ==================== 声明式约束 ====================
@@ -123,20 +132,9 @@ public:
                 throw ConflictException("不能将部门设为自己的子部门");
             }
 
-            DatabaseService db;
-            auto result = co_await db.execSqlCoro(R"(
-                WITH RECURSIVE ancestors AS (
-                    SELECT id, parent_id FROM sys_department
-                    WHERE id = ? AND deleted_at IS NULL
-                    UNION ALL
-                    SELECT d.id, d.parent_id FROM sys_department d
-                    INNER JOIN ancestors a ON a.parent_id = d.id
-                    WHERE d.deleted_at IS NULL
-                )
-                SELECT 1 FROM ancestors WHERE id = ?
-            )", {std::to_string(newParentId), std::to_string(dept.id())});
-
-            if (!result.empty()) {
+            // 按缓存树的子树区间判断新父部门是否为当前部门的子孙
+            auto snapshot = co_await treeSnapshot();
+            if (snapshot->isDescendant(dept.id(), newParentId)) {
                 throw ConflictException("不能将部门设为其子部门的下级，会导致循环引用");
             }
         };
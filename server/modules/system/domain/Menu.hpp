@@ -6,6 +6,7 @@
 #include "common/utils/FieldHelper.hpp"
 #include "common/utils/TimestampHelper.hpp"
 #include "common/utils/TreeBuilder.hpp"
+#include "common/cache/TreeCache.hpp"
 #include "common/utils/Pagination.hpp"
 
 /**
@@ -83,10 +84,18 @@ public:
      * @brief 获取菜单树形结构
      */
     static Task<Json::Value> tree(const std::string& status = "") {
-        auto items = co_await list("", status);
-        auto tree = TreeBuilder::build(items, "id", "parent_id", "children");
-        TreeBuilder::sort(tree, "sort_order", true);
-        co_return tree;
+        auto snapshot = co_await treeSnapshot(status);
+        co_return snapshot->tree;
+    }
+
+    /**
+     * @brief 获取共享的菜单树快照（菜单变更事件失效）
+     */
+    static Task<std::shared_ptr<const TreeSnapshot>> treeSnapshot(const std::string& status = "") {
+        co_return co_await TreeCache::instance().get(
+            "menu", "status:" + status,
+            [status]() -> Task<Json::Value> { co_return co_await list("", status); }
+        );
     }
 
     // ==================== 声明式约束 ====================
@@ -118,20 +127,9 @@ public:
                 throw ConflictException("不能将菜单设为自己的子菜单");
             }
 
-            DatabaseService db;
-            auto result = co_await db.execSqlCoro(R"(
-                WITH RECURSIVE ancestors AS (
-                    SELECT id, parent_id FROM sys_menu
-                    WHERE id = ? AND deleted_at IS NULL
-                    UNION ALL
-                    SELECT m.id, m.parent_id FROM sys_menu m
-                    INNER JOIN ancestors a ON a.parent_id = m.id
-                    WHERE m.deleted_at IS NULL
-                )
-                SELECT 1 FROM ancestors WHERE id = ?
-            )", {std::to_string(newParentId), std::to_string(menu.id())});
-
-            if (!result.empty()) {
+            // 按缓存树的子树区间判断新父菜单是否为当前菜单的子孙
+            auto snapshot = co_await treeSnapshot();
+            if (snapshot->isDescendant(menu.id(), newParentId)) {
                 throw ConflictException("不能将菜单设为其子菜单的下级，会导致循环引用");
             }
         };